@@ -12,366 +12,693 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include <stdio.h>
-#include "stm32f7xx_hal.h"
 
 #include "GLCD_Config.h"
-#include "Board_Touch.h"
 
+#include "platform.h"
 #include "poll.h"
 #include "Render.h"
 #include "game.h"
 #include "math_functions.h"
 #include "list.h"
+#include "replay.h"
+#include "simulation.h"
+#include "eventqueue.h"
+#include "latency.h"
+#include "encoder.h"
+#include "trig.h"
+#include "particles.h"
+#include "starfield.h"
+#include "capture.h"
 
 
 /* Defines ------------------------------------------------------------------*/
-#ifdef __RTX
-extern uint32_t os_time;
-uint32_t HAL_GetTick(void) {
-	return os_time;
-}
-#endif 
+#define BULLET_TRAIL_THICKNESS 3
 
+/* Meteors are drawn as one of ASTEROID_SHAPES jagged outlines of ASTEROID_VERTICES points, about BULLET_RADIUS across */
+#define ASTEROID_SHAPES 4
+#define ASTEROID_VERTICES 9
+/* Binary angle units a meteor turns for each pixel it falls */
+#define ASTEROID_SPIN 150
+/* Meteors drawn in one fillPolygons() batch */
+#define METEOR_BATCH 16
 
-#define COUNTERMAX 10
-#define AIM_HEIGHT 160
-#define BULLET_EXPLOSION_RADIUS 60
-#define BULLET_RADIUS 10
-#define BULLET_TRAIL_THICKNESS 3
+/* Particle bursts: how many, top speed in pixels per second and lifetime in milliseconds. 
+ The explosion throws out sparks; each destroyed meteor breaks into debris that falls. */
+#define EXPLOSION_SPARKS 768
+#define EXPLOSION_SPARK_SPEED 240
+#define EXPLOSION_SPARK_LIFE 700
+#define METEOR_DEBRIS 192
+#define METEOR_DEBRIS_SPEED 90
+#define METEOR_DEBRIS_LIFE 900
+/* Side of each particle's square, in pixels; 1 draws points */
+#define PARTICLE_SIZE 2
 
-/** Enumerator representing the different screens */
-enum stateEnum{
-	start, game, lose, win
-};
-static enum stateEnum state = start;
+/* Milliseconds between rendered frames; 30 FPS */
+#define RENDER_INTERVAL 33
+/* Most simulation ticks run between two renders; beyond this the game slows down rather than never drawing */
+#define MAX_TICKS_PER_FRAME 12
+/* Most renders skipped in a row when drawing is over budget */
+#define MAX_FRAMESKIP 3
+
+/* Aim pixels per quadrature count with the encoder turning slowly; four counts per cycle, where there used to be two steps */
+#define ENCODER_AIM_SCALE ((AIM_STEP << ENCODER_FIXED_SHIFT) / 2)
+
+/* Seed for meteor spawning. Games still differ, as the generator is stirred every frame on the start screen. */
+#define GAME_SEED 0x2545F491
+
+/* Input replay. 0 plays live, 1 records every simulation tick's input into replayBuffer, 
+ 2 plays replayBuffer back in place of the hardware. Dump replayBuffer with the debugger; playback loads it 
+ through platformLoadRecording(), which on the board leaves whatever the debugger put there. */
+#ifndef REPLAY_MODE
+#define REPLAY_MODE 0
+#endif
+#define REPLAY_BUFFER_SIZE 65536
+
+/* Input-to-photon latency. 1 measures from each touch sensor edge to the frame that first shows the shot or 
+ explosion, and shows the median, 99th percentile and worst case on the start screen. Read latency with the debugger for the histogram. */
+#ifndef LATENCY_MODE
+#define LATENCY_MODE 0
+#endif
+
+/* Glow post-process. 1 blurs the bright parts of the game screen into a glow after it is drawn. Whenever a frame 
+ overruns RENDER_INTERVAL the glow is dropped for BLOOM_RETRY frames, then tried again. */
+#ifndef BLOOM_MODE
+#define BLOOM_MODE 1
+#endif
+#define BLOOM_RETRY 90
 
+/* Layers. 1 draws what doesn't move on each screen, the panels, onto a background layer only 
+ when the screen changes, and just the moving parts each frame onto the frame buffers over it, clearing only what 
+ was drawn. Frame buffer pixels of LAYER_KEY show the background through. The stars stop scrolling behind the panels. */
+#ifndef LAYER_MODE
+#define LAYER_MODE 1
+#endif
+#define LAYER_KEY GLCD_COLOR_BLACK
+/* 1 blends the trails' anti-aliased edges in linear light, so they fade evenly rather than darkening in the middle;
+ 0 blends the RGB565 values as they are, which is cheaper over a coloured background */
+#ifndef BLEND_GAMMA
+#define BLEND_GAMMA 0
+#endif
 
-static pin sevenSegmentDisplay[7]; /** Array of seven segment display pins, from a to g*/
+/* Frame capture. 1 records every presented frame into a ring in the platform's capture buffer, as the runs of pixels 
+ that changed since the frame before, keeping the latest few thousand; dump the buffer with the debugger. 2 streams 
+ the records out through platformSaveCapture() as they are made, to a file on hosts. host/capture_decode.c turns 
+ either into images. Read captureTime with the debugger for what it costs. */
+#ifndef CAPTURE_MODE
+#define CAPTURE_MODE 0
+#endif
+
+/* Particle pool occupancy. 1 shows live, peak and dropped particles in the corner of the game screen. */
+#ifndef PARTICLE_STATS
+#define PARTICLE_STATS 0
+#endif
+
+static sevenSegmentStruct sevenSegmentDisplay; /** Seven segment display, showing meteors left to spawn */
 static buttonStruct touchSensor; /** Struct representing the touch sensor */
 static buttonStruct button; /** Struct representing the user button */
 static rotaryEncoderStruct rotaryEncoder; /** Struct representing the rotary encoder */
-static TOUCH_STATE tsc_state; /** Touchscreen state struct */
-
-static int enemiesRemaining; 
-static Projectile bullet; 
-static list enemyList;
-static int explosionTimer;
-static int enemyTimer;
-static int rand;
-static int wasTouched;
+static encoderTracker encoderMotion; /** Rotary encoder velocity, for the aim acceleration curve */
+
+static gameState sim; /** Game state, advanced by step() */
+static inputFrame input; /** This tick's inputs, either read from hardware or played back */
+static eventQueue inputQueue; /** Input events from the pin and debounce timer handlers, drained once per tick */
+static particlePool particles; /** Sparks and debris; moved once per rendered frame, not per tick */
+static starfield stars; /** Background stars, scrolled once per rendered frame */
+#if(BLOOM_MODE != 0)
+static uint32_t bloomPassTime[4]; /** Microseconds the last glow took in each pass: extract, rows, columns, composite. Read with the debugger. */
+static uint32_t bloomHoldoff; /** Frames left before the glow is tried again after an overrun */
+#endif
+#if(LAYER_MODE != 0)
+static int32_t backgroundState = -1; /** Screen drawn on the background layer; -1 for none yet */
+#endif
+#if(REPLAY_MODE != 0)
+static replayStream replay;
+static uint8_t replayBuffer[REPLAY_BUFFER_SIZE];
+#endif
+#if(LATENCY_MODE != 0)
+static latencyTracker latency;
+#endif
+#if(CAPTURE_MODE != 0)
+static frameCapture capture;
+static uint32_t captureTime; /** Microseconds the last frame's capture took, and the most any has. Read with the debugger. */
+static uint32_t captureTimeMax;
+#endif
+
+/* Distance of each asteroid vertex from the centre, in pixels, going round */
+static const int8_t asteroidRadii[ASTEROID_SHAPES][ASTEROID_VERTICES] = {
+	{12, 7, 12, 10, 6, 11, 13, 8, 11},
+	{13, 10, 6, 12, 11, 7, 11, 13, 8},
+	{9, 13, 11, 6, 12, 10, 13, 7, 12},
+	{11, 13, 6, 11, 12, 8, 7, 13, 11}
+};
+static int16_t asteroidX[ASTEROID_SHAPES][ASTEROID_VERTICES]; /** Asteroid vertices about the centre, in subpixels; built by initAsteroids() */
+static int16_t asteroidY[ASTEROID_SHAPES][ASTEROID_VERTICES];
 /**
 * @}
 */
 
 /**
-* @brief System Clock Configuration, as given in the GLCD labsheet
+* @brief Reads every input used this tick into input. 
+* When recording, the inputs are also appended to the replay stream. When playing back, the hardware reads are replaced by the stream. 
 */
-void SystemClock_Config(void) {
-	RCC_OscInitTypeDef RCC_OscInitStruct;
-	RCC_ClkInitTypeDef RCC_ClkInitStruct;
-	/* Enable Power Control clock */
-	__HAL_RCC_PWR_CLK_ENABLE();
-	/* The voltage scaling allows optimizing the power
-	consumption when the device is clocked below the
-	maximum system frequency. */
-	__HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE1);
-	/* Enable HSE Oscillator and activate PLL
-	with HSE as source */
-	RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSE;
-	RCC_OscInitStruct.HSEState = RCC_HSE_ON;
-	RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
-	RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSE;
-	RCC_OscInitStruct.PLL.PLLM = 25;
-	RCC_OscInitStruct.PLL.PLLN = 336;
-	RCC_OscInitStruct.PLL.PLLP = RCC_PLLP_DIV2;
-	RCC_OscInitStruct.PLL.PLLQ = 7;
-	HAL_RCC_OscConfig(&RCC_OscInitStruct);
-	/* Select PLL as system clock source and configure
-	the HCLK, PCLK1 and PCLK2 clocks dividers */
-	RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_SYSCLK | 
-	RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
-	RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
-	RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
-	RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV4;
-	RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV2;
-	HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_5);
+void pollInputs(){
+	inputEvent event;
+	uint32_t touchEdgeTime = 0, age, now;
+	
+	touchSensor.changed = 0;
+	button.changed = 0;
+	input.tick = platformTick();
+	now = platformMicros();
+	
+	/* Apply the events queued by the interrupts. Only one edge per button is taken each tick, 
+	 so a press and release that both land between two ticks are seen on consecutive ticks, not lost. */
+	while(peekEvent(&inputQueue, &event) == 0){
+		if(event.type == eventEncoder){
+			/* Move the aim by each count, further the faster the encoder turns. Clamp after each count. */
+			rotaryEncoder.counter += encoderCount(&encoderMotion, event.value, event.timestamp);
+			rotaryEncoder.counter = (rotaryEncoder.counter > COUNTERMAX) ? COUNTERMAX : rotaryEncoder.counter;
+			rotaryEncoder.counter = (rotaryEncoder.counter < -COUNTERMAX) ? -COUNTERMAX : rotaryEncoder.counter;
+		}
+		else if(event.type == eventTouchSensor){
+			if(touchSensor.changed){break;}
+			touchSensor.state = event.value;
+			touchSensor.changed = 1;
+			touchEdgeTime = event.timestamp;
+		}
+		else if(event.type == eventButton){
+			if(button.changed){break;}
+			button.state = event.value;
+			button.changed = 1;
+		}
+		popEvent(&inputQueue, &event);
+	}
+#if(ENCODER_HARDWARE != 0)
+	/* The hardware counter has counted the encoder; the counts are timed to this poll, to within a tick */
+	rotaryEncoder.counter += encoderCount(&encoderMotion, readEncoderTimer(&rotaryEncoder), now);
+	rotaryEncoder.counter = (rotaryEncoder.counter > COUNTERMAX) ? COUNTERMAX : rotaryEncoder.counter;
+	rotaryEncoder.counter = (rotaryEncoder.counter < -COUNTERMAX) ? -COUNTERMAX : rotaryEncoder.counter;
+#endif
+	
+	input.encoderCounter = rotaryEncoder.counter;
+	input.touchSensorState = touchSensor.state;
+	input.touchSensorChanged = touchSensor.changed;
+	/* How long ago the touch sensor edge happened, so the game can act as of the edge rather than this tick */
+	age = touchSensor.changed ? ((now - touchEdgeTime) / 1000) : 0;
+	input.touchSensorEdgeAge = (age > 255) ? 255 : (uint8_t)age;
+	input.buttonState = button.state;
+	input.buttonChanged = button.changed;
+	/* Poll touchscreen */
+	input.touchscreenPressed = platformTouchscreenPressed();
+	
+#if(REPLAY_MODE == 1)
+	recordFrame(&replay, &input);
+#elif(REPLAY_MODE == 2)
+	/* Falls back to live input once the stream runs out */
+	readFrame(&replay, &input);
+#endif
 }
 
 /**
-* @brief Function that handles drawing and input for the start screen
+* @brief Draws the start screen
 */
-void startLoop(){
-	/* Read touchscreen */
-	Touch_GetState(&tsc_state);
+void drawStartScreen(){
 	/* Draw box and text */
 	setForegroundColor(GLCD_COLOR_NAVY);
 	fillRectangle(136-100, 240-120, 200, 160);
 	setForegroundColor(GLCD_COLOR_WHITE);
 	GLCD_DrawString(136-64, 240-12, "Touch to");
 	GLCD_DrawString(136-32, 240+12, "Play");
-	/* Wait for touch to be released */ 
-	if(wasTouched && !tsc_state.pressed){
-		wasTouched = 0;
-	}
-	if(tsc_state.pressed && !wasTouched){
-		/* Initialise game variables, set state to game */
-		state = game;
-		rotaryEncoder.counter = 0;
-		bullet = shoot(10, 10, 131, 0, 0);
-		readButton(&touchSensor);
-		deleteList(&enemyList);
-		enemiesRemaining = 9;
-		explosionTimer = 0;
-		enemyTimer = 60;
-	}
 }
 
+#if(LATENCY_MODE != 0)
+/**
+* @brief Draws the latency measured so far, under the start screen box
+*/
+void drawLatencyReport(){
+	char text[24];
+	setForegroundColor(GLCD_COLOR_WHITE);
+	GLCD_DrawString(16, 400, "Lag 50/99/max");
+	sprintf(text, "%u/%u/%ums", (unsigned)latencyPercentile(&latency, 50), 
+		(unsigned)latencyPercentile(&latency, 99), (unsigned)(latency.count ? latency.max : 0));
+	GLCD_DrawString(16, 424, text);
+}
+#endif
+
+#if(PARTICLE_STATS != 0)
 /**
-* @brief Function that handles drawing and input for the win screen
+* @brief Draws the particle pool's occupancy, live/peak particles and how many were dropped
 */
-void winLoop(){
-	/* Read touchscreen */
-	Touch_GetState(&tsc_state);
+void drawParticleStats(){
+	char text[32];
+	setForegroundColor(GLCD_COLOR_WHITE);
+	sprintf(text, "%u/%u %u%% -%u", (unsigned)particles.count, (unsigned)particles.peak, 
+		(unsigned)particleOccupancy(&particles), (unsigned)particles.dropped);
+	GLCD_DrawString(0, 456, text);
+}
+#endif
+
+/**
+* @brief Draws the win screen
+*/
+void drawWinScreen(){
 	/* Draw box and text */
 	setForegroundColor(GLCD_COLOR_DARK_GREEN);
 	fillRectangle(136-100, 240-80, 200, 160);
 	setForegroundColor(GLCD_COLOR_WHITE);
 	GLCD_DrawString(136-64, 240-12, "You win!");
-	/* Switch to start screen */
-	if(tsc_state.pressed){
-		state = start;
-		wasTouched = 1;
-	}
 }
 
 /**
-* @brief Function that handles drawing and input for the lose screen.
+* @brief Draws the lose screen
 */
-void loseLoop(){
-	/* Read touchscreen */
-	Touch_GetState(&tsc_state);
+void drawLoseScreen(){
 	/* Draw box and text */
 	setForegroundColor(GLCD_COLOR_MAROON);
 	fillRectangle(136-100, 240-80, 200, 160);
 	setForegroundColor(GLCD_COLOR_WHITE);
 	GLCD_DrawString(136-72, 240-12, "You lose!");
-	/* Switch to start screen */
-	if(tsc_state.pressed){
-		state = start;
-		wasTouched = 1;
+}
+
+/**
+* @brief Builds the asteroid outlines from asteroidRadii, with the vertices evenly spaced round. 
+*/
+static void initAsteroids(void){
+	int32_t shape, i, sine, cosine;
+	for(shape = 0; shape < ASTEROID_SHAPES; shape++){
+		for(i = 0; i < ASTEROID_VERTICES; i++){
+			trigSinCos((i * ANGLE_FULL) / ASTEROID_VERTICES, &sine, &cosine);
+			asteroidX[shape][i] = (int16_t)((TO_SUBPIXEL(asteroidRadii[shape][i]) * cosine) >> TRIG_SHIFT);
+			asteroidY[shape][i] = (int16_t)((TO_SUBPIXEL(asteroidRadii[shape][i]) * sine) >> TRIG_SHIFT);
+		}
 	}
 }
 
 /**
-* @brief Function that handles drawing, input and logic for the game.
+* @brief Fills in a polygon for a meteor at pos, using vertex storage x and y. 
+* Each meteor keeps the shape picked by where it started, and spins as it falls, one way or the other by shape. 
 */
-void gameLoop(){
+static void shapeMeteor(const Projectile* meteor, const float pos[2], polygon* shape, int16_t* x, int16_t* y){
+	int32_t kind = ((int32_t)meteor->xpos_start) % ASTEROID_SHAPES;
+	int32_t spin = (int32_t)((meteor->ypos_start - pos[1]) * ASTEROID_SPIN);
+	int16_t cx = (int16_t)TO_SUBPIXEL(pos[0]), cy = (int16_t)TO_SUBPIXEL(pos[1]);
+	int32_t i;
+	rotatePoints(asteroidX[kind], asteroidY[kind], x, y, ASTEROID_VERTICES, (kind & 1) ? spin : -spin);
+	for(i = 0; i < ASTEROID_VERTICES; i++){
+		x[i] += cx;
+		y[i] += cy;
+	}
+	shape->x = x;
+	shape->y = y;
+	shape->count = ASTEROID_VERTICES;
+	shape->fill = GLCD_COLOR_MAROON;
+	shape->outline = GLCD_COLOR_RED;
+	shape->outlined = 1;
+}
+
+/**
+* @brief Draws the game from the simulation state. Changes nothing in it. 
+* Moving objects are drawn alpha of the way from their previous tick's position to their current one. 
+*/
+void drawGame(const gameState* sim, float alpha){
 	/* Local variables */
-	int32_t aimPos, rand1;
-	float gunTip[2];
+	float pos[2];
+	int32_t sine, cosine;
 	iterator enemyIter;
 	Projectile *curEnemy;
+	static polygon meteors[METEOR_BATCH];
+	static int16_t meteorX[METEOR_BATCH][ASTEROID_VERTICES], meteorY[METEOR_BATCH][ASTEROID_VERTICES];
+	uint32_t meteorCount = 0;
 	
-	/* Poll inputs */
-	
-	/* Clamp rotary encoder counter to +-10 */
-	rotaryEncoder.counter = (rotaryEncoder.counter > COUNTERMAX) ? COUNTERMAX : rotaryEncoder.counter;
-	rotaryEncoder.counter = (rotaryEncoder.counter < -COUNTERMAX) ? -COUNTERMAX : rotaryEncoder.counter;
-	
-	/* Get aim position. Player gun will aim at a point AIM_HEIGHT pixels up and aimPos pixels left/right
-	 Doing it like this avoids doing trigonometry.*/
-	aimPos = 136 + (15*rotaryEncoder.counter);
-	
-	/** Poll touch sensor and button */
-	readButton(&touchSensor);
-	readButton(&button);
-	
-	
-	
-	
-	/* Move and draw projectiles */
-	
-	/* Bounce player bullet; not fully implemented, as the trail will follow it, but better than segfaulting. */
-	if(bullet.xpos<5 || bullet.xpos > 267){
-		bullet.xvel = -bullet.xvel;
-	}
-	/* Move player bullet one frame */
-	move(&bullet, 30);
 	/* Draw player bullet trail and circle*/
+	interpolatePosition(&sim->bullet, alpha, pos);
 	setForegroundColor(GLCD_COLOR_NAVY);
-	drawThickLine(bullet.xpos_start, bullet.ypos_start, bullet.xpos, bullet.ypos, BULLET_TRAIL_THICKNESS);
+	drawThickLine(sim->bullet.xpos_start, sim->bullet.ypos_start, pos[0], pos[1], BULLET_TRAIL_THICKNESS);
 	setForegroundColor(GLCD_COLOR_CYAN);
-	drawFilledCircle(bullet.xpos, bullet.ypos, BULLET_RADIUS);
+	drawFilledCircleAA(TO_SUBPIXEL(pos[0]), TO_SUBPIXEL(pos[1]), TO_SUBPIXEL(BULLET_RADIUS));
 	
-	/* Iterate over enemy bullets*/
-	enemyIter = getIterator(&enemyList);
+	/* Draw meteor trails, then the meteors over them in batches */
+	enemyIter = getIterator((list*)&sim->enemyList);
+	setForegroundColor(GLCD_COLOR_PURPLE);
 	while((curEnemy = getNext(&enemyIter)) != NULL){
-		/* Move then draw each bullet */
-		move(curEnemy, 30);
-		setForegroundColor(GLCD_COLOR_PURPLE);
-		drawThickLine(curEnemy->xpos_start, curEnemy->ypos_start, curEnemy->xpos, curEnemy->ypos, BULLET_TRAIL_THICKNESS);
-		setForegroundColor(GLCD_COLOR_RED);
-		drawFilledCircle(curEnemy->xpos, curEnemy->ypos, BULLET_RADIUS);
-	}
-	
-	/* Meteor shooting */
-	
-	/* Shoot a meteor if there are enemies remaining, and either the button is pressed or the timer has elapsed*/
-	if((enemiesRemaining!=0) && ((button.changed && button.state) || 
-		(enemyTimer < 0))){
-		/** Acquire a couple random-ish numbers*/
-		rand1 = (rand * HAL_GetTick() + aimPos) % 272;
-		rand = (rand1 * HAL_GetTick() + aimPos) % 260;
-		/** Create the new meteor, add it to the list*/
-		pushItem(&enemyList, shoot(rand-(rand1), 480, rand+6, 478, -(20 + rand1%60)));
-		enemiesRemaining--; /**Decrement remaining enemies */
-		enemyTimer = 300; /** Start 300-frame timer to spawn next meteor */
+		interpolatePosition(curEnemy, alpha, pos);
+		drawThickLine(curEnemy->xpos_start, curEnemy->ypos_start, pos[0], pos[1], BULLET_TRAIL_THICKNESS);
+		if(meteorCount == METEOR_BATCH){
+			fillPolygons(meteors, meteorCount);
+			meteorCount = 0;
+		}
+		shapeMeteor(curEnemy, pos, &meteors[meteorCount], meteorX[meteorCount], meteorY[meteorCount]);
+		meteorCount++;
 	}
-	enemyTimer--; /**Decrement timer to spawn next meteor */
+	fillPolygons(meteors, meteorCount);
 	
-	/* Player gun */
 	/* Draw explosion effect */
-	if(explosionTimer != 0){
-		/* Swap explosion colour every frame */
-		if(explosionTimer%2) setForegroundColor(GLCD_COLOR_CYAN);
-		else setForegroundColor(GLCD_COLOR_DARK_GREEN);
-		/* Draw the circle */
-		drawFilledCircle(bullet.xpos, bullet.ypos, BULLET_EXPLOSION_RADIUS);
-		/* Move the player bullet under the turret when the explosion ends */
-		if(!(--explosionTimer)){
-			bullet.xpos = 136; bullet.ypos = 0;
-		}
-	}
-	else if(touchSensor.changed != 0){ /* If not already exploding */
-		if(touchSensor.state != 0){ /* Shoot on a rising edge */
-			bullet = shoot(aimPos-136, AIM_HEIGHT, 136, 7, 150);
-		}
-		else{ /* Explode on a falling edge */
-			/* Stop bullet's movement */
-			bullet.xvel = 0; bullet.yvel = 0;
-			
-			/* Check for and remove destroyed meteors */
-			enemyIter = getIterator(&enemyList);			
-			while((curEnemy = getNext(&enemyIter)) != NULL){
-				/* If a meteor is in the explosion radius, remove it */
-				if(isInRadius(curEnemy->xpos, curEnemy->ypos, bullet.xpos, bullet.ypos, BULLET_EXPLOSION_RADIUS)){
-					removeItem(&enemyIter, &enemyList);
-				}
-			}
-			
-			/* Set 10-frame timer of explosion effect and draw the first frame of it */
-			explosionTimer = 30;
-			setForegroundColor(GLCD_COLOR_CYAN);
-			drawFilledCircle(bullet.xpos, bullet.ypos, BULLET_EXPLOSION_RADIUS);
-		}
+	if(sim->explosionTimer != 0){
+		/* Swap explosion colour every 30th of a second, starting with cyan */
+		if(((sim->explosionTimer * 30) / SIM_RATE) % 2) setForegroundColor(GLCD_COLOR_DARK_GREEN);
+		else setForegroundColor(GLCD_COLOR_CYAN);
+		drawFilledCircleAA(TO_SUBPIXEL(sim->bullet.xpos), TO_SUBPIXEL(sim->bullet.ypos), TO_SUBPIXEL(BULLET_EXPLOSION_RADIUS));
 	}
 
-	/* Draw player turret */
+	/* Draw sparks and debris over the explosion */
+	drawSplats(particles.x, particles.y, particles.color, particles.alpha, particles.count, PARTICLE_SIZE);
+#if(PARTICLE_STATS != 0)
+	drawParticleStats();
+#endif
+
+	/* Draw player turret over the explosion, so it stays on the sprites rather than the background */
 	setForegroundColor(GLCD_COLOR_BLUE);
-	drawFilledCircle(136, 0, 40); /**Turret body */
-	/* Point barrel at the aim point; scale it to be 100 pixels long */
-	normalizeToCircle(aimPos-136, AIM_HEIGHT, 100, gunTip);
-	drawThickLine(136, 7, 136 + (int)gunTip[0], (int)gunTip[1], 7);
+	drawFilledCircleAA(TO_SUBPIXEL(136), 0, TO_SUBPIXEL(40)); /**Turret body */
+	/* Point barrel along the aim angle; 100 pixels long */
+	trigSinCosFast(sim->aimAngle, &sine, &cosine);
+	drawThickLine(136, 7, 136 + ((100 * sine) >> TRIG_SHIFT), (100 * cosine) >> TRIG_SHIFT, 7);
 	
 	/* Draw player reticule */
 	setForegroundColor(GLCD_COLOR_WHITE);
-	drawFilledCircle(aimPos, AIM_HEIGHT, 10);
-	
-	/* Write remaining enemies to 7-segment display */
-	sevenSegmentDisplayNumber(enemiesRemaining, sevenSegmentDisplay);
-	
-	/* Check victory and defeat conditions */
-	
-	enemyIter = getIterator(&enemyList);
-	/* Check if enemy list is empty */
-	curEnemy = getNext(&enemyIter);
-	if(curEnemy == NULL){
-		if(enemiesRemaining == 0){ /** If so and none are remaining, the player has won */
-			state = win;
-			resetPins(7, sevenSegmentDisplay);
-		}
+	drawFilledCircleAA(TO_SUBPIXEL(sim->aimPos), TO_SUBPIXEL(AIM_HEIGHT), TO_SUBPIXEL(10));
+}
+
+/**
+* @brief Applies the hardware side effects of the last step: encoder re-centring and the 7-segment display. 
+*/
+void updateOutputs(const gameState* sim){
+	if(sim->events & EVENT_GAME_STARTED){
+		rotaryEncoder.counter = 0;
 	}
-	else{
-		/* Otherwise, check none are less than 20 pixels off the bottom of the screen. 
-		If one is, the player loses. */
-		do{
-			if(curEnemy->ypos <= 20){
-				state = lose;
-				resetPins(7, sevenSegmentDisplay);
-			}
-		}while((curEnemy = getNext(&enemyIter)) != NULL);
+	if(sim->state == game){
+		/* Write remaining enemies to 7-segment display; the refresh interrupt puts it on the pins */
+		sevenSegmentDisplayNumber(&sevenSegmentDisplay, sim->enemiesRemaining);
 	}
-	
+	if(sim->events & EVENT_GAME_OVER){
+		sevenSegmentBlank(&sevenSegmentDisplay);
+	}
+}
 
+/**
+* @brief Emits particle bursts for the last step's explosion and destroyed meteors. 
+* Uses the pool's own random numbers, so the simulation plays out the same with or without effects. 
+*/
+void emitEffects(const gameState* sim){
+	int i;
+	if(sim->events & EVENT_GAME_STARTED){
+		particles.count = 0;
+	}
+	if(sim->events & EVENT_EXPLODED){
+		emitBurst(&particles, sim->bullet.xpos, sim->bullet.ypos, EXPLOSION_SPARKS / 2, EXPLOSION_SPARK_SPEED, EXPLOSION_SPARK_LIFE, GLCD_COLOR_CYAN, 0);
+		emitBurst(&particles, sim->bullet.xpos, sim->bullet.ypos, EXPLOSION_SPARKS / 2, EXPLOSION_SPARK_SPEED, EXPLOSION_SPARK_LIFE, GLCD_COLOR_WHITE, 0);
+	}
+	if(sim->events & EVENT_METEOR_DESTROYED){
+		for(i = 0; i < sim->destroyedCount; i++){
+			emitBurst(&particles, sim->destroyedX[i], sim->destroyedY[i], METEOR_DEBRIS / 2, METEOR_DEBRIS_SPEED, METEOR_DEBRIS_LIFE, GLCD_COLOR_RED, 1);
+			emitBurst(&particles, sim->destroyedX[i], sim->destroyedY[i], METEOR_DEBRIS / 2, METEOR_DEBRIS_SPEED, METEOR_DEBRIS_LIFE, GLCD_COLOR_MAROON, 1);
+		}
+	}
 }
 
+#if(BLOOM_MODE != 0)
 /**
-* @brief Main function. Holds the main superloop structure, handles frame timing and buffer switching. 
+* @brief Runs the glow post-process over the drawn frame, timing each pass into bloomPassTime
 */
-int main(void){
-	uint32_t frameStartTime, frameTime;
-	int32_t delay;
-	/* Initialization functions. */
-	HAL_Init();
-	SystemClock_Config();
-	GLCD_Initialize_Doublebuffer();
-	initializePins(sevenSegmentDisplay, &touchSensor, &button, &rotaryEncoder);
+static void drawBloom(void){
+	uint32_t start, end;
+	start = platformMicros();
+	bloomExtract();
+	end = platformMicros();
+	bloomPassTime[0] = end - start;
+	bloomBlurRows();
+	start = platformMicros();
+	bloomPassTime[1] = start - end;
+	bloomBlurColumns();
+	end = platformMicros();
+	bloomPassTime[2] = end - start;
+	bloomComposite();
+	bloomPassTime[3] = platformMicros() - end;
+}
+#endif
 
-	/* Frame loop */
-	while(1){ 
-		/* Mark current time */
-		frameStartTime = HAL_GetTick();
-		/* Wipe the back buffer */
-		clearScreen();
-		/* Run appropriate frame function */
-		switch(state){
-			case start:
-				startLoop();
-				break;
-			case game:
-				gameLoop();
-				break;
-			case lose:
-				loseLoop();
-				break;
-			case win:
-				winLoop();
-				break;
+/**
+* @brief Draws the parts of the current screen that don't move: the panel. The game screen has none.
+*/
+void drawStaticScreen(){
+	switch(sim.state){
+		case start:
+			drawStartScreen();
+			break;
+		case lose:
+			drawLoseScreen();
+			break;
+		case win:
+			drawWinScreen();
+			break;
+		default:
+			break;
+	}
+}
+
+#if(CAPTURE_MODE != 0)
+/**
+* @brief Captures the frame about to be presented against the one on screen, which was the last captured, timing it into captureTime
+*/
+static void captureShown(void){
+	uint32_t start;
+	renderFlush();
+	start = platformMicros();
+	captureFrame(&capture, platformFrameBuffer(backBufferIndex()), platformFrameBuffer(backBufferIndex() ^ 1), platformTick());
+#if(CAPTURE_MODE == 2)
+	captureDrain(&capture, platformSaveCapture);
+#endif
+	captureTime = platformMicros() - start;
+	captureTimeMax = (captureTime > captureTimeMax) ? captureTime : captureTimeMax;
+}
+#endif
+
+/**
+* @brief Draws and presents one frame, alpha of the way between the last two simulation ticks. 
+*/
+void drawFrame(float alpha){
+#if(LAYER_MODE != 0)
+	/* Redraw the background layer when the screen changes, with the stars frozen behind a panel; 
+	 both frame buffers are then wholly cleared to show it */
+	if((int32_t)sim.state != backgroundState){
+		drawToBackground();
+		if(sim.state == game){
+			clearScreen();
 		}
+		else{
+			clearScreenStars(stars.columnStarts, stars.y, stars.color);
+		}
+		drawStaticScreen();
+		drawToSprites();
+		invalidateSprites();
+		backgroundState = (int32_t)sim.state;
+#if(CAPTURE_MODE != 0)
+		captureBackgroundChanged(&capture);
+#endif
+	}
+	/* Wipe what was drawn on the back buffer two frames ago, then move the stars */
+	clearSprites();
+	if(sim.state == game){
+		drawStars(stars.columnStarts, stars.y, stars.color, stars.drawn[backBufferIndex()]);
+	}
+#else
+	/* Wipe the back buffer, drawing the stars as it goes */
+	clearScreenStars(stars.columnStarts, stars.y, stars.color);
+	drawStaticScreen();
+#endif
+	/* Draw the moving parts of the appropriate screen */
+	switch(sim.state){
+		case start:
+#if(LATENCY_MODE != 0)
+			drawLatencyReport();
+#endif
+			break;
+		case game:
+			drawGame(&sim, alpha);
+#if(BLOOM_MODE != 0)
+			if(bloomHoldoff == 0){
+				drawBloom();
+			}
+#endif
+			break;
+		default:
+			break;
+	}
+#if(CAPTURE_MODE != 0)
+	captureShown();
+#endif
+	/* Switch newly drawn frame to front buffer. Synchronises to LCD's vsync. */
+	switchBuffer();
+}
 
-		/* Switch newly drawn frame to front buffer. Synchronises to LCD's vsync. */
-		switchBuffer();
-		/* Get the time taken to render the last frame */
-		frameTime = HAL_GetTick() - frameStartTime;
-		/* Time to wait, in order to make the frame time total to 30ms. 
-		 Total frame time is 33; the last 3 are left loose, and will be spent waiting for vsync. */
-		delay = 30 - frameTime;
-		/*Ideally, this would be PCLK1 set to count microseconds
-		 However, PCLK1 is already in use. Therefore, frame time is done imprecisely with the system tick. */
-		if(delay > 0) HAL_Delay(delay);
+/**
+* @brief Pin change handler, called from the pin interrupts with the mask of the pin that changed. 
+*/
+static void pinChanged(uint16_t pinMask){
+	int32_t direction, level;
+	uint32_t now = platformMicros();
+	/* If clk or data caused the interrupt, read the rotary encoder. 
+	 Steps are queued for the main loop rather than written to the counter here. */
+	if((pinMask == rotaryEncoder.clk.pin) || (pinMask == rotaryEncoder.dt.pin)){
+		direction = readEncoder(&rotaryEncoder);
+		if(direction != 0){
+			pushEvent(&inputQueue, now, eventEncoder, (int8_t)direction);
+		}
+	}
+	/* Touch sensor and button edges are debounced and queued with the time they happened */
+	else if(pinMask == touchSensor.signal.pin){
+		if((level = buttonEdge(&touchSensor, now)) >= 0){
+			pushEvent(&inputQueue, now, eventTouchSensor, (int8_t)level);
+		}
+	}
+	else if(pinMask == button.signal.pin){
+		if((level = buttonEdge(&button, now)) >= 0){
+			pushEvent(&inputQueue, now, eventButton, (int8_t)level);
+		}
 	}
 }
 
 /**
-* @brief Boilerplate external interrupt request handler, for pin 2. 
+* @brief Debounce timer handler. Picks up buttons that ended their holdoff in a different state. 
 */
-void EXTI2_IRQHandler(void){
-	HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_2);
+static void debounceTimerElapsed(void){
+	int32_t level;
+	uint32_t now = platformMicros();
+	if((level = buttonSettle(&touchSensor, now)) >= 0){
+		pushEvent(&inputQueue, now, eventTouchSensor, (int8_t)level);
+	}
+	if((level = buttonSettle(&button, now)) >= 0){
+		pushEvent(&inputQueue, now, eventButton, (int8_t)level);
+	}
 }
+
 /**
-* @brief Boilerplate external interrupt request handler, for pin 15. 
+* @brief Display timer handler. Lights the next digit of the 7-segment display. 
 */
-void EXTI15_10_IRQHandler(void){
-	HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_15);
+static void displayTimerElapsed(void){
+	sevenSegmentRefresh(&sevenSegmentDisplay);
 }
 
 /**
-* @brief External interrupt callback. 
+* @brief Main function. Holds the main superloop structure, handles simulation and frame timing. 
+* The simulation runs in fixed steps of 1/SIM_RATE seconds from an accumulator, whatever the render rate. 
+* The accumulator counts milliseconds multiplied by SIM_RATE, so 120 Hz steps stay exact with a 1 ms system tick. 
 */
-void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin){
-	/* If pins 2 or 15 (clk or data, respectively) caused the interrupt, read the rotary encoder. */
-	if((GPIO_Pin == GPIO_PIN_2) || (GPIO_Pin == GPIO_PIN_15)){
-		readEncoder(&rotaryEncoder);
+int main(void){
+	uint32_t now, previousTime, nextRender, renderStart, renderTime, ticks, skip, lastRender;
+	uint32_t accumulator, busy;
+#if(LATENCY_MODE != 0)
+	uint32_t stepTime;
+#endif
+#if(CAPTURE_MODE != 0)
+	uint8_t* captureBuffer;
+	uint32_t captureSize;
+#endif
+	/* Initialization functions. The handlers go in before the pins, which interrupt as soon as they are set up. */
+	platformInit();
+	GLCD_Initialize_Doublebuffer();
+	setBlendGamma(BLEND_GAMMA);
+#if(LAYER_MODE != 0)
+	platformEnableLayers(LAYER_KEY);
+	GLCD_InitializeLayers(platformBackgroundBuffer(), LAYER_KEY);
+#endif
+#if(CAPTURE_MODE != 0)
+	captureBuffer = platformCaptureBuffer(&captureSize);
+	startCapture(&capture, captureBuffer, captureSize, (CAPTURE_MODE == 2) ? captureStream : captureRing, GLCD_WIDTH, GLCD_HEIGHT, GLCD_HEIGHT);
+#if(LAYER_MODE != 0)
+	captureLayers(&capture, platformBackgroundBuffer(), LAYER_KEY);
+#endif
+#endif
+	initAsteroids();
+	initParticles(&particles, GAME_SEED);
+	initStars(&stars, STAR_COUNT, GAME_SEED);
+	initEventQueue(&inputQueue);
+	platformSetPinHandler(pinChanged);
+	initializePins(&sevenSegmentDisplay, &touchSensor, &button, &rotaryEncoder);
+	platformStartTimer(timerDebounce, DEBOUNCE_TIMER_RATE, debounceTimerElapsed);
+	platformStartTimer(timerDisplay, SEVEN_SEGMENT_REFRESH_RATE * sevenSegmentDisplay.digits, displayTimerElapsed);
+	initEncoderTracker(&encoderMotion, ENCODER_AIM_SCALE, platformMicros());
+	initGame(&sim, GAME_SEED);
+#if(LATENCY_MODE != 0)
+	initLatency(&latency);
+#endif
+#if(REPLAY_MODE == 1)
+	startRecording(&replay, replayBuffer, REPLAY_BUFFER_SIZE, GAME_SEED, platformTick());
+#elif(REPLAY_MODE == 2)
+	/* Restore the recorded seed so meteors spawn the same way */
+	if(startPlayback(&replay, replayBuffer, platformLoadRecording(replayBuffer, REPLAY_BUFFER_SIZE)) == 0){
+		initGame(&sim, (uint32_t)replay.seed);
+	}
+#endif
+
+	previousTime = platformTick();
+	nextRender = previousTime;
+	lastRender = previousTime;
+	accumulator = 0;
+	
+	/* Main loop */
+	while(1){ 
+		/* Run every simulation tick that is due. Inputs are read once per tick. */
+		now = platformTick();
+		accumulator += (now - previousTime) * SIM_RATE;
+		previousTime = now;
+		ticks = 0;
+		busy = 0;
+		while(accumulator >= 1000){
+			pollInputs();
+			step(&sim, &input);
+			updateOutputs(&sim);
+			emitEffects(&sim);
+#if(LATENCY_MODE != 0)
+			/* Shots and explosions are drawn by the next frame presented, so measure from their edge to it */
+			if(sim.events & (EVENT_SHOT | EVENT_EXPLODED)){
+				stepTime = platformTick();
+				latencyInput(&latency, stepTime - input.touchSensorEdgeAge, stepTime);
+			}
+#endif
+			accumulator -= 1000;
+			/* Drop the backlog if the simulation itself can't keep up */
+			if(++ticks == MAX_TICKS_PER_FRAME){
+				accumulator %= 1000;
+			}
+		}
+		
+		/* Render when a frame is due, interpolating by how far we are into the next tick */
+		if((int32_t)(now - nextRender) >= 0){
+			busy = 1;
+			renderStart = now;
+			/* Particles and stars move by the time since the last frame, all together */
+			updateParticles(&particles, now - lastRender);
+			updateStars(&stars, now - lastRender);
+			lastRender = now;
+			drawFrame((float)accumulator / 1000.0f);
+			renderTime = platformTick() - renderStart;
+#if(LATENCY_MODE != 0)
+			/* drawFrame() returns once the new buffer is being scanned out */
+			latencyPresent(&latency, platformTick());
+#endif
+#if(BLOOM_MODE != 0)
+			/* Drop the glow for a while if the frame overran, whether or not it was drawn */
+			if(renderTime > RENDER_INTERVAL){
+				bloomHoldoff = BLOOM_RETRY;
+			}
+			else if(bloomHoldoff != 0){
+				bloomHoldoff--;
+			}
+#endif
+			/* Frame skipping. If drawing overran, skip the renders that fell due while it ran, 
+			 so the simulation gets that time back with inputs read on time. */
+			skip = renderTime / RENDER_INTERVAL;
+			skip = (skip > MAX_FRAMESKIP) ? MAX_FRAMESKIP : skip;
+			nextRender += RENDER_INTERVAL * (1 + skip);
+			/* Resynchronise after a long stall, rather than rendering back to back to catch up */
+			if((int32_t)(platformTick() - nextRender) > RENDER_INTERVAL){
+				nextRender = platformTick() + RENDER_INTERVAL;
+			}
+		}
+		/* Nothing was due; let the platform sleep until the next interrupt */
+		if((ticks == 0) && (busy == 0)){
+			platformIdle();
+		}
 	}
 }
 
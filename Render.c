@@ -15,251 +15,774 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
-#include "stm32f7xx_hal.h"
-#include "stm32f746xx.h"
 #include "GLCD_Config.h"
-#include "stm32746g_discovery_sdram.h"
+#include "platform.h"
 #include "Render.h"
 #include "Fonts.h"
 #include "math_functions.h"
-
-
-#ifndef SDRAM_BASE_ADDR
-#define SDRAM_BASE_ADDR       0xC0000000
+#include "tables.h"
+#if(RENDER_THREADS != 0)
+#include <pthread.h>
+#include <stdatomic.h>
+/* Drawing state each thread drawing bands keeps its own copy of */
+#define RENDER_LOCAL _Thread_local
+#else
+#define RENDER_LOCAL
 #endif
 
-#define Buffer1_address SDRAM_BASE_ADDR
-#define Buffer2_address SDRAM_BASE_ADDR + GLCD_SIZE_X * GLCD_SIZE_Y * 2
 extern GLCD_FONT GLCD_Font_16x24;
 
 /*---------------------------- Global variables ------------------------------*/
-static uint16_t frame_buf_1[GLCD_WIDTH*GLCD_HEIGHT] __attribute__((at(Buffer1_address)));
-static uint16_t frame_buf_2[GLCD_WIDTH*GLCD_HEIGHT] __attribute__((at(Buffer2_address)));
-static uint16_t* frame_buf; 
-static uint16_t foreground_color = GLCD_COLOR_WHITE;
-static uint16_t background_color = GLCD_COLOR_BLACK;
-static LTDC_HandleTypeDef LTDC_Handle;
-static int32_t stride;
+static pixel* frame_buf_1; /** Frame buffer 0, from the platform */
+static pixel* frame_buf_2; /** Frame buffer 1, from the platform */
+static pixel* frame_buf; 
+static RENDER_LOCAL pixel foreground_color = PIXEL_FROM_565(GLCD_COLOR_WHITE);
+static RENDER_LOCAL pixel background_color = PIXEL_FROM_565(GLCD_COLOR_BLACK);
+static RENDER_LOCAL int32_t clip_top = 0; /** First frame buffer row drawn on; the top of the band being drawn */
+static RENDER_LOCAL int32_t clip_bottom = GLCD_WIDTH; /** Row after the last drawn on */
+static int32_t surface_width = GLCD_WIDTH; /** Frame buffer rows, game x across the screen; see renderSurface */
+static int32_t surface_height = GLCD_HEIGHT; /** Pixels along each row, game y up the screen */
+static int32_t stride = GLCD_HEIGHT;
 static GLCD_FONT *active_font = &GLCD_Font_16x24;
 static enum framebuffer active = buffer1;
 
-/**
-	*@brief Initialize the SDRAM and LCD-TFT Display Controller.
-	*Almost identical to the version in the GLCD API; it simply initializes both buffers as well. 
-*/
-void GLCD_Initialize_Doublebuffer(void){
-  GPIO_InitTypeDef         GPIO_InitStructure;
-  RCC_PeriphCLKInitTypeDef RCC_PeriphClkInitStructure;
-  LTDC_LayerCfgTypeDef     LTDC_LayerCfg;
-
-#if !defined(DATA_IN_ExtSDRAM)
-  /* Initialize the SDRAM */
-  BSP_SDRAM_Init();
+/* Each pixel format's channels, and its spread: the colour channels with gaps between them, so blends and sums work 
+ on all three at once. A channel's carry or borrow lands in the guard bit above it */
+#if(PIXEL_FORMAT == PIXEL_ARGB8888)
+typedef uint64_t spreadPixel;
+#define PIXEL_RED(c) (((c) >> 16) & 0xFF)
+#define PIXEL_GREEN(c) (((c) >> 8) & 0xFF)
+#define PIXEL_BLUE(c) ((c) & 0xFF)
+#define PIXEL_RGB(r, g, b) ((pixel)(0xFF000000u | ((r) << 16) | ((g) << 8) | (b)))
+/* Blue, green then red in 16-bit lanes up from bit 0; alpha is dropped, and put back by PIXEL_OPAQUE */
+#define SPREAD_PIXEL(c) (((spreadPixel)(c) & 0xFF) | (((spreadPixel)(c) & 0xFF00) << 8) | (((spreadPixel)(c) & 0xFF0000) << 16))
+#define UNSPREAD_PIXEL(s) ((pixel)(((s) & 0xFF) | (((s) >> 8) & 0xFF00) | (((s) >> 16) & 0xFF0000)))
+#define SPREAD_MASK 0xFF00FF00FFull
+#define SPREAD_GUARD 0x10001000100ull
+#define PIXEL_OPAQUE 0xFF000000u
+/* blendDot()'s weight for an alpha, out of 2^BLEND_SHIFT */
+#define BLEND_WEIGHT(a) ((uint32_t)(a) + ((a) >> 7))
+#define BLEND_SHIFT 8
+#define GAMMA_DECODE_RB gammaDecode8
+#define GAMMA_DECODE_G gammaDecode8
+#define GAMMA_ENCODE_RB gammaEncode8
+#define GAMMA_ENCODE_G gammaEncode8
+#else
+typedef uint32_t spreadPixel;
+#define PIXEL_RED(c) ((c) >> 11)
+#define PIXEL_GREEN(c) (((c) >> 5) & 0x3F)
+#define PIXEL_BLUE(c) ((c) & 0x1F)
+#define PIXEL_RGB(r, g, b) ((pixel)(((r) << 11) | ((g) << 5) | (b)))
+/* RGB565 spread to GRB655 with zero padding between the channels */
+#define SPREAD_PIXEL(c) ((((uint32_t)(c)) | (((uint32_t)(c)) << 16)) & 0x7E0F81F)
+#define UNSPREAD_PIXEL(s) ((pixel)(((s) >> 16) | (s)))
+#define SPREAD_MASK 0x7E0F81F
+#define SPREAD_GUARD 0x8010020
+#define PIXEL_OPAQUE 0
+#define BLEND_WEIGHT(a) blendRamp[a]
+#define BLEND_SHIFT 5
+#define GAMMA_DECODE_RB gammaDecode5
+#define GAMMA_DECODE_G gammaDecode6
+#define GAMMA_ENCODE_RB gammaEncode5
+#define GAMMA_ENCODE_G gammaEncode6
 #endif
 
-	//initialise areas of SDRAM to 0
-	memset((uint16_t*)Buffer1_address, 0, GLCD_SIZE_X * GLCD_SIZE_Y * 2);
-	memset((uint16_t*)Buffer2_address, 0, GLCD_SIZE_X * GLCD_SIZE_Y * 2);
-	
-  /* Enable GPIOs clock */
-  __HAL_RCC_GPIOE_CLK_ENABLE();
-  __HAL_RCC_GPIOG_CLK_ENABLE();
-  __HAL_RCC_GPIOI_CLK_ENABLE();
-  __HAL_RCC_GPIOJ_CLK_ENABLE();
-  __HAL_RCC_GPIOK_CLK_ENABLE();
-
-  /* GPIOs configuration */
-  /*
-   +------------------+-------------------+-------------------+
-   +                   LCD pins assignment                    +
-   +------------------+-------------------+-------------------+
-   |  LCD_R0 <-> PI15 |  LCD_G0 <-> PJ7   |  LCD_B0 <-> PE4   |
-   |  LCD_R1 <-> PJ0  |  LCD_G1 <-> PJ8   |  LCD_B1 <-> PJ13  |
-   |  LCD_R2 <-> PJ1  |  LCD_G2 <-> PJ9   |  LCD_B2 <-> PJ14  |
-   |  LCD_R3 <-> PJ2  |  LCD_G3 <-> PJ10  |  LCD_B3 <-> PJ15  |
-   |  LCD_R4 <-> PJ3  |  LCD_G4 <-> PJ11  |  LCD_B4 <-> PG12  |
-   |  LCD_R5 <-> PJ4  |  LCD_G5 <-> PK0   |  LCD_B5 <-> PK4   |
-   |  LCD_R6 <-> PJ5  |  LCD_G6 <-> PK1   |  LCD_B6 <-> PK5   |
-   |  LCD_R7 <-> PJ6  |  LCD_G7 <-> PK2   |  LCD_B7 <-> PK6   |
-   ------------------------------------------------------------
-   |  LCD_HSYNC <-> PI10         |  LCD_VSYNC <-> PI9         |
-   |  LCD_CLK   <-> PI14         |  LCD_DE    <-> PK7         |
-   |  LCD_DISP  <-> PI12 (GPIO)  |  LCD_INT   <-> PI13        |
-   ------------------------------------------------------------
-   |  LCD_SCL <-> PH7 (I2C3 SCL) | LCD_SDA <-> PH8 (I2C3 SDA) |
-   ------------------------------------------------------------
-   |  LCD_BL_CTRL <-> PK3 (GPIO) |
-   -------------------------------
-  */
-  GPIO_InitStructure.Mode = GPIO_MODE_AF_PP;
-  GPIO_InitStructure.Pull = GPIO_NOPULL;
-  GPIO_InitStructure.Speed = GPIO_SPEED_FAST;
-
-  GPIO_InitStructure.Alternate = GPIO_AF9_LTDC;
-
-  /* GPIOG configuration */
-  GPIO_InitStructure.Pin = GPIO_PIN_12;
-  HAL_GPIO_Init(GPIOG, &GPIO_InitStructure);
+/* Blend ramps hold a colour spread into three lanes of a 64-bit word, blue, red then green up from bit 0, each 
+ wide enough for a GAMMA_LINEAR_BITS linear light value times a weight of up to 256 */
+#define RAMP_LANE 21
+/* A lane's value once divided back down by 256 */
+#define RAMP_VALUE_MASK ((1u << (RAMP_LANE - 8)) - 1)
+/* Half of a weight of 256 in each lane, to round the blend to nearest */
+#define RAMP_ROUND ((uint64_t)128 | ((uint64_t)128 << RAMP_LANE) | ((uint64_t)128 << (2 * RAMP_LANE)))
+/* Pixels in each 16-byte store fillSpan() makes */
+#define FILL_PIXELS ((int32_t)(16 / sizeof(pixel)))
+
+static RENDER_LOCAL uint64_t blend_ramp[256]; /** foreground_color in lanes times the weight of each alpha, rounded; rebuilt for each colour */
+static RENDER_LOCAL pixel blend_over_black[256]; /** foreground_color blended onto black at each alpha */
+static RENDER_LOCAL uint8_t blend_gamma; /** Nonzero to blend in linear light */
+static RENDER_LOCAL uint8_t ramp_stale = 1; /** Set when the ramps don't match foreground_color */
+/* Columns left of the screen that polygon edges may reach, in pixels */
+#define POLYGON_LEFT 1024
+/* Fractional bits of the columns where polygon edges cross rows */
+#define POLYGON_FRACTION_BITS 12
 
-  GPIO_InitStructure.Alternate = GPIO_AF14_LTDC;
-
-  /* GPIOE configuration */
-  GPIO_InitStructure.Pin = GPIO_PIN_4;
-  HAL_GPIO_Init(GPIOE, &GPIO_InitStructure);
-
-  /* GPIOI configuration */
-  GPIO_InitStructure.Pin = GPIO_PIN_9  | GPIO_PIN_10 | GPIO_PIN_14 | GPIO_PIN_15;
-  HAL_GPIO_Init(GPIOI, &GPIO_InitStructure);
-
-  /* GPIOJ configuration */
-  GPIO_InitStructure.Pin = GPIO_PIN_0  | GPIO_PIN_1  | GPIO_PIN_2  | GPIO_PIN_3  |
-                           GPIO_PIN_4  | GPIO_PIN_5  | GPIO_PIN_6  | GPIO_PIN_7  |
-                           GPIO_PIN_8  | GPIO_PIN_9  | GPIO_PIN_10 | GPIO_PIN_11 |
-                                         GPIO_PIN_13 | GPIO_PIN_14 | GPIO_PIN_15;
-  HAL_GPIO_Init(GPIOJ, &GPIO_InitStructure);
+/**
+	*@brief A polygon edge in fillPolygons()'s edge tables, in frame buffer coordinates. 
+*/
+typedef struct{
+	uint32_t key; /** Column where the edge crosses the current row's centre, in pixels from POLYGON_LEFT with POLYGON_FRACTION_BITS */
+	int32_t step; /** Change in the column from one row to the next, with POLYGON_FRACTION_BITS */
+	int16_t last_row; /** Last row whose centre the edge crosses */
+	int16_t next; /** Next edge starting on the same row, or -1 */
+}polygonEdge;
+static RENDER_LOCAL polygonEdge edges[POLYGON_EDGES]; /** Edges of the polygon being filled */
+static RENDER_LOCAL int16_t edge_starts[RENDER_MAX_WIDTH]; /** First edge starting on each row, or -1 */
+static RENDER_LOCAL polygonEdge active_edges[POLYGON_EDGES]; /** Edges crossing the current row, by column; copies, so sorting reads no further */
+
+/* Glow buffer size, half the screen each way, in frame buffer orientation */
+#define BLOOM_ROWS ((uint32_t)surface_width >> 1)
+#define BLOOM_COLS ((uint32_t)surface_height >> 1)
+/* Colour subtracted from every pixel before it glows; only channels brighter than this glow */
+#define BLOOM_THRESHOLD 0x8410
+/* Doublings of the glow's brightness after the threshold */
+#define BLOOM_GAIN_SHIFT 1
+/* Each blur pass averages 2^BLOOM_BOX_BITS pixels, so its division is a shift */
+#define BLOOM_BOX_BITS 2
+#define BLOOM_BOX (1 << BLOOM_BOX_BITS)
+
+static pixel bloom_buf[(RENDER_MAX_WIDTH >> 1) * (RENDER_MAX_HEIGHT >> 1)]; /** Bright parts of the frame at half size, blurred in place, no alpha */
+static spreadPixel bloom_line[2][RENDER_MAX_HEIGHT >> 1]; /** A row or column of bloom_buf spread, and the blur's output */
+
+/* Sprite layer tiles are 2^layer_tile_bits pixels square; each frame buffer only clears the tiles drawn on since it was last cleared. 
+ They are at least 2^LAYER_TILE_MIN_BITS, and bigger on wide surfaces, so a row of them is one word of dirty_tiles */
+#define LAYER_TILE_MIN_BITS 4
+#define LAYER_MAX_TILE_ROWS ((RENDER_MAX_WIDTH + (1 << LAYER_TILE_MIN_BITS) - 1) >> LAYER_TILE_MIN_BITS)
+
+static uint32_t layer_tile_bits = LAYER_TILE_MIN_BITS;
+static uint32_t layer_tile_rows; /** Rows of tiles down the frame buffer */
+static uint32_t layer_tile_cols; /** Tiles along a row, at most 32 */
+static pixel* background_buf; /** Static layer under the sprites, or NULL for a single layer */
+static pixel key_color; /** Sprite layer colour the background shows through */
+static uint32_t dirty_tiles[2][LAYER_MAX_TILE_ROWS]; /** Tiles drawn on in each frame buffer, a bit per column of tiles */
+static RENDER_LOCAL uint32_t* dirty; /** dirty_tiles of the buffer being drawn to, or NULL when drawing isn't tracked */
+
+#if(RENDER_THREADS != 0)
+/* Frame buffer rows are drawn in bands of a row of sprite layer tiles each, so no two threads mark the same dirty_tiles word */
+#define RENDER_BANDS layer_tile_rows
+/* Drawing calls recorded before the frame is drawn anyway */
+#define RENDER_COMMANDS 4096
+/* Space for the arrays recorded calls are given, in 8-byte words */
+#define RENDER_ARENA_WORDS (1 << 16)
 
-  /* GPIOK configuration */
-  GPIO_InitStructure.Pin = GPIO_PIN_0  | GPIO_PIN_1  | GPIO_PIN_2  |
-                           GPIO_PIN_4  | GPIO_PIN_5  | GPIO_PIN_6  | GPIO_PIN_7;
-  HAL_GPIO_Init(GPIOK, &GPIO_InitStructure);
+/**
+	*@brief What a recorded drawing call does. 
+*/
+enum renderCommandType{
+	commandBackground, commandForeground, commandGamma, commandClear, commandClearStars, commandBlend, commandBlendFast, 
+	commandBlendRamp, commandLine, commandThickLine, commandCircle, commandCircleAA, commandPolygons, commandSplats, 
+	commandRectangle, commandHLine, commandVLine, commandChar
+};
 
-  GPIO_InitStructure.Mode = GPIO_MODE_OUTPUT_PP;
+/**
+	*@brief A drawing call recorded to be drawn in bands, with the frame buffer rows it may draw on. 
+*/
+typedef struct{
+	enum renderCommandType type;
+	int32_t top; /** First frame buffer row it may draw on */
+	int32_t bottom; /** Last frame buffer row it may draw on */
+	int32_t arg[5]; /** Its arguments, in order */
+	void* data; /** Copies of the arrays it was given, in the arena */
+}renderCommand;
+
+static renderCommand commands[RENDER_COMMANDS]; /** Calls recorded since the bands were last drawn */
+static uint32_t command_count;
+static uint64_t arena[RENDER_ARENA_WORDS]; /** The recorded calls' arrays */
+static uint32_t arena_used; /** Words of arena taken */
+static uint8_t recording; /** Nonzero while calls are recorded rather than drawn; cleared while the bands are drawn */
+static pixel batch_foreground, batch_background; /** Drawing state when the first call recorded was made */
+static uint8_t batch_gamma;
+static uint32_t* batch_dirty;
+
+static pthread_t band_threads[RENDER_THREADS]; /** Threads drawing bands alongside the one recording */
+static uint32_t threads_started;
+static uint32_t thread_count; /** Threads drawing bands, the recording one included; 0 when not recording */
+static pthread_mutex_t band_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t band_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t band_done = PTHREAD_COND_INITIALIZER;
+static uint32_t band_batch; /** Batches handed to the threads, so each wakes once per batch */
+static uint32_t threads_busy; /** Threads yet to finish the batch, besides the recording one */
+static _Atomic uint32_t next_band; /** Next band for a thread to take */
 
-  /* GPIOI PI12 configuration */
-  GPIO_InitStructure.Pin = GPIO_PIN_12;
-  HAL_GPIO_Init(GPIOI, &GPIO_InitStructure);
+/**
+	* @brief Record a drawing call of type, that may draw on frame buffer rows top to bottom, with bytes of space for 
+	* copies of its arrays at data. Draws what was recorded first if the call won't fit. Returns NULL if there 
+	* could never be room; the caller then draws there and then, after everything recorded before it. 
+*/
+static renderCommand* recordCommand(enum renderCommandType type, int32_t top, int32_t bottom, uint32_t bytes){
+	renderCommand* c;
+	uint32_t words = (bytes + 7) >> 3;
+	if((command_count == RENDER_COMMANDS) || (arena_used + words > RENDER_ARENA_WORDS)){
+		renderFlush();
+	}
+	if(words > RENDER_ARENA_WORDS){
+		return NULL;
+	}
+	if(command_count == 0){
+		batch_foreground = foreground_color;
+		batch_background = background_color;
+		batch_gamma = blend_gamma;
+		batch_dirty = dirty;
+	}
+	c = &commands[command_count++];
+	c->type = type;
+	c->top = top;
+	c->bottom = bottom;
+	c->data = &arena[arena_used];
+	arena_used += words;
+	return c;
+}
+#endif
 
-  /* GPIOK PK3 configuration */
-  GPIO_InitStructure.Pin = GPIO_PIN_3;
-  HAL_GPIO_Init(GPIOK, &GPIO_InitStructure);
+/**
+	*@brief Initialize the display, through the platform, and both frame buffers, as the panel: GLCD_Config.h's size, 
+	*in the build's pixel format. Buffer 0 is shown and buffer 1 drawn to first. 
+*/
+void GLCD_Initialize_Doublebuffer(void){
+	renderSurface panel;
+	panel.width = GLCD_WIDTH;
+	panel.height = GLCD_HEIGHT;
+	panel.stride = GLCD_HEIGHT;
+	panel.format = PIXEL_FORMAT;
+	GLCD_InitializeSurface(&panel);
+}
 
-  /* LCD clock configuration 
-       PLLSAI_VCO Input = HSE_VALUE / PLL_M = 1MHz
-       PLLSAI_VCO Output = PLLSAI_VCO Input * PLLSAIN = 192MHz
-       PLLLCDCLK = PLLSAI_VCO Output / PLLSAIR = 192/5 = 38.4MHz
-       LTDC clock frequency = PLLLCDCLK / LTDC_PLLSAI_DIVR_4 = 38.4/4 = 9.6MHz
-  */
-  RCC_PeriphClkInitStructure.PeriphClockSelection = RCC_PERIPHCLK_LTDC;
-  RCC_PeriphClkInitStructure.PLLSAI.PLLSAIN = 192;
-  RCC_PeriphClkInitStructure.PLLSAI.PLLSAIR = 5;
-  RCC_PeriphClkInitStructure.PLLSAIDivR = RCC_PLLSAIDIVR_4;
-  HAL_RCCEx_PeriphCLKConfig(&RCC_PeriphClkInitStructure); 
-
-  // Enable the LTDC Clock
-  __HAL_RCC_LTDC_CLK_ENABLE();
-
-  // LTDC configuration
-  LTDC_Handle.Instance = LTDC;
-
-  // Configure horizontal synchronization width
-  LTDC_Handle.Init.HorizontalSync = 40;
-  // Configure vertical synchronization height
-  LTDC_Handle.Init.VerticalSync = 9;
-  // Configure accumulated horizontal back porch
-  LTDC_Handle.Init.AccumulatedHBP = 53;
-  // Configure accumulated vertical back porch
-  LTDC_Handle.Init.AccumulatedVBP = 11;
-  // Configure accumulated active width
-  LTDC_Handle.Init.AccumulatedActiveW = 533;
-  // Configure accumulated active height
-  LTDC_Handle.Init.AccumulatedActiveH = 283;
-  // Configure total width
-  LTDC_Handle.Init.TotalWidth = 565;
-  // Configure total height
-  LTDC_Handle.Init.TotalHeigh = 285;
-
-  // Configure R,G,B component values for LCD background color
-  LTDC_Handle.Init.Backcolor.Red   = 0;
-  LTDC_Handle.Init.Backcolor.Blue  = 0;
-  LTDC_Handle.Init.Backcolor.Green = 0;
-
-  // Polarity
-  LTDC_Handle.Init.HSPolarity = LTDC_HSPOLARITY_AL;
-  LTDC_Handle.Init.VSPolarity = LTDC_VSPOLARITY_AL;
-  LTDC_Handle.Init.DEPolarity = LTDC_DEPOLARITY_AL;
-  LTDC_Handle.Init.PCPolarity = LTDC_PCPOLARITY_IPC;
-    
-  HAL_LTDC_Init(&LTDC_Handle); 
-
-  LTDC_LayerCfg.WindowX0 = 0;
-  LTDC_LayerCfg.WindowX1 = GLCD_SIZE_X - 1;
-  LTDC_LayerCfg.WindowY0 = 0;
-  LTDC_LayerCfg.WindowY1 = GLCD_SIZE_Y - 1;
-  LTDC_LayerCfg.PixelFormat = LTDC_PIXEL_FORMAT_RGB565;
-  LTDC_LayerCfg.Alpha  = 255;
-  LTDC_LayerCfg.Alpha0 = 0;
-  LTDC_LayerCfg.BlendingFactor1 = LTDC_BLENDING_FACTOR1_CA;
-  LTDC_LayerCfg.BlendingFactor2 = LTDC_BLENDING_FACTOR2_CA;
-  LTDC_LayerCfg.ImageWidth  = GLCD_SIZE_X;
-  LTDC_LayerCfg.ImageHeight = GLCD_SIZE_Y;
-  LTDC_LayerCfg.Backcolor.Red   = 0;
-  LTDC_LayerCfg.Backcolor.Green = 0;
-  LTDC_LayerCfg.Backcolor.Blue  = 0;
-	LTDC_LayerCfg.FBStartAdress = Buffer1_address;
-  HAL_LTDC_ConfigLayer(&LTDC_Handle, &LTDC_LayerCfg, 0);
-	
+/**
+	*@brief Initialize the display, through the platform, and both frame buffers, as surface describes them. 
+	*The platform's buffers must hold it. Game coordinates are pixels of the surface, with the origin where the 
+	*panel's is, so a bigger surface has more of them rather than bigger ones. 
+	*Returns -1, leaving the display as it was, if the surface is bigger than RENDER_MAX_WIDTH by RENDER_MAX_HEIGHT, 
+	*its rows overlap, or its format isn't the one the drawing was built for. 
+*/
+int32_t GLCD_InitializeSurface(const renderSurface* surface){
+	if((surface->format != PIXEL_FORMAT) || (surface->width == 0) || (surface->width > RENDER_MAX_WIDTH) || 
+		(surface->height == 0) || (surface->height > RENDER_MAX_HEIGHT) || (surface->stride < surface->height)){
+		return -1;
+	}
+	renderFlush();
+	surface_width = (int32_t)surface->width;
+	surface_height = (int32_t)surface->height;
+	stride = (int32_t)surface->stride;
+	clip_top = 0;
+	clip_bottom = surface_width;
+	//The smallest tiles that fit a row of them in a word
+	for(layer_tile_bits = LAYER_TILE_MIN_BITS; ((surface->height - 1) >> layer_tile_bits) >= 32; layer_tile_bits++);
+	layer_tile_rows = (surface->width + (1u << layer_tile_bits) - 1) >> layer_tile_bits;
+	layer_tile_cols = (surface->height + (1u << layer_tile_bits) - 1) >> layer_tile_bits;
+
+	platformDisplayInit();
+	frame_buf_1 = platformFrameBuffer(0);
+	frame_buf_2 = platformFrameBuffer(1);
 	frame_buf = frame_buf_2;
 	active = buffer1;
-	
-  /* Turn display and backlight on */
-  HAL_GPIO_WritePin(GPIOI, GPIO_PIN_12, GPIO_PIN_SET);
-  HAL_GPIO_WritePin(GPIOK, GPIO_PIN_3,  GPIO_PIN_SET);
+	return 0;
+}
 
-	#if(GLCD_LANDSCAPE == 0)
-		stride = GLCD_HEIGHT;
-	#else
-		stride = GLCD_WIDTH;
-	#endif
+/**
+	* @brief Index of the frame buffer being drawn to, as platformFrameBuffer() numbers them. 
+*/
+uint32_t backBufferIndex(void){
+	return (active == buffer1) ? 1 : 0;
+}
+
+/**
+	* @brief Track drawing to the back buffer, if there are layers. 
+*/
+static void trackBackBuffer(void){
+	dirty = background_buf ? dirty_tiles[backBufferIndex()] : NULL;
 }
 
 /**
 	*@brief Switchs the front and back frame buffers
-	*Points the LTDC's front buffer start address to the back buffer
-	*then sets the active frame buffer pointer to the new back buffer. 
-	*Finally, it waits for the LCD panel's vertical synchronisation signal. 
-	*This is necessary because the LCD only switches frame buffers once it's finished drawing the current frame. 
+	*Shows the back buffer, then sets the active frame buffer pointer to the new back buffer. 
+	*The platform waits for the LCD panel's vertical synchronisation signal before returning, 
+	*as the LCD only switches frame buffers once it's finished drawing the current frame. 
 	*Otherwise, switching buffer then immediately writing to the buffer would change the front buffer. 
 */
 void switchBuffer(void){
+	renderFlush();
 	if(active == buffer1){
-		HAL_LTDC_SetAddress(&LTDC_Handle, Buffer2_address, 0);
+		platformPresent(1);
 		frame_buf = frame_buf_1;
 		active = buffer2;
 	}
 	else{
-		HAL_LTDC_SetAddress(&LTDC_Handle, Buffer1_address, 0);
+		platformPresent(0);
 		frame_buf = frame_buf_2;
 		active = buffer1;
 	}
-	while(!(LTDC_Handle.Instance->CDSR & LTDC_CDSR_VSYNCS));
+	trackBackBuffer();
 }
 
 void setBuffer(enum framebuffer buff){
+	renderFlush();
 	if(buff == buffer1){
-		HAL_LTDC_SetAddress(&LTDC_Handle, Buffer1_address, 0);
+		platformPresent(0);
 		frame_buf = frame_buf_2;
 		active = buffer1;
 	}
 	else{
-		HAL_LTDC_SetAddress(&LTDC_Handle, Buffer2_address, 0);
+		platformPresent(1);
 		frame_buf = frame_buf_1;
 		active = buffer2;
 	}
-	while(!(LTDC_Handle.Instance->CDSR & LTDC_CDSR_VSYNCS));
+	trackBackBuffer();
+}
+
+#if(RENDER_THREADS != 0)
+/**
+	* @brief Draw a recorded call, clipped to the band being drawn. 
+*/
+static void replayCommand(const renderCommand* c){
+	uint32_t n = (uint32_t)c->arg[0];
+	const uint8_t* data = (const uint8_t*)c->data;
+	switch(c->type){
+		case commandBackground: setBackgroundColor((uint16_t)c->arg[0]); break;
+		case commandForeground: setForegroundColor((uint16_t)c->arg[0]); break;
+		case commandGamma: setBlendGamma((uint8_t)c->arg[0]); break;
+		case commandClear: clearScreen(); break;
+		case commandClearStars: clearScreenStars((const uint16_t*)(data + (n * 6)), (const uint32_t*)data, (const uint16_t*)(data + (n * 4))); break;
+		case commandBlend: blendPixel((uint32_t)c->arg[0], (uint32_t)c->arg[1], (uint8_t)c->arg[2]); break;
+		case commandBlendFast: blendPixelFast((uint32_t)c->arg[0], (uint32_t)c->arg[1], (uint8_t)c->arg[2]); break;
+		case commandBlendRamp: blendPixelRamp((uint32_t)c->arg[0], (uint32_t)c->arg[1], (uint8_t)c->arg[2]); break;
+		case commandLine: drawLine((uint32_t)c->arg[0], (uint32_t)c->arg[1], (uint32_t)c->arg[2], (uint32_t)c->arg[3]); break;
+		case commandThickLine: 
+			drawThickLine((uint32_t)c->arg[0], (uint32_t)c->arg[1], (uint32_t)c->arg[2], (uint32_t)c->arg[3], (uint32_t)c->arg[4]); 
+			break;
+		case commandCircle: drawFilledCircle(c->arg[0], c->arg[1], c->arg[2]); break;
+		case commandCircleAA: drawFilledCircleAA(c->arg[0], c->arg[1], c->arg[2]); break;
+		case commandPolygons: fillPolygons((const polygon*)data, n); break;
+		case commandSplats: 
+			drawSplats((const int32_t*)data, (const int32_t*)(data + (n * 4)), (const uint16_t*)(data + (n * 8)), 
+				(const uint16_t*)(data + (n * 10)), n, (uint32_t)c->arg[1]); 
+			break;
+		case commandRectangle: fillRectangle((uint32_t)c->arg[0], (uint32_t)c->arg[1], (uint32_t)c->arg[2], (uint32_t)c->arg[3]); break;
+		case commandHLine: GLCD_DrawHLine((uint32_t)c->arg[0], (uint32_t)c->arg[1], (uint32_t)c->arg[2]); break;
+		case commandVLine: GLCD_DrawVLine((uint32_t)c->arg[0], (uint32_t)c->arg[1], (uint32_t)c->arg[2]); break;
+		case commandChar: GLCD_DrawChar((uint32_t)c->arg[0], (uint32_t)c->arg[1], c->arg[2]); break;
+	}
+}
+
+/**
+	* @brief Take bands until there are none left, drawing on each every recorded call that may touch it, in order, 
+	* from the drawing state the first was recorded in. Run by every thread drawing. 
+*/
+static void drawBands(void){
+	uint32_t band, i;
+	while((band = atomic_fetch_add(&next_band, 1)) < RENDER_BANDS){
+		clip_top = (int32_t)(band << layer_tile_bits);
+		clip_bottom = (clip_top + (1 << layer_tile_bits) > surface_width) ? surface_width : clip_top + (1 << layer_tile_bits);
+		ramp_stale |= (foreground_color != batch_foreground);
+		foreground_color = batch_foreground;
+		background_color = batch_background;
+		if(blend_gamma != batch_gamma){
+			setBlendGamma(batch_gamma);
+		}
+		dirty = batch_dirty;
+		for(i = 0; i < command_count; i++){
+			if((commands[i].top < clip_bottom) && (commands[i].bottom >= clip_top)){
+				replayCommand(&commands[i]);
+			}
+		}
+	}
+	clip_top = 0;
+	clip_bottom = surface_width;
+}
+
+/**
+	* @brief A thread drawing bands alongside the recording one, index counting from 0. Sleeps until a batch is 
+	* handed out, and sits it out if setRenderThreads() has since left it spare. 
+*/
+static void* bandThread(void* arg){
+	uint32_t index = (uint32_t)(uintptr_t)arg, seen = 0;
+	pthread_mutex_lock(&band_lock);
+	for(;;){
+		while(band_batch == seen){
+			pthread_cond_wait(&band_wake, &band_lock);
+		}
+		seen = band_batch;
+		if(index + 1 < thread_count){
+			pthread_mutex_unlock(&band_lock);
+			drawBands();
+			pthread_mutex_lock(&band_lock);
+			if(--threads_busy == 0){
+				pthread_cond_signal(&band_done);
+			}
+		}
+	}
+	return NULL;
+}
+#endif
+
+/**
+	* @brief Draw frames with count threads, in bands of frame buffer rows, on builds with RENDER_THREADS; at most 
+	* RENDER_THREADS. From here drawing calls are recorded, and drawn at the latest when the buffers are switched, 
+	* or anything else reads or changes the frame buffers as a whole: each thread takes a band at a time and draws 
+	* every call that may touch it, cut to the band. The frame drawn is the same, bit for bit, as drawing each call as 
+	* it is made, which a count of 0 or 1 goes back to, as one thread only pays for the recording. Arrays passed to 
+	* drawing calls are copied, so they can change straight after. Calls that work on the whole frame, like 
+	* clearSprites(), drawStars() and the glow, are drawn there and then, after everything recorded before them. 
+*/
+void setRenderThreads(uint32_t count){
+	#if(RENDER_THREADS != 0)
+	renderFlush();
+	count = (count > RENDER_THREADS) ? RENDER_THREADS : count;
+	while(threads_started + 1 < count){
+		if(pthread_create(&band_threads[threads_started], NULL, bandThread, (void*)(uintptr_t)threads_started) != 0){
+			count = threads_started + 1;
+			break;
+		}
+		threads_started++;
+	}
+	pthread_mutex_lock(&band_lock);
+	thread_count = count;
+	pthread_mutex_unlock(&band_lock);
+	recording = (count > 1);
+	#else
+	(void)count;
+	#endif
+}
+
+/**
+	* @brief Draw everything recorded since the last time, in bands, and wait for all of it. 
+	* Nothing to do unless setRenderThreads() has turned recording on. 
+*/
+void renderFlush(void){
+	#if(RENDER_THREADS != 0)
+	if(command_count == 0){
+		return;
+	}
+	recording = 0;
+	pthread_mutex_lock(&band_lock);
+	atomic_store(&next_band, 0);
+	threads_busy = thread_count - 1;
+	band_batch++;
+	pthread_cond_broadcast(&band_wake);
+	pthread_mutex_unlock(&band_lock);
+	drawBands();
+	pthread_mutex_lock(&band_lock);
+	while(threads_busy != 0){
+		pthread_cond_wait(&band_done, &band_lock);
+	}
+	pthread_mutex_unlock(&band_lock);
+	command_count = 0;
+	arena_used = 0;
+	recording = 1;
+	#endif
+}
+
+/**
+	* @brief Mark the tiles under frame buffer rows row0 to row1 and columns col0 to col1, inclusive, as drawn on. 
+	* Clipped to the screen, and to the band being drawn. 
+*/
+static void markDirty(int32_t row0, int32_t row1, int32_t col0, int32_t col1){
+	uint32_t mask;
+	if(dirty == NULL){
+		return;
+	}
+	row0 = (row0 < clip_top) ? clip_top : row0;
+	col0 = (col0 < 0) ? 0 : col0;
+	row1 = (row1 >= clip_bottom) ? clip_bottom - 1 : row1;
+	col1 = (col1 >= surface_height) ? surface_height - 1 : col1;
+	if((row0 > row1) || (col0 > col1)){
+		return;
+	}
+	mask = (2u << (col1 >> layer_tile_bits)) - (1u << (col0 >> layer_tile_bits));
+	for(row0 >>= layer_tile_bits; row0 <= (row1 >> layer_tile_bits); row0++){
+		dirty[row0] |= mask;
+	}
+}
+
+/**
+	* @brief Split the display into a static background layer and a sprite layer over it, the double buffered 
+	* frame buffers. Sprite pixels of key colour show the background through. The platform composites the two. 
+	* From here on each frame buffer only clears what was drawn on it, with clearSprites(). key is RGB565. 
+*/
+void GLCD_InitializeLayers(pixel* background, uint16_t key){
+	renderFlush();
+	background_buf = background;
+	key_color = PIXEL_FROM_565(key);
+	invalidateSprites();
+	trackBackBuffer();
+}
+
+/**
+	* @brief Send drawing to the background layer, until drawToSprites(). Nothing drawn there is tracked. 
+*/
+void drawToBackground(void){
+	renderFlush();
+	frame_buf = background_buf;
+	dirty = NULL;
+}
+
+/**
+	* @brief Send drawing back to the sprite layer's back buffer. 
+*/
+void drawToSprites(void){
+	renderFlush();
+	frame_buf = (active == buffer1) ? frame_buf_2 : frame_buf_1;
+	trackBackBuffer();
+}
+
+/**
+	* @brief Mark every tile of both sprite buffers as drawn on, so each is wholly cleared the next time. 
+*/
+void invalidateSprites(void){
+	uint32_t i;
+	renderFlush();
+	for(i = 0; i < layer_tile_rows; i++){
+		dirty_tiles[0][i] = 0xFFFFFFFFu >> (32 - layer_tile_cols);
+		dirty_tiles[1][i] = 0xFFFFFFFFu >> (32 - layer_tile_cols);
+	}
+}
+
+/**
+	* @brief Clear the tiles of the sprite back buffer drawn on since it was last cleared to the key colour. 
+	* Runs of tiles along a row are cleared together. Returns the pixels written. 
+*/
+uint32_t clearSprites(void){
+	uint32_t t, first, last, row, rows, end, col, written = 0;
+	uint32_t* tiles = dirty_tiles[backBufferIndex()];
+	uint32_t bits = layer_tile_bits;
+	pixel key = key_color;
+	pixel* line;
+
+	renderFlush();
+	for(t = 0; t < layer_tile_rows; t++){
+		//The last row of tiles may be cut short by the screen's edge
+		rows = (((t + 1) << bits) > (uint32_t)surface_width) ? (uint32_t)surface_width - (t << bits) : (1u << bits);
+		first = 0;
+		while((first < layer_tile_cols) && (tiles[t] >> first)){
+			//Next run of set bits
+			while(!((tiles[t] >> first) & 1)){
+				first++;
+			}
+			for(last = first; (last < layer_tile_cols) && ((tiles[t] >> last) & 1); last++);
+			end = last << bits;
+			end = (end > (uint32_t)surface_height) ? (uint32_t)surface_height : end;
+			for(row = t << bits; row < (t << bits) + rows; row++){
+				line = &frame_buf[row * stride];
+				for(col = first << bits; col < end; col++){
+					line[col] = key;
+				}
+			}
+			written += (end - (first << bits)) * rows;
+			first = last;
+		}
+		tiles[t] = 0;
+	}
+	return written;
+}
+
+/**
+	* @brief Draws a starfield onto the sprite layer, as clearScreenStars() does onto a single layer. 
+	* Stars aren't tracked by tile, as they cover the whole screen; instead each erases itself. drawn holds the 
+	* frame buffer index each star was drawn at the last time in this buffer, from backBufferIndex(), and is updated. 
+*/
+void drawStars(const uint16_t* columnStarts, const uint32_t* y, const uint16_t* color, uint32_t* drawn){
+	uint32_t x, i, end, dot;
+	uint32_t width = (uint32_t)surface_width, height = (uint32_t)surface_height;
+	uint32_t count = columnStarts[width];
+	pixel key = key_color;
+
+	renderFlush();
+	for(i = 0; i < count; i++){
+		frame_buf[drawn[i]] = key;
+	}
+	#if(GLCD_LANDSCAPE == 0)
+	for(x = 0; x < width; x++){
+		end = columnStarts[x + 1];
+		for(i = columnStarts[x]; i < end; i++){
+			dot = ((width - 1 - x) * stride) + (height - 1) - (((y[i] >> 16) * height) >> 16);
+			frame_buf[dot] = PIXEL_FROM_565(color[i]);
+			drawn[i] = dot;
+		}
+	}
+	#endif
+}
+
+/**
+	* @brief Software stand-in for the display controller's second layer: writes a screen of sprites over background 
+	* to out, with sprite pixels of the key colour showing the background. For hosts, or a panel without layers. 
+	* The select is done with masks rather than a branch, so it doesn't mispredict along the edges of sprites. Each 
+	* line is built in a local buffer the compiler knows nothing else points to, so it vectorises it, then copied out. 
+	* All three are laid out as the surface is; key is RGB565. 
+*/
+void compositeLayers(pixel* out, const pixel* sprites, const pixel* background, uint16_t key){
+	uint32_t row, i;
+	uint32_t height = (uint32_t)surface_height;
+	pixel s, keyed, k = PIXEL_FROM_565(key);
+	pixel line[RENDER_MAX_HEIGHT];
+	renderFlush();
+	for(row = 0; row < (uint32_t)surface_width; row++){
+		for(i = 0; i < height; i++){
+			s = sprites[i];
+			keyed = (pixel)-(pixel)(s == k);
+			line[i] = (pixel)((s & ~keyed) | (background[i] & keyed));
+		}
+		memcpy(out, line, height * sizeof(pixel));
+		out += stride;
+		sprites += stride;
+		background += stride;
+	}
 }
 
 void clearScreen (void) {
-  uint32_t  i;
-  for (i = 0; i < (GLCD_WIDTH * GLCD_HEIGHT); i++) {
-    frame_buf[i] = background_color;
+  uint32_t  row, i;
+  uint32_t  height = (uint32_t)surface_height;
+  pixel     bg = background_color;
+  pixel*    line;
+#if(RENDER_THREADS != 0)
+  if (recording) {
+    recordCommand(commandClear, 0, surface_width - 1, 0);
+    return;
+  }
+#endif
+  for (row = (uint32_t)clip_top; row < (uint32_t)clip_bottom; row++) {
+    line = &frame_buf[row * stride];
+    for (i = 0; i < height; i++) {
+      line[i] = bg;
+    }
   }
 }
 
+/**
+	* @brief Clears the screen to the background colour with a starfield on it, in one pass over the frame buffer. 
+	* Stars are sorted by game x: columnStarts[x] is the first star at x, with an entry for each of the surface's width 
+	* and one more, and y is each star's height as a fraction of the screen in 0.32 fixed point. Colours are RGB565. 
+	* Game x is a frame buffer row, so each row's stars are plotted straight after it is cleared, and no pixel is 
+	* fetched twice. 
+*/
+void clearScreenStars(const uint16_t* columnStarts, const uint32_t* y, const uint16_t* color){
+	uint32_t row, i, end;
+	uint32_t width = (uint32_t)surface_width, height = (uint32_t)surface_height;
+	pixel* line;
+	pixel bg = background_color;
+	#if(RENDER_THREADS != 0)
+	renderCommand* c;
+	uint32_t count = columnStarts[width];
+	uint8_t* data;
+	if(recording && ((c = recordCommand(commandClearStars, 0, surface_width - 1, count * 6 + (width + 1) * 2)) != NULL)){
+		data = (uint8_t*)c->data;
+		memcpy(data, y, count * 4);
+		memcpy(data + count * 4, color, count * 2);
+		memcpy(data + count * 6, columnStarts, (width + 1) * 2);
+		c->arg[0] = (int32_t)count;
+		return;
+	}
+	#endif
+
+	#if(GLCD_LANDSCAPE == 0)
+	for(row = (uint32_t)clip_top; row < (uint32_t)clip_bottom; row++){
+		line = &frame_buf[row * stride];
+		for(i = 0; i < height; i++){
+			line[i] = bg;
+		}
+		//Row 0 is the right hand edge of the screen, the last game x
+		end = columnStarts[width - row];
+		for(i = columnStarts[width - 1 - row]; i < end; i++){
+			line[(height - 1) - (((y[i] >> 16) * height) >> 16)] = PIXEL_FROM_565(color[i]);
+		}
+	}
+	#endif
+}
+
 void setBackgroundColor(uint16_t color){
-	background_color = color;
+	#if(RENDER_THREADS != 0)
+	if(recording){
+		recordCommand(commandBackground, 0, surface_width - 1, 0)->arg[0] = color;
+	}
+	#endif
+	background_color = PIXEL_FROM_565(color);
+}
+
+/**
+	* @brief Spread a pixel's colour into ramp lanes, decoded to linear light when blending with gamma. 
+*/
+static uint64_t rampLanes(pixel color){
+	if(blend_gamma){
+		return (uint64_t)GAMMA_DECODE_RB[PIXEL_BLUE(color)] | ((uint64_t)GAMMA_DECODE_RB[PIXEL_RED(color)] << RAMP_LANE) | 
+			((uint64_t)GAMMA_DECODE_G[PIXEL_GREEN(color)] << (2 * RAMP_LANE));
+	}
+	return (uint64_t)PIXEL_BLUE(color) | ((uint64_t)PIXEL_RED(color) << RAMP_LANE) | ((uint64_t)PIXEL_GREEN(color) << (2 * RAMP_LANE));
+}
+
+/**
+	* @brief Back from ramp lanes weighted to a total of 256 to a pixel, encoding linear light when blending with gamma. 
+*/
+static pixel rampColor(uint64_t lanes){
+	uint32_t b, r, g;
+	b = (uint32_t)(lanes >> 8) & RAMP_VALUE_MASK;
+	r = (uint32_t)(lanes >> (RAMP_LANE + 8)) & RAMP_VALUE_MASK;
+	g = (uint32_t)(lanes >> ((2 * RAMP_LANE) + 8));
+	if(blend_gamma){
+		return PIXEL_RGB((uint32_t)GAMMA_ENCODE_RB[r], (uint32_t)GAMMA_ENCODE_G[g], (uint32_t)GAMMA_ENCODE_RB[b]);
+	}
+	return PIXEL_RGB(r, g, b);
+}
+
+/**
+	* @brief Rebuild the blend ramps for foreground_color. Alpha a weighs a + (a >> 7) out of 256, so 255 is opaque. 
+	* Run by the drawing that blends, the first time after the colour changes, so text and fills don't pay for it. 
+*/
+static void buildBlendRamp(void){
+	uint32_t a;
+	uint64_t fg = rampLanes(foreground_color);
+	for(a = 0; a < 256; a++){
+		blend_ramp[a] = (fg * (a + (a >> 7))) + RAMP_ROUND;
+		blend_over_black[a] = rampColor(blend_ramp[a]);
+	}
+	ramp_stale = 0;
 }
+
+/**
+	* @brief Blend foreground_color onto a frame buffer pixel from the ramps; the body of blendPixelRamp(). 
+	* The foreground's share comes from the table, so only the background's is multiplied, all three channels in 
+	* one go; over black, the commonest background, the result is looked up outright. Keeps all 8 bits of alpha. 
+	* The ramps must be up to date. 
+*/
+static void blendDotRamp(pixel* dot, uint8_t alpha){
+	uint32_t bg = *dot, b, r, g;
+	uint64_t lanes;
+	if(bg == PIXEL_FROM_565(GLCD_COLOR_BLACK)){
+		*dot = blend_over_black[alpha];
+		return;
+	}
+	//rampLanes(), blend, then rampColor(), written out so it all stays in registers
+	b = PIXEL_BLUE(bg);
+	r = PIXEL_RED(bg);
+	g = PIXEL_GREEN(bg);
+	if(blend_gamma){
+		b = GAMMA_DECODE_RB[b];
+		r = GAMMA_DECODE_RB[r];
+		g = GAMMA_DECODE_G[g];
+	}
+	lanes = blend_ramp[alpha] + (((uint64_t)b | ((uint64_t)r << RAMP_LANE) | ((uint64_t)g << (2 * RAMP_LANE))) * (uint32_t)(256 - alpha - (alpha >> 7)));
+	b = (uint32_t)(lanes >> 8) & RAMP_VALUE_MASK;
+	r = (uint32_t)(lanes >> (RAMP_LANE + 8)) & RAMP_VALUE_MASK;
+	g = (uint32_t)(lanes >> ((2 * RAMP_LANE) + 8));
+	if(blend_gamma){
+		b = GAMMA_ENCODE_RB[b];
+		r = GAMMA_ENCODE_RB[r];
+		g = GAMMA_ENCODE_G[g];
+	}
+	*dot = PIXEL_RGB(r, g, b);
+}
+
+/**
+	* @brief Draw in color, RGB565 whatever the frame buffers' format, as every colour passed to drawing is. 
+*/
 void setForegroundColor(uint16_t color){
-	foreground_color = color;
+	#if(RENDER_THREADS != 0)
+	if(recording){
+		recordCommand(commandForeground, 0, surface_width - 1, 0)->arg[0] = color;
+	}
+	#endif
+	ramp_stale |= (PIXEL_FROM_565(color) != foreground_color);
+	foreground_color = PIXEL_FROM_565(color);
+}
+
+/**
+	* @brief Blend in linear light, so a half covered edge looks half as bright, if enabled is nonzero; else blend 
+	* the pixel values as they are, as blendPixel() does. Applies to blendPixelRamp() and thick lines. 
+*/
+void setBlendGamma(uint8_t enabled){
+	#if(RENDER_THREADS != 0)
+	if(recording){
+		recordCommand(commandGamma, 0, surface_width - 1, 0)->arg[0] = enabled;
+	}
+	#endif
+	blend_gamma = enabled ? 1 : 0;
+	ramp_stale = 1;
 }
 
 
@@ -270,168 +793,227 @@ void setForegroundColor(uint16_t color){
 */
 int32_t blendPixel(uint32_t x, uint32_t y, uint8_t alpha){
 	uint32_t dot = x + (stride*y);
-	uint16_t bg = frame_buf[dot];
+	uint32_t fg_r, fg_g, fg_b, bg_r, bg_g, bg_b, out_r, out_g, out_b;
+	pixel bg;
+	#if(RENDER_THREADS != 0)
+	renderCommand* c;
+	if(recording){
+		c = recordCommand(commandBlend, (int32_t)y, (int32_t)y, 0);
+		c->arg[0] = (int32_t)x; c->arg[1] = (int32_t)y; c->arg[2] = alpha;
+		return 0;
+	}
+	#endif
+	bg = frame_buf[dot];
 	
 	//split foreground and background into rgb components
-	uint16_t fg_r = foreground_color >> 11;
-	uint16_t fg_g = (foreground_color >> 5) & ((1u << 6) - 1);
-	uint16_t fg_b = foreground_color & ((1u << 5) - 1);
+	fg_r = PIXEL_RED(foreground_color);
+	fg_g = PIXEL_GREEN(foreground_color);
+	fg_b = PIXEL_BLUE(foreground_color);
 	
-  uint16_t bg_r = bg >> 11;
-  uint16_t bg_g = (bg >> 5) & ((1u << 6) - 1);
-  uint16_t bg_b = bg & ((1u << 5) - 1);
+  bg_r = PIXEL_RED(bg);
+  bg_g = PIXEL_GREEN(bg);
+  bg_b = PIXEL_BLUE(bg);
 	
-  uint16_t out_r = (fg_r * alpha + bg_r * (255 - alpha)) / 255;
-  uint16_t out_g = (fg_g * alpha + bg_g * (255 - alpha)) / 255;
-  uint16_t out_b = (fg_b * alpha + bg_b * (255 - alpha)) / 255;
+  out_r = (fg_r * alpha + bg_r * (255 - alpha)) / 255;
+  out_g = (fg_g * alpha + bg_g * (255 - alpha)) / 255;
+  out_b = (fg_b * alpha + bg_b * (255 - alpha)) / 255;
 	
-	uint16_t out = ((out_r << 11) | (out_g << 5) | out_b);
-	frame_buf[dot] = out;
+	frame_buf[dot] = PIXEL_RGB(out_r, out_g, out_b);
 	return 0;
 }
 
 /**
-	* @brief Linear interpolation of foreground_color onto specified pixel. A faster version of blendPixel(). 
-	* Hardcoded for GLCD_LANDSCAPE = 0. Carefully note how dot is calculated; it is not the same as GLCD_DrawPixel(). 
+	* @brief Linear interpolation of foreground_color onto specified pixel, from per colour tables. 
+	* More precise than blendPixelFast(), and cheaper than blendPixel(); see blendDotRamp() for how. 
+	* Hardcoded for GLCD_LANDSCAPE = 0, with dot calculated as in blendPixel(). 
+*/
+int32_t blendPixelRamp(uint32_t x, uint32_t y, uint8_t alpha){
+	#if(RENDER_THREADS != 0)
+	renderCommand* c;
+	if(recording){
+		c = recordCommand(commandBlendRamp, (int32_t)y, (int32_t)y, 0);
+		c->arg[0] = (int32_t)x; c->arg[1] = (int32_t)y; c->arg[2] = alpha;
+		return 0;
+	}
+	#endif
+	if(ramp_stale){
+		buildBlendRamp();
+	}
+	blendDotRamp(&frame_buf[x + (stride * y)], alpha);
+	return 0;
+}
+
+/**
+	* @brief Blend a colour onto a frame buffer pixel; the body of blendPixelFast(). 
+	* fg is the colour already spread by SPREAD_PIXEL(), so a caller drawing many pixels does it once. 
 	* Avoids doing three multiplications and divisions by doing a parallel multiply, at the cost of a little bit of precision. 
 	* The produced colour may be slightly inaccurate. This is imperceptible, and therefore acceptable. 
 */
+static void blendDot(pixel* dot, spreadPixel fg, uint8_t alpha){
+	spreadPixel bg, out;
+	uint32_t weight;
+	
+	//convert alpha to a weight out of 2^BLEND_SHIFT; 5 bits plus one for RGB565, from the flash ramp. 
+	weight = BLEND_WEIGHT(alpha);
+	
+	//expand to the spread channels, with 0s padding. 
+	bg = SPREAD_PIXEL(*dot);
+	
+	//apply interpolation formula. The weights are 0-2^BLEND_SHIFT instead of 0-1
+	//Shift right in place of the division. 
+	//bg + (alpha * (fg - bg)), the same as (alpha * fg) + ((1-alpha) * bg) with one multiply. A channel's difference 
+	//borrows from the one above, but its fraction lands in the gap below that one and the borrow is undone by adding bg. 
+	out = bg + (((fg - bg) * weight) >> BLEND_SHIFT);
+	//mask out fractional results
+	out &= SPREAD_MASK;
+	//Revert to the pixel; for RGB565, shifting right 16 put R and B in the least
+	//significant 16 bits. Then, just mask the green part into the middle. 
+	*dot = UNSPREAD_PIXEL(out) | PIXEL_OPAQUE;
+}
+
+/**
+	* @brief Linear interpolation of foreground_color onto specified pixel. A faster version of blendPixel(). 
+	* Hardcoded for GLCD_LANDSCAPE = 0. Carefully note how dot is calculated; it is not the same as GLCD_DrawPixel(). 
+	* See blendDot() for how. 
+*/
 int32_t blendPixelFast(uint32_t x, uint32_t y, uint8_t alpha){
 	uint32_t dot = x + (stride*y);
-
-	uint32_t bg = (uint32_t)frame_buf[dot];
-	uint32_t fg = (uint32_t)foreground_color;
-	uint32_t out;
-	uint8_t beta;
-	
+	#if(RENDER_THREADS != 0)
+	renderCommand* c;
+	if(recording){
+		c = recordCommand(commandBlendFast, (int32_t)y, (int32_t)y, 0);
+		c->arg[0] = (int32_t)x; c->arg[1] = (int32_t)y; c->arg[2] = alpha;
+		return 0;
+	}
+	#endif
 	if(alpha == 255){
 		frame_buf[dot] = foreground_color;
 		return 0;
 	}
-	//convert alpha to 5-bit and add one. 
-	alpha = (alpha+4) >> 3;
-	//such that alpha + beta is full opacity.
-	beta = 32 - alpha;
-	
-	//expand RGB565 to GRB655, with 5/5/6 0s padding. 
-	bg = (bg | (bg << 16)) & 0x7E0F81F;
-	fg = (fg | (fg << 16)) & 0x7E0F81F;
-	
-	//apply interpolation formula. Alpha is 0-32 instead of 0-1
-	//Shift right 5 in place of division by 32. 
-	//(alpha * fg) + ((1-alpha) * bg)
-	out = ((alpha * fg) + (beta * bg)) >> 5;
-	//mask out fractional results
-	out &= 0x7E0F81F;
-	//Revert to RGB565; shifting right 16 put R and B in the least
-	//significant 16 bits. Then, just mask the green part into the middle. 
-	frame_buf[dot] = (uint16_t)((out >> 16) | out);
+	blendDot(&frame_buf[dot], SPREAD_PIXEL(foreground_color), alpha);
 	return 0;
 }
 
 /**
-	* @brief Xiaolin Wu algorithm, draws an anti-aliased line from (x0,y0) to (x1,y1). 
-	* Implemented using purely integer math. Uses fixed-point unsigned integers in their place. 
-	* If x0, y0, x1 or y1 are off the screen, it will either segfault or write outside of the frame buffer. 
+	* @brief Xiaolin Wu algorithm in frame buffer coordinates, with the ends in subpixels. 
+	* Steps one pixel at a time along the line's longer axis, sampling at pixel centres from the first end up to the second, 
+	* and splits each step between the two pixels either side of the line by how close it passes. 
+	* Implemented using purely integer math, 16.16 fixed point along the shorter axis. Pixels off the screen, or 
+	* outside the band being drawn, are skipped; the first pixel's position is worked out afresh, so the rest land 
+	* just where they would unclipped. fg is the colour spread by SPREAD_PIXEL(). 
 */
-void drawLine(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1){
-	int32_t temp, dX, dY, xDir;
-	uint32_t gradient, subPixel;
+static void wuLine(int32_t row0, int32_t col0, int32_t row1, int32_t col1, spreadPixel fg){
+	int32_t temp, major0, major1, minor0, minor1, first, end, limit, low, high, i, gradient, base, pos, k;
 	uint8_t alpha;
-
-	#if(GLCD_LANDSCAPE == 0)
-		temp = y0; y0 = GLCD_WIDTH - x0; x0 = temp;
-		temp = y1; y1 = GLCD_WIDTH - x1; x1 = temp;
-	#endif
-	
-	//Line must be top to bottom
-	if(y1 < y0){
-		temp = y0; y0 = y1; y1 = temp;
-		temp = x0; x0 = x1; x1 = temp;
+	int32_t dRow = (row1 > row0) ? row1 - row0 : row0 - row1;
+	int32_t dCol = (col1 > col0) ? col1 - col0 : col0 - col1;
+
+	//Step along columns for lines nearer a row, else along rows
+	//limit is the end of the major axis, and low to high the pixels allowed along the minor
+	if(dCol >= dRow){
+		major0 = col0; major1 = col1; minor0 = row0; minor1 = row1;
+		first = 0; limit = surface_height; low = clip_top; high = clip_bottom;
 	}
-	//draw the ends of the line
-	frame_buf[x0 + (y0 * stride)] = foreground_color;
-	frame_buf[x1 + (y1 * GLCD_WIDTH)] = foreground_color;
-	
-	dX = x1 - x0;
-	dY = y1 - y0;
-	
-	if(dX >= 0){ xDir = 1;}
-	else{ xDir = -1; dX = -dX;}
-	
-	if(dY == 0){
-		while((dX+=xDir)){
-			frame_buf[x0+(y0*stride)] = foreground_color;
-			x0+=xDir;
-		}
-		return;
+	else{
+		major0 = row0; major1 = row1; minor0 = col0; minor1 = col1;
+		first = clip_top; limit = clip_bottom; low = 0; high = surface_height;
 	}
-	if(dX == 0){
-		while(dY--){
-			frame_buf[x0+(y0*stride)] = foreground_color;
-			y0++;
-		}
+	if(major1 < major0){
+		temp = major0; major0 = major1; major1 = temp;
+		temp = minor0; minor0 = minor1; minor1 = temp;
+	}
+	if(major1 == major0){
 		return;
 	}
+	//Pixels whose centres are from the first end up to the second
+	temp = (major0 + (1 << (CIRCLE_SUBPIXEL_BITS - 1)) - 1) >> CIRCLE_SUBPIXEL_BITS;
+	end = (major1 + (1 << (CIRCLE_SUBPIXEL_BITS - 1)) - 1) >> CIRCLE_SUBPIXEL_BITS;
+	if(temp > first){first = temp;}
+	if(end > limit){end = limit;}
 	
-	subPixel = 0;
-	
-	if(dY > dX){
-		//(1/gradient) * 65536
-		//Reciprocal of gradient, with fixed-point at 16 bits. 
-		gradient = (dX << 16) / dY;
-		while(--dY){
-			subPixel += gradient;
-			//When subPixel overflows to a whole pixel, step the whole pixel. 
-			if(subPixel >= (2<<15)){
-				x0+=xDir;
-				subPixel -= (2<<15);
+	//gradient * 65536; the product is 64-bit for surfaces 2048 or more pixels across
+	gradient = (int32_t)(((int64_t)(minor1 - minor0) * 65536) / (major1 - major0));
+	//Where the line crosses the first pixel centre, less half a pixel, so the integer part is the nearer pixel above
+	base = (minor0 * (65536 >> CIRCLE_SUBPIXEL_BITS)) - 32768;
+	pos = base + (int32_t)(((int64_t)gradient * ((first << CIRCLE_SUBPIXEL_BITS) + (1 << (CIRCLE_SUBPIXEL_BITS - 1)) - major0)) >> CIRCLE_SUBPIXEL_BITS);
+	//A line along the rows may cross the band for only part of its length: start a pixel or two before, and end after
+	if((dCol >= dRow) && ((low > 0) || (high < surface_width))){
+		if(gradient == 0){
+			end = (((pos >> 16) + 1 < low) || ((pos >> 16) >= high)) ? first : end;
+		}
+		else{
+			temp = first + (int32_t)(((((int64_t)low - 1) << 16) - pos) / gradient);
+			k = first + (int32_t)((((int64_t)high << 16) - pos) / gradient);
+			if(temp > k){
+				i = temp; temp = k; k = i;
+			}
+			if(k + 2 < end){
+				end = k + 2;
+			}
+			if(temp - 1 > first){
+				first = temp - 1;
+				pos = base + (int32_t)(((int64_t)gradient * ((first << CIRCLE_SUBPIXEL_BITS) + (1 << (CIRCLE_SUBPIXEL_BITS - 1)) - major0)) >> CIRCLE_SUBPIXEL_BITS);
 			}
-			y0++;
-			
-			alpha = (uint8_t)((subPixel >> 8) & 0xFF);
-			
-			blendPixelFast(x0, y0, alpha);
-			blendPixelFast(x0-xDir, y0, alpha^255);
 		}
 	}
-	else{
-		//Same as other case, but iterate over x axis. 
-		//gradient * 65536
-		gradient = (dY << 16) / dX;
-		while(--dX){
-			subPixel += gradient;
-			if(subPixel >= 65536){
-				y0++;
-				subPixel -= 65536;
-			}
-			x0 += xDir;
-			alpha = (uint8_t)((subPixel >> 8) & 0xFF);
-			
-			blendPixel(x0,y0, alpha);
-			blendPixel(x0,y0+1, alpha^0xFF);
+	for(i = first; i < end; i++, pos += gradient){
+		k = pos >> 16;
+		alpha = (uint8_t)((pos >> 8) & 0xFF);
+		if((k >= low) && (k < high)){
+			blendDot((dCol >= dRow) ? &frame_buf[(stride * k) + i] : &frame_buf[(stride * i) + k], fg, alpha ^ 0xFF);
+		}
+		if((k + 1 >= low) && (k + 1 < high)){
+			blendDot((dCol >= dRow) ? &frame_buf[(stride * (k + 1)) + i] : &frame_buf[(stride * i) + k + 1], fg, alpha);
 		}
 	}
-	return;
+}
+
+/**
+	* @brief Xiaolin Wu algorithm, draws an anti-aliased line from (x0,y0) to (x1,y1), through wuLine(). 
+	* Hardcoded for GLCD_LANDSCAPE = 0. Pixels off the screen are skipped. 
+*/
+void drawLine(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1){
+	#if(RENDER_THREADS != 0)
+	renderCommand* c;
+	if(recording){
+		c = recordCommand(commandLine, surface_width - (int32_t)((x0 > x1) ? x0 : x1) - 1, surface_width - (int32_t)((x0 < x1) ? x0 : x1) + 1, 0);
+		c->arg[0] = (int32_t)x0; c->arg[1] = (int32_t)y0; c->arg[2] = (int32_t)x1; c->arg[3] = (int32_t)y1;
+		return;
+	}
+	#endif
+	markDirty(surface_width - (int32_t)((x0 > x1) ? x0 : x1) - 1, surface_width - (int32_t)((x0 < x1) ? x0 : x1) + 1, 
+		surface_height - (int32_t)((y0 > y1) ? y0 : y1) - 1, surface_height - (int32_t)((y0 < y1) ? y0 : y1) + 1);
+	wuLine(TO_SUBPIXEL(surface_width - (int32_t)x0), TO_SUBPIXEL(surface_height - (int32_t)y0), 
+		TO_SUBPIXEL(surface_width - (int32_t)x1), TO_SUBPIXEL(surface_height - (int32_t)y1), SPREAD_PIXEL(foreground_color));
 }
 
 /**
 	* @brief Xiaolin Wu algorithm, draws an anti-aliased line from (x0,y0) to (x1,y1). Stretches the line to a specified width.
 	* The ends of the line are flat, as strictly speaking the Xiaolin Wu algorithm is not appropriate for this. 
-	* If x0, y0, x1 or y1 are off the screen, it will write outside of the frame buffer. 
-	* If the thickness causes a pixel to go off the screen, it will once again write outside of the frame buffer. 
+	* Pixels off the top or bottom of the screen, or outside the band being drawn, are skipped, but if y0 or y1 
+	* are off the screen, or the thickness takes a pixel off it that way, it will write outside of the frame buffer. 
 	* The thickness is all on one side of the line; which direction this is depends on the gradient. 
 */
 void drawThickLine(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint32_t thickness){
 	int32_t temp, dX, dY, xDir;
 	uint32_t gradient, subPixel;
 	uint8_t alpha;
-	int32_t i;
+	int32_t i, low, high;
+	pixel color = foreground_color;
+	#if(RENDER_THREADS != 0)
+	renderCommand* c;
+	if(recording){
+		c = recordCommand(commandThickLine, surface_width - (int32_t)((x0 > x1) ? x0 : x1) - (int32_t)thickness, 
+			surface_width - (int32_t)((x0 < x1) ? x0 : x1), 0);
+		c->arg[0] = (int32_t)x0; c->arg[1] = (int32_t)y0; c->arg[2] = (int32_t)x1; c->arg[3] = (int32_t)y1; c->arg[4] = (int32_t)thickness;
+		return;
+	}
+	#endif
 
 
 	#if(GLCD_LANDSCAPE == 0)
-		temp = y0; y0 = GLCD_WIDTH-x0; x0 = GLCD_HEIGHT-temp;
-		temp = y1; y1 = GLCD_WIDTH-x1; x1 = GLCD_HEIGHT-temp;
+		temp = y0; y0 = surface_width-x0; x0 = surface_height-temp;
+		temp = y1; y1 = surface_width-x1; x1 = surface_height-temp;
 	#endif
 	
 	
@@ -446,6 +1028,12 @@ void drawThickLine(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint32_t
 	dY = y1 - y0;
 	
 	if((dX == 0) && (dY == 0)){return;}
+	if(ramp_stale){
+		buildBlendRamp();
+	}
+	//Tracked as a whole; the lines drawn are mostly near straight up, so their box is little more than the line
+	markDirty((int32_t)y0 - (int32_t)thickness, (int32_t)y1, ((dX < 0) ? (int32_t)x1 : (int32_t)x0) - (int32_t)thickness, 
+		((dX < 0) ? (int32_t)x0 : (int32_t)x1) + (int32_t)thickness);
 	
 	if(dX >= 0){ 
 	xDir = 1;
@@ -468,15 +1056,18 @@ void drawThickLine(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint32_t
 				subPixel -= (2<<15);
 			}
 			y0++;
+			if(((int32_t)y0 < clip_top) || ((int32_t)y0 >= clip_bottom)){
+				continue;
+			}
 			
 			alpha = (uint8_t)((subPixel >> 8) & 0xFF);
 			
-			blendPixelFast(x0, y0, alpha);
-			blendPixelFast(x0+(xDir*thickness), y0, alpha^255);
+			blendDotRamp(&frame_buf[x0 + (stride * y0)], alpha);
+			blendDotRamp(&frame_buf[x0 + (xDir * thickness) + (stride * y0)], alpha ^ 0xFF);
 			i = xDir*thickness;
 			while(i){
 				i -= xDir;
-				blendPixelFast(x0+i, y0, 0xFF);
+				frame_buf[x0 + i + (stride * y0)] = color;
 			}
 		}
 	}
@@ -492,13 +1083,21 @@ void drawThickLine(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint32_t
 			}
 			x0 += xDir;
 			alpha = (uint8_t)((subPixel >> 8) & 0xFF);
+			//Rows y0 - thickness to y0 are drawn on; fill only those i in the band
+			low = (int32_t)y0 - clip_bottom + 1;
+			high = (int32_t)y0 - clip_top;
 			
-			blendPixel(x0,y0, alpha);
-			blendPixel(x0,y0-thickness, alpha^0xFF);
-			i = thickness;
-			while(i){
+			if((low <= 0) && (high >= 0)){
+				blendDotRamp(&frame_buf[x0 + (stride * y0)], alpha);
+			}
+			if((low <= (int32_t)thickness) && (high >= (int32_t)thickness)){
+				blendDotRamp(&frame_buf[x0 + (stride * (y0 - thickness))], alpha ^ 0xFF);
+			}
+			i = ((int32_t)thickness < high + 1) ? (int32_t)thickness : high + 1;
+			low = (low < 0) ? 0 : low;
+			while(i > low){
 				i--;
-				blendPixelFast(x0, y0-i, 0xFF);
+				frame_buf[x0 + (stride * (y0 - i))] = color;
 			}
 		}
 	}
@@ -511,52 +1110,736 @@ void drawThickLine(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint32_t
 	* Unlikely to work for GLCD_LANDSCAPE == 1. 
 */
 void drawFilledCircle(int32_t origin_x, int32_t origin_y, int32_t radius){
-	int32_t height, rad_y, dot, y;
+	int32_t height, rad_y, dot, y, top, bottom;
 	int32_t y_squared;	int32_t radius_squared = radius * radius;
-	uint32_t buffsize = GLCD_WIDTH * GLCD_HEIGHT;
+	#if(RENDER_THREADS != 0)
+	renderCommand* c;
+	if(recording){
+		c = recordCommand(commandCircle, surface_width - origin_x - radius, surface_width - origin_x + radius, 0);
+		c->arg[0] = origin_x; c->arg[1] = origin_y; c->arg[2] = radius;
+		return;
+	}
+	#endif
 
 	#if(GLCD_LANDSCAPE == 0)
-	origin_y = GLCD_HEIGHT-origin_y;
-	origin_x = GLCD_WIDTH-origin_x;
+	origin_y = surface_height-origin_y;
+	origin_x = surface_width-origin_x;
 	#endif
+	markDirty(origin_x - radius, origin_x + radius, origin_y - radius, origin_y + radius);
 	
 	for(y = -radius; y < radius; y++){
 		rad_y = y + origin_y;
 		//if x is off the right side, end the function. 
-		if((rad_y >= GLCD_HEIGHT) || (rad_y <= 0)){
+		if((rad_y >= surface_height) || (rad_y <= 0)){
 			continue;
 		}
 		y_squared = y * y;
-		height = fastIntSqrt(radius_squared - y_squared);
-		//Iterate in increments of GLCD_WIDTH, to avoid multiplying by it for each pixel.
+		//Half widths of small circles are in flash
+		if(radius <= CIRCLE_TABLE_RADIUS){
+			height = circleSpans[CIRCLE_SPAN_OFFSET(radius) + ((y < 0) ? -y : y)];
+		}
+		else{
+			height = intSqrt(radius_squared - y_squared);
+		}
+		//Rows from origin_x - height up to origin_x + height, cut to the screen and the band being drawn
+		top = (origin_x - height < clip_top) ? clip_top : origin_x - height;
+		bottom = (origin_x + height > clip_bottom) ? clip_bottom : origin_x + height;
+		//Iterate in increments of the stride, to avoid multiplying by it for each pixel.
 		//Add rad_x to the iterator, to avoid adding it for each pixel. Vroom vroom!
-		for(dot = (stride*(origin_x-height)) + rad_y; dot < (stride * (origin_x + height)) + rad_y; dot+=stride){
-			//if the position's off the bottom of the screen, jump up to the bottom. 
-			if(dot < 0){
-				dot += -(dot/stride) * stride;
+		for(dot = (stride * top) + rad_y; dot < (stride * bottom) + rad_y; dot+=stride){
+			frame_buf[dot] = foreground_color;
+		}
+	}
+
+	return;
+}
+/**
+	* @brief Fills pixels col to end of a frame buffer row with color. 
+	* Stores 16 bytes at a time through memcpy(), which the compiler makes one wide store or a few word stores. The first 
+	* and last may be unaligned and overlap the aligned ones between, so there is no loop to reach alignment. Along a row 
+	* this is much quicker than a pixel at a time, which the compiler leaves as it is. 
+*/
+static void fillSpan(pixel* line, int32_t col, int32_t end, pixel color){
+	uint64_t wide[2];
+	uint32_t bits;
+	int32_t first;
+	if(end - col + 1 < FILL_PIXELS){
+		for(; col <= end; col++){
+			line[col] = color;
+		}
+		return;
+	}
+	wide[0] = color;
+	for(bits = 8 * sizeof(pixel); bits < 64; bits *= 2){
+		wide[0] |= wide[0] << bits;
+	}
+	wide[1] = wide[0];
+	memcpy(&line[col], wide, 16);
+	memcpy(&line[end + 1 - FILL_PIXELS], wide, 16);
+	//From the first aligned pixel after col, while a whole store fits
+	first = col + FILL_PIXELS - (int32_t)(((uintptr_t)&line[col] & 15) / sizeof(pixel));
+	for(; first + FILL_PIXELS <= end + 1; first += FILL_PIXELS){
+		memcpy(&line[first], wide, 16);
+	}
+}
+
+/**
+	* @brief Blends a pixel of a circle by its coverage, for edge = (d^2 - r^2) * inv_diameter where d is its distance 
+	* from the centre and r the radius; a pixel inside the opaque threshold is set to the colour. No branch, so the 
+	* pixels at the ends of each row can be drawn without knowing which are on the edge. 
+*/
+static void blendCircleDot(pixel* dot, spreadPixel fg, int32_t edge){
+	int32_t index = (edge >> 16) + CIRCLE_EDGE_WIDTH;
+	blendDot(dot, fg, (index > 0) ? circleEdgeCoverage[index] : 0xFF);
+}
+
+/**
+	* @brief Draws an anti-aliased filled circle, with the centre and radius in subpixels (see TO_SUBPIXEL()). 
+	* Safe to use at the edges of the screen. 
+	* A pixel's coverage only depends on its squared distance from the centre, d^2, through circleEdgeCoverage at 
+	* (d^2 - r^2) / 2r subpixels outside the edge, so a threshold on d^2 from which pixels are clear is worked out once 
+	* per circle, and pixels are opaque while their coverage index is 0 or below. Each frame buffer row is then an opaque 
+	* span, filled 16 bytes at a time by fillSpan(), with edge pixels either side that are blended by their coverage; the 
+	* ends of the row are tracked from row to row, and each edge pixel's coverage is stepped on from its neighbour's, so 
+	* there is no square root or multiply per pixel. Unlikely to work for GLCD_LANDSCAPE == 1. 
+*/
+void drawFilledCircleAA(int32_t origin_x, int32_t origin_y, int32_t radius){
+	int32_t row, last_row, col, end, centre, first, last, left, right, d, row_squared, limit, edge, step, edge_end, step_end;
+	int32_t outer = radius + CIRCLE_EDGE_WIDTH;
+	int32_t radius_squared = radius * radius;
+	int32_t inv_diameter, step_growth, clear_squared, middle;
+	//Indexed by coverage index less CIRCLE_EDGE_WIDTH, the edge value's top half
+	const uint8_t* coverage = &circleEdgeCoverage[CIRCLE_EDGE_WIDTH];
+	//Coverage indices from 1 up are on the edge; below, the pixel is opaque
+	const int32_t opaque_edge = -((CIRCLE_EDGE_WIDTH - 1) << 16);
+	//Locals, as stores through line could otherwise alias foreground_color and force a reload per pixel
+	pixel color = foreground_color;
+	spreadPixel spread = SPREAD_PIXEL(color);
+	pixel* line;
+	#if(RENDER_THREADS != 0)
+	renderCommand* c;
+	if(recording){
+		c = recordCommand(commandCircleAA, ((surface_width << CIRCLE_SUBPIXEL_BITS) - origin_x - outer) >> CIRCLE_SUBPIXEL_BITS, 
+			((surface_width << CIRCLE_SUBPIXEL_BITS) - origin_x + outer) >> CIRCLE_SUBPIXEL_BITS, 0);
+		c->arg[0] = origin_x; c->arg[1] = origin_y; c->arg[2] = radius;
+		return;
+	}
+	#endif
+
+	if(radius <= 0){
+		return;
+	}
+	//The edge's coverage index is ((d^2 - r^2) * inv_diameter >> 16) + CIRCLE_EDGE_WIDTH; at 0 and below the pixel is 
+	//opaque, and from 2 * CIRCLE_EDGE_WIDTH clear, which puts the threshold on d^2 at that. Nothing is drawn 
+	//beyond CIRCLE_EDGE_WIDTH outside the radius, which rounding in inv_diameter would otherwise reach for big circles. 
+	inv_diameter = (1 << 16) / (2 * radius);
+	clear_squared = radius_squared + (((CIRCLE_EDGE_WIDTH << 16) + inv_diameter - 1) / inv_diameter);
+	if(clear_squared > outer * outer){
+		clear_squared = outer * outer;
+	}
+	step_growth = 2 * (1 << (2 * CIRCLE_SUBPIXEL_BITS)) * inv_diameter;
+
+	#if(GLCD_LANDSCAPE == 0)
+	//Game x runs up the frame buffer rows, game y runs back along each row
+	origin_x = (surface_width << CIRCLE_SUBPIXEL_BITS) - origin_x;
+	origin_y = (surface_height << CIRCLE_SUBPIXEL_BITS) - origin_y;
+	#endif
+
+	row = (origin_x - outer) >> CIRCLE_SUBPIXEL_BITS;
+	last_row = (origin_x + outer) >> CIRCLE_SUBPIXEL_BITS;
+	markDirty(row, last_row, (origin_y - outer) >> CIRCLE_SUBPIXEL_BITS, (origin_y + outer) >> CIRCLE_SUBPIXEL_BITS);
+	//Cut to the band being drawn; the span is found afresh on the first row, so later rows are as they would be uncut
+	if(row < clip_top){
+		row = clip_top;
+	}
+	if(last_row >= clip_bottom){
+		last_row = clip_bottom - 1;
+	}
+	//The span's ends are tracked by the offsets of their pixel centres from the circle's along the row, in subpixels. 
+	//It starts at the pixel whose centre is nearest the circle's, which is inside it on any row that has pixels inside, 
+	//so the span always holds it; first and last are the offsets of the screen's ends. 
+	centre = (1 << (CIRCLE_SUBPIXEL_BITS - 1)) - (origin_y & ((1 << CIRCLE_SUBPIXEL_BITS) - 1));
+	first = (1 << (CIRCLE_SUBPIXEL_BITS - 1)) - origin_y;
+	last = first + ((surface_height - 1) * (1 << CIRCLE_SUBPIXEL_BITS));
+	left = centre;
+	right = centre;
+	//The column of the pixel nearest the circle's centre
+	middle = origin_y >> CIRCLE_SUBPIXEL_BITS;
+	for(; row <= last_row; row++){
+		d = (row * (1 << CIRCLE_SUBPIXEL_BITS)) + (1 << (CIRCLE_SUBPIXEL_BITS - 1)) - origin_x;
+		row_squared = d * d;
+		//A pixel on this row is inside the clear threshold while its offset squared is below limit
+		limit = clear_squared - row_squared;
+		//Move the ends of the span out to this row's edge while the rows near the centre, in after. 
+		//An empty span is only ever the centre pixel, on a row with nothing to draw. 
+		if((d < (1 << (CIRCLE_SUBPIXEL_BITS - 1))) || (left == right)){
+			//The ends move a pixel or none on most rows, so the first step is taken without a branch
+			left -= (((left - (1 << CIRCLE_SUBPIXEL_BITS)) * (left - (1 << CIRCLE_SUBPIXEL_BITS))) < limit) << CIRCLE_SUBPIXEL_BITS;
+			right += (((right + (1 << CIRCLE_SUBPIXEL_BITS)) * (right + (1 << CIRCLE_SUBPIXEL_BITS))) < limit) << CIRCLE_SUBPIXEL_BITS;
+			while(((left - (1 << CIRCLE_SUBPIXEL_BITS)) * (left - (1 << CIRCLE_SUBPIXEL_BITS))) < limit){
+				left -= 1 << CIRCLE_SUBPIXEL_BITS;
+			}
+			while(((right + (1 << CIRCLE_SUBPIXEL_BITS)) * (right + (1 << CIRCLE_SUBPIXEL_BITS))) < limit){
+				right += 1 << CIRCLE_SUBPIXEL_BITS;
+			}
+		}
+		else{
+			left += ((left < centre) & ((left * left) >= limit)) << CIRCLE_SUBPIXEL_BITS;
+			right -= ((right > centre) & ((right * right) >= limit)) << CIRCLE_SUBPIXEL_BITS;
+			while((left < centre) && ((left * left) >= limit)){
+				left += 1 << CIRCLE_SUBPIXEL_BITS;
+			}
+			while((right > centre) && ((right * right) >= limit)){
+				right -= 1 << CIRCLE_SUBPIXEL_BITS;
+			}
+		}
+		if((left == right) && ((left * left) >= limit)){
+			continue;
+		}
+
+		//Cut to the screen; nothing to draw where the span is all off it
+		col = (left < first) ? first : left;
+		end = (right > last) ? last : right;
+		if(col > end){
+			continue;
+		}
+		line = &frame_buf[stride * row];
+		//Blend in from each end until the pixels are opaque. (d + s)^2 - d^2 is (2d + s) * s for a step s of a pixel, which 
+		//grows by 2s^2 a pixel, so the coverage's (d^2 - r^2) * inv_diameter is stepped on from its neighbour's with adds. 
+		edge = ((col * col) + row_squared - radius_squared) * inv_diameter;
+		step = ((2 * col) + (1 << CIRCLE_SUBPIXEL_BITS)) * (1 << CIRCLE_SUBPIXEL_BITS) * inv_diameter;
+		edge_end = ((end * end) + row_squared - radius_squared) * inv_diameter;
+		step_end = ((2 * end) - (1 << CIRCLE_SUBPIXEL_BITS)) * (1 << CIRCLE_SUBPIXEL_BITS) * inv_diameter;
+		//From offsets to the pixels themselves
+		col = (col + origin_y) >> CIRCLE_SUBPIXEL_BITS;
+		end = (end + origin_y) >> CIRCLE_SUBPIXEL_BITS;
+		//The pixel at each end is on the edge on most rows, so it's blended without a branch, and filled if in fact opaque
+		if(end > col){
+			blendCircleDot(&line[col], spread, edge);
+			edge += step;
+			step += step_growth;
+			col++;
+			blendCircleDot(&line[end], spread, edge_end);
+			edge_end -= step_end;
+			step_end -= step_growth;
+			end--;
+		}
+		//Where the pixel nearest the circle's centre is opaque and left between the ends, each end stops there at the 
+		//latest, so the loops needn't check the ends haven't met
+		if((col <= middle) && (middle <= end) && ((((centre * centre) + row_squared - radius_squared) * inv_diameter) < opaque_edge)){
+			while(edge >= opaque_edge){
+				blendDot(&line[col], spread, coverage[edge >> 16]);
+				edge += step;
+				step += step_growth;
+				col++;
+			}
+			while(edge_end >= opaque_edge){
+				blendDot(&line[end], spread, coverage[edge_end >> 16]);
+				edge_end -= step_end;
+				step_end -= step_growth;
+				end--;
+			}
+		}
+		else{
+			while((col <= end) && (edge >= opaque_edge)){
+				blendDot(&line[col], spread, coverage[edge >> 16]);
+				edge += step;
+				step += step_growth;
+				col++;
+			}
+			while((end >= col) && (edge_end >= opaque_edge)){
+				blendDot(&line[end], spread, coverage[edge_end >> 16]);
+				edge_end -= step_end;
+				step_end -= step_growth;
+				end--;
 			}
-			//Don't draw pixels off the top of the screen. 
-			if(dot > buffsize){
+		}
+		fillSpan(line, col, end, color);
+	}
+}
+
+/**
+	* @brief Adds the edge from (row0, col0) to (row1, col1), in frame buffer subpixels, to the edge table. 
+	* Edges take the rows whose centres are from the top end up to the bottom, so horizontal edges take none, 
+	* and a vertex shared by two edges is counted once. Only rows in the band being drawn are taken; the column where 
+	* the edge crosses its first is worked out afresh, and is where stepping from an earlier row would have put it. 
+	* Returns 1 if the edge crosses a row of the band. 
+*/
+static int32_t addPolygonEdge(int32_t index, int32_t row0, int32_t col0, int32_t row1, int32_t col1){
+	int32_t temp, top, end, col;
+	if(row1 < row0){
+		temp = row0; row0 = row1; row1 = temp;
+		temp = col0; col0 = col1; col1 = temp;
+	}
+	top = (row0 + (1 << (CIRCLE_SUBPIXEL_BITS - 1)) - 1) >> CIRCLE_SUBPIXEL_BITS;
+	end = (row1 + (1 << (CIRCLE_SUBPIXEL_BITS - 1)) - 1) >> CIRCLE_SUBPIXEL_BITS;
+	if(top < clip_top){top = clip_top;}
+	if(end > clip_bottom){end = clip_bottom;}
+	if(top >= end){
+		return 0;
+	}
+	edges[index].step = ((col1 - col0) * (1 << POLYGON_FRACTION_BITS)) / (row1 - row0);
+	col = (col0 * (1 << (POLYGON_FRACTION_BITS - CIRCLE_SUBPIXEL_BITS))) + 
+		((edges[index].step * ((top << CIRCLE_SUBPIXEL_BITS) + (1 << (CIRCLE_SUBPIXEL_BITS - 1)) - row0)) >> CIRCLE_SUBPIXEL_BITS);
+	edges[index].key = (uint32_t)(col + (POLYGON_LEFT << POLYGON_FRACTION_BITS));
+	edges[index].last_row = (int16_t)(end - 1);
+	edges[index].next = edge_starts[top];
+	edge_starts[top] = (int16_t)index;
+	return 1;
+}
+
+/**
+	* @brief Nonzero if polygon p, outline and all, may reach a row of the band being drawn. 
+*/
+static int32_t polygonInBand(const polygon* p){
+	int32_t j, high, low;
+	if(p->count == 0){
+		return 0;
+	}
+	high = p->x[0];
+	low = p->x[0];
+	for(j = 1; j < p->count; j++){
+		high = (p->x[j] > high) ? p->x[j] : high;
+		low = (p->x[j] < low) ? p->x[j] : low;
+	}
+	#if(GLCD_LANDSCAPE == 0)
+	//Game x runs up the frame buffer rows; outlines reach a pixel past the vertices
+	return ((((surface_width << CIRCLE_SUBPIXEL_BITS) - high) >> CIRCLE_SUBPIXEL_BITS) - 1 < clip_bottom) && 
+		((((surface_width << CIRCLE_SUBPIXEL_BITS) - low) >> CIRCLE_SUBPIXEL_BITS) + 1 >= clip_top);
+	#endif
+}
+
+/**
+	* @brief Fills a batch of polygons, convex or concave, in order, then draws the outlines of those that have them. 
+	* Safe to use at the edges of the screen. Unlikely to work for GLCD_LANDSCAPE == 1. 
+	* Scanline fill with an active edge table, a polygon at a time: its edges go in a table by the row they start on, 
+	* and each frame buffer row keeps the edges crossing it sorted by column. Pixels whose centres lie between 
+	* alternate crossings are inside it (even-odd rule), and are filled along the row. Edges step from row to row in 
+	* fixed point, so there is no division past setting them up. Each polygon is scanned over its own rows only, as 
+	* sharing the rows between polygons that don't overlap only meant sorting their edges past each other. 
+	* A polygon with more than POLYGON_EDGES edges is skipped, as are those off the screen or the band being drawn. 
+*/
+void fillPolygons(const polygon* polygons, uint32_t count){
+	uint32_t i, j;
+	int32_t row, last_row, edge_count, active, e, n, k, col, end;
+	int32_t row0 = 0, col0 = 0, row1 = 0, col1 = 0;
+	int32_t top = 0, bottom = 0, left = 0, right = 0;
+	const polygon* p;
+	pixel* line;
+	pixel color;
+	polygonEdge edge;
+	uint32_t key;
+	#if(RENDER_THREADS != 0)
+	renderCommand* c;
+	polygon* copy;
+	int16_t* vertex;
+	uint32_t vertices = 0;
+	int32_t high = -32768, low = 32767;
+	for(i = 0; i < count; i++){
+		vertices += polygons[i].count;
+	}
+	if(recording && ((c = recordCommand(commandPolygons, 0, 0, (count * sizeof(polygon)) + (vertices * 2 * sizeof(int16_t)))) != NULL)){
+		copy = (polygon*)c->data;
+		vertex = (int16_t*)&copy[count];
+		for(i = 0; i < count; i++){
+			copy[i] = polygons[i];
+			copy[i].x = vertex;
+			memcpy(vertex, polygons[i].x, polygons[i].count * sizeof(int16_t));
+			vertex += polygons[i].count;
+			copy[i].y = vertex;
+			memcpy(vertex, polygons[i].y, polygons[i].count * sizeof(int16_t));
+			vertex += polygons[i].count;
+			for(j = 0; j < polygons[i].count; j++){
+				high = (polygons[i].x[j] > high) ? polygons[i].x[j] : high;
+				low = (polygons[i].x[j] < low) ? polygons[i].x[j] : low;
+			}
+		}
+		//Outlines reach a pixel past the vertices
+		c->top = (((surface_width << CIRCLE_SUBPIXEL_BITS) - high) >> CIRCLE_SUBPIXEL_BITS) - 1;
+		c->bottom = (((surface_width << CIRCLE_SUBPIXEL_BITS) - low) >> CIRCLE_SUBPIXEL_BITS) + 1;
+		c->arg[0] = (int32_t)count;
+		return;
+	}
+	#endif
+
+	for(i = 0; i < count; i++){
+		p = &polygons[i];
+		if((p->count > POLYGON_EDGES) || !polygonInBand(p)){
+			continue;
+		}
+		for(j = 0; j < p->count; j++){
+			#if(GLCD_LANDSCAPE == 0)
+			//Game x runs up the frame buffer rows, game y runs back along each row
+			row0 = (surface_width << CIRCLE_SUBPIXEL_BITS) - p->x[j];
+			col0 = (surface_height << CIRCLE_SUBPIXEL_BITS) - p->y[j];
+			#endif
+			//Bounds, for the rows to take edges on and the sprite layer's tiles; outlines reach a pixel past the vertices
+			top = (j == 0) ? row0 : ((row0 < top) ? row0 : top);
+			bottom = (j == 0) ? row0 : ((row0 > bottom) ? row0 : bottom);
+			left = (j == 0) ? col0 : ((col0 < left) ? col0 : left);
+			right = (j == 0) ? col0 : ((col0 > right) ? col0 : right);
+		}
+		markDirty((top >> CIRCLE_SUBPIXEL_BITS) - 1, (bottom >> CIRCLE_SUBPIXEL_BITS) + 1, (left >> CIRCLE_SUBPIXEL_BITS) - 1, (right >> CIRCLE_SUBPIXEL_BITS) + 1);
+		//Only the rows the polygon's edges can start on are cleared and searched
+		row = ((top >> CIRCLE_SUBPIXEL_BITS) < clip_top) ? clip_top : (top >> CIRCLE_SUBPIXEL_BITS);
+		end = ((bottom >> CIRCLE_SUBPIXEL_BITS) + 1 < clip_bottom) ? (bottom >> CIRCLE_SUBPIXEL_BITS) + 1 : clip_bottom;
+		for(; row < end; row++){
+			edge_starts[row] = -1;
+		}
+		edge_count = 0;
+		last_row = -1;
+		for(j = 0; j < p->count; j++){
+			#if(GLCD_LANDSCAPE == 0)
+			row0 = (surface_width << CIRCLE_SUBPIXEL_BITS) - p->x[j];
+			col0 = (surface_height << CIRCLE_SUBPIXEL_BITS) - p->y[j];
+			row1 = (surface_width << CIRCLE_SUBPIXEL_BITS) - p->x[(j + 1 == p->count) ? 0 : j + 1];
+			col1 = (surface_height << CIRCLE_SUBPIXEL_BITS) - p->y[(j + 1 == p->count) ? 0 : j + 1];
+			#endif
+			if(addPolygonEdge(edge_count, row0, col0, row1, col1)){
+				if(edges[edge_count].last_row > last_row){last_row = edges[edge_count].last_row;}
+				edge_count++;
+			}
+		}
+		if(edge_count == 0){
+			continue;
+		}
+		for(row = ((top >> CIRCLE_SUBPIXEL_BITS) < clip_top) ? clip_top : (top >> CIRCLE_SUBPIXEL_BITS); edge_starts[row] < 0; row++);
+		color = PIXEL_FROM_565(p->fill);
+		active = 0;
+		for(; row <= last_row; row++){
+			//Drop the edges that ended, and take on those that start
+			n = 0;
+			for(k = 0; k < active; k++){
+				if(active_edges[k].last_row >= row){
+					active_edges[n++] = active_edges[k];
+				}
+			}
+			active = n;
+			for(e = edge_starts[row]; e >= 0; e = edges[e].next){
+				active_edges[active++] = edges[e];
+			}
+			//Insertion sort; the order barely changes from row to row
+			for(k = 1; k < active; k++){
+				key = active_edges[k].key;
+				if(active_edges[k - 1].key <= key){
+					continue;
+				}
+				edge = active_edges[k];
+				for(n = k; (n > 0) && (active_edges[n - 1].key > key); n--){
+					active_edges[n] = active_edges[n - 1];
+				}
+				active_edges[n] = edge;
+			}
+			//Fill pixels whose centres are from each crossing up to the next
+			line = &frame_buf[stride * row];
+			for(k = 0; k + 1 < active; k += 2){
+				col = (int32_t)(active_edges[k].key + (1 << (POLYGON_FRACTION_BITS - 1)) - 1) >> POLYGON_FRACTION_BITS;
+				end = (int32_t)(active_edges[k + 1].key + (1 << (POLYGON_FRACTION_BITS - 1)) - 1) >> POLYGON_FRACTION_BITS;
+				col -= POLYGON_LEFT;
+				end -= POLYGON_LEFT;
+				if(col < 0){col = 0;}
+				if(end > surface_height){end = surface_height;}
+				for(; col < end; col++){
+					line[col] = color;
+				}
+			}
+			for(k = 0; k < active; k++){
+				active_edges[k].key += (uint32_t)active_edges[k].step;
+			}
+		}
+	}
+
+	//Outlines over the fills
+	for(i = 0; i < count; i++){
+		p = &polygons[i];
+		if(!p->outlined || (p->count > POLYGON_EDGES) || !polygonInBand(p)){
+			continue;
+		}
+		for(j = 0; j < p->count; j++){
+			#if(GLCD_LANDSCAPE == 0)
+			wuLine((surface_width << CIRCLE_SUBPIXEL_BITS) - p->x[j], (surface_height << CIRCLE_SUBPIXEL_BITS) - p->y[j], 
+				(surface_width << CIRCLE_SUBPIXEL_BITS) - p->x[(j + 1 == p->count) ? 0 : j + 1], 
+				(surface_height << CIRCLE_SUBPIXEL_BITS) - p->y[(j + 1 == p->count) ? 0 : j + 1], SPREAD_PIXEL(PIXEL_FROM_565(p->outline)));
+			#endif
+		}
+	}
+}
+
+#if(RENDER_THREADS != 0)
+/**
+	* @brief The bands a dot of drawSplats(), of size by size pixels, at game x in 16.16 pixels with alpha in 8.8, 
+	* draws on, first to last. Returns 0 if it draws on none. 
+*/
+static int32_t splatBands(int32_t x, uint16_t alpha, uint32_t size, uint32_t* first, uint32_t* last){
+	int32_t row0 = (((surface_width << 16) - x) >> 16) - (int32_t)(size >> 1);
+	int32_t row1 = row0 + (int32_t)size - 1;
+	if(((alpha >> 8) == 0) || (row1 < 0) || (row0 >= surface_width)){
+		return 0;
+	}
+	*first = (row0 < 0) ? 0 : (uint32_t)row0 >> layer_tile_bits;
+	*last = (uint32_t)((row1 >= surface_width) ? surface_width - 1 : row1) >> layer_tile_bits;
+	return 1;
+}
+#endif
+
+/**
+	* @brief Blend count square dots of size by size pixels, for particles. 
+	* Positions are game coordinates in 16.16 fixed point pixels, alpha is 8.8; the arrays are read straight through, 
+	* one dot after another, so they can be a particle pool's own. Dots are clipped to the screen, and the band being 
+	* drawn, a pixel at a time. 
+*/
+void drawSplats(const int32_t* x, const int32_t* y, const uint16_t* color, const uint16_t* alpha, uint32_t count, uint32_t size){
+	uint32_t i, r, c;
+	spreadPixel spread;
+	int32_t row, col;
+	uint8_t a;
+	#if(RENDER_THREADS != 0)
+	uint32_t band, last, words, n;
+	uint32_t counts[LAYER_MAX_TILE_ROWS];
+	renderCommand* bands[LAYER_MAX_TILE_ROWS];
+	uint8_t* data;
+	//Sorted into a call per band, as there are many, spread over the screen, and each band would otherwise go through them all
+	if(recording){
+		memset(counts, 0, sizeof(counts));
+		for(i = 0; i < count; i++){
+			if(splatBands(x[i], alpha[i], size, &band, &last)){
+				for(; band <= last; band++){
+					counts[band]++;
+				}
+			}
+		}
+		words = 0;
+		for(band = 0; band < RENDER_BANDS; band++){
+			words += ((counts[band] * 12) + 7) >> 3;
+		}
+		if((command_count + RENDER_BANDS > RENDER_COMMANDS) || (arena_used + words > RENDER_ARENA_WORDS)){
+			renderFlush();
+		}
+		if(words <= RENDER_ARENA_WORDS){
+			for(band = 0; band < RENDER_BANDS; band++){
+				bands[band] = NULL;
+				if(counts[band] != 0){
+					bands[band] = recordCommand(commandSplats, (int32_t)(band << layer_tile_bits), 
+						(int32_t)((band + 1) << layer_tile_bits) - 1, counts[band] * 12);
+					bands[band]->arg[0] = (int32_t)counts[band];
+					bands[band]->arg[1] = (int32_t)size;
+				}
+				counts[band] = 0;
+			}
+			for(i = 0; i < count; i++){
+				if(!splatBands(x[i], alpha[i], size, &band, &last)){
+					continue;
+				}
+				for(; band <= last; band++){
+					n = (uint32_t)bands[band]->arg[0];
+					data = (uint8_t*)bands[band]->data;
+					((int32_t*)data)[counts[band]] = x[i];
+					((int32_t*)(data + (n * 4)))[counts[band]] = y[i];
+					((uint16_t*)(data + (n * 8)))[counts[band]] = color[i];
+					((uint16_t*)(data + (n * 10)))[counts[band]] = alpha[i];
+					counts[band]++;
+				}
+			}
+			return;
+		}
+	}
+	#endif
+
+	for(i = 0; i < count; i++){
+		a = (uint8_t)(alpha[i] >> 8);
+		if(a == 0){
+			continue;
+		}
+		spread = SPREAD_PIXEL(PIXEL_FROM_565(color[i]));
+		#if(GLCD_LANDSCAPE == 0)
+		row = ((surface_width << 16) - x[i]) >> 16;
+		col = ((surface_height << 16) - y[i]) >> 16;
+		#endif
+		if(size == 1){
+			//Points are most of what is drawn, so skip the loops
+			if((row >= clip_top) && (row < clip_bottom) && ((uint32_t)col < (uint32_t)surface_height)){
+				blendDot(&frame_buf[(uint32_t)col + (stride * (uint32_t)row)], spread, a);
+				if(dirty != NULL){
+					dirty[row >> layer_tile_bits] |= 1u << (col >> layer_tile_bits);
+				}
+			}
+			continue;
+		}
+		row -= (int32_t)(size >> 1);
+		col -= (int32_t)(size >> 1);
+		markDirty(row, row + (int32_t)size - 1, col, col + (int32_t)size - 1);
+		for(r = 0; r < size; r++){
+			if((row + (int32_t)r < clip_top) || (row + (int32_t)r >= clip_bottom)){
 				continue;
 			}
-			frame_buf[dot] = foreground_color;
+			for(c = 0; c < size; c++){
+				if((uint32_t)(col + (int32_t)c) < (uint32_t)surface_height){
+					blendDot(&frame_buf[(uint32_t)(col + (int32_t)c) + (stride * (uint32_t)(row + (int32_t)r))], spread, a);
+				}
+			}
 		}
 	}
+}
 
-	return;
+/**
+	* @brief Widen the guard bits set in guard to masks of their whole channel, for a spread colour. 
+*/
+static spreadPixel spreadLanes(spreadPixel guard){
+	#if(PIXEL_FORMAT == PIXEL_ARGB8888)
+	return guard - (guard >> 8);
+	#else
+	return ((guard & 0x10020) - ((guard & 0x10020) >> 5)) | ((guard & 0x8000000) - ((guard & 0x8000000) >> 6));
+	#endif
 }
+
+/**
+	* @brief Glow pass 1. Averages each 2x2 block of the frame into bloom_buf, keeping only how far each channel is above BLOOM_THRESHOLD. 
+	* The four pixels are summed spread, in parallel, and the threshold subtracted from every channel at once; a channel that 
+	* would go below zero borrows its guard bit, and is cleared. 
+*/
+void bloomExtract(void){
+	uint32_t r, c;
+	spreadPixel s, t;
+	const pixel* src;
+	pixel* out = bloom_buf;
+
+	renderFlush();
+	for(r = 0; r < BLOOM_ROWS; r++){
+		src = &frame_buf[(r << 1) * stride];
+		for(c = 0; c < BLOOM_COLS; c++, src += 2){
+			s = SPREAD_PIXEL(src[0]) + SPREAD_PIXEL(src[1]) + SPREAD_PIXEL(src[stride]) + SPREAD_PIXEL(src[stride + 1]);
+			s = (s >> 2) & SPREAD_MASK;
+			t = (s | SPREAD_GUARD) - SPREAD_PIXEL(PIXEL_FROM_565(BLOOM_THRESHOLD));
+			s = (t & spreadLanes(t & SPREAD_GUARD)) << BLOOM_GAIN_SHIFT;
+			*out++ = UNSPREAD_PIXEL(s);
+		}
+	}
+}
+
+/**
+	* @brief Running-sum box blur of count spread colours, BLOOM_BOX wide, starting first places from each one. 
+	* Pixels past the ends count as black. The sums fit in the gaps between the channels, so one add and one 
+	* subtract move the window, and a shift divides it. 
+*/
+static void boxBlur(const spreadPixel* in, spreadPixel* out, int32_t count, int32_t first){
+	int32_t i;
+	spreadPixel sum = 0;
+
+	for(i = first; i < first + BLOOM_BOX; i++){
+		if((i >= 0) && (i < count)){
+			sum += in[i];
+		}
+	}
+	for(i = 0; i < count; i++){
+		out[i] = (sum >> BLOOM_BOX_BITS) & SPREAD_MASK;
+		if(i + first + BLOOM_BOX < count){
+			sum += in[i + first + BLOOM_BOX];
+		}
+		if(i + first >= 0){
+			sum -= in[i + first];
+		}
+	}
+}
+
+/**
+	* @brief Blur count pixels of bloom_buf, step apart, with two boxes offset either way, which together 
+	* make a centred tent 2 * BLOOM_BOX - 1 wide. Black lines are left as they are. 
+*/
+static void bloomBlurLine(pixel* line, int32_t count, int32_t step){
+	int32_t i;
+	spreadPixel any = 0;
+	for(i = 0; i < count; i++){
+		bloom_line[0][i] = SPREAD_PIXEL(line[i * step]);
+		any |= bloom_line[0][i];
+	}
+	//Most lines have no glow in them
+	if(any == 0){
+		return;
+	}
+	boxBlur(bloom_line[0], bloom_line[1], count, -(BLOOM_BOX >> 1));
+	boxBlur(bloom_line[1], bloom_line[0], count, 1 - (BLOOM_BOX >> 1));
+	for(i = 0; i < count; i++){
+		line[i * step] = UNSPREAD_PIXEL(bloom_line[0][i]);
+	}
+}
+
+/**
+	* @brief Glow pass 2. Blurs bloom_buf along the frame buffer's rows, across the screen. 
+*/
+void bloomBlurRows(void){
+	uint32_t r;
+	for(r = 0; r < BLOOM_ROWS; r++){
+		bloomBlurLine(&bloom_buf[r * BLOOM_COLS], BLOOM_COLS, 1);
+	}
+}
+
+/**
+	* @brief Glow pass 3. Blurs bloom_buf down the frame buffer's columns, up and down the screen. 
+*/
+void bloomBlurColumns(void){
+	uint32_t c;
+	for(c = 0; c < BLOOM_COLS; c++){
+		bloomBlurLine(&bloom_buf[c], BLOOM_ROWS, BLOOM_COLS);
+	}
+}
+
+/**
+	* @brief Glow pass 4. Adds bloom_buf back onto the frame, each glow pixel over a 2x2 block. 
+	* Channels that overflow carry into their guard bit and are set to full, so bright parts saturate to white rather 
+	* than wrap. Most of the glow buffer is black, and those blocks are skipped without touching the frame. 
+*/
+void bloomComposite(void){
+	uint32_t r, c, i;
+	spreadPixel glow, s;
+	pixel* dst;
+	const pixel* in = bloom_buf;
+
+	renderFlush();
+	for(r = 0; r < BLOOM_ROWS; r++){
+		dst = &frame_buf[(r << 1) * stride];
+		for(c = 0; c < BLOOM_COLS; c++, dst += 2, in++){
+			if(*in == 0){
+				continue;
+			}
+			glow = SPREAD_PIXEL(*in);
+			if(dirty != NULL){
+				dirty[(r << 1) >> layer_tile_bits] |= 1u << ((c << 1) >> layer_tile_bits);
+			}
+			for(i = 0; i < 4; i++){
+				s = SPREAD_PIXEL(dst[(i & 1) + ((i >> 1) * stride)]) + glow;
+				s = (s | spreadLanes(s & SPREAD_GUARD)) & SPREAD_MASK;
+				dst[(i & 1) + ((i >> 1) * stride)] = UNSPREAD_PIXEL(s) | PIXEL_OPAQUE;
+			}
+		}
+	}
+}
+
 /**
 	* @brief Fills a rectangle with solid colour. 
 	* An input which attempts to draw pixels off the screen will write outside the frame buffer. 
 */
 void fillRectangle(uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
 	uint32_t  i, j, temp, dot;
+	#if(RENDER_THREADS != 0)
+	renderCommand* c;
+	if(recording){
+		c = recordCommand(commandRectangle, (int32_t)x, (int32_t)(x + width) - 1, 0);
+		c->arg[0] = (int32_t)x; c->arg[1] = (int32_t)y; c->arg[2] = (int32_t)width; c->arg[3] = (int32_t)height;
+		return;
+	}
+	#endif
 	#if(GLCD_LANDSCAPE == 0)
-		temp = x; x = GLCD_WIDTH - y; y=temp;
+		temp = x; x = (uint32_t)surface_width - y; y=temp;
 		temp = width; width = height; height = temp;
 	#endif
+	markDirty((int32_t)y, (int32_t)(y + height) - 1, (int32_t)x + 1, (int32_t)(x + width));
 	dot = x + y*stride;
 	for(i=0; i < height; i++){
+		//Rows outside the band being drawn are stepped over
+		if(((int32_t)(y + i) < clip_top) || ((int32_t)(y + i) >= clip_bottom)){
+			dot += stride;
+			continue;
+		}
 		for(j = 0; j<width; j++){
 			dot++;
 			frame_buf[dot] = foreground_color;
@@ -582,19 +1865,30 @@ void fillRectangle(uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
 */
 int32_t GLCD_DrawHLine (uint32_t x, uint32_t y, uint32_t length) {
   uint32_t dot;
+#if (RENDER_THREADS != 0)
+  renderCommand* c;
+  if (recording) {
+    c = recordCommand(commandHLine, (surface_width - (int32_t)x) - (int32_t)length + 1, (surface_width - (int32_t)x), 0);
+    c->arg[0] = (int32_t)x; c->arg[1] = (int32_t)y; c->arg[2] = (int32_t)length;
+    return 0;
+  }
+#endif
 
 #if (GLCD_LANDSCAPE != 0)
   dot = (y * GLCD_WIDTH) + x;
 #else
-  dot = ((GLCD_WIDTH - x) * GLCD_HEIGHT) + y;
+  dot = (((uint32_t)surface_width - x) * (uint32_t)stride) + y;
+  markDirty((surface_width - (int32_t)x) - (int32_t)length + 1, (surface_width - (int32_t)x), (int32_t)y, (int32_t)y);
 #endif
 
   while (length--) { 
-    frame_buf[dot] = foreground_color;
 #if (GLCD_LANDSCAPE != 0)
+    frame_buf[dot] = foreground_color;
     dot += 1;
 #else
-    dot -= GLCD_HEIGHT;
+    /* Only rows in the band being drawn */
+    if ((dot >= (uint32_t)(clip_top * stride)) && (dot < (uint32_t)(clip_bottom * stride))) frame_buf[dot] = foreground_color;
+    dot -= (uint32_t)stride;
 #endif
   }
 
@@ -604,11 +1898,20 @@ int32_t GLCD_DrawHLine (uint32_t x, uint32_t y, uint32_t length) {
 
 int32_t GLCD_DrawVLine (uint32_t x, uint32_t y, uint32_t length) {
   uint32_t dot;
+#if (RENDER_THREADS != 0)
+  renderCommand* c;
+  if (recording) {
+    c = recordCommand(commandVLine, (surface_width - (int32_t)x), (surface_width - (int32_t)x), 0);
+    c->arg[0] = (int32_t)x; c->arg[1] = (int32_t)y; c->arg[2] = (int32_t)length;
+    return 0;
+  }
+#endif
 
 #if (GLCD_LANDSCAPE != 0)
   dot = (y * GLCD_WIDTH) + x;
 #else
-  dot = ((GLCD_WIDTH - x) * GLCD_HEIGHT) + y;
+  dot = (((uint32_t)surface_width - x) * (uint32_t)stride) + y;
+  markDirty((surface_width - (int32_t)x), (surface_width - (int32_t)x), (int32_t)y, (int32_t)(y + length) - 1);
 #endif
 
   while (length--) { 
@@ -642,8 +1945,18 @@ int32_t GLCD_DrawChar (uint32_t x, uint32_t y, int32_t ch) {
   uint32_t i, j;
   uint32_t wb, dot;
   uint8_t *ptr_ch_bmp;
+#if (RENDER_THREADS != 0)
+  renderCommand* c;
+#endif
 
   if (active_font == NULL) return -1;
+#if (RENDER_THREADS != 0)
+  if (recording) {
+    c = recordCommand(commandChar, (surface_width - (int32_t)x) - (int32_t)active_font->width + 1, (surface_width - (int32_t)x), 0);
+    c->arg[0] = (int32_t)x; c->arg[1] = (int32_t)y; c->arg[2] = ch;
+    return 0;
+  }
+#endif
 
   ch        -= active_font->offset;
   wb         = (active_font->width + 7)/8;
@@ -651,23 +1964,25 @@ int32_t GLCD_DrawChar (uint32_t x, uint32_t y, int32_t ch) {
 #if (GLCD_LANDSCAPE != 0)
   dot        = (y * GLCD_WIDTH) + x;
 #else
-  dot        = ((GLCD_WIDTH - x) * GLCD_HEIGHT) + y;
+  dot        = (((uint32_t)surface_width - x) * (uint32_t)stride) + y;
+  markDirty((surface_width - (int32_t)x) - (int32_t)active_font->width + 1, (surface_width - (int32_t)x), (int32_t)y, (int32_t)(y + active_font->height) - 1);
 #endif
 
   for (i = 0; i < active_font->height; i++) {
     for (j = 0; j < active_font->width; j++) {
-      frame_buf[dot] = (((*ptr_ch_bmp >> (j & 7)) & 1) ? foreground_color : frame_buf[dot]);
+      /* Only set pixels are written, and only in the band being drawn */
+      if (((*ptr_ch_bmp >> (j & 7)) & 1) && (dot >= (uint32_t)(clip_top * stride)) && (dot < (uint32_t)(clip_bottom * stride))) frame_buf[dot] = foreground_color;
 #if (GLCD_LANDSCAPE != 0)
       dot += 1;
 #else
-      dot -= GLCD_HEIGHT;
+      dot -= (uint32_t)stride;
 #endif
-      if (((j & 7) == 7) && (j != (active_font->width - 1))) ptr_ch_bmp++;
+      if (((j & 7) == 7) && (j != (uint32_t)(active_font->width - 1))) ptr_ch_bmp++;
     }
 #if (GLCD_LANDSCAPE != 0)
     dot +=  GLCD_WIDTH - j;
 #else
-    dot += (GLCD_HEIGHT * j) + 1;
+    dot += ((uint32_t)stride * j) + 1;
 #endif
     ptr_ch_bmp++;
   }
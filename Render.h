@@ -11,16 +11,84 @@
 
 
 #include <stdint.h>
+#include "platform.h"
+
+/* Fractional bits of the positions and radius drawFilledCircleAA() takes, and of polygon vertices */
+#define CIRCLE_SUBPIXEL_BITS 4
+/* Convert a float position or radius to drawFilledCircleAA()'s fixed point */
+#define TO_SUBPIXEL(f) ((int32_t)((f) * (1 << CIRCLE_SUBPIXEL_BITS)))
+/* Most edges of a polygon fillPolygons() fills; polygons with more are skipped */
+#define POLYGON_EDGES 256
+/* Host builds only, with -pthread: most threads setRenderThreads() can draw a frame with, in bands. 
+ 0 leaves drawing as it is, each call drawn as it is made */
+#ifndef RENDER_THREADS
+#define RENDER_THREADS 0
+#endif
+/* Largest surface GLCD_InitializeSurface() takes, in portrait pixels; the renderer's own buffers are sized for it. 
+ The panel by default; override on the host to benchmark bigger screens */
+#ifndef RENDER_MAX_WIDTH
+#define RENDER_MAX_WIDTH GLCD_SIZE_Y
+#endif
+#ifndef RENDER_MAX_HEIGHT
+#define RENDER_MAX_HEIGHT GLCD_SIZE_X
+#endif
+
+/**
+	*@brief The frame buffers drawn on, for GLCD_InitializeSurface(). Sizes are in portrait, as the game sees the screen. 
+*/
+typedef struct{
+	uint32_t width; /** Pixels across, in game x; the frame buffer rows. At most RENDER_MAX_WIDTH */
+	uint32_t height; /** Pixels up, in game y; the pixels along each frame buffer row. At most RENDER_MAX_HEIGHT */
+	uint32_t stride; /** Pixels from the start of one frame buffer row to the next, at least height */
+	uint32_t format; /** PIXEL_RGB565 or PIXEL_ARGB8888; the build's PIXEL_FORMAT, which the drawing is compiled for */
+}renderSurface;
+
+/**
+	*@brief A closed polygon for fillPolygons(), convex or not. 
+	*Vertices are game coordinates in subpixels, and must be within 1000 pixels of the screen. Being 16-bit, they 
+	*reach 2047 pixels from the origin, which bounds where polygons go on bigger surfaces. 
+*/
+typedef struct{
+	const int16_t* x; /** Vertex x positions */
+	const int16_t* y; /** Vertex y positions */
+	uint16_t count; /** Vertices; the last joins back to the first. At most POLYGON_EDGES */
+	uint16_t fill; /** Fill colour */
+	uint16_t outline; /** Anti-aliased outline colour */
+	uint8_t outlined; /** Nonzero to draw the outline */
+}polygon;
 
 
 void GLCD_Initialize_Doublebuffer(void);
+int32_t GLCD_InitializeSurface(const renderSurface* surface);
+void GLCD_InitializeLayers(pixel* background, uint16_t key);
+void drawToBackground(void);
+void drawToSprites(void);
+void invalidateSprites(void);
+uint32_t clearSprites(void);
+uint32_t backBufferIndex(void);
+void drawStars(const uint16_t* columnStarts, const uint32_t* y, const uint16_t* color, uint32_t* drawn);
+void compositeLayers(pixel* out, const pixel* sprites, const pixel* background, uint16_t key);
 void drawFilledCircle(int32_t origin_x, int32_t origin_y, int32_t radius);
+void drawFilledCircleAA(int32_t origin_x, int32_t origin_y, int32_t radius);
+void fillPolygons(const polygon* polygons, uint32_t count);
+void drawSplats(const int32_t* x, const int32_t* y, const uint16_t* color, const uint16_t* alpha, uint32_t count, uint32_t size);
 void drawLine(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
 void drawThickLine(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint32_t thickness);
 void switchBuffer(void);
+void setRenderThreads(uint32_t count);
+void renderFlush(void);
 void clearScreen (void);
+void bloomExtract(void);
+void bloomBlurRows(void);
+void bloomBlurColumns(void);
+void bloomComposite(void);
+void clearScreenStars(const uint16_t* columnStarts, const uint32_t* y, const uint16_t* color);
 void setBackgroundColor(uint16_t color);
 void setForegroundColor(uint16_t color);
+void setBlendGamma(uint8_t enabled);
+int32_t blendPixel(uint32_t x, uint32_t y, uint8_t alpha);
+int32_t blendPixelFast(uint32_t x, uint32_t y, uint8_t alpha);
+int32_t blendPixelRamp(uint32_t x, uint32_t y, uint8_t alpha);
 uint32_t fastIntSqrt(uint32_t x);
 int32_t GLCD_DrawChar (uint32_t x, uint32_t y, int32_t ch);
 int32_t GLCD_DrawString (uint32_t x, uint32_t y, const char *str);
@@ -0,0 +1,500 @@
+/**
+  ******************************************************************************
+  * @file    capture.c
+  * @author  David Webster - 100293854
+  * @brief   This file contains functions for capturing presented frames as delta/RLE records, and reading them back.
+	*Has no hardware dependencies, so a capture dumped from the board can be decoded by a host build.
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "capture.h"
+
+#define CAPTURE_VERSION 1
+/* Length, kind and tick at the start of each record */
+#define CAPTURE_RECORD_HEADER 9
+
+//record kinds
+#define CAPTURE_KEYFRAME 'K'
+#define CAPTURE_DELTA 'D'
+
+//bits of a keyframe's flags byte
+#define CAPTURE_LAYERED 0x01
+
+//run ops, in the top 2 bits of a run's first byte
+#define RUN_SKIP 0x00
+#define RUN_LITERAL 0x40
+#define RUN_FILL 0x80
+#define RUN_COUNT_MASK 0x3F
+
+/* Shortest run of one pixel written as a fill rather than literals */
+#define CAPTURE_MIN_FILL 3
+/* Pixels compared at once while skipping unchanged parts of a row */
+#define CAPTURE_BLOCK 16
+
+/**
+	* @brief Write a 32-bit value into buf, little-endian.
+*/
+static void writeWord(uint8_t* buf, uint32_t value){
+	buf[0] = (uint8_t)value;
+	buf[1] = (uint8_t)(value >> 8);
+	buf[2] = (uint8_t)(value >> 16);
+	buf[3] = (uint8_t)(value >> 24);
+}
+
+/**
+	* @brief Read a little-endian 32-bit value from buf.
+*/
+static uint32_t readWord(const uint8_t* buf){
+	return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/**
+	* @brief Rewrite the header's positions and counts.
+*/
+static void writeHeader(frameCapture* capture){
+	writeWord(&capture->buffer[12], capture->ring);
+	writeWord(&capture->buffer[16], capture->tail);
+	writeWord(&capture->buffer[20], capture->used);
+	writeWord(&capture->buffer[24], capture->frames);
+	writeWord(&capture->buffer[28], capture->dropped);
+}
+
+/**
+	* @brief Drop the oldest record of a ring, to make room.
+*/
+static void dropOldest(frameCapture* capture){
+	uint8_t length[4];
+	uint32_t i, pos = capture->tail;
+	for(i = 0; i < 4; i++){
+		length[i] = capture->buffer[CAPTURE_HEADER_SIZE + pos];
+		pos = (pos + 1 == capture->ring) ? 0 : pos + 1;
+	}
+	i = readWord(length);
+	capture->tail = (capture->tail + i) % capture->ring;
+	capture->used -= i;
+}
+
+/**
+	* @brief Append a byte to the record being written. A full ring drops its oldest records to make room;
+	* if there are none left, or a stream is full, the record is marked as overflowing and the byte is lost.
+*/
+static void putByte(frameCapture* capture, uint8_t byte){
+	if(capture->used == capture->ring){
+		if((capture->mode != captureRing) || (capture->used == capture->recordBytes)){
+			capture->overflow = 1;
+			return;
+		}
+		dropOldest(capture);
+	}
+	capture->buffer[CAPTURE_HEADER_SIZE + capture->pos] = byte;
+	capture->pos = (capture->pos + 1 == capture->ring) ? 0 : capture->pos + 1;
+	capture->used++;
+	capture->recordBytes++;
+}
+
+/**
+	* @brief Claim count bytes of the record being written, if they fit before the end of the buffer without dropping
+	* anything, for writing straight in. Returns where they go, or NULL to write them a byte at a time with putByte().
+*/
+static uint8_t* putSpace(frameCapture* capture, uint32_t count){
+	uint8_t* out;
+	if((capture->used + count > capture->ring) || (capture->pos + count >= capture->ring)){
+		return NULL;
+	}
+	out = &capture->buffer[CAPTURE_HEADER_SIZE + capture->pos];
+	capture->pos += count;
+	capture->used += count;
+	capture->recordBytes += count;
+	return out;
+}
+
+static void putWord(frameCapture* capture, uint32_t value){
+	putByte(capture, (uint8_t)value);
+	putByte(capture, (uint8_t)(value >> 8));
+	putByte(capture, (uint8_t)(value >> 16));
+	putByte(capture, (uint8_t)(value >> 24));
+}
+
+/**
+	* @brief Append count pixels from span, little-endian.
+*/
+static void putPixels(frameCapture* capture, const pixel* span, uint32_t count){
+	uint32_t i, j;
+	uint8_t* out = putSpace(capture, count * sizeof(pixel));
+	if(out != NULL){
+		for(i = 0; i < count; i++){
+			for(j = 0; j < sizeof(pixel); j++){
+				*out++ = (uint8_t)(span[i] >> (j * 8));
+			}
+		}
+		return;
+	}
+	for(i = 0; i < count; i++){
+		for(j = 0; j < sizeof(pixel); j++){
+			putByte(capture, (uint8_t)(span[i] >> (j * 8)));
+		}
+	}
+}
+
+/**
+	* @brief Start a run of op, count long; counts over the byte's 6 bits follow it as a varint.
+*/
+static void putRun(frameCapture* capture, uint8_t op, uint32_t count){
+	if(count <= RUN_COUNT_MASK){
+		putByte(capture, (uint8_t)(op | count));
+		return;
+	}
+	putByte(capture, op);
+	do{
+		putByte(capture, (uint8_t)((count & 0x7F) | ((count > 0x7F) ? 0x80 : 0)));
+		count >>= 7;
+	}while(count);
+}
+
+/**
+	* @brief Write count changed pixels from span, as fills where a pixel repeats and literals between.
+*/
+static void putSpan(frameCapture* capture, const pixel* span, uint32_t count){
+	uint32_t i = 0, run, literals = 0;
+	while(i < count){
+		for(run = 1; (i + run < count) && (span[i + run] == span[i]); run++);
+		if(run >= CAPTURE_MIN_FILL){
+			if(literals != 0){
+				putRun(capture, RUN_LITERAL, literals);
+				putPixels(capture, &span[i - literals], literals);
+				literals = 0;
+			}
+			putRun(capture, RUN_FILL, run);
+			putPixels(capture, &span[i], 1);
+		}
+		else{
+			literals += run;
+		}
+		i += run;
+	}
+	if(literals != 0){
+		putRun(capture, RUN_LITERAL, literals);
+		putPixels(capture, &span[count - literals], literals);
+	}
+}
+
+/**
+	* @brief Write the runs of frame that differ from previous, or all of it if previous is NULL.
+	* Skips carry on from one row to the next, and a skip at the end of the frame is left out.
+*/
+static void putFrame(frameCapture* capture, const pixel* frame, const pixel* previous){
+	uint32_t row, i, j, skip = 0;
+	const pixel* now;
+	const pixel* before;
+	for(row = 0; (row < capture->rows) && !capture->overflow; row++){
+		now = &frame[row * capture->stride];
+		before = previous ? &previous[row * capture->stride] : NULL;
+		i = 0;
+		while(i < capture->length){
+			j = capture->length;
+			if(before != NULL){
+				//Most of a frame is as it was, so it is compared a block at a time
+				for(j = i; (j + CAPTURE_BLOCK <= capture->length) && (memcmp(&now[j], &before[j], CAPTURE_BLOCK * sizeof(pixel)) == 0); j += CAPTURE_BLOCK);
+				for(; (j < capture->length) && (now[j] == before[j]); j++);
+				skip += j - i;
+				i = j;
+				if(i == capture->length){
+					break;
+				}
+				if(skip != 0){
+					putRun(capture, RUN_SKIP, skip);
+					skip = 0;
+				}
+				for(j = i + 1; (j < capture->length) && (now[j] != before[j]); j++);
+			}
+			putSpan(capture, &now[i], j - i);
+			i = j;
+		}
+	}
+}
+
+/**
+	* @brief Begin capturing frames of rows rows, length pixels long and stride apart, into buffer. Writes the header.
+	* Returns 0 on success, or -1 if the buffer is too small to hold the header and a record, or the frame too big.
+*/
+int32_t startCapture(frameCapture* capture, uint8_t* buffer, uint32_t size, enum captureMode mode, uint32_t rows, uint32_t length, uint32_t stride){
+	capture->mode = captureOff;
+	if((size <= CAPTURE_HEADER_SIZE + CAPTURE_RECORD_HEADER) || (mode == captureOff) || (rows > 0xFFFF) || (length > 0xFFFF)){
+		return -1;
+	}
+	capture->buffer = buffer;
+	capture->ring = size - CAPTURE_HEADER_SIZE;
+	capture->tail = 0;
+	capture->used = 0;
+	capture->rows = rows;
+	capture->length = length;
+	capture->stride = stride;
+	capture->background = NULL;
+	capture->key = 0;
+	capture->sinceKey = 0;
+	capture->keyDue = 1;
+	capture->headerSent = 0;
+	capture->frames = 0;
+	capture->dropped = 0;
+	capture->bytes = 0;
+	buffer[0] = 'A';
+	buffer[1] = 'C';
+	buffer[2] = CAPTURE_VERSION;
+	buffer[3] = (uint8_t)mode;
+	buffer[4] = (uint8_t)sizeof(pixel);
+	buffer[5] = 0;
+	buffer[6] = (uint8_t)rows;
+	buffer[7] = (uint8_t)(rows >> 8);
+	buffer[8] = (uint8_t)length;
+	buffer[9] = (uint8_t)(length >> 8);
+	buffer[10] = 0;
+	buffer[11] = 0;
+	capture->mode = mode;
+	writeHeader(capture);
+	return 0;
+}
+
+/**
+	* @brief Capture the frames as shown over background, laid out as they are, with frame pixels of key, in RGB565,
+	* showing it through; NULL for none. The background is recorded with each keyframe, starting with the next frame.
+*/
+void captureLayers(frameCapture* capture, const pixel* background, uint16_t key){
+	capture->background = background;
+	capture->key = PIXEL_FROM_565(key);
+	capture->keyDue = 1;
+}
+
+/**
+	* @brief Record the background again, with a keyframe, as the next frame is captured. Call when it is redrawn.
+*/
+void captureBackgroundChanged(frameCapture* capture){
+	capture->keyDue = 1;
+}
+
+/**
+	* @brief Capture frame, about to be presented, against previous, the frame presented before it.
+	* A keyframe is written instead every CAPTURE_KEYFRAME_INTERVAL frames, when the background has changed,
+	* after a dropped frame, or when previous is NULL.
+	* Returns the bytes recorded, or -1 if the capture is off or the frame didn't fit and was dropped.
+*/
+int32_t captureFrame(frameCapture* capture, const pixel* frame, const pixel* previous, uint32_t tick){
+	uint32_t start, pos, i;
+	uint8_t key, length[4];
+
+	if(capture->mode == captureOff){return -1;}
+	key = capture->keyDue || (capture->sinceKey >= CAPTURE_KEYFRAME_INTERVAL) || (previous == NULL);
+	start = (capture->tail + capture->used) % capture->ring;
+	capture->pos = start;
+	capture->recordBytes = 0;
+	capture->overflow = 0;
+
+	//The length is filled in once the record is done
+	putWord(capture, 0);
+	putByte(capture, key ? CAPTURE_KEYFRAME : CAPTURE_DELTA);
+	putWord(capture, tick);
+	if(key){
+		putByte(capture, capture->background ? CAPTURE_LAYERED : 0);
+		if(capture->background != NULL){
+			putPixels(capture, &capture->key, 1);
+			putFrame(capture, capture->background, NULL);
+		}
+		putFrame(capture, frame, NULL);
+	}
+	else{
+		putFrame(capture, frame, previous);
+	}
+
+	if(capture->overflow){
+		//Whatever of it was written is given back; the next frame has nothing to be a delta of
+		capture->used -= capture->recordBytes;
+		capture->dropped++;
+		capture->keyDue = 1;
+		writeHeader(capture);
+		return -1;
+	}
+	writeWord(length, capture->recordBytes);
+	for(i = 0, pos = start; i < 4; i++){
+		capture->buffer[CAPTURE_HEADER_SIZE + pos] = length[i];
+		pos = (pos + 1 == capture->ring) ? 0 : pos + 1;
+	}
+	capture->frames++;
+	capture->bytes += capture->recordBytes;
+	capture->sinceKey = key ? 0 : capture->sinceKey + 1;
+	capture->keyDue = 0;
+	writeHeader(capture);
+	return (int32_t)capture->recordBytes;
+}
+
+/**
+	* @brief Pass everything a stream has recorded since it was last drained to write, the header first time,
+	* and empty it. Returns the bytes passed on, 0 for a ring, which keeps its records.
+*/
+uint32_t captureDrain(frameCapture* capture, void (*write)(const uint8_t* data, uint32_t length)){
+	uint32_t sent = 0;
+	if(capture->mode != captureStream){return 0;}
+	if(!capture->headerSent){
+		write(capture->buffer, CAPTURE_HEADER_SIZE);
+		sent += CAPTURE_HEADER_SIZE;
+		capture->headerSent = 1;
+	}
+	//A stream never wraps, as it is emptied every frame and a record that reaches the end is dropped
+	if(capture->used != 0){
+		write(&capture->buffer[CAPTURE_HEADER_SIZE + capture->tail], capture->used);
+		sent += capture->used;
+	}
+	capture->tail = 0;
+	capture->used = 0;
+	return sent;
+}
+
+static uint8_t getByte(captureReader* reader){
+	uint8_t byte = reader->buffer[CAPTURE_HEADER_SIZE + reader->pos];
+	reader->pos = (reader->pos + 1 == reader->ring) ? 0 : reader->pos + 1;
+	reader->left--;
+	return byte;
+}
+
+static uint32_t getWord(captureReader* reader){
+	uint8_t bytes[4];
+	bytes[0] = getByte(reader);
+	bytes[1] = getByte(reader);
+	bytes[2] = getByte(reader);
+	bytes[3] = getByte(reader);
+	return readWord(bytes);
+}
+
+static uint32_t getPixel(captureReader* reader){
+	uint32_t i, value = 0;
+	for(i = 0; i < reader->pixelBytes; i++){
+		value |= (uint32_t)getByte(reader) << (i * 8);
+	}
+	return value;
+}
+
+/**
+	* @brief Apply runs to out until the record is down to end bytes left, or, if whole, until every pixel is written.
+	* Returns 0 on success, or -1 if the runs are cut short or go past the end of the frame.
+*/
+static int32_t getFrame(captureReader* reader, uint32_t* out, uint32_t end, uint8_t whole){
+	uint32_t i = 0, total = reader->rows * reader->length, count, shift, value;
+	uint8_t op, byte;
+	while((reader->left > end) && (!whole || (i < total))){
+		byte = getByte(reader);
+		op = byte & (uint8_t)~RUN_COUNT_MASK;
+		count = byte & RUN_COUNT_MASK;
+		if(count == 0){
+			shift = 0;
+			do{
+				if((reader->left == end) || (shift > 28)){return -1;}
+				byte = getByte(reader);
+				count |= (uint32_t)(byte & 0x7F) << shift;
+				shift += 7;
+			}while(byte & 0x80);
+		}
+		if((count == 0) || (count > total - i)){return -1;}
+		switch(op){
+			case RUN_SKIP:
+				i += count;
+				break;
+			case RUN_LITERAL:
+				if(reader->left - end < count * reader->pixelBytes){return -1;}
+				while(count--){
+					out[i++] = getPixel(reader);
+				}
+				break;
+			case RUN_FILL:
+				if(reader->left - end < reader->pixelBytes){return -1;}
+				value = getPixel(reader);
+				while(count--){
+					out[i++] = value;
+				}
+				break;
+			default:
+				return -1;
+		}
+	}
+	return (whole && (i != total)) ? -1 : 0;
+}
+
+/**
+	* @brief Begin reading a capture of length bytes: a dumped buffer, or a stream saved from captureDrain().
+	* Frames are decoded into frame, and backgrounds into background, each rows * length words, from the header.
+	* Returns 0 on success, or -1 if the header is missing, from a different version, or the ring is cut short.
+*/
+int32_t openCapture(captureReader* reader, const uint8_t* buffer, uint32_t length, uint32_t* frame, uint32_t* background){
+	if(length < CAPTURE_HEADER_SIZE){return -1;}
+	if((buffer[0] != 'A') || (buffer[1] != 'C') || (buffer[2] != CAPTURE_VERSION) ||
+		((buffer[4] != 2) && (buffer[4] != 4))){return -1;}
+	reader->buffer = buffer;
+	reader->pixelBytes = buffer[4];
+	reader->rows = (uint32_t)buffer[6] | ((uint32_t)buffer[7] << 8);
+	reader->length = (uint32_t)buffer[8] | ((uint32_t)buffer[9] << 8);
+	reader->captured = readWord(&buffer[24]);
+	reader->dropped = readWord(&buffer[28]);
+	if(buffer[3] == captureRing){
+		reader->ring = readWord(&buffer[12]);
+		reader->pos = readWord(&buffer[16]);
+		reader->left = readWord(&buffer[20]);
+		if((reader->ring > length - CAPTURE_HEADER_SIZE) || (reader->pos >= reader->ring) || (reader->left > reader->ring)){return -1;}
+	}
+	else{
+		//A stream's records run to the end of the file
+		reader->ring = length - CAPTURE_HEADER_SIZE;
+		reader->pos = 0;
+		reader->left = reader->ring;
+	}
+	reader->frame = frame;
+	reader->background = background;
+	reader->key = 0;
+	reader->layered = 0;
+	reader->keyed = 0;
+	reader->tick = 0;
+	return 0;
+}
+
+/**
+	* @brief Decode the next frame into reader->frame, with its tick in reader->tick. Once a keyframe with layers
+	* has been read, reader->background holds the background, and reader->layered is set.
+	* Returns 0 on success, or -1 at the end of the capture or on a record cut short. Reading stops when this fails.
+*/
+int32_t readCapture(captureReader* reader){
+	uint32_t length, end, tick;
+	uint8_t kind, flags;
+
+	while(reader->left >= CAPTURE_RECORD_HEADER){
+		length = getWord(reader);
+		if((length < CAPTURE_RECORD_HEADER) || (length - 4 > reader->left)){
+			break;
+		}
+		end = reader->left - (length - 4);
+		kind = getByte(reader);
+		tick = getWord(reader);
+		if((kind == CAPTURE_DELTA) && reader->keyed){
+			if(getFrame(reader, reader->frame, end, 0) != 0){break;}
+		}
+		else if(kind == CAPTURE_KEYFRAME){
+			if(reader->left == end){break;}
+			flags = getByte(reader);
+			reader->layered = (flags & CAPTURE_LAYERED) ? 1 : 0;
+			if(reader->layered){
+				if(reader->left - end < reader->pixelBytes){break;}
+				reader->key = getPixel(reader);
+				if(getFrame(reader, reader->background, end, 1) != 0){break;}
+			}
+			if(getFrame(reader, reader->frame, end, 1) != 0){break;}
+			reader->keyed = 1;
+		}
+		else{
+			//Deltas before the first keyframe have nothing to go on
+			reader->pos = (reader->pos + (reader->left - end)) % reader->ring;
+			reader->left = end;
+			continue;
+		}
+		if(reader->left != end){break;}
+		reader->tick = tick;
+		return 0;
+	}
+	reader->left = 0;
+	return -1;
+}
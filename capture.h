@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    capture.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains structs and functions for capturing presented frames as delta/RLE records, and reading them back.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#include "platform.h"
+#ifndef captureHeader
+#define captureHeader
+
+/* Bytes at the start of a capture buffer, or file, before the records */
+#define CAPTURE_HEADER_SIZE 32
+/* Most frames between keyframes, which hold every pixel, so a ring that has wrapped decodes from the oldest one left */
+#ifndef CAPTURE_KEYFRAME_INTERVAL
+#define CAPTURE_KEYFRAME_INTERVAL 64
+#endif
+
+/**
+	*@brief Capture mode enumerator
+	*A ring keeps the latest records in its buffer, dropping the oldest to make room, for dumping after the fact.
+	*A stream's records are handed on with captureDrain() after every frame, and its buffer only holds one.
+*/
+enum captureMode{
+	captureOff, captureRing, captureStream
+};
+
+/**
+	*@brief Frame capture struct
+	*Records each frame as it is presented, in a caller-owned buffer, as the runs of pixels that changed since the
+	*frame before, which the front buffer still holds, so nothing is copied. The buffer starts with a 32 byte header:
+	*"AC", a version byte, the mode, the bytes per pixel, a reserved byte, the 16-bit little-endian rows and pixels per
+	*row, 2 reserved bytes, then the little-endian record space, the offset of the oldest record in it, the bytes used,
+	*and the frames captured and dropped. The header is rewritten after every frame, so a ring dumped at any point decodes.
+	*Each record is a 32-bit length, covering the whole record, a kind byte, the 32-bit tick, then runs. A keyframe
+	*has a flags byte first, and with layers the key colour and every pixel of the background, then every pixel of
+	*the frame; a delta has only the pixels that changed. A run is a byte of op in the top 2 bits and count in the rest,
+	*or 0 and a 7-bit varint count after it for runs over 63: skip count pixels, count literal pixels, or count of
+	*one pixel. Pixels are little-endian, in the frame buffer's format, and runs go along the rows in order.
+*/
+typedef struct{
+	uint8_t *buffer; /** Header then record space */
+	uint32_t ring; /** Record space, in bytes */
+	uint32_t tail; /** Offset of the oldest record */
+	uint32_t used; /** Bytes of record space holding records */
+	uint32_t pos; /** Where the record being written is up to */
+	uint32_t recordBytes; /** Bytes of the record being written so far */
+	uint8_t overflow; /** Set when the record being written won't fit */
+	uint8_t keyDue; /** Set when the next frame must be a keyframe */
+	uint8_t headerSent; /** Set once captureDrain() has passed the header on */
+	uint32_t rows; /** Frame buffer rows */
+	uint32_t length; /** Pixels along each row */
+	uint32_t stride; /** Pixels from one row to the next */
+	const pixel* background; /** Layer the frames go over, or NULL */
+	pixel key; /** Frame pixel colour that shows the background */
+	uint32_t sinceKey; /** Frames since the last keyframe */
+	uint32_t frames; /** Frames captured */
+	uint32_t dropped; /** Frames that didn't fit */
+	uint32_t bytes; /** Bytes captured over every frame */
+	enum captureMode mode; /** What the capture is doing */
+}frameCapture;
+
+/**
+	*@brief Capture reader struct
+	*Decodes a capture's records, oldest first, into the caller's frame and background, one pixel per word whatever
+	*the format. Deltas before the first keyframe left are skipped.
+*/
+typedef struct{
+	const uint8_t *buffer; /** Capture, from its header */
+	uint32_t ring; /** Record space, in bytes */
+	uint32_t pos; /** Offset of the next record */
+	uint32_t left; /** Bytes of records not yet read */
+	uint32_t rows; /** Frame rows */
+	uint32_t length; /** Pixels along each row */
+	uint32_t pixelBytes; /** Bytes per pixel: 2 for RGB565, 4 for ARGB8888 */
+	uint32_t* frame; /** Latest frame, rows * length pixels */
+	uint32_t* background; /** Background layer, rows * length pixels */
+	uint32_t key; /** Frame pixel colour that shows the background */
+	uint8_t layered; /** Set if the latest keyframe had a background */
+	uint8_t keyed; /** Set once a keyframe has been read */
+	uint32_t tick; /** Tick of the latest frame */
+	uint32_t captured; /** Frames captured, from the header */
+	uint32_t dropped; /** Frames dropped, from the header */
+}captureReader;
+
+int32_t startCapture(frameCapture* capture, uint8_t* buffer, uint32_t size, enum captureMode mode, uint32_t rows, uint32_t length, uint32_t stride);
+void captureLayers(frameCapture* capture, const pixel* background, uint16_t key);
+void captureBackgroundChanged(frameCapture* capture);
+int32_t captureFrame(frameCapture* capture, const pixel* frame, const pixel* previous, uint32_t tick);
+uint32_t captureDrain(frameCapture* capture, void (*write)(const uint8_t* data, uint32_t length));
+int32_t openCapture(captureReader* reader, const uint8_t* buffer, uint32_t length, uint32_t* frame, uint32_t* background);
+int32_t readCapture(captureReader* reader);
+#endif
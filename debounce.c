@@ -0,0 +1,50 @@
+/**
+  ******************************************************************************
+  * @file    debounce.c 
+  * @author  David Webster - 100293854
+  * @brief   This file contains an edge-triggered debouncer for buttons read from interrupts.
+	*Has no hardware dependencies; the caller reads the pin and supplies the time, 
+	*so it can be driven by a mock GPIO on a host. 
+  ******************************************************************************
+  */
+
+#include "debounce.h"
+
+/**
+	* @brief Initialize a debouncer with the pin's current level. 
+*/
+void initDebouncer(debouncer* d, uint8_t level, uint32_t holdoff){
+	d->state = level ? 1 : 0;
+	d->settling = 0;
+	d->lastEdge = 0;
+	d->holdoff = holdoff;
+}
+
+/**
+	* @brief Handle a pin change interrupt. level is the pin as read in the interrupt, now is the current time. 
+	* Returns the new state if the edge is accepted, or -1 if it is bounce or not a change. 
+*/
+int32_t debounceEdge(debouncer* d, uint8_t level, uint32_t now){
+	level = level ? 1 : 0;
+	if(d->settling){
+		//Still inside the holdoff of the last edge; debounceSettle() will pick up where the pin ended up
+		if((now - d->lastEdge) < d->holdoff){return -1;}
+		d->settling = 0;
+	}
+	if(level == d->state){return -1;}
+	d->state = level;
+	d->lastEdge = now;
+	d->settling = 1;
+	return level;
+}
+
+/**
+	* @brief Call periodically from a timer with the pin's current level. 
+	* Ends the holdoff once it has elapsed. If the pin has settled in the other state, accepts that as a new edge. 
+	* Returns the new state if an edge is accepted, otherwise -1. 
+*/
+int32_t debounceSettle(debouncer* d, uint8_t level, uint32_t now){
+	if(!d->settling || ((now - d->lastEdge) < d->holdoff)){return -1;}
+	d->settling = 0;
+	return debounceEdge(d, level, now);
+}
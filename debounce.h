@@ -0,0 +1,32 @@
+/**
+  ******************************************************************************
+  * @file    debounce.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains an edge-triggered debouncer for buttons read from interrupts.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#ifndef debounceHeader
+#define debounceHeader
+
+/* Default time a button's edges are ignored for after one is accepted, in ms */
+#define DEBOUNCE_TIME 10
+
+/**
+	*@brief Debouncer struct
+	*The first edge is accepted immediately, so its timestamp is the real press or release time.
+	*Edges are then ignored for holdoff ms, after which the pin is sampled again in case the final state
+	*differs from the accepted one (a very short press entirely inside the bounce).
+*/
+typedef struct{
+	uint8_t state; /** Debounced state of the pin */
+	uint8_t settling; /** Set while edges are being ignored */
+	uint32_t lastEdge; /** Time of the last accepted edge */
+	uint32_t holdoff; /** Time edges are ignored for after one is accepted */
+}debouncer;
+
+void initDebouncer(debouncer* d, uint8_t level, uint32_t holdoff);
+int32_t debounceEdge(debouncer* d, uint8_t level, uint32_t now);
+int32_t debounceSettle(debouncer* d, uint8_t level, uint32_t now);
+#endif
@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file    encoder.c 
+  * @author  David Webster - 100293854
+  * @brief   This file contains rotary encoder velocity tracking and an acceleration curve. 
+	*Has no hardware dependencies; it is given the steps and the times they happened, from interrupts 
+	*or from a hardware encoder counter, so it can be run on a host. 
+  ******************************************************************************
+  */
+
+#include "encoder.h"
+
+/**
+	* @brief Initialise a tracker at rest. 
+	*@param scale Output units per count at rest, with ENCODER_FIXED_SHIFT fractional bits. 
+	*@param now Current time, in microseconds. 
+*/
+void initEncoderTracker(encoderTracker* tracker, int32_t scale, uint32_t now){
+	tracker->position = 0;
+	tracker->lastTime = now - ENCODER_IDLE_TIME;
+	tracker->velocity = 0;
+	tracker->acceleration = 0;
+	tracker->scale = scale;
+	tracker->remainder = 0;
+}
+
+/**
+	* @brief Apply steps counts that happened at time, in microseconds. Returns how far to move, in output units. 
+	* Each count is scaled by 1 + (velocity / ENCODER_ACCEL_KNEE)^2, up to ENCODER_ACCEL_MAX, so slow turns 
+	* aim finely and fast spins cross the screen. Fractions of a unit are kept, so slow turns are never lost. 
+*/
+int32_t encoderCount(encoderTracker* tracker, int32_t steps, uint32_t time){
+	uint32_t interval = time - tracker->lastTime;
+	int32_t instant, previous = tracker->velocity, speed, gain, move;
+
+	if(steps == 0){return 0;}
+	/* Speed from the time since the last count; a pause or a change of direction starts again from rest */
+	if((interval >= ENCODER_IDLE_TIME) || (interval == 0)){
+		instant = (interval == 0) ? previous : 0;
+	}
+	else{
+		instant = (int32_t)(1000000 / interval) * steps;
+	}
+	if((previous > 0 && steps < 0) || (previous < 0 && steps > 0)){
+		tracker->velocity = instant;
+		tracker->remainder = 0;
+	}
+	else if(instant == 0){
+		tracker->velocity = 0;
+	}
+	else{
+		/* Smooth over the last few counts, as detent spacing is uneven */
+		tracker->velocity = previous + (instant - previous) / 4;
+	}
+	tracker->acceleration = (interval == 0) ? tracker->acceleration : 
+		(int32_t)(((int64_t)(tracker->velocity - previous) * 1000000) / (int64_t)interval);
+	tracker->lastTime = time;
+	tracker->position += steps;
+
+	/* gain = 1 + (speed/knee)^2, with ENCODER_FIXED_SHIFT fractional bits */
+	speed = (tracker->velocity < 0) ? -tracker->velocity : tracker->velocity;
+	speed = (speed > ENCODER_ACCEL_KNEE * ENCODER_ACCEL_MAX) ? ENCODER_ACCEL_KNEE * ENCODER_ACCEL_MAX : speed;
+	gain = (1 << ENCODER_FIXED_SHIFT) + ((speed * speed) << ENCODER_FIXED_SHIFT) / (ENCODER_ACCEL_KNEE * ENCODER_ACCEL_KNEE);
+	gain = (gain > (ENCODER_ACCEL_MAX << ENCODER_FIXED_SHIFT)) ? (ENCODER_ACCEL_MAX << ENCODER_FIXED_SHIFT) : gain;
+
+	/* Scale, keeping the fraction for next time */
+	move = tracker->remainder + (int32_t)(((int64_t)steps * tracker->scale * gain) >> ENCODER_FIXED_SHIFT);
+	tracker->remainder = move % (1 << ENCODER_FIXED_SHIFT);
+	return move / (1 << ENCODER_FIXED_SHIFT);
+}
+
+/**
+	* @brief Speed at now, in counts per second; positive is clockwise. Zero once the encoder has been still for ENCODER_IDLE_TIME. 
+*/
+int32_t encoderVelocity(const encoderTracker* tracker, uint32_t now){
+	if(now - tracker->lastTime >= ENCODER_IDLE_TIME){return 0;}
+	return tracker->velocity;
+}
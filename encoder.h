@@ -0,0 +1,39 @@
+/**
+  ******************************************************************************
+  * @file    encoder.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains rotary encoder velocity tracking and an acceleration curve, from timestamped counts.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#ifndef encoderHeader
+#define encoderHeader
+
+/* Counts further apart than this, in microseconds, are taken as starting from rest */
+#define ENCODER_IDLE_TIME 100000
+/* Speed, in counts per second, at which each count moves twice as far as at rest */
+#define ENCODER_ACCEL_KNEE 200
+/* Most a count can be scaled up by the acceleration curve */
+#define ENCODER_ACCEL_MAX 4
+/* Fractional bits of the output scale and gain */
+#define ENCODER_FIXED_SHIFT 8
+
+/**
+	*@brief Encoder tracker struct
+	*Fed every count with the time the interrupt saw it, so velocity is measured between the real transitions 
+	*rather than between main loop ticks. Only used by the main loop. 
+*/
+typedef struct{
+	int32_t position; /** Counts since initialisation */
+	uint32_t lastTime; /** Time of the last count, in microseconds */
+	int32_t velocity; /** Smoothed speed in counts per second; positive is clockwise */
+	int32_t acceleration; /** Change in velocity over the last count, in counts per second squared */
+	int32_t scale; /** Output units per count at rest, with ENCODER_FIXED_SHIFT fractional bits */
+	int32_t remainder; /** Fraction of an output unit carried to the next count */
+}encoderTracker;
+
+void initEncoderTracker(encoderTracker* tracker, int32_t scale, uint32_t now);
+int32_t encoderCount(encoderTracker* tracker, int32_t steps, uint32_t time);
+int32_t encoderVelocity(const encoderTracker* tracker, uint32_t now);
+#endif
@@ -0,0 +1,102 @@
+/**
+  ******************************************************************************
+  * @file    eventqueue.c 
+  * @author  David Webster - 100293854
+  * @brief   This file contains a lock-free single-producer, single-consumer queue of timestamped input events.
+	*Used to pass events from the EXTI interrupts to the main loop. Has no hardware dependencies, 
+	*so it can be stress tested with threads on a host. 
+  ******************************************************************************
+  */
+
+#include <stddef.h>
+#include "eventqueue.h"
+
+//Orders the event copy against the index update. On the M7 this is a DMB; on a host, a full fence. 
+#if defined(__CC_ARM)
+#define MEMORY_BARRIER() __dmb(0xF)
+#else
+#define MEMORY_BARRIER() __sync_synchronize()
+#endif
+
+#define EVENT_QUEUE_MASK (EVENT_QUEUE_SIZE - 1)
+
+/**
+	* @brief Empty a queue. Must not be called while either side is using it. 
+*/
+void initEventQueue(eventQueue* queue){
+	queue->head = 0;
+	queue->tail = 0;
+	queue->dropped = 0;
+}
+
+/**
+	* @brief Push an event. Producer side only. 
+	* Returns 0 on success, or -1 if the queue is full, in which case the event is dropped and counted. 
+*/
+int32_t pushEvent(eventQueue* queue, uint32_t timestamp, uint8_t type, int8_t value){
+	uint32_t head = queue->head;
+	inputEvent* slot;
+	
+	if((head - queue->tail) >= EVENT_QUEUE_SIZE){
+		queue->dropped++;
+		return -1;
+	}
+	slot = &queue->events[head & EVENT_QUEUE_MASK];
+	slot->timestamp = timestamp;
+	slot->type = type;
+	slot->value = value;
+	//Publish the event only once it's fully written
+	MEMORY_BARRIER();
+	queue->head = head + 1;
+	return 0;
+}
+
+/**
+	* @brief Pop the oldest event into event. Consumer side only. 
+	* Returns 0 on success, or -1 if the queue is empty. 
+*/
+int32_t popEvent(eventQueue* queue, inputEvent* event){
+	uint32_t tail = queue->tail;
+	
+	if(tail == queue->head){return -1;}
+	//Read the event only after seeing it published
+	MEMORY_BARRIER();
+	*event = queue->events[tail & EVENT_QUEUE_MASK];
+	//Finish reading before handing the slot back
+	MEMORY_BARRIER();
+	queue->tail = tail + 1;
+	return 0;
+}
+
+/**
+	* @brief Copy the oldest event into event without removing it. Consumer side only. 
+	* Returns 0 on success, or -1 if the queue is empty. 
+*/
+int32_t peekEvent(eventQueue* queue, inputEvent* event){
+	uint32_t tail = queue->tail;
+	
+	if(tail == queue->head){return -1;}
+	MEMORY_BARRIER();
+	*event = queue->events[tail & EVENT_QUEUE_MASK];
+	return 0;
+}
+
+/**
+	* @brief Pop up to max events into out[max], oldest first. Consumer side only. 
+	* Takes a snapshot of the head once, so an interrupt arriving mid-drain is left for the next call. 
+	* Returns the number of events copied. 
+*/
+uint32_t drainEvents(eventQueue* queue, inputEvent* out, uint32_t max){
+	uint32_t tail = queue->tail;
+	uint32_t count = queue->head - tail;
+	uint32_t i;
+	
+	count = (count > max) ? max : count;
+	MEMORY_BARRIER();
+	for(i = 0; i < count; i++){
+		out[i] = queue->events[(tail + i) & EVENT_QUEUE_MASK];
+	}
+	MEMORY_BARRIER();
+	queue->tail = tail + count;
+	return count;
+}
@@ -0,0 +1,50 @@
+/**
+  ******************************************************************************
+  * @file    eventqueue.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains a lock-free single-producer, single-consumer queue of timestamped input events.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#ifndef eventQueueHeader
+#define eventQueueHeader
+
+/* Queue capacity; must be a power of two */
+#define EVENT_QUEUE_SIZE 64
+
+/**
+	*@brief Input event type enumerator
+*/
+enum inputEventType{
+	eventEncoder, eventTouchSensor, eventButton
+};
+
+/**
+	*@brief A single timestamped input event.
+*/
+typedef struct{
+	uint32_t timestamp; /** Microsecond clock when the event happened */
+	uint8_t type; /** An inputEventType */
+	int8_t value; /** Encoder step of +-1, or the new pin state */
+}inputEvent;
+
+/**
+	*@brief Event queue struct
+	*Exactly one producer (an interrupt, or one thread) may push, and exactly one consumer may pop.
+	*head is only written by the producer and tail only by the consumer, so no locks or disabled interrupts are needed.
+	*Both are free-running and wrap at 2^32; their difference is the number of queued events.
+*/
+typedef struct{
+	inputEvent events[EVENT_QUEUE_SIZE]; /** Event storage */
+	volatile uint32_t head; /** Count of events pushed */
+	volatile uint32_t tail; /** Count of events popped */
+	volatile uint32_t dropped; /** Count of events lost to a full queue; only written by the producer */
+}eventQueue;
+
+void initEventQueue(eventQueue* queue);
+int32_t pushEvent(eventQueue* queue, uint32_t timestamp, uint8_t type, int8_t value);
+int32_t popEvent(eventQueue* queue, inputEvent* event);
+int32_t peekEvent(eventQueue* queue, inputEvent* event);
+uint32_t drainEvents(eventQueue* queue, inputEvent* out, uint32_t max);
+#endif
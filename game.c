@@ -8,15 +8,35 @@
 
 #include "game.h"
 #include "math_functions.h"
+#include "trig.h"
 
 /**
 	* @brief Move a projectile by 1 frame
 */
 void move(Projectile* proj, int32_t framerate){
+	proj->xpos_prev = proj->xpos;
+	proj->ypos_prev = proj->ypos;
 	proj->xpos += proj->xvel / framerate;
 	proj->ypos += proj->yvel / framerate;
 }
 
+/**
+	* @brief Move a projectile by an arbitrary time, which may be negative. Leaves the previous position alone. 
+*/
+void advance(Projectile* proj, int32_t milliseconds){
+	proj->xpos += proj->xvel * milliseconds / 1000;
+	proj->ypos += proj->yvel * milliseconds / 1000;
+}
+
+/**
+	* @brief Position between the last two moves. alpha of 0 gives the previous position, 1 the current one. 
+	* Output is written to out[2]. 
+*/
+void interpolatePosition(const Projectile* proj, float alpha, float out[2]){
+	out[0] = proj->xpos_prev + (proj->xpos - proj->xpos_prev) * alpha;
+	out[1] = proj->ypos_prev + (proj->ypos - proj->ypos_prev) * alpha;
+}
+
 /**
 	* @brief Create and populate a new projectile struct
 */
@@ -26,6 +46,8 @@ Projectile createProjectile(uint32_t xpos, uint32_t ypos, float xvel, float yvel
 	proj.ypos = (float)ypos;
 	proj.xpos_start = xpos;
 	proj.ypos_start = ypos;
+	proj.xpos_prev = proj.xpos;
+	proj.ypos_prev = proj.ypos;
 	proj.xvel = xvel;
 	proj.yvel = yvel;
 	return proj;
@@ -41,3 +63,12 @@ Projectile shoot(int32_t aimX, int32_t aimY, int32_t xpos, int32_t ypos, int32_t
 	return createProjectile(xpos, ypos, velArr[0], velArr[1]);;
 }
 
+/**
+	* @brief Shoot a projectile from the specified position (xpos, ypos) at angle from straight up, positive to the right, with a speed of vel. 
+	* Takes no square root, unlike shoot(). 
+*/
+Projectile shootAngle(int32_t angle, int32_t xpos, int32_t ypos, int32_t vel){
+	int32_t sine, cosine;
+	trigSinCos(angle, &sine, &cosine);
+	return createProjectile(xpos, ypos, (float)(vel * sine) / TRIG_ONE, (float)(vel * cosine) / TRIG_ONE);
+}
@@ -17,6 +17,8 @@
 typedef struct{
 	float xpos_start;/** the x position it started at*/
 	float ypos_start;/** the y position it started at*/
+	float xpos_prev;/** the x position before the last move, for interpolation */
+	float ypos_prev;/** the y position before the last move, for interpolation */
 	float xpos;/** the x position */
 	float ypos;/** the y position */
 	float xvel;/** the distance it moves per second along the x axis */
@@ -24,6 +26,9 @@ typedef struct{
 }Projectile;
 
 Projectile shoot(int32_t aimX, int32_t aimY, int32_t xpos, int32_t ypos, int32_t vel);
+Projectile shootAngle(int32_t angle, int32_t xpos, int32_t ypos, int32_t vel);
 void move(Projectile* proj, int32_t framerate);
+void advance(Projectile* proj, int32_t milliseconds);
+void interpolatePosition(const Projectile* proj, float alpha, float out[2]);
 Projectile createProjectile(uint32_t xpos, uint32_t ypos, float xvel, float yvel);
 #endif
@@ -0,0 +1,338 @@
+/**
+  ******************************************************************************
+  * @file    band_bench.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only check and scaling benchmark for drawing frames in bands on several threads, in Render.c.
+	*Build from the repository root with:
+	*  gcc -O2 -pthread -DRENDER_THREADS=16 -I. host/band_bench.c Render.c Fonts.c math_functions.c tables.c particles.c starfield.c trig.c prng.c -lm -o band_bench
+	*Stands in for the platform's frame buffers, as circle_bench.c does, keeping a copy of each frame presented. Draws
+	*the same frames of a scene with every kind of drawing call, many times busier than the game's, first as each call
+	*is made, then in bands on 1 to RENDER_THREADS threads, and checks that every frame is the same bit for bit, on one
+	*layer and on two, with the same tiles left to clear, and that 1 thread draws each call as it is made rather than
+	*paying to record it. Then times a frame on 1 up to as many threads as there are cores, against drawing it as the
+	*calls are made. Exits non-zero if a check fails.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Portrait, as Render.c draws */
+#define GLCD_LANDSCAPE 0
+#include "GLCD_Config.h"
+#include "platform.h"
+#include "Render.h"
+#include "particles.h"
+#include "starfield.h"
+
+#define CHECK_FRAMES 12
+#define BENCH_FRAMES 40
+#define BENCH_RUNS 3
+/* Milliseconds per rendered frame, as in Mainloop.c */
+#define FRAME_MS 33
+/* Times over the game's busiest frame the scene draws */
+#define LOAD 8
+#define SCREEN_PIXELS (GLCD_WIDTH * GLCD_HEIGHT)
+/* Guard words either side of each buffer, to catch writes off the screen */
+#define GUARD 4096
+#define GUARD_VALUE 0xA5A5
+#define KEY GLCD_COLOR_BLACK
+
+#if(RENDER_THREADS == 0)
+#error "Build with -DRENDER_THREADS=n, as the build line above"
+#endif
+
+static uint16_t memory[3][GUARD + SCREEN_PIXELS + GUARD];
+static uint16_t* presented; /** Each frame presented, CHECK_FRAMES of them */
+static uint32_t presents; /** Frames presented since the last restart() */
+static uint32_t cleared[CHECK_FRAMES]; /** Pixels clearSprites() wrote each frame, layered */
+static particlePool pool;
+static starfield field;
+static int failures;
+
+void platformDisplayInit(void){
+	uint32_t i, j;
+	for(i = 0; i < 3; i++){
+		for(j = 0; j < sizeof(memory[0]) / sizeof(memory[0][0]); j++){
+			memory[i][j] = GUARD_VALUE;
+		}
+	}
+}
+
+uint16_t* platformFrameBuffer(uint32_t index){
+	return &memory[index ? 1 : 0][GUARD];
+}
+
+void platformPresent(uint32_t index){
+	if(presents < CHECK_FRAMES){
+		memcpy(&presented[presents * SCREEN_PIXELS], platformFrameBuffer(index), SCREEN_PIXELS * sizeof(uint16_t));
+	}
+	presents++;
+}
+
+static uint16_t* background(void){
+	return &memory[2][GUARD];
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int guardsIntact(void){
+	uint32_t b, i;
+	for(b = 0; b < 3; b++){
+		for(i = 0; i < GUARD; i++){
+			if((memory[b][i] != GUARD_VALUE) || (memory[b][GUARD + SCREEN_PIXELS + i] != GUARD_VALUE)){
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+static void restart(void){
+	initParticles(&pool, 21);
+	initStars(&field, STAR_CAPACITY, 9);
+	presents = 0;
+}
+
+/**
+	* @brief Moves the stars and sparks on a frame, bursting sparks now and then, some off the edges of the screen.
+*/
+static void step(uint32_t frame){
+	if((frame % 4) == 0){
+		emitBurst(&pool, (float)(10 + (frame * 37) % 252), (float)(20 + (frame * 71) % 440), 300, 120, 900, GLCD_COLOR_WHITE, 0);
+		emitBurst(&pool, (float)((frame * 53) % 300) - 10, (float)((frame * 29) % 500) - 10, 200, 200, 600, GLCD_COLOR_YELLOW, 1);
+	}
+	updateParticles(&pool, FRAME_MS);
+	updateStars(&field, FRAME_MS);
+}
+
+/**
+	* @brief Draws frame's moving things, LOAD times over: anti-aliased and aliased circles, trails, lines,
+	* meteors, sparks, text, boxes and single blended pixels, in several colours and with and without gamma.
+	* Plenty cross the edges of the screen, and the bands.
+*/
+static void drawMoving(uint32_t frame){
+	static int16_t xs[8 * LOAD][5], ys[8 * LOAD][5];
+	polygon meteors[8 * LOAD];
+	uint32_t i, x, y, n = frame * 2654435761u;
+	char text[16];
+
+	for(i = 0; i < 6 * LOAD; i++){
+		n = n * 1103515245 + 12345;
+		x = (n >> 8) % 300;
+		y = (n >> 16) % 500;
+		setForegroundColor((i & 1) ? GLCD_COLOR_CYAN : GLCD_COLOR_MAROON);
+		drawFilledCircleAA(TO_SUBPIXEL(x) - TO_SUBPIXEL(14) + (int32_t)(n & 15), TO_SUBPIXEL(y) - TO_SUBPIXEL(10),
+			TO_SUBPIXEL(3 + (i % 40)) + (int32_t)((n >> 4) & 15));
+	}
+	setForegroundColor(GLCD_COLOR_GREEN);
+	drawFilledCircle(136, 240, 30 + (frame % 9));
+	for(i = 0; i < 5 * LOAD; i++){
+		x = 12 + ((frame * (3 + i) + i * 50) % 240);
+		y = 40 + ((frame * (5 + 2 * i) + i * 70) % 400);
+		setBlendGamma((uint8_t)(i & 1));
+		setForegroundColor((i % 3) ? GLCD_COLOR_NAVY : GLCD_COLOR_PURPLE);
+		drawThickLine(x, 20, x + (i % 7) - 3, y, 3);
+		drawThickLine(x, y, x + 10 + (i % 17), y + 4 + (i % 5), 2);
+		setForegroundColor(GLCD_COLOR_WHITE);
+		drawLine(x, y, (x * 7 + 50) % 272, (y * 3 + frame) % 480);
+	}
+	setBlendGamma(0);
+	for(i = 0; i < 8 * LOAD; i++){
+		x = TO_SUBPIXEL(((i * 37) % 300) - 14);
+		y = TO_SUBPIXEL(490 - ((frame * 4 + i * 40) % 520)) + (i * 5);
+		xs[i][0] = (int16_t)(x - TO_SUBPIXEL(9));
+		ys[i][0] = (int16_t)(y - TO_SUBPIXEL(4));
+		xs[i][1] = (int16_t)(x + TO_SUBPIXEL(2));
+		ys[i][1] = (int16_t)(y - TO_SUBPIXEL(10));
+		xs[i][2] = (int16_t)(x + TO_SUBPIXEL(4));
+		ys[i][2] = (int16_t)(y);
+		xs[i][3] = (int16_t)(x + TO_SUBPIXEL(10));
+		ys[i][3] = (int16_t)(y + TO_SUBPIXEL(3));
+		xs[i][4] = (int16_t)(x - TO_SUBPIXEL(1));
+		ys[i][4] = (int16_t)(y + TO_SUBPIXEL(11 + (i % 20)));
+		meteors[i].x = xs[i];
+		meteors[i].y = ys[i];
+		meteors[i].count = 5;
+		meteors[i].fill = (i & 1) ? GLCD_COLOR_MAROON : GLCD_COLOR_OLIVE;
+		meteors[i].outline = GLCD_COLOR_RED;
+		meteors[i].outlined = (uint8_t)((i % 3) != 0);
+	}
+	fillPolygons(meteors, 8 * LOAD);
+	//Changed straight after, as the game's own arrays may be
+	memset(xs, 0, sizeof(xs));
+	drawSplats(pool.x, pool.y, pool.color, pool.alpha, pool.count, 1 + (frame & 1));
+	setForegroundColor(GLCD_COLOR_YELLOW);
+	fillRectangle(20, 30 + (frame % 50), 40, 25);
+	GLCD_DrawRectangle(100, 200, 60 + (frame % 30), 40);
+	setForegroundColor(GLCD_COLOR_WHITE);
+	sprintf(text, "Frame %u", (unsigned)frame);
+	GLCD_DrawString(8 + (frame % 100), 440, text);
+	for(i = 0; i < 64; i++){
+		blendPixel((i * 7) % GLCD_HEIGHT, (i * 13 + frame) % GLCD_WIDTH, (uint8_t)(i * 4));
+		blendPixelFast((i * 11) % GLCD_HEIGHT, (i * 3 + frame) % GLCD_WIDTH, (uint8_t)(i * 4));
+		blendPixelRamp((i * 5) % GLCD_HEIGHT, (i * 17 + frame) % GLCD_WIDTH, (uint8_t)(i * 4));
+	}
+}
+
+/**
+	* @brief Draws frames frames on one layer with threads threads, or as each call is made for 0: the stars and
+	* background colour cleared together, then the moving things, with the glow over every other frame.
+*/
+static void drawFrames(uint32_t threads, uint32_t frames){
+	uint32_t frame;
+	setRenderThreads(threads);
+	restart();
+	for(frame = 0; frame < frames; frame++){
+		step(frame);
+		setBackgroundColor((frame % 5) ? GLCD_COLOR_BLACK : 0x0841);
+		clearScreenStars(field.columnStarts, field.y, field.color);
+		drawMoving(frame);
+		if(frame & 1){
+			bloomExtract();
+			bloomBlurRows();
+			bloomBlurColumns();
+			bloomComposite();
+		}
+		switchBuffer();
+	}
+	setRenderThreads(0);
+}
+
+/**
+	* @brief As drawFrames(), but on the sprite layer over a background, clearing only the tiles drawn on.
+*/
+static void drawLayeredFrames(uint32_t threads, uint32_t frames){
+	uint32_t frame;
+	setRenderThreads(threads);
+	restart();
+	drawToBackground();
+	setBackgroundColor(GLCD_COLOR_NAVY);
+	clearScreen();
+	drawToSprites();
+	invalidateSprites();
+	for(frame = 0; frame < frames; frame++){
+		step(frame);
+		cleared[frame % CHECK_FRAMES] = clearSprites();
+		drawStars(field.columnStarts, field.y, field.color, field.drawn[backBufferIndex()]);
+		drawMoving(frame);
+		switchBuffer();
+	}
+	setRenderThreads(0);
+}
+
+/**
+	* @brief Nonzero if the frames just presented, and the tiles cleared, match those in expected and expectedCleared.
+*/
+static int sameFrames(const uint16_t* expected, const uint32_t* expectedCleared){
+	return (memcmp(presented, expected, sizeof(uint16_t) * SCREEN_PIXELS * CHECK_FRAMES) == 0) &&
+		((expectedCleared == NULL) || (memcmp(cleared, expectedCleared, sizeof(cleared)) == 0));
+}
+
+/**
+	* @brief Nonzero if, drawing with threads threads, a circle is on the back buffer before anything is flushed.
+*/
+static int drawnAsMade(uint32_t threads){
+	static uint16_t before[SCREEN_PIXELS];
+	int drawn;
+	setRenderThreads(threads);
+	memcpy(before, platformFrameBuffer(backBufferIndex()), sizeof(before));
+	setForegroundColor(GLCD_COLOR_WHITE);
+	drawFilledCircle(136, 240, 30);
+	drawn = memcmp(before, platformFrameBuffer(backBufferIndex()), sizeof(before)) != 0;
+	setRenderThreads(0);
+	return drawn;
+}
+
+/**
+	* @brief Best time over BENCH_RUNS for a frame of the scene on threads threads, or as the calls are made for 0.
+*/
+static double timeFrames(uint32_t threads){
+	uint32_t run;
+	double begin, seconds, best = 1e9;
+	for(run = 0; run < BENCH_RUNS; run++){
+		begin = nowSeconds();
+		drawFrames(threads, BENCH_FRAMES);
+		seconds = (nowSeconds() - begin) / BENCH_FRAMES;
+		best = (seconds < best) ? seconds : best;
+	}
+	return best;
+}
+
+int main(void){
+	static uint32_t serialCleared[CHECK_FRAMES];
+	uint16_t *serial, *serialLayered;
+	uint32_t t, cores, differ, differLayered, lit = 0, i;
+	double direct, one = 0, seconds;
+
+	presented = (uint16_t*)malloc(sizeof(uint16_t) * SCREEN_PIXELS * CHECK_FRAMES);
+	serial = (uint16_t*)malloc(sizeof(uint16_t) * SCREEN_PIXELS * CHECK_FRAMES);
+	serialLayered = (uint16_t*)malloc(sizeof(uint16_t) * SCREEN_PIXELS * CHECK_FRAMES);
+	GLCD_Initialize_Doublebuffer();
+
+	/* Drawn as each call is made */
+	drawFrames(0, CHECK_FRAMES);
+	memcpy(serial, presented, sizeof(uint16_t) * SCREEN_PIXELS * CHECK_FRAMES);
+	for(i = 0; i < SCREEN_PIXELS; i++){
+		lit += presented[(CHECK_FRAMES - 1) * SCREEN_PIXELS + i] != 0;
+	}
+	GLCD_InitializeLayers(background(), KEY);
+	drawLayeredFrames(0, CHECK_FRAMES);
+	memcpy(serialLayered, presented, sizeof(uint16_t) * SCREEN_PIXELS * CHECK_FRAMES);
+	memcpy(serialCleared, cleared, sizeof(cleared));
+	printf("the last frame covers %u of %u pixels\n", (unsigned)lit, (unsigned)SCREEN_PIXELS);
+
+	/* In bands, on each count of threads */
+	differ = 0;
+	differLayered = 0;
+	for(t = 1; t <= RENDER_THREADS; t++){
+		drawLayeredFrames(t, CHECK_FRAMES);
+		differLayered += !sameFrames(serialLayered, serialCleared);
+	}
+	GLCD_Initialize_Doublebuffer();
+	for(t = 1; t <= RENDER_THREADS; t++){
+		drawFrames(t, CHECK_FRAMES);
+		differ += !sameFrames(serial, NULL);
+	}
+	printf("thread counts drawing differently: %u of %u on one layer, %u layered\n", (unsigned)differ, RENDER_THREADS, (unsigned)differLayered);
+	check(differ == 0, "on one layer, frames drawn in bands match those drawn call by call, bit for bit, on every count of threads");
+	check(differLayered == 0, "layered, they match too, and leave the same tiles to clear");
+	check(guardsIntact(), "no band writes outside the frame buffers");
+	check(drawnAsMade(1) && !drawnAsMade(2), "1 thread draws each call as it is made; 2 record it to draw in bands");
+
+	/* Scaling */
+	cores = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+	cores = (cores > RENDER_THREADS) ? RENDER_THREADS : cores;
+	direct = timeFrames(0);
+	printf("%u cores; a frame %u times the game's busiest\n", (unsigned)cores, LOAD);
+	printf("%8s %12s %14s %14s\n", "threads", "frame us", "vs call by call", "vs 1 thread");
+	printf("%8s %12.1f %14.2fx %14s\n", "calls", direct * 1e6, 1.0, "");
+	for(t = 1; t <= cores; t++){
+		seconds = timeFrames(t);
+		one = (t == 1) ? seconds : one;
+		printf("%8u %12.1f %14.2fx %14.2fx\n", (unsigned)t, seconds * 1e6, direct / seconds, one / seconds);
+	}
+	if(cores < 2){
+		printf("one core here, so there is no scaling to see\n");
+	}
+	else{
+		check(seconds < one, "more threads draw a frame faster than one");
+	}
+
+	free(presented);
+	free(serial);
+	free(serialLayered);
+	return failures ? 1 : 0;
+}
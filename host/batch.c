@@ -0,0 +1,325 @@
+/**
+  ******************************************************************************
+  * @file    batch.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only batch runner; plays many independent games across every core, for tuning difficulty.
+	*Build from the repository root with:
+	*  gcc -O2 -pthread -I. host/batch.c simulation.c game.c list.c math_functions.c trig.c tables.c replay.c prng.c -lm -o batch
+	*Usage: batch [-n games] [-t threads] [-p scripted|bot] [-s seed] [-m meteors] [-i spawn interval]
+	*             [-v min speed] [-r speed range] [-f max ticks] [-o out.csv]
+	*Writes one CSV row per game, then prints win rate, mean ticks to finish and throughput to stderr.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "simulation.h"
+#include "math_functions.h"
+#include "trig.h"
+
+#define DEFAULT_GAMES 10000
+#define DEFAULT_MAX_TICKS (SIM_RATE*3600)
+#define MAX_THREADS 256
+
+/** Enumerator of the player policies */
+enum policy{
+	scripted, bot
+};
+
+/** Outcome of one game */
+typedef struct{
+	uint32_t stream; /** Generator stream the game was played on; the seed is shared by the whole batch */
+	int result; /** 1 win, 0 lose, -1 ran out of ticks */
+	uint32_t ticks; /** Simulation ticks from leaving the start screen to the game ending */
+	uint64_t nanoseconds; /** Wall time spent stepping the game */
+}gameResult;
+
+/**
+	*@brief Per-worker queue of game indices.
+	*The range [lo, hi) is packed into one word so the owner can pop from the bottom and thieves can take
+	*the top half with a single compare-and-swap each.
+*/
+typedef struct{
+	_Atomic uint64_t range;
+	char pad[64 - sizeof(uint64_t)]; /** Keep each queue on its own cache line */
+}workQueue;
+
+/** Shared batch configuration */
+static struct{
+	uint32_t games;
+	uint32_t threads;
+	uint32_t maxTicks;
+	uint32_t seed;
+	enum policy policy;
+	int meteorCount;
+	int spawnInterval;
+	int meteorSpeedMin;
+	int meteorSpeedRange;
+	gameResult* results;
+	workQueue* queues;
+}batch;
+
+static uint64_t packRange(uint32_t lo, uint32_t hi){
+	return ((uint64_t)hi << 32) | lo;
+}
+
+static uint64_t nowNanoseconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+	* @brief Take the next game from the bottom of a worker's own queue. Returns 0 if it is empty.
+*/
+static int popLocal(workQueue* queue, uint32_t* index){
+	uint64_t old = atomic_load(&queue->range);
+	uint32_t lo, hi;
+	do{
+		lo = (uint32_t)old;
+		hi = (uint32_t)(old >> 32);
+		if(lo >= hi){return 0;}
+	}while(!atomic_compare_exchange_weak(&queue->range, &old, packRange(lo + 1, hi)));
+	*index = lo;
+	return 1;
+}
+
+/**
+	* @brief Steal the top half of a victim's queue into thief's queue. Returns 0 if there was nothing to steal.
+	* Only the owner ever refills its own queue, and only when it is empty, so the store cannot race another thief.
+*/
+static int steal(workQueue* victim, workQueue* thief){
+	uint64_t old = atomic_load(&victim->range);
+	uint32_t lo, hi, mid;
+	do{
+		lo = (uint32_t)old;
+		hi = (uint32_t)(old >> 32);
+		if(lo >= hi){return 0;}
+		mid = hi - (hi - lo + 1) / 2;
+	}while(!atomic_compare_exchange_weak(&victim->range, &old, packRange(lo, mid)));
+	atomic_store(&thief->range, packRange(mid, hi));
+	return 1;
+}
+
+/**
+	* @brief Scripted player; sweeps the aim and fires and explodes on a fixed rhythm, ignoring the game.
+*/
+static void scriptedPolicy(const gameState* sim, uint32_t tick, inputFrame* input){
+	int prevState = input->touchSensorState;
+	uint32_t frame = tick * 30 / SIM_RATE;
+	(void)sim;
+	input->encoderCounter = (int32_t)((frame / 8) % 21) * AIM_STEP - COUNTERMAX;
+	input->touchSensorState = (frame % 45) < 20;
+	input->touchSensorChanged = (input->touchSensorState != prevState);
+}
+
+/**
+	* @brief Bot player; aims at the lowest meteor, fires, and explodes once a meteor is in the blast radius.
+	* Gives up on a shot that leaves the screen by exploding it.
+*/
+static void botPolicy(const gameState* sim, uint32_t tick, inputFrame* input){
+	iterator iter;
+	Projectile *cur, *target = NULL;
+	int prevState = input->touchSensorState;
+	int32_t counter;
+	int hold = prevState;
+	(void)tick;
+
+	iter = getIterator((list*)&sim->enemyList);
+	while((cur = getNext(&iter)) != NULL){
+		if((target == NULL) || (cur->ypos < target->ypos)){target = cur;}
+	}
+
+	if(sim->explosionTimer != 0){
+		hold = 0;
+	}
+	else if(!prevState){
+		/* Aim along the line from the turret through the lowest meteor, to the nearest aim unit */
+		if((target != NULL) && (target->ypos > 7)){
+			counter = trigAtan2((int32_t)(target->xpos - 136), (int32_t)(target->ypos - 7));
+			counter = (counter + ((counter < 0) ? -AIM_ANGLE_UNIT : AIM_ANGLE_UNIT) / 2) / AIM_ANGLE_UNIT;
+			counter = (counter > COUNTERMAX) ? COUNTERMAX : counter;
+			counter = (counter < -COUNTERMAX) ? -COUNTERMAX : counter;
+			input->encoderCounter = counter;
+			hold = (target->ypos < 420);
+		}
+	}
+	else{
+		/* Let go to explode when anything is in range, or the shot has missed */
+		hold = 1;
+		iter = getIterator((list*)&sim->enemyList);
+		while((cur = getNext(&iter)) != NULL){
+			if(isInRadius(cur->xpos, cur->ypos, sim->bullet.xpos, sim->bullet.ypos, BULLET_EXPLOSION_RADIUS - 10)){hold = 0;}
+		}
+		if((sim->bullet.ypos > 480) || (sim->bullet.ypos < 0)){hold = 0;}
+	}
+	input->touchSensorState = hold;
+	input->touchSensorChanged = (hold != prevState);
+}
+
+/**
+	* @brief Play one game to the end, or until maxTicks.
+*/
+static void runGame(uint32_t index){
+	gameState sim;
+	inputFrame input;
+	gameResult* result = &batch.results[index];
+	uint32_t tick;
+	uint64_t begin;
+
+	memset(&sim, 0, sizeof(sim));
+	memset(&input, 0, sizeof(input));
+	result->stream = index;
+	initGame(&sim, batch.seed);
+	prngSeed(&sim.rng, batch.seed, index);
+	sim.meteorCount = batch.meteorCount;
+	sim.spawnInterval = batch.spawnInterval;
+	sim.meteorSpeedMin = batch.meteorSpeedMin;
+	sim.meteorSpeedRange = batch.meteorSpeedRange;
+
+	begin = nowNanoseconds();
+	/* Touch the screen to leave the start screen */
+	input.touchscreenPressed = 1;
+	step(&sim, &input);
+	input.touchscreenPressed = 0;
+
+	result->result = -1;
+	for(tick = 0; tick < batch.maxTicks; tick++){
+		input.tick = tick * 1000 / SIM_RATE;
+		if(batch.policy == bot){botPolicy(&sim, tick, &input);}
+		else{scriptedPolicy(&sim, tick, &input);}
+		step(&sim, &input);
+		if(sim.events & EVENT_GAME_OVER){
+			result->result = (sim.state == win) ? 1 : 0;
+			tick++;
+			break;
+		}
+	}
+	result->ticks = tick;
+	result->nanoseconds = nowNanoseconds() - begin;
+	deleteList(&sim.enemyList);
+}
+
+/**
+	* @brief Worker thread. Drains its own queue, then steals from the others until all are empty.
+*/
+static void* worker(void* arg){
+	uint32_t self = (uint32_t)(uintptr_t)arg;
+	uint32_t index, i, victim;
+	for(;;){
+		while(popLocal(&batch.queues[self], &index)){
+			runGame(index);
+		}
+		for(i = 1; i < batch.threads; i++){
+			victim = (self + i) % batch.threads;
+			if(steal(&batch.queues[victim], &batch.queues[self])){break;}
+		}
+		if(i == batch.threads){return NULL;}
+	}
+}
+
+int main(int argc, char** argv){
+	pthread_t threads[MAX_THREADS];
+	FILE* out = stdout;
+	const char* outPath = NULL;
+	uint32_t i, wins = 0, losses = 0, finished = 0;
+	uint64_t begin, elapsed, tickTotal = 0, gameNanoseconds = 0;
+	int opt;
+	long cores;
+
+	cores = sysconf(_SC_NPROCESSORS_ONLN);
+	batch.games = DEFAULT_GAMES;
+	batch.threads = (cores > 0) ? (uint32_t)cores : 1;
+	batch.maxTicks = DEFAULT_MAX_TICKS;
+	batch.seed = 1;
+	batch.policy = bot;
+	batch.meteorCount = DEFAULT_METEOR_COUNT;
+	batch.spawnInterval = DEFAULT_SPAWN_INTERVAL;
+	batch.meteorSpeedMin = DEFAULT_METEOR_SPEED_MIN;
+	batch.meteorSpeedRange = DEFAULT_METEOR_SPEED_RANGE;
+
+	while((opt = getopt(argc, argv, "n:t:p:s:m:i:v:r:f:o:")) != -1){
+		switch(opt){
+			case 'n': batch.games = (uint32_t)strtoul(optarg, NULL, 10); break;
+			case 't': batch.threads = (uint32_t)strtoul(optarg, NULL, 10); break;
+			case 'p': batch.policy = (strcmp(optarg, "scripted") == 0) ? scripted : bot; break;
+			case 's': batch.seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+			case 'm': batch.meteorCount = atoi(optarg); break;
+			case 'i': batch.spawnInterval = atoi(optarg); break;
+			case 'v': batch.meteorSpeedMin = atoi(optarg); break;
+			case 'r': batch.meteorSpeedRange = atoi(optarg); break;
+			case 'f': batch.maxTicks = (uint32_t)strtoul(optarg, NULL, 10); break;
+			case 'o': outPath = optarg; break;
+			default:
+				fprintf(stderr, "usage: %s [-n games] [-t threads] [-p scripted|bot] [-s seed] [-m meteors] "
+					"[-i spawn interval] [-v min speed] [-r speed range] [-f max ticks] [-o out.csv]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(batch.threads < 1){batch.threads = 1;}
+	if(batch.threads > MAX_THREADS){batch.threads = MAX_THREADS;}
+	if(batch.meteorSpeedRange < 1){batch.meteorSpeedRange = 1;}
+
+	batch.results = (gameResult*)calloc(batch.games ? batch.games : 1, sizeof(gameResult));
+	batch.queues = (workQueue*)calloc(batch.threads, sizeof(workQueue));
+	if((batch.results == NULL) || (batch.queues == NULL)){
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	/* Deal the games out evenly; stealing evens out the rest */
+	for(i = 0; i < batch.threads; i++){
+		atomic_store(&batch.queues[i].range, packRange(
+			(uint32_t)((uint64_t)batch.games * i / batch.threads),
+			(uint32_t)((uint64_t)batch.games * (i + 1) / batch.threads)));
+	}
+
+	begin = nowNanoseconds();
+	for(i = 0; i < batch.threads; i++){
+		pthread_create(&threads[i], NULL, worker, (void*)(uintptr_t)i);
+	}
+	for(i = 0; i < batch.threads; i++){
+		pthread_join(threads[i], NULL);
+	}
+	elapsed = nowNanoseconds() - begin;
+
+	if(outPath != NULL){
+		out = fopen(outPath, "w");
+		if(out == NULL){
+			fprintf(stderr, "could not open %s\n", outPath);
+			return 1;
+		}
+	}
+	fprintf(out, "game,seed,stream,result,ticks,nanoseconds\n");
+	for(i = 0; i < batch.games; i++){
+		gameResult* r = &batch.results[i];
+		fprintf(out, "%u,%u,%u,%s,%u,%llu\n", i, batch.seed, r->stream,
+			(r->result == 1) ? "win" : ((r->result == 0) ? "lose" : "timeout"),
+			r->ticks, (unsigned long long)r->nanoseconds);
+		if(r->result == 1){wins++;}
+		if(r->result == 0){losses++;}
+		if(r->result >= 0){
+			finished++;
+			tickTotal += r->ticks;
+		}
+		gameNanoseconds += r->nanoseconds;
+	}
+	if(out != stdout){fclose(out);}
+
+	fprintf(stderr, "games %u threads %u policy %s\n", batch.games, batch.threads, (batch.policy == bot) ? "bot" : "scripted");
+	fprintf(stderr, "win rate %.4f (%u wins, %u losses, %u timeouts)\n",
+		batch.games ? (double)wins / batch.games : 0.0, wins, losses, batch.games - finished);
+	fprintf(stderr, "mean ticks to finish %.1f (%.1f s)\n", finished ? (double)tickTotal / finished : 0.0,
+		finished ? (double)tickTotal / finished / SIM_RATE : 0.0);
+	fprintf(stderr, "wall %.3f s, %.0f games/s, mean %.1f us/game\n", elapsed / 1e9,
+		elapsed ? batch.games / (elapsed / 1e9) : 0.0,
+		batch.games ? gameNanoseconds / 1e3 / batch.games : 0.0);
+
+	free(batch.results);
+	free(batch.queues);
+	return 0;
+}
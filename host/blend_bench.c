@@ -0,0 +1,213 @@
+/**
+  ******************************************************************************
+  * @file    blend_bench.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only accuracy and speed benchmark for the pixel blends in Render.c.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/blend_bench.c Render.c Fonts.c math_functions.c tables.c -lm -o blend_bench
+	*Stands in for the platform's frame buffers, as circle_bench.c does. Blends every alpha of a spread of colours
+	*over a spread of backgrounds with blendPixel(), blendPixelFast() and blendPixelRamp(), with and without gamma,
+	*and measures how far each lands from the exact blend, worked out in floating point: straight for the first
+	*three, in linear light for the ramp with gamma. Counts the distinct shades along a white fade, where a coarse
+	*alpha shows as bands. Then times each blend at random alphas, over black as most edges are, and over colour.
+	*Exits non-zero if a check fails. Only the time over black is checked: over colour the ramp still has a
+	*multiply for the background, which the host does as cheaply as the table lookups blendPixel() saves.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+/* Portrait, as Render.c draws */
+#define GLCD_LANDSCAPE 0
+#include "GLCD_Config.h"
+#include "platform.h"
+#include "Render.h"
+
+#define BENCH_PIXELS 100000
+#define BENCH_RUNS 7
+#define BLENDS 4
+
+typedef int32_t (*blendFunction)(uint32_t x, uint32_t y, uint8_t alpha);
+
+/**
+	*@brief Error of a blend against the exact result, in 8-bit steps, over every channel blended
+*/
+typedef struct{
+	double total; /** Summed error */
+	double worst; /** Largest error */
+	uint32_t count; /** Channels measured */
+}blendError;
+
+static uint16_t memory[2][GLCD_WIDTH * GLCD_HEIGHT];
+static uint16_t black[GLCD_WIDTH * GLCD_HEIGHT];
+static uint16_t colored[GLCD_WIDTH * GLCD_HEIGHT];
+static uint32_t xs[BENCH_PIXELS], ys[BENCH_PIXELS];
+static uint8_t alphas[BENCH_PIXELS];
+static int failures;
+
+static const char* const names[BLENDS] = {"blendPixel", "blendPixelFast", "blendPixelRamp", "ramp, gamma"};
+static const blendFunction blends[BLENDS] = {blendPixel, blendPixelFast, blendPixelRamp, blendPixelRamp};
+
+void platformDisplayInit(void){
+}
+
+uint16_t* platformFrameBuffer(uint32_t index){
+	return memory[index ? 1 : 0];
+}
+
+void platformPresent(uint32_t index){
+	(void)index;
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double srgbDecode(double level){
+	return (level <= 0.04045) ? level / 12.92 : pow((level + 0.055) / 1.055, 2.4);
+}
+
+static double srgbEncode(double linear){
+	return (linear <= 0.0031308) ? linear * 12.92 : 1.055 * pow(linear, 1 / 2.4) - 0.055;
+}
+
+/**
+	* @brief Exact blend of one channel with levels steps, alpha out of 255, as a fraction of full scale.
+*/
+static double exactBlend(uint32_t fg, uint32_t bg, uint32_t levels, uint32_t alpha, int gamma){
+	double a = alpha / 255.0;
+	if(gamma){
+		return srgbEncode(srgbDecode(fg / (double)levels) * a + srgbDecode(bg / (double)levels) * (1 - a));
+	}
+	return (fg * a + bg * (1 - a)) / levels;
+}
+
+static void measure(blendError* e, uint32_t got, uint32_t fg, uint32_t bg, uint32_t levels, uint32_t alpha, int gamma){
+	double error = fabs(got / (double)levels - exactBlend(fg, bg, levels, alpha, gamma)) * 255;
+	e->total += error;
+	e->worst = (error > e->worst) ? error : e->worst;
+	e->count++;
+}
+
+/**
+	* @brief Blend with blend b of a spread of colours over a spread of backgrounds at every alpha, into e.
+	* Nonzero if alpha 0 always left the background and alpha 255 always gave the colour.
+*/
+static int accuracy(uint32_t b, blendError* e){
+	static const uint16_t colors[] = {GLCD_COLOR_WHITE, GLCD_COLOR_NAVY, GLCD_COLOR_CYAN, GLCD_COLOR_RED, GLCD_COLOR_PURPLE,
+		GLCD_COLOR_DARK_GREEN, 0x8410, 0x2945, 0xFFE0, 0x0841};
+	uint32_t f, g, a, ends = 1;
+	uint16_t fg, bg, out;
+	uint16_t* frame = memory[1];
+	memset(e, 0, sizeof(*e));
+	for(f = 0; f < sizeof(colors) / sizeof(colors[0]); f++){
+		fg = colors[f];
+		setForegroundColor(fg);
+		for(g = 0; g < sizeof(colors) / sizeof(colors[0]) + 1; g++){
+			bg = g ? colors[g - 1] : GLCD_COLOR_BLACK;
+			for(a = 0; a < 256; a++){
+				frame[0] = bg;
+				blends[b](0, 0, (uint8_t)a);
+				out = frame[0];
+				if(((a == 0) && (out != bg)) || ((a == 255) && (out != fg))){
+					ends = 0;
+				}
+				measure(e, out >> 11, fg >> 11, bg >> 11, 31, a, b == 3);
+				measure(e, (out >> 5) & 0x3F, (fg >> 5) & 0x3F, (bg >> 5) & 0x3F, 63, a, b == 3);
+				measure(e, out & 0x1F, fg & 0x1F, bg & 0x1F, 31, a, b == 3);
+			}
+		}
+	}
+	return ends;
+}
+
+/**
+	* @brief Distinct levels of the 6-bit green channel blend b gives fading white in over black, at every alpha.
+*/
+static uint32_t shades(uint32_t b){
+	uint8_t seen[64];
+	uint32_t a, g, count = 0;
+	memset(seen, 0, sizeof(seen));
+	setForegroundColor(GLCD_COLOR_WHITE);
+	for(a = 0; a < 256; a++){
+		memory[1][0] = GLCD_COLOR_BLACK;
+		blends[b](0, 0, (uint8_t)a);
+		g = (memory[1][0] >> 5) & 0x3F;
+		count += !seen[g];
+		seen[g] = 1;
+	}
+	return count;
+}
+
+/**
+	* @brief Best time over BENCH_RUNS for blend b to blend BENCH_PIXELS random pixels of the frame start, in ns a pixel.
+*/
+static double timeBlend(uint32_t b, const uint16_t* start){
+	uint32_t run, i;
+	double begin, seconds, best = 1e9;
+	blendFunction blend = blends[b];
+	setForegroundColor(GLCD_COLOR_CYAN);
+	for(run = 0; run < BENCH_RUNS; run++){
+		memcpy(memory[1], start, sizeof(memory[1]));
+		begin = nowSeconds();
+		for(i = 0; i < BENCH_PIXELS; i++){
+			blend(xs[i], ys[i], alphas[i]);
+		}
+		seconds = nowSeconds() - begin;
+		best = (seconds < best) ? seconds : best;
+	}
+	return best * 1e9 / BENCH_PIXELS;
+}
+
+int main(void){
+	blendError errors[BLENDS];
+	uint32_t b, i, n = 4242, ends[BLENDS], bands[BLENDS];
+	double overBlack[BLENDS], overColor[BLENDS];
+
+	GLCD_Initialize_Doublebuffer();
+	for(i = 0; i < GLCD_WIDTH * GLCD_HEIGHT; i++){
+		n = n * 1103515245 + 12345;
+		colored[i] = (uint16_t)(n >> 12);
+	}
+	for(i = 0; i < BENCH_PIXELS; i++){
+		//Each pixel once, in a scattered order, so the background is always what it started as
+		xs[i] = ((i * 40507u) % (GLCD_WIDTH * GLCD_HEIGHT)) % GLCD_HEIGHT;
+		ys[i] = ((i * 40507u) % (GLCD_WIDTH * GLCD_HEIGHT)) / GLCD_HEIGHT;
+		n = n * 1103515245 + 12345;
+		//Mostly partial, as on an anti-aliased edge
+		alphas[i] = (uint8_t)(1 + ((n >> 16) % 254));
+	}
+
+	printf("%-16s %10s %10s %8s %12s %12s\n", "", "mean err", "worst err", "greens", "black ns", "colour ns");
+	for(b = 0; b < BLENDS; b++){
+		setBlendGamma(b == 3);
+		ends[b] = accuracy(b, &errors[b]);
+		bands[b] = shades(b);
+		overBlack[b] = timeBlend(b, black);
+		overColor[b] = timeBlend(b, colored);
+		printf("%-16s %10.3f %10.3f %8u %12.2f %12.2f\n", names[b], errors[b].total / errors[b].count, errors[b].worst,
+			(unsigned)bands[b], overBlack[b], overColor[b]);
+	}
+	setBlendGamma(0);
+	printf("errors are in 8-bit steps; a 5-bit channel step is 8.2, a 6-bit one 4.0\n");
+
+	check(ends[2] && ends[3], "the ramp leaves the background at alpha 0 and gives the colour at 255, with and without gamma");
+	check(errors[2].worst < 0.6 * 255 / 31, "the ramp rounds every channel to the nearest level, give or take its 8-bit weight");
+	check(errors[2].total < errors[0].total, "the ramp is closer to the exact blend than blendPixel()");
+	check(errors[3].worst <= 255 / 31.0, "with gamma, the ramp is within a level of the exact blend in linear light");
+	check(bands[2] == 64, "the ramp fades white in through every 6-bit green level");
+	check(overBlack[2] < overBlack[1], "the ramp is faster than blendPixelFast() over black");
+	printf("over colour the ramp takes %.2fx blendPixel()'s time\n", overColor[2] / overColor[0]);
+
+	return failures ? 1 : 0;
+}
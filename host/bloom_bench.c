@@ -0,0 +1,217 @@
+/**
+  ******************************************************************************
+  * @file    bloom_bench.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only check and per-pass benchmark for the glow post-process in Render.c.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/bloom_bench.c Render.c Fonts.c math_functions.c tables.c -lm -o bloom_bench
+	*Stands in for the platform's frame buffers, as circle_bench.c does. Checks that dim frames are left alone, that
+	*a bright square glows evenly all round and only nearby, that the glow only ever brightens a channel and saturates
+	*rather than wrapping, and that nothing is written outside the frame buffer. Then times each pass on a frame like
+	*the game's and on a frame that is bright all over. Exits non-zero if a check fails.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* Portrait, as Render.c draws */
+#define GLCD_LANDSCAPE 0
+#include "GLCD_Config.h"
+#include "platform.h"
+#include "Render.h"
+
+#define BENCH_FRAMES 100
+#define BENCH_RUNS 5
+/* Guard words either side of the frame buffers, to catch writes off the screen */
+#define GUARD 4096
+#define GUARD_VALUE 0xA5A5
+
+static uint16_t memory[2][GUARD + (GLCD_WIDTH * GLCD_HEIGHT) + GUARD];
+static uint16_t before[GLCD_WIDTH * GLCD_HEIGHT];
+static int failures;
+
+void platformDisplayInit(void){
+	uint32_t i, j;
+	for(i = 0; i < 2; i++){
+		for(j = 0; j < sizeof(memory[0]) / sizeof(memory[0][0]); j++){
+			memory[i][j] = GUARD_VALUE;
+		}
+	}
+}
+
+uint16_t* platformFrameBuffer(uint32_t index){
+	return &memory[index ? 1 : 0][GUARD];
+}
+
+void platformPresent(uint32_t index){
+	(void)index;
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint16_t* drawn(void){
+	return &memory[1][GUARD];
+}
+
+static void bloom(void){
+	bloomExtract();
+	bloomBlurRows();
+	bloomBlurColumns();
+	bloomComposite();
+}
+
+static int guardsIntact(void){
+	uint32_t i;
+	for(i = 0; i < GUARD; i++){
+		if((memory[1][i] != GUARD_VALUE) || (memory[1][GUARD + (GLCD_WIDTH * GLCD_HEIGHT) + i] != GUARD_VALUE)){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+	* @brief Nonzero if every channel of every pixel is at least what it was in before.
+*/
+static int onlyBrighter(void){
+	uint32_t i;
+	uint16_t a, b;
+	for(i = 0; i < GLCD_WIDTH * GLCD_HEIGHT; i++){
+		a = before[i];
+		b = drawn()[i];
+		if(((b >> 11) < (a >> 11)) || (((b >> 5) & 0x3F) < ((a >> 5) & 0x3F)) || ((b & 0x1F) < (a & 0x1F))){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+	* @brief Draws something like a frame of the game: a starfield, meteors, the explosion, turret and reticule.
+*/
+static void drawGameLike(void){
+	uint32_t i, n = 99;
+	setBackgroundColor(GLCD_COLOR_BLACK);
+	clearScreen();
+	for(i = 0; i < 2000; i++){
+		n = n * 1103515245 + 12345;
+		drawn()[(n >> 8) % (GLCD_WIDTH * GLCD_HEIGHT)] = 0xDEFB;
+	}
+	setForegroundColor(GLCD_COLOR_MAROON);
+	for(i = 0; i < 8; i++){
+		drawFilledCircleAA(TO_SUBPIXEL(30 + i * 28), TO_SUBPIXEL(300 + (i * 37) % 150), TO_SUBPIXEL(10));
+	}
+	setForegroundColor(GLCD_COLOR_CYAN);
+	drawFilledCircleAA(TO_SUBPIXEL(150), TO_SUBPIXEL(200), TO_SUBPIXEL(60));
+	setForegroundColor(GLCD_COLOR_BLUE);
+	drawFilledCircleAA(TO_SUBPIXEL(136), 0, TO_SUBPIXEL(40));
+	setForegroundColor(GLCD_COLOR_WHITE);
+	drawFilledCircleAA(TO_SUBPIXEL(100), TO_SUBPIXEL(200), TO_SUBPIXEL(10));
+}
+
+/**
+	* @brief Best time of each pass over BENCH_RUNS, on frames drawn by draw, into seconds[4].
+*/
+static void timePasses(void (*draw)(void), double* seconds){
+	void (*const passes[4])(void) = {bloomExtract, bloomBlurRows, bloomBlurColumns, bloomComposite};
+	uint32_t run, frame, p;
+	double begin, total[4];
+	for(p = 0; p < 4; p++){
+		seconds[p] = 1e9;
+	}
+	for(run = 0; run < BENCH_RUNS; run++){
+		for(p = 0; p < 4; p++){
+			total[p] = 0;
+		}
+		for(frame = 0; frame < BENCH_FRAMES; frame++){
+			draw();
+			for(p = 0; p < 4; p++){
+				begin = nowSeconds();
+				passes[p]();
+				total[p] += nowSeconds() - begin;
+			}
+		}
+		for(p = 0; p < 4; p++){
+			seconds[p] = (total[p] / BENCH_FRAMES < seconds[p]) ? total[p] / BENCH_FRAMES : seconds[p];
+		}
+	}
+}
+
+static void drawWhite(void){
+	setBackgroundColor(GLCD_COLOR_WHITE);
+	clearScreen();
+}
+
+static void report(const char* name, const double* seconds){
+	printf("%-10s extract %6.1f us, rows %6.1f us, columns %6.1f us, composite %6.1f us, total %6.1f us\n", name,
+		seconds[0] * 1e6, seconds[1] * 1e6, seconds[2] * 1e6, seconds[3] * 1e6, (seconds[0] + seconds[1] + seconds[2] + seconds[3]) * 1e6);
+}
+
+int main(void){
+	uint32_t r, c, reach, ok;
+	uint16_t* frame;
+	double seconds[4];
+
+	GLCD_Initialize_Doublebuffer();
+	frame = drawn();
+
+	/* Dim colours don't glow */
+	setBackgroundColor(GLCD_COLOR_MAROON);
+	clearScreen();
+	setForegroundColor(GLCD_COLOR_PURPLE);
+	fillRectangle(50, 100, 100, 100);
+	memcpy(before, frame, sizeof(before));
+	bloom();
+	check(memcmp(before, frame, sizeof(before)) == 0, "a frame below the threshold is left alone");
+
+	/* A white square, on 2x2 block boundaries, glows the same distance each way */
+	setBackgroundColor(GLCD_COLOR_BLACK);
+	clearScreen();
+	for(r = 120; r < 140; r++){
+		for(c = 220; c < 260; c++){
+			frame[r * GLCD_HEIGHT + c] = GLCD_COLOR_WHITE;
+		}
+	}
+	memcpy(before, frame, sizeof(before));
+	bloom();
+	for(reach = 0; (reach < 100) && (frame[130 * GLCD_HEIGHT + 219 - reach] != 0); reach++);
+	ok = (reach > 2) && (reach < 20);
+	for(r = 0; r < 100; r++){
+		ok = ok && (frame[130 * GLCD_HEIGHT + 219 - r] == frame[130 * GLCD_HEIGHT + 260 + r]);
+		ok = ok && (frame[(119 - (r % 40)) * GLCD_HEIGHT + 240] == frame[(140 + (r % 40)) * GLCD_HEIGHT + 240]);
+	}
+	printf("glow reaches %u pixels past the square\n", (unsigned)reach);
+	check(ok, "a bright square glows symmetrically, a few pixels out");
+	check(frame[130 * GLCD_HEIGHT + 240] == GLCD_COLOR_WHITE, "white stays white");
+	check((frame[0] == 0) && (frame[130 * GLCD_HEIGHT + 100] == 0), "pixels far from the square stay black");
+
+	/* Saturating, only brighter, stays on the frame buffer */
+	drawGameLike();
+	setForegroundColor(GLCD_COLOR_RED);
+	fillRectangle(0, 0, 40, 40);
+	setForegroundColor(GLCD_COLOR_YELLOW);
+	fillRectangle(230, 440, 40, 39);
+	memcpy(before, frame, sizeof(before));
+	bloom();
+	check(onlyBrighter(), "the glow only brightens channels, never wrapping them");
+	check(memcmp(before, frame, sizeof(before)) != 0, "a game frame does glow");
+	check(guardsIntact(), "the glow stays inside the frame buffer, including at the edges");
+
+	timePasses(drawGameLike, seconds);
+	report("game frame", seconds);
+	timePasses(drawWhite, seconds);
+	report("all white", seconds);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,334 @@
+/**
+  ******************************************************************************
+  * @file    capture_bench.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only check and overhead benchmark for the frame capture in capture.c.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/capture_bench.c capture.c Render.c Fonts.c math_functions.c tables.c particles.c starfield.c trig.c prng.c -lm -o capture_bench
+	*Stands in for the platform's frame buffers and background layer, as layer_bench.c does, and draws the same moving
+	*scene, like a frame of the game. Captures each frame as Mainloop.c does, against the frame on screen, and checks
+	*that decoding gives back every frame exactly: streamed, in a ring big enough for all of them, in a small ring that
+	*has wrapped, where the frames from its oldest keyframe on must come back, and layered, where the frames must
+	*composite as the panel shows them. A ring too small for a keyframe must drop every frame and say so. Then times
+	*the capture of a frame against drawing it, and reports the bytes a frame takes. Exits non-zero if a check fails.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Portrait, as Render.c draws */
+#define GLCD_LANDSCAPE 0
+#include "GLCD_Config.h"
+#include "platform.h"
+#include "Render.h"
+#include "particles.h"
+#include "starfield.h"
+#include "capture.h"
+
+#define BENCH_FRAMES 200
+#define BENCH_RUNS 5
+/* Milliseconds per rendered frame, as in Mainloop.c */
+#define FRAME_MS 33
+#define SCREEN_PIXELS (GLCD_WIDTH * GLCD_HEIGHT)
+#define KEY GLCD_COLOR_BLACK
+/* A capture buffer for every frame, and one that wraps over them but holds more than a keyframe interval */
+#define BIG_RING (64 * 1024 * 1024)
+#define SMALL_RING (2 * 1024 * 1024)
+/* Too small for a keyframe of a starfield */
+#define TINY_RING 4096
+
+static pixel memory[3][SCREEN_PIXELS];
+static pixel composited[SCREEN_PIXELS];
+static pixel* expected; /** Each frame as the panel shows it, BENCH_FRAMES of them */
+static uint32_t* ticks; /** Each frame's tick */
+static uint8_t* ring;
+static uint8_t* saved; /** Streamed capture, as a file would hold it */
+static uint32_t savedLength;
+static uint32_t decoded[SCREEN_PIXELS], decodedBackground[SCREEN_PIXELS];
+static particlePool pool;
+static starfield field;
+static int failures;
+
+void platformDisplayInit(void){
+}
+
+pixel* platformFrameBuffer(uint32_t index){
+	return memory[index ? 1 : 0];
+}
+
+void platformPresent(uint32_t index){
+	(void)index;
+}
+
+static pixel* background(void){
+	return memory[2];
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void save(const uint8_t* data, uint32_t length){
+	memcpy(&saved[savedLength], data, length);
+	savedLength += length;
+}
+
+/**
+	* @brief Draws frame's moving things, as layer_bench.c does: bullets and their trails, meteors, an explosion and sparks, and text.
+*/
+static void drawMoving(uint32_t frame){
+	static int16_t xs[8][4], ys[8][4];
+	polygon meteors[8];
+	uint32_t i, x, y;
+	char text[16];
+
+	for(i = 0; i < 5; i++){
+		x = 20 + ((frame * (3 + i) + i * 50) % 232);
+		y = 110 + ((frame * (5 + 2 * i) + i * 70) % 340);
+		setForegroundColor(GLCD_COLOR_NAVY);
+		drawThickLine(x, 90, x, y, 3);
+		setForegroundColor(GLCD_COLOR_CYAN);
+		drawFilledCircleAA(TO_SUBPIXEL(x) + (frame & 15), TO_SUBPIXEL(y), TO_SUBPIXEL(10));
+	}
+	for(i = 0; i < 8; i++){
+		x = TO_SUBPIXEL(30 + i * 30);
+		y = TO_SUBPIXEL(460 - ((frame * 4 + i * 40) % 340)) + (i * 5);
+		xs[i][0] = (int16_t)(x - TO_SUBPIXEL(9));
+		ys[i][0] = (int16_t)(y - TO_SUBPIXEL(4));
+		xs[i][1] = (int16_t)(x + TO_SUBPIXEL(2));
+		ys[i][1] = (int16_t)(y - TO_SUBPIXEL(10));
+		xs[i][2] = (int16_t)(x + TO_SUBPIXEL(10));
+		ys[i][2] = (int16_t)(y + TO_SUBPIXEL(3));
+		xs[i][3] = (int16_t)(x - TO_SUBPIXEL(1));
+		ys[i][3] = (int16_t)(y + TO_SUBPIXEL(11));
+		meteors[i].x = xs[i];
+		meteors[i].y = ys[i];
+		meteors[i].count = 4;
+		meteors[i].fill = GLCD_COLOR_MAROON;
+		meteors[i].outline = GLCD_COLOR_RED;
+		meteors[i].outlined = 1;
+	}
+	fillPolygons(meteors, 8);
+	if((frame % 30) < 12){
+		setForegroundColor(((frame / 2) & 1) ? GLCD_COLOR_DARK_GREEN : GLCD_COLOR_CYAN);
+		drawFilledCircleAA(TO_SUBPIXEL(150), TO_SUBPIXEL(300), TO_SUBPIXEL(60));
+	}
+	drawSplats(pool.x, pool.y, pool.color, pool.alpha, pool.count, 2);
+	setForegroundColor(GLCD_COLOR_WHITE);
+	sprintf(text, "%u", (unsigned)frame);
+	GLCD_DrawString(0, 456, text);
+}
+
+/**
+	* @brief Moves the stars and sparks on a frame, bursting sparks now and then.
+*/
+static void step(uint32_t frame){
+	if((frame % 30) == 0){
+		emitBurst(&pool, 150, 300, 600, 60, 800, GLCD_COLOR_WHITE, 0);
+	}
+	updateParticles(&pool, FRAME_MS);
+	updateStars(&field, FRAME_MS);
+}
+
+static void restart(void){
+	initParticles(&pool, 11);
+	initStars(&field, STAR_CAPACITY, 5);
+}
+
+/**
+	* @brief Draws frame onto a single layer, as the game does without layers.
+*/
+static void drawSingle(uint32_t frame){
+	step(frame);
+	clearScreenStars(field.columnStarts, field.y, field.color);
+	setForegroundColor(GLCD_COLOR_BLUE);
+	drawFilledCircleAA(TO_SUBPIXEL(136), 0, TO_SUBPIXEL(40));
+	drawMoving(frame);
+	bloomExtract();
+	bloomBlurRows();
+	bloomBlurColumns();
+	bloomComposite();
+}
+
+/**
+	* @brief Draws frame onto the sprite layer, over the turret base on the background, as the game does with layers.
+*/
+static void drawLayered(uint32_t frame){
+	step(frame);
+	clearSprites();
+	drawStars(field.columnStarts, field.y, field.color, field.drawn[backBufferIndex()]);
+	drawMoving(frame);
+}
+
+/**
+	* @brief Captures the frame about to be presented against the one on screen, as Mainloop.c does. Returns the bytes recorded.
+*/
+static int32_t captureShown(frameCapture* capture, uint32_t frame){
+	return captureFrame(capture, platformFrameBuffer(backBufferIndex()), platformFrameBuffer(backBufferIndex() ^ 1), frame * FRAME_MS);
+}
+
+/**
+	* @brief Decodes a capture of length bytes, and counts the frames that match expected from frame first on, in order, by
+	* tick and pixels. Returns the frames decoded, or 0 if any doesn't match.
+*/
+static uint32_t decodesTo(const uint8_t* data, uint32_t length, uint32_t first){
+	captureReader reader;
+	uint32_t frame = first, i;
+	const pixel* want;
+	if(openCapture(&reader, data, length, decoded, decodedBackground) != 0){
+		return 0;
+	}
+	while(readCapture(&reader) == 0){
+		if((frame >= BENCH_FRAMES) || (reader.tick != ticks[frame])){
+			return 0;
+		}
+		want = &expected[frame * SCREEN_PIXELS];
+		for(i = 0; i < SCREEN_PIXELS; i++){
+			if((reader.layered && (decoded[i] == reader.key) ? decodedBackground[i] : decoded[i]) != want[i]){
+				return 0;
+			}
+		}
+		frame++;
+	}
+	return frame - first;
+}
+
+/**
+	* @brief First frame a wrapped ring's capture decodes from: its oldest keyframe.
+*/
+static uint32_t oldestKeyframe(const uint8_t* data, uint32_t length){
+	captureReader reader;
+	if((openCapture(&reader, data, length, decoded, decodedBackground) != 0) || (readCapture(&reader) != 0)){
+		return BENCH_FRAMES;
+	}
+	return reader.tick / FRAME_MS;
+}
+
+int main(void){
+	frameCapture big, small, tiny, stream, layered;
+	uint8_t* smallRing;
+	uint8_t tinyRing[TINY_RING];
+	uint32_t frame, run, first, ok, total, keyframes;
+	int32_t bytes;
+	double begin, draw = 1e9, capture = 1e9, worst = 0, seconds;
+
+	expected = (pixel*)malloc(sizeof(pixel) * SCREEN_PIXELS * BENCH_FRAMES);
+	ticks = (uint32_t*)malloc(sizeof(uint32_t) * BENCH_FRAMES);
+	ring = (uint8_t*)malloc(BIG_RING);
+	smallRing = (uint8_t*)malloc(SMALL_RING);
+	saved = (uint8_t*)malloc(BIG_RING);
+	GLCD_Initialize_Doublebuffer();
+	setBackgroundColor(GLCD_COLOR_BLACK);
+
+	/* One layer, captured every way at once */
+	restart();
+	startCapture(&big, ring, BIG_RING, captureRing, GLCD_WIDTH, GLCD_HEIGHT, GLCD_HEIGHT);
+	startCapture(&small, smallRing, SMALL_RING, captureRing, GLCD_WIDTH, GLCD_HEIGHT, GLCD_HEIGHT);
+	check(startCapture(&tiny, tinyRing, CAPTURE_HEADER_SIZE, captureRing, GLCD_WIDTH, GLCD_HEIGHT, GLCD_HEIGHT) == -1,
+		"a buffer with no room for records is turned away");
+	startCapture(&tiny, tinyRing, TINY_RING, captureRing, GLCD_WIDTH, GLCD_HEIGHT, GLCD_HEIGHT);
+	ok = 1;
+	total = 0;
+	keyframes = 0;
+	for(frame = 0; frame < BENCH_FRAMES; frame++){
+		drawSingle(frame);
+		renderFlush();
+		memcpy(&expected[frame * SCREEN_PIXELS], platformFrameBuffer(backBufferIndex()), sizeof(composited));
+		ticks[frame] = frame * FRAME_MS;
+		bytes = captureShown(&big, frame);
+		total += (bytes > 0) ? (uint32_t)bytes : 0;
+		keyframes += big.sinceKey == 0;
+		ok = ok && (bytes > 0) && (captureShown(&tiny, frame) == -1);
+		switchBuffer();
+	}
+	check(ok && (big.frames == BENCH_FRAMES) && (tiny.frames == 0) && (tiny.dropped == BENCH_FRAMES),
+		"every frame fits a big ring, and a ring too small for a keyframe drops every one");
+	check(decodesTo(ring, BIG_RING, 0) == BENCH_FRAMES, "a ring holding every frame decodes to every frame exactly");
+	check(decodesTo(tinyRing, TINY_RING, 0) == 0, "a ring that dropped every frame decodes to none");
+	printf("%.0f bytes a frame, against %u raw; %u keyframes\n", total / (double)BENCH_FRAMES, (unsigned)sizeof(composited),
+		(unsigned)keyframes);
+
+	/* The small ring and the stream, captured again from the same frames */
+	savedLength = 0;
+	for(frame = 0; frame < BENCH_FRAMES; frame++){
+		ok = ok && (captureFrame(&small, &expected[frame * SCREEN_PIXELS], frame ? &expected[(frame - 1) * SCREEN_PIXELS] : NULL,
+			ticks[frame]) > 0);
+	}
+	first = oldestKeyframe(smallRing, SMALL_RING);
+	printf("a %u KB ring holds frames %u on, of %u\n", SMALL_RING / 1024, (unsigned)first, BENCH_FRAMES);
+	check(ok && (first > 0) && (first < BENCH_FRAMES) && (decodesTo(smallRing, SMALL_RING, first) == BENCH_FRAMES - first),
+		"a wrapped ring decodes exactly to the last frames, from its oldest keyframe");
+	startCapture(&stream, smallRing, SMALL_RING, captureStream, GLCD_WIDTH, GLCD_HEIGHT, GLCD_HEIGHT);
+	for(frame = 0; frame < BENCH_FRAMES; frame++){
+		captureFrame(&stream, &expected[frame * SCREEN_PIXELS], frame ? &expected[(frame - 1) * SCREEN_PIXELS] : NULL, ticks[frame]);
+		captureDrain(&stream, save);
+	}
+	check(decodesTo(saved, savedLength, 0) == BENCH_FRAMES, "a stream saved as it goes decodes to every frame exactly");
+	check(decodesTo(saved, savedLength - 100, 0) == BENCH_FRAMES - 1, "a stream cut short decodes up to the frame cut");
+
+	/* Layered, decoded over the background as the panel shows it */
+	restart();
+	GLCD_InitializeLayers(background(), KEY);
+	drawToBackground();
+	clearScreen();
+	setForegroundColor(GLCD_COLOR_BLUE);
+	drawFilledCircleAA(TO_SUBPIXEL(136), 0, TO_SUBPIXEL(40));
+	drawToSprites();
+	startCapture(&layered, ring, BIG_RING, captureRing, GLCD_WIDTH, GLCD_HEIGHT, GLCD_HEIGHT);
+	captureLayers(&layered, background(), KEY);
+	ok = 1;
+	for(frame = 0; frame < BENCH_FRAMES; frame++){
+		drawLayered(frame);
+		compositeLayers(&expected[frame * SCREEN_PIXELS], platformFrameBuffer(backBufferIndex()), background(), KEY);
+		ok = ok && (captureShown(&layered, frame) > 0);
+		switchBuffer();
+	}
+	check(ok && (decodesTo(ring, BIG_RING, 0) == BENCH_FRAMES), "layered frames decode to what the panel shows, background and all");
+	GLCD_InitializeLayers(NULL, KEY);
+
+	/* Overhead: drawing a frame, and capturing it */
+	for(run = 0; run < BENCH_RUNS; run++){
+		restart();
+		startCapture(&big, ring, BIG_RING, captureRing, GLCD_WIDTH, GLCD_HEIGHT, GLCD_HEIGHT);
+		seconds = 0;
+		begin = nowSeconds();
+		for(frame = 0; frame < BENCH_FRAMES; frame++){
+			drawSingle(frame);
+			renderFlush();
+			switchBuffer();
+		}
+		draw = ((nowSeconds() - begin) / BENCH_FRAMES < draw) ? (nowSeconds() - begin) / BENCH_FRAMES : draw;
+		restart();
+		for(frame = 0; frame < BENCH_FRAMES; frame++){
+			drawSingle(frame);
+			renderFlush();
+			begin = nowSeconds();
+			captureShown(&big, frame);
+			begin = nowSeconds() - begin;
+			seconds += begin;
+			worst = (begin > worst) ? begin : worst;
+			switchBuffer();
+		}
+		capture = (seconds / BENCH_FRAMES < capture) ? seconds / BENCH_FRAMES : capture;
+	}
+	printf("frame: drawing %7.1f us, capture %6.1f us (%.1f%% of drawing, %.2f%% of a %u ms frame), worst capture %6.1f us\n",
+		draw * 1e6, capture * 1e6, capture * 100 / draw, capture * 1e5 / FRAME_MS, FRAME_MS, worst * 1e6);
+	check((capture * 2 < draw) && (capture * 1000 * 50 < FRAME_MS), "capturing a frame costs under half of drawing it, and a fiftieth of a frame");
+
+	free(expected);
+	free(ticks);
+	free(ring);
+	free(smallRing);
+	free(saved);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,115 @@
+/**
+  ******************************************************************************
+  * @file    capture_decode.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only decoder for frame captures from capture.c, to a PPM sequence or a stream for a video encoder.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/capture_decode.c capture.c -o capture_decode
+	*Usage: capture_decode capture [prefix or -]
+	*The capture is a capture buffer dumped from the board, or written by the host build, with ASTEROID_CAPTURE.
+	*Each frame is written, composited over its background if it had one, as prefix00000.ppm and on, in the panel's
+	*own orientation as the snapshots are, or with - one after another to stdout, to pipe into a video encoder:
+	*  capture_decode capture.bin - | ffmpeg -f image2pipe -c:v ppm -framerate 30 -i - capture.mp4
+	*Frames are as often as they were presented, so the rate is only nominal; the ticks are listed on stderr.
+	*Without a prefix it only lists the frames. Exits non-zero if the capture can't be read.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "capture.h"
+
+/**
+	* @brief Write frame, over background where it is key if layered, to f as a binary PPM.
+*/
+static void writeFrame(FILE* f, const captureReader* reader, uint8_t* rgb){
+	uint32_t i, c;
+	for(i = 0; i < reader->rows * reader->length; i++){
+		c = reader->frame[i];
+		if(reader->layered && (c == reader->key)){
+			c = reader->background[i];
+		}
+		if(reader->pixelBytes == 4){
+			rgb[i * 3] = (uint8_t)(c >> 16);
+			rgb[i * 3 + 1] = (uint8_t)(c >> 8);
+			rgb[i * 3 + 2] = (uint8_t)c;
+		}
+		else{
+			rgb[i * 3] = (uint8_t)(((c >> 11) & 0x1F) * 255 / 31);
+			rgb[i * 3 + 1] = (uint8_t)(((c >> 5) & 0x3F) * 255 / 63);
+			rgb[i * 3 + 2] = (uint8_t)((c & 0x1F) * 255 / 31);
+		}
+	}
+	fprintf(f, "P6\n%u %u\n255\n", (unsigned)reader->length, (unsigned)reader->rows);
+	fwrite(rgb, 1, reader->rows * reader->length * 3, f);
+}
+
+int main(int argc, char** argv){
+	captureReader reader;
+	uint8_t* data;
+	uint8_t* rgb;
+	uint32_t* frame;
+	uint32_t* background;
+	uint32_t length, pixels, count = 0, first = 0;
+	long size;
+	char path[1024];
+	FILE* f;
+
+	if(argc < 2){
+		fprintf(stderr, "usage: %s capture [prefix or -]\n", argv[0]);
+		return 2;
+	}
+	if((f = fopen(argv[1], "rb")) == NULL){
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return 1;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	data = (uint8_t*)malloc(size > 0 ? (size_t)size : 1);
+	length = (uint32_t)fread(data, 1, size > 0 ? (size_t)size : 0, f);
+	fclose(f);
+
+	//The frame size is in the header, so it is read once to find it, then again with somewhere to put the frames
+	if(openCapture(&reader, data, length, NULL, NULL) != 0){
+		fprintf(stderr, "%s is not a capture this decoder reads\n", argv[1]);
+		return 1;
+	}
+	pixels = reader.rows * reader.length;
+	frame = (uint32_t*)calloc(pixels, sizeof(uint32_t));
+	background = (uint32_t*)calloc(pixels, sizeof(uint32_t));
+	rgb = (uint8_t*)malloc(pixels * 3);
+	openCapture(&reader, data, length, frame, background);
+	fprintf(stderr, "%ux%u, %u-bit pixels, %u frames captured, %u dropped\n", (unsigned)reader.length, (unsigned)reader.rows,
+		(unsigned)reader.pixelBytes * 8, (unsigned)reader.captured, (unsigned)reader.dropped);
+
+	while(readCapture(&reader) == 0){
+		if(count == 0){
+			first = reader.tick;
+		}
+		if(argc > 2){
+			if(strcmp(argv[2], "-") == 0){
+				writeFrame(stdout, &reader, rgb);
+			}
+			else{
+				snprintf(path, sizeof(path), "%s%05u.ppm", argv[2], (unsigned)count);
+				if((f = fopen(path, "wb")) == NULL){
+					fprintf(stderr, "cannot write %s\n", path);
+					return 1;
+				}
+				writeFrame(f, &reader, rgb);
+				fclose(f);
+			}
+		}
+		fprintf(stderr, "frame %u: tick %u%s\n", (unsigned)count, (unsigned)reader.tick, reader.layered ? ", layered" : "");
+		count++;
+	}
+	fprintf(stderr, "%u frames decoded, ticks %u to %u\n", (unsigned)count, (unsigned)first, (unsigned)(count ? reader.tick : 0));
+
+	free(data);
+	free(frame);
+	free(background);
+	free(rgb);
+	return 0;
+}
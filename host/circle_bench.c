@@ -0,0 +1,198 @@
+/**
+  ******************************************************************************
+  * @file    circle_bench.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only accuracy and speed benchmark for the circle rasterizers in Render.c.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/circle_bench.c Render.c Fonts.c math_functions.c tables.c -lm -o circle_bench
+	*Stands in for the platform's frame buffers, so Render.c draws into memory. Checks that drawFilledCircleAA()
+	*covers the area of its circle, moves with its sub-pixel centre and stays inside the frame buffer at the
+	*screen edges, then times it against drawFilledCircle() at the radii the game draws. Small circles are mostly
+	*edge, so cost more anti-aliased; bigger ones cost less, as whole rows are filled along the frame buffer.
+	*A frame's circles, as Mainloop.c draws them, are held to AA_BUDGET times the aliased time. Each run times every
+	*radius both ways back to back, and the median run is checked, as a busy host slows some runs by more than the
+	*budget. Exits non-zero if a check fails.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Portrait, as Render.c draws */
+#define GLCD_LANDSCAPE 0
+#include "GLCD_Config.h"
+#include "platform.h"
+#include "Render.h"
+
+#define PI 3.14159265358979323846
+#define BENCH_CIRCLES 20000
+#define BENCH_RUNS 21
+/* Most a frame's anti-aliased circles may take, over the aliased ones */
+#define AA_BUDGET 1.1
+/* Guard words either side of the frame buffers, to catch writes off the screen */
+#define GUARD 4096
+#define GUARD_VALUE 0xA5A5
+
+static uint16_t memory[2][GUARD + (GLCD_WIDTH * GLCD_HEIGHT) + GUARD];
+static int failures;
+
+void platformDisplayInit(void){
+	uint32_t i;
+	for(i = 0; i < sizeof(memory) / sizeof(memory[0][0]); i++){
+		memory[i / (sizeof(memory[0]) / sizeof(memory[0][0]))][i % (sizeof(memory[0]) / sizeof(memory[0][0]))] = GUARD_VALUE;
+	}
+}
+
+uint16_t* platformFrameBuffer(uint32_t index){
+	return &memory[index ? 1 : 0][GUARD];
+}
+
+void platformPresent(uint32_t index){
+	(void)index;
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+	* @brief Black out the screen area of the buffer being drawn to, leaving the guards alone.
+*/
+static void clearDrawn(void){
+	memset(&memory[1][GUARD], 0, GLCD_WIDTH * GLCD_HEIGHT * sizeof(uint16_t));
+}
+
+/**
+	* @brief Pixels' worth of white on the drawn buffer, from the 5-bit blue channel.
+*/
+static double coveredArea(void){
+	uint32_t i;
+	double area = 0;
+	for(i = 0; i < GLCD_WIDTH * GLCD_HEIGHT; i++){
+		area += (memory[1][GUARD + i] & 0x1F) / 31.0;
+	}
+	return area;
+}
+
+static int guardsIntact(void){
+	uint32_t i;
+	for(i = 0; i < GUARD; i++){
+		if((memory[1][i] != GUARD_VALUE) || (memory[1][GUARD + (GLCD_WIDTH * GLCD_HEIGHT) + i] != GUARD_VALUE)){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int compareDoubles(const void* a, const void* b){
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+int main(void){
+	static const int32_t radii[] = {10, 40, 60};
+	/* Circles of each radius in a frame without an explosion: the reticule and the player's bullet, then the turret. 
+	 Meteors are polygons. */
+	static const int32_t perFrame[] = {2, 1, 0};
+	static int32_t xs[BENCH_CIRCLES], ys[BENCH_CIRCLES];
+	uint32_t i, r, n, run;
+	double ratios[BENCH_RUNS], aliased[sizeof(radii) / sizeof(radii[0])], smooth[sizeof(radii) / sizeof(radii[0])];
+	double area, worstArea = 0, begin, seconds, frameAliased, frameSmooth;
+	int ok;
+	static uint16_t before[GLCD_WIDTH * GLCD_HEIGHT];
+
+	GLCD_Initialize_Doublebuffer();
+	setForegroundColor(GLCD_COLOR_WHITE);
+
+	/* Area, at sub-pixel offsets */
+	for(r = 4; r <= 60; r += 3){
+		for(i = 0; i < 16; i++){
+			clearDrawn();
+			drawFilledCircleAA(TO_SUBPIXEL(136) + i, TO_SUBPIXEL(240) + ((i * 7) & 15), TO_SUBPIXEL(r) + (i & 3));
+			area = coveredArea() / (PI * (r + (i & 3) / 16.0) * (r + (i & 3) / 16.0));
+			area = (area > 1) ? area - 1 : 1 - area;
+			if(area > worstArea){worstArea = area;}
+		}
+	}
+	printf("drawFilledCircleAA: worst area error %.2f%% over radii 4 to 58\n", worstArea * 100);
+	check(worstArea < 0.02, "covers the circle's area to within 2%");
+
+	/* A sixteenth of a pixel moves the edge */
+	clearDrawn();
+	drawFilledCircleAA(TO_SUBPIXEL(136), TO_SUBPIXEL(240), TO_SUBPIXEL(20));
+	memcpy(before, &memory[1][GUARD], sizeof(before));
+	clearDrawn();
+	drawFilledCircleAA(TO_SUBPIXEL(136) + 1, TO_SUBPIXEL(240), TO_SUBPIXEL(20));
+	check(memcmp(before, &memory[1][GUARD], sizeof(before)) != 0, "a sixteenth of a pixel shift changes the edge");
+
+	/* Symmetric about a pixel centre */
+	clearDrawn();
+	drawFilledCircleAA(TO_SUBPIXEL(136) + 8, TO_SUBPIXEL(240) + 8, TO_SUBPIXEL(17) + 5);
+	ok = 1;
+	for(i = 100; i < 172; i++){
+		for(n = 200; n < 280; n++){
+			ok = ok && (memory[1][GUARD + (i * GLCD_HEIGHT) + n] == memory[1][GUARD + ((270 - i) * GLCD_HEIGHT) + n]);
+			ok = ok && (memory[1][GUARD + (i * GLCD_HEIGHT) + n] == memory[1][GUARD + (i * GLCD_HEIGHT) + (478 - n)]);
+		}
+	}
+	check(ok, "centred on a pixel, the circle is symmetric both ways");
+
+	/* Off every edge and corner */
+	for(i = 0; i < 400; i++){
+		drawFilledCircleAA(TO_SUBPIXEL((int32_t)(i % 20) * 20 - 60) + (i & 15), TO_SUBPIXEL((int32_t)(i / 20) * 30 - 60) + (i & 7), TO_SUBPIXEL(70));
+	}
+	check(guardsIntact(), "circles off the edges stay inside the frame buffer");
+
+	/* Timing at random sub-pixel positions on screen */
+	n = 12345;
+	for(i = 0; i < BENCH_CIRCLES; i++){
+		n = n * 1103515245 + 12345;
+		xs[i] = (int32_t)((n >> 8) % (GLCD_WIDTH << CIRCLE_SUBPIXEL_BITS));
+		n = n * 1103515245 + 12345;
+		ys[i] = (int32_t)((n >> 8) % (GLCD_HEIGHT << CIRCLE_SUBPIXEL_BITS));
+	}
+	for(r = 0; r < sizeof(radii) / sizeof(radii[0]); r++){
+		aliased[r] = 1e9;
+		smooth[r] = 1e9;
+	}
+	for(run = 0; run < BENCH_RUNS; run++){
+		frameAliased = 0;
+		frameSmooth = 0;
+		for(r = 0; r < sizeof(radii) / sizeof(radii[0]); r++){
+			begin = nowSeconds();
+			for(i = 0; i < BENCH_CIRCLES; i++){
+				drawFilledCircle(xs[i] >> CIRCLE_SUBPIXEL_BITS, ys[i] >> CIRCLE_SUBPIXEL_BITS, radii[r]);
+			}
+			seconds = nowSeconds() - begin;
+			frameAliased += perFrame[r] * seconds;
+			aliased[r] = (seconds < aliased[r]) ? seconds : aliased[r];
+			begin = nowSeconds();
+			for(i = 0; i < BENCH_CIRCLES; i++){
+				drawFilledCircleAA(xs[i], ys[i], TO_SUBPIXEL(radii[r]));
+			}
+			seconds = nowSeconds() - begin;
+			frameSmooth += perFrame[r] * seconds;
+			smooth[r] = (seconds < smooth[r]) ? seconds : smooth[r];
+		}
+		ratios[run] = frameSmooth / frameAliased;
+	}
+	/* Best of the runs for each radius, as the host is shared */
+	for(r = 0; r < sizeof(radii) / sizeof(radii[0]); r++){
+		printf("radius %2d: drawFilledCircle %7.2f us, drawFilledCircleAA %7.2f us, %.2fx\n", radii[r],
+			aliased[r] * 1e6 / BENCH_CIRCLES, smooth[r] * 1e6 / BENCH_CIRCLES, smooth[r] / aliased[r]);
+	}
+	qsort(ratios, BENCH_RUNS, sizeof(ratios[0]), compareDoubles);
+	printf("frame's circles: median run %.2fx the aliased time\n", ratios[BENCH_RUNS / 2]);
+	check(ratios[BENCH_RUNS / 2] < AA_BUDGET, "a frame's circles anti-aliased within AA_BUDGET of the aliased time");
+
+	return failures ? 1 : 0;
+}
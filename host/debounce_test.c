@@ -0,0 +1,179 @@
+/**
+  ******************************************************************************
+  * @file    debounce_test.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only test and benchmark for debounce.c, driven by a mock GPIO pin.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/debounce_test.c debounce.c prng.c -o debounce_test
+	*The mock pin plays back a timeline of level changes with switch bounce. Every change "interrupts" the way
+	*the EXTI line would, and a mock 1 kHz timer calls debounceSettle(), both reading the mock pin.
+	*Times are in microseconds here, so bounce shorter than the 1 ms system tick can be modelled.
+	*Exits non-zero if any check fails.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "debounce.h"
+#include "prng.h"
+
+#define HOLDOFF_US 10000
+#define TIMER_PERIOD_US 1000
+#define MAX_CHANGES 4096
+#define MAX_EDGES 1024
+
+/**
+	*@brief Mock GPIO pin. Holds a timeline of level changes; the level at any time is read from it.
+*/
+typedef struct{
+	uint32_t time[MAX_CHANGES]; /** Time of each change */
+	uint8_t level[MAX_CHANGES]; /** Level after each change */
+	uint32_t count; /** Number of changes */
+	uint8_t initial; /** Level before the first change */
+}mockPin;
+
+/** An edge reported by the debouncer */
+typedef struct{
+	uint32_t time;
+	uint8_t level;
+}edge;
+
+static int failures;
+
+static void addChange(mockPin* pin, uint32_t time, uint8_t level){
+	if(pin->count < MAX_CHANGES){
+		pin->time[pin->count] = time;
+		pin->level[pin->count] = level;
+		pin->count++;
+	}
+}
+
+/**
+	* @brief Add a transition to level at time, with bounces toggling every bounceUs for the given count first.
+*/
+static void addBouncyChange(mockPin* pin, uint32_t time, uint8_t level, uint32_t bounces, uint32_t bounceUs){
+	uint32_t i;
+	for(i = 0; i < bounces * 2; i++){
+		addChange(pin, time + i * bounceUs, (i & 1) ? !level : level);
+	}
+	addChange(pin, time + bounces * 2 * bounceUs, level);
+}
+
+/**
+	* @brief Mock HAL_GPIO_ReadPin(); the level of the pin at time.
+*/
+static uint8_t readMockPin(const mockPin* pin, uint32_t time){
+	uint8_t level = pin->initial;
+	uint32_t i;
+	for(i = 0; (i < pin->count) && (pin->time[i] <= time); i++){
+		level = pin->level[i];
+	}
+	return level;
+}
+
+/**
+	* @brief Play the pin through a debouncer, as the EXTI interrupt and timer would, until end. Returns the edge count.
+	* The interrupt reads the pin latencyUs after the change, like the real handler does.
+*/
+static uint32_t runPin(const mockPin* pin, uint32_t end, uint32_t latencyUs, edge* edges){
+	debouncer d;
+	uint32_t change = 0, timer = TIMER_PERIOD_US, count = 0, now;
+	int32_t level;
+
+	initDebouncer(&d, pin->initial, HOLDOFF_US);
+	while(1){
+		/* Next event is either a pin change interrupt or a timer tick */
+		if((change < pin->count) && (pin->time[change] + latencyUs <= timer)){
+			now = pin->time[change] + latencyUs;
+			if(now > end){break;}
+			level = debounceEdge(&d, readMockPin(pin, now), now);
+			change++;
+		}
+		else{
+			now = timer;
+			if(now > end){break;}
+			level = debounceSettle(&d, readMockPin(pin, now), now);
+			timer += TIMER_PERIOD_US;
+		}
+		if((level >= 0) && (count < MAX_EDGES)){
+			edges[count].time = now;
+			edges[count].level = (uint8_t)level;
+			count++;
+		}
+	}
+	return count;
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(void){
+	static mockPin pin;
+	edge edges[MAX_EDGES];
+	uint32_t count, i, presses, t, ok;
+	prngState rng;
+	debouncer d;
+	volatile int32_t sink = 0;
+	double begin, seconds;
+	const uint32_t benchCalls = 20000000;
+
+	/* Clean press and release are reported at the exact edge times */
+	memset(&pin, 0, sizeof(pin));
+	addChange(&pin, 5000, 1);
+	addChange(&pin, 80000, 0);
+	count = runPin(&pin, 200000, 0, edges);
+	check((count == 2) && (edges[0].time == 5000) && (edges[0].level == 1) &&
+		(edges[1].time == 80000) && (edges[1].level == 0), "clean press is two edges at the exact times");
+
+	/* Bounce is swallowed; the edge keeps the time of the first transition */
+	memset(&pin, 0, sizeof(pin));
+	addBouncyChange(&pin, 5000, 1, 6, 300);
+	addBouncyChange(&pin, 90000, 0, 6, 300);
+	count = runPin(&pin, 200000, 2, edges);
+	check((count == 2) && (edges[0].time == 5002) && (edges[1].time == 90002), "bouncy press is two edges at the first transition");
+
+	/* A press shorter than the holdoff still produces a release, when the holdoff ends */
+	memset(&pin, 0, sizeof(pin));
+	addBouncyChange(&pin, 5000, 1, 3, 200);
+	addBouncyChange(&pin, 8000, 0, 3, 200);
+	count = runPin(&pin, 200000, 2, edges);
+	check((count == 2) && (edges[1].level == 0) && (edges[1].time >= 5002 + HOLDOFF_US) &&
+		(edges[1].time <= 5002 + HOLDOFF_US + TIMER_PERIOD_US), "short press is caught by the timer");
+
+	/* Randomized presses; every press and release is seen exactly once, and the final state matches the pin */
+	memset(&pin, 0, sizeof(pin));
+	prngSeed(&rng, 12345, 0);
+	t = 1000;
+	for(presses = 0; presses < 200; presses++){
+		addBouncyChange(&pin, t, 1, prngRange(&rng, 8), 50 + prngRange(&rng, 500));
+		t += HOLDOFF_US + 1000 + prngRange(&rng, 50000);
+		addBouncyChange(&pin, t, 0, prngRange(&rng, 8), 50 + prngRange(&rng, 500));
+		t += HOLDOFF_US + 1000 + prngRange(&rng, 50000);
+	}
+	count = runPin(&pin, t + 2 * HOLDOFF_US, prngRange(&rng, 5), edges);
+	ok = (count == presses * 2);
+	for(i = 0; ok && (i < count); i++){
+		ok = (edges[i].level == ((i & 1) ? 0 : 1));
+	}
+	check(ok && (edges[count - 1].level == readMockPin(&pin, t)), "200 random bouncy presses give 400 alternating edges");
+
+	/* Cost of the interrupt-side call, alternating accepted edges and ignored bounce */
+	initDebouncer(&d, 0, HOLDOFF_US);
+	begin = nowSeconds();
+	for(i = 0; i < benchCalls; i++){
+		sink += debounceEdge(&d, (uint8_t)(i & 1), i * 3000);
+	}
+	seconds = nowSeconds() - begin;
+	printf("debounceEdge: %.2f ns/call\n", seconds * 1e9 / benchCalls);
+
+	return failures ? 1 : 0;
+}
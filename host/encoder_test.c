@@ -0,0 +1,134 @@
+/**
+  ******************************************************************************
+  * @file    encoder_test.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only test and benchmark for encoder.c, fed by a mock quadrature encoder through the event queue.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/encoder_test.c encoder.c eventqueue.c -o encoder_test
+	*The mock interrupt does what the board's does on every transition: a motion table lookup on the two pins, 
+	*then a timestamped push. The main loop side drains the queue into the tracker, as pollInputs() does.
+	*Checks slow turns keep their sub-step fractions, the velocity estimate follows the real speed, 
+	*fast spins are accelerated up to the cap, and reversals are seen at once. Exits non-zero if any check fails.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <time.h>
+#include "encoder.h"
+#include "eventqueue.h"
+
+/* As in Mainloop.c, with AIM_STEP 15 */
+#define ENCODER_AIM_SCALE ((15 << ENCODER_FIXED_SHIFT) / 2)
+
+//The motion table from poll.c
+static const int rotaryEncoderMotionTable[16] = {0,-1,1,0,1,0,0,-1,-1,0,0,1,0,1,-1,0};
+//Gray code sequence of clk, dt when turning clockwise
+static const int quadrature[4] = {3, 1, 0, 2};
+
+static eventQueue queue;
+static int previousPins, phase, failures;
+
+/**
+	* @brief Mock interrupt: the pins have moved one transition in direction, at time.
+*/
+static void encoderInterrupt(int direction, uint32_t time){
+	int pins, step;
+	phase = (phase + direction) & 3;
+	pins = quadrature[phase];
+	step = rotaryEncoderMotionTable[(previousPins << 2) | pins];
+	previousPins = pins;
+	if(step != 0){
+		pushEvent(&queue, time, eventEncoder, (int8_t)step);
+	}
+}
+
+/**
+	* @brief Main loop side: apply every queued count to the tracker. Returns the total move in aim pixels.
+*/
+static int32_t drain(encoderTracker* tracker){
+	inputEvent event;
+	int32_t move = 0;
+	while(popEvent(&queue, &event) == 0){
+		move += encoderCount(tracker, event.value, event.timestamp);
+	}
+	return move;
+}
+
+/**
+	* @brief Turn counts transitions at a steady rate in counts per second, starting at *time. Returns the move.
+*/
+static int32_t turn(encoderTracker* tracker, int32_t counts, uint32_t rate, uint32_t* time){
+	int32_t i, move = 0, direction = (counts < 0) ? -1 : 1;
+	for(i = 0; i < counts * direction; i++){
+		*time += 1000000 / rate;
+		encoderInterrupt(direction, *time);
+		//The main loop drains at 120 Hz; the queue easily holds the counts in between at these rates
+		if(i % 8 == 7){move += drain(tracker);}
+	}
+	return move + drain(tracker);
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+int main(void){
+	encoderTracker tracker;
+	uint32_t time = 5000000, i;
+	int32_t move, velocity;
+	clock_t begin;
+	double seconds;
+	const uint32_t benchCalls = 20000000;
+
+	initEventQueue(&queue);
+	previousPins = quadrature[0];
+	phase = 0;
+	initEncoderTracker(&tracker, ENCODER_AIM_SCALE, time);
+
+	/* Slow: 20 counts at 5 per second are each from rest, 7.5 pixels apiece */
+	move = turn(&tracker, 20, 5, &time);
+	check(move == 150, "slow turn moves 7.5 pixels per count, fractions kept");
+	check(tracker.position == 20, "every transition counted");
+
+	/* Moderate: the velocity estimate settles on the real speed */
+	time += ENCODER_IDLE_TIME;
+	turn(&tracker, 40, 100, &time);
+	velocity = encoderVelocity(&tracker, time);
+	printf("velocity at 100 counts/s: %d, acceleration %d\n", velocity, tracker.acceleration);
+	check((velocity > 90) && (velocity < 110), "velocity within 10% at 100 counts/s");
+
+	/* Fast: gain is capped, so each count moves at most ENCODER_ACCEL_MAX times as far */
+	time += ENCODER_IDLE_TIME;
+	move = turn(&tracker, 200, 2000, &time);
+	printf("200 counts at 2000 counts/s moved %d pixels\n", move);
+	check((move > 200 * 15 / 2 * 2) && (move <= 200 * 15 / 2 * ENCODER_ACCEL_MAX), "fast spin accelerated up to the cap");
+
+	/* Reversal: the speed is measured afresh in the new direction, not smoothed from the old one */
+	move = turn(&tracker, -1, 2000, &time);
+	check((move < 0) && (encoderVelocity(&tracker, time) < 0), "reversal moves back at once");
+
+	/* Idle: the velocity decays to zero */
+	check(encoderVelocity(&tracker, time + ENCODER_IDLE_TIME) == 0, "velocity is zero after the idle time");
+	check(queue.dropped == 0, "no counts dropped");
+
+	/* Cost of the interrupt side, lookup and push, with the queue kept drained */
+	begin = clock();
+	for(i = 0; i < benchCalls; i++){
+		encoderInterrupt((i & 64) ? -1 : 1, i);
+		if((i & 31) == 31){queue.tail = queue.head;}
+	}
+	seconds = (double)(clock() - begin) / CLOCKS_PER_SEC;
+	printf("interrupt body: %.2f ns/transition\n", seconds * 1e9 / benchCalls);
+	initEventQueue(&queue);
+
+	/* Cost of the main loop side, per count */
+	begin = clock();
+	for(i = 0; i < benchCalls; i++){
+		encoderCount(&tracker, (i & 64) ? -1 : 1, i * 700);
+	}
+	seconds = (double)(clock() - begin) / CLOCKS_PER_SEC;
+	printf("encoderCount: %.2f ns/count\n", seconds * 1e9 / benchCalls);
+
+	return failures ? 1 : 0;
+}
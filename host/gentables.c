@@ -0,0 +1,232 @@
+/**
+  ******************************************************************************
+  * @file    gentables.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only generator for tables.c and tables.h, the lookup tables the board keeps in flash.
+	*Build and run from the repository root with:
+	*  gcc -O2 -DTABLE_GENERATOR -I. host/gentables.c trig.c math_functions.c -lm -o gentables && ./gentables .
+	*Every table is computed by the same runtime code it replaces, or derived from a description of the
+	*hardware, so it can't drift from them. TABLE_GENERATOR leaves out the code that reads the tables, so the
+	*generator builds without them. Rerun it after changing any of the code or descriptions below, and check
+	*the result with host/tables_test.c. Uvision has no host build step, so the output is committed.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "math_functions.h"
+#include "trig.h"
+#include "Render.h"
+
+/* Largest circle radius with precomputed spans; bigger circles fall back to intSqrt() */
+#define CIRCLE_TABLE_RADIUS 64
+/* The quarter sine wave is held at 2^SINE_TABLE_BITS steps, and interpolated between them */
+#define SINE_TABLE_BITS 8
+/* Distance either side of a circle's edge, in subpixels, over which pixels are blended. A pixel is partly covered out to its
+ * half diagonal, 0.71 pixels, but past 0.56 pixels the coverage is under 4/255, too faint to see */
+#define CIRCLE_EDGE_WIDTH 9
+/* Linear light is held to this many bits between decoding a channel and encoding it again, enough that no two 
+ * 6-bit levels decode to the same value */
+#define GAMMA_LINEAR_BITS 12
+/* Samples per pixel side, and edge angles, for working out coverage */
+#define COVERAGE_SAMPLES 64
+#define COVERAGE_ANGLES 16
+
+/* Lit segments of each seven-segment pattern, the digits 0-9 then blank, by segment letter */
+static const char* const glyphs[] = {
+	"abcdef", "bc", "abdeg", "abcdg", "bcfg", "acdfg", "acdefg", "abc", "abcdefg", "abcfg", ""
+};
+
+/* Rotary encoder clk/dt states in clockwise order */
+static const int quadratureCycle[4] = {3, 1, 0, 2};
+
+static const char banner[] =
+	"/**\n"
+	"  ******************************************************************************\n"
+	"  * @file    %s\n"
+	"  * @author  David Webster - 100293854\n"
+	"  * @brief   This file contains the lookup tables kept in flash.\n"
+	"\t*Generated by host/gentables.c from the runtime code; do not edit. Checked by host/tables_test.c.\n"
+	"  ******************************************************************************\n"
+	"  */\n\n";
+
+/**
+	* @brief Write count values as a C array body, 16 to a line.
+*/
+static void writeValues(FILE* f, const long* values, int count){
+	int i;
+	for(i = 0; i < count; i++){
+		fprintf(f, "%s%ld%s", (i % 16 == 0) ? "\t" : "", values[i], (i == count - 1) ? "\n" : ((i % 16 == 15) ? ",\n" : ", "));
+	}
+}
+
+static int writeHeader(const char* dir){
+	char path[512];
+	FILE* f;
+	sprintf(path, "%s/tables.h", dir);
+	if((f = fopen(path, "w")) == NULL){return -1;}
+	fprintf(f, banner, "tables.h");
+	fprintf(f, "#include <stdint.h>\n#ifndef tablesHeader\n#define tablesHeader\n\n");
+	fprintf(f, "/* Largest radius in circleSpans; bigger circles fall back to intSqrt() */\n");
+	fprintf(f, "#define CIRCLE_TABLE_RADIUS %d\n", CIRCLE_TABLE_RADIUS);
+	fprintf(f, "/* Index of the span at row 0 of a circle of radius r; rows 0 to r follow it */\n");
+	fprintf(f, "#define CIRCLE_SPAN_OFFSET(r) (((r) * ((r) + 1)) / 2)\n");
+	fprintf(f, "/* sineTable holds a quarter wave in 2^SINE_TABLE_BITS steps, plus the end point */\n");
+	fprintf(f, "#define SINE_TABLE_BITS %d\n", SINE_TABLE_BITS);
+	fprintf(f, "#define SINE_TABLE_SIZE (1 << SINE_TABLE_BITS)\n");
+	fprintf(f, "/* circleEdgeCoverage spans this many subpixels either side of an edge */\n");
+	fprintf(f, "#define CIRCLE_EDGE_WIDTH %d\n", CIRCLE_EDGE_WIDTH);
+	fprintf(f, "/* The gammaDecode tables give linear light to this many bits; the gammaEncode tables take it back */\n");
+	fprintf(f, "#define GAMMA_LINEAR_BITS %d\n\n", GAMMA_LINEAR_BITS);
+	fprintf(f, "extern const uint8_t circleSpans[CIRCLE_SPAN_OFFSET(CIRCLE_TABLE_RADIUS + 1)]; /** Half width of each row of each circle, from intSqrt() */\n");
+	fprintf(f, "extern const uint8_t blendRamp[256]; /** 8-bit alpha to blendPixelFast()'s 0 to 32 weight */\n");
+	fprintf(f, "extern const uint16_t sineTable[SINE_TABLE_SIZE + 1]; /** Q15 sine over a quarter turn, from trigSin() */\n");
+	fprintf(f, "extern const int8_t encoderMotionTable[16]; /** Encoder step from previous clk, dt and current clk, dt */\n");
+	fprintf(f, "extern const uint8_t circleEdgeCoverage[2 * CIRCLE_EDGE_WIDTH + 1]; /** Alpha of a pixel whose centre is index - CIRCLE_EDGE_WIDTH subpixels outside an edge */\n");
+	fprintf(f, "extern const uint8_t segmentPatterns[11]; /** Lit segments of 0-9 and blank, bit 0 is a through bit 6 is g */\n");
+	fprintf(f, "extern const uint16_t gammaDecode5[32]; /** Linear light of each 5-bit sRGB level */\n");
+	fprintf(f, "extern const uint16_t gammaDecode6[64]; /** Linear light of each 6-bit sRGB level */\n");
+	fprintf(f, "extern const uint8_t gammaEncode5[1 << GAMMA_LINEAR_BITS]; /** Nearest 5-bit sRGB level to each linear light value */\n");
+	fprintf(f, "extern const uint8_t gammaEncode6[1 << GAMMA_LINEAR_BITS]; /** Nearest 6-bit sRGB level to each linear light value */\n");
+	fprintf(f, "extern const uint16_t gammaDecode8[256]; /** Linear light of each 8-bit sRGB level, for ARGB8888 frame buffers */\n");
+	fprintf(f, "extern const uint8_t gammaEncode8[1 << GAMMA_LINEAR_BITS]; /** Nearest 8-bit sRGB level to each linear light value */\n");
+	fprintf(f, "#endif\n");
+	return fclose(f);
+}
+
+/**
+	* @brief Fraction of a pixel covered by a straight edge whose distance from the pixel centre is distance pixels, 
+	* positive outside. Averaged over edge angles from 0 to 45 degrees, which by symmetry is every angle; 
+	* a circle's edge is near enough straight across one pixel. 
+*/
+static double edgeCoverage(double distance){
+	int a, i, j, inside = 0;
+	double angle, nx, ny, px, py;
+	for(a = 0; a < COVERAGE_ANGLES; a++){
+		angle = (a + 0.5) * (3.14159265358979 / 4) / COVERAGE_ANGLES;
+		nx = cos(angle);
+		ny = sin(angle);
+		for(i = 0; i < COVERAGE_SAMPLES; i++){
+			for(j = 0; j < COVERAGE_SAMPLES; j++){
+				px = (i + 0.5) / COVERAGE_SAMPLES - 0.5;
+				py = (j + 0.5) / COVERAGE_SAMPLES - 0.5;
+				//Inside if the sample is further in along the edge normal than the edge is
+				if(px * nx + py * ny < -distance){inside++;}
+			}
+		}
+	}
+	return (double)inside / ((double)COVERAGE_ANGLES * COVERAGE_SAMPLES * COVERAGE_SAMPLES);
+}
+
+/**
+	* @brief The sRGB transfer function, from linear light in 0 to 1 to the encoded level in 0 to 1, and back. 
+	* The panel is near enough sRGB that blending in its linear light keeps edges the same brightness all round. 
+*/
+static double srgbEncode(double linear){
+	return (linear <= 0.0031308) ? linear * 12.92 : 1.055 * pow(linear, 1 / 2.4) - 0.055;
+}
+
+static double srgbDecode(double level){
+	return (level <= 0.04045) ? level / 12.92 : pow((level + 0.055) / 1.055, 2.4);
+}
+
+static int writeSource(const char* dir){
+	static long values[CIRCLE_TABLE_RADIUS * CIRCLE_TABLE_RADIUS * 2];
+	char path[512];
+	FILE* f;
+	int r, y, i, n, prev, cur, step;
+	const char* c;
+	sprintf(path, "%s/tables.c", dir);
+	if((f = fopen(path, "w")) == NULL){return -1;}
+	fprintf(f, banner, "tables.c");
+	fprintf(f, "#include \"tables.h\"\n\n");
+
+	/* Circle half widths, as drawFilledCircle() computes them */
+	n = 0;
+	for(r = 0; r <= CIRCLE_TABLE_RADIUS; r++){
+		for(y = 0; y <= r; y++){
+			values[n++] = (long)intSqrt((uint32_t)(r * r - y * y));
+		}
+	}
+	fprintf(f, "const uint8_t circleSpans[CIRCLE_SPAN_OFFSET(CIRCLE_TABLE_RADIUS + 1)] = {\n");
+	writeValues(f, values, n);
+	fprintf(f, "};\n\n");
+
+	/* Alpha to 5-bit weight, rounded, so 255 is fully opaque */
+	for(i = 0; i < 256; i++){
+		values[i] = (i + 4) >> 3;
+	}
+	fprintf(f, "const uint8_t blendRamp[256] = {\n");
+	writeValues(f, values, 256);
+	fprintf(f, "};\n\n");
+
+	/* Quarter sine wave, from the CORDIC */
+	for(i = 0; i <= (1 << SINE_TABLE_BITS); i++){
+		values[i] = trigSin(i * (ANGLE_QUARTER >> SINE_TABLE_BITS));
+	}
+	fprintf(f, "const uint16_t sineTable[SINE_TABLE_SIZE + 1] = {\n");
+	writeValues(f, values, (1 << SINE_TABLE_BITS) + 1);
+	fprintf(f, "};\n\n");
+
+	/* Encoder steps: one place along the quadrature cycle is a step, anything else is bounce or a missed state */
+	for(prev = 0; prev < 4; prev++){
+		for(cur = 0; cur < 4; cur++){
+			for(i = 0; quadratureCycle[i] != prev; i++);
+			for(n = 0; quadratureCycle[n] != cur; n++);
+			step = (n - i + 4) % 4;
+			values[(prev << 2) | cur] = (step == 1) ? 1 : ((step == 3) ? -1 : 0);
+		}
+	}
+	fprintf(f, "const int8_t encoderMotionTable[16] = {\n");
+	writeValues(f, values, 16);
+	fprintf(f, "};\n\n");
+
+	/* Seven-segment patterns from the glyph descriptions */
+	for(i = 0; i < 11; i++){
+		values[i] = 0;
+		for(c = glyphs[i]; *c; c++){
+			values[i] |= 1 << (*c - 'a');
+		}
+	}
+	fprintf(f, "const uint8_t segmentPatterns[11] = {\n");
+	writeValues(f, values, 11);
+	fprintf(f, "};\n\n");
+
+	/* Edge coverage, by distance of the pixel centre outside the edge */
+	for(i = -CIRCLE_EDGE_WIDTH; i <= CIRCLE_EDGE_WIDTH; i++){
+		values[i + CIRCLE_EDGE_WIDTH] = (long)(edgeCoverage((double)i / (1 << CIRCLE_SUBPIXEL_BITS)) * 255 + 0.5);
+	}
+	fprintf(f, "const uint8_t circleEdgeCoverage[2 * CIRCLE_EDGE_WIDTH + 1] = {\n");
+	writeValues(f, values, 2 * CIRCLE_EDGE_WIDTH + 1);
+	fprintf(f, "};\n\n");
+
+	/* Gamma: each channel level to linear light, and linear light to the nearest level, for 5, 6 and 8-bit channels */
+	for(n = 5; n <= 8; n += (n == 6) ? 2 : 1){
+		for(i = 0; i < (1 << n); i++){
+			values[i] = (long)(srgbDecode((double)i / ((1 << n) - 1)) * ((1 << GAMMA_LINEAR_BITS) - 1) + 0.5);
+		}
+		fprintf(f, "const uint16_t gammaDecode%d[%d] = {\n", n, 1 << n);
+		writeValues(f, values, 1 << n);
+		fprintf(f, "};\n\n");
+	}
+	for(n = 5; n <= 8; n += (n == 6) ? 2 : 1){
+		for(i = 0; i < (1 << GAMMA_LINEAR_BITS); i++){
+			values[i] = (long)(srgbEncode((double)i / ((1 << GAMMA_LINEAR_BITS) - 1)) * ((1 << n) - 1) + 0.5);
+		}
+		fprintf(f, "const uint8_t gammaEncode%d[1 << GAMMA_LINEAR_BITS] = {\n", n);
+		writeValues(f, values, 1 << GAMMA_LINEAR_BITS);
+		fprintf(f, "};\n%s", (n != 8) ? "\n" : "");
+	}
+	return fclose(f);
+}
+
+int main(int argc, char** argv){
+	const char* dir = (argc > 1) ? argv[1] : ".";
+	if((writeHeader(dir) != 0) || (writeSource(dir) != 0)){
+		fprintf(stderr, "gentables: cannot write to %s\n", dir);
+		return 1;
+	}
+	printf("gentables: wrote %s/tables.h and %s/tables.c\n", dir, dir);
+	return 0;
+}
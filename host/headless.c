@@ -0,0 +1,153 @@
+/**
+  ******************************************************************************
+  * @file    headless.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only soak test; runs the game simulation with no display or hardware.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/headless.c simulation.c game.c list.c math_functions.c trig.c tables.c replay.c prng.c latency.c -lm -o headless
+	*Usage: headless [ticks] [replay file or -] [draw ms]
+	*Without a replay file, a scripted player touches the screen, shoots and explodes on a fixed rhythm.
+	*Also reports input-to-photon latency, with frames rendered every RENDER_INTERVAL ms of input time 
+	*and taking draw ms to draw and present, as LATENCY_MODE does on the board.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "simulation.h"
+#include "replay.h"
+#include "latency.h"
+
+#define DEFAULT_TICKS 1000000
+/* As in Mainloop.c */
+#define RENDER_INTERVAL 33
+
+/**
+	* @brief Scripted input for tick n. Sweeps the aim, holds the touch sensor for 20 frames out of every 45, at 30 FPS.
+*/
+static void scriptedInput(uint32_t n, inputFrame* input){
+	int prevState = input->touchSensorState;
+	uint32_t frame = n * 30 / SIM_RATE;
+	input->encoderCounter = (int32_t)((frame / 8) % 21) * AIM_STEP - COUNTERMAX;
+	input->touchSensorState = (frame % 45) < 20;
+	input->touchSensorChanged = (input->touchSensorState != prevState);
+	input->buttonState = 0;
+	input->buttonChanged = 0;
+	input->touchscreenPressed = (frame % 60) == 0;
+	input->tick = n * 1000 / SIM_RATE;
+}
+
+/**
+	* @brief Read a whole file into a malloc'd buffer. Returns NULL on failure.
+*/
+static uint8_t* readFile(const char* path, uint32_t* length){
+	FILE* f = fopen(path, "rb");
+	uint8_t* data;
+	long size;
+	if(f == NULL){return NULL;}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	data = (uint8_t*)malloc(size > 0 ? size : 1);
+	if(data && fread(data, 1, size, f) != (size_t)size){
+		free(data);
+		data = NULL;
+	}
+	fclose(f);
+	*length = (uint32_t)size;
+	return data;
+}
+
+/**
+	* @brief Print the latency histogram and summary.
+*/
+static void printLatency(const latencyTracker* tracker){
+	uint32_t i, j, peak = 1, bar;
+	printf("latency count %u dropped %u\n", tracker->count, tracker->dropped);
+	if(tracker->count == 0){return;}
+	printf("latency min %u p50 %u p90 %u p99 %u max %u ms\n", tracker->min, latencyPercentile(tracker, 50), 
+		latencyPercentile(tracker, 90), latencyPercentile(tracker, 99), tracker->max);
+	printf("latency mean edge-to-step %.1f step-to-present %.1f ms\n", 
+		(double)tracker->totalEdgeToStep / tracker->count, (double)tracker->totalStepToPresent / tracker->count);
+	for(i = 0; i < LATENCY_BUCKETS; i++){
+		peak = (tracker->histogram[i] > peak) ? tracker->histogram[i] : peak;
+	}
+	for(i = 0; i < LATENCY_BUCKETS; i++){
+		if(tracker->histogram[i] == 0){continue;}
+		bar = (uint32_t)((uint64_t)tracker->histogram[i] * 50 / peak);
+		printf("%3u%s ms %8u ", i * LATENCY_BUCKET_MS, (i == LATENCY_BUCKETS - 1) ? "+" : " ", tracker->histogram[i]);
+		for(j = 0; j < bar; j++){putchar('#');}
+		putchar('\n');
+	}
+}
+
+int main(int argc, char** argv){
+	gameState sim;
+	inputFrame input;
+	replayStream replay;
+	uint8_t* replayData = NULL;
+	uint32_t replayLength, n, ticks = DEFAULT_TICKS;
+	uint32_t games = 0, wins = 0, losses = 0;
+	uint32_t drawTime = 0, nextRender = 0, busyUntil = 0, stepTime;
+	latencyTracker latency;
+	clock_t begin, end;
+	double seconds;
+
+	if(argc > 1){ticks = (uint32_t)strtoul(argv[1], NULL, 10);}
+	memset(&sim, 0, sizeof(sim));
+	memset(&input, 0, sizeof(input));
+	initGame(&sim, 0);
+	replay.mode = replayOff;
+	initLatency(&latency);
+	if(argc > 3){drawTime = (uint32_t)strtoul(argv[3], NULL, 10);}
+
+	if((argc > 2) && strcmp(argv[2], "-")){
+		replayData = readFile(argv[2], &replayLength);
+		if((replayData == NULL) || (startPlayback(&replay, replayData, replayLength) != 0)){
+			fprintf(stderr, "could not read replay %s\n", argv[2]);
+			return 1;
+		}
+		initGame(&sim, (uint32_t)replay.seed);
+	}
+	nextRender = (replay.mode == replayPlayback) ? replay.lastTick : 0;
+
+	begin = clock();
+	for(n = 0; n < ticks; n++){
+		if(replay.mode == replayPlayback){
+			if(readFrame(&replay, &input) != 0){break;}
+		}
+		else{
+			scriptedInput(n, &input);
+		}
+		step(&sim, &input);
+		if(sim.events & EVENT_GAME_STARTED){games++;}
+		if(sim.events & EVENT_GAME_OVER){
+			if(sim.state == win){wins++;}
+			else{losses++;}
+		}
+		/* A tick that fell due while a frame was drawing runs once the draw finishes */
+		stepTime = ((int32_t)(busyUntil - input.tick) > 0) ? busyUntil : input.tick;
+		if(sim.events & (EVENT_SHOT | EVENT_EXPLODED)){
+			latencyInput(&latency, input.tick - input.touchSensorEdgeAge, stepTime);
+		}
+		if((int32_t)(stepTime - nextRender) >= 0){
+			busyUntil = stepTime + drawTime;
+			latencyPresent(&latency, busyUntil);
+			nextRender += RENDER_INTERVAL * (1 + drawTime / RENDER_INTERVAL);
+			if((int32_t)(busyUntil - nextRender) > RENDER_INTERVAL){
+				nextRender = busyUntil + RENDER_INTERVAL;
+			}
+		}
+	}
+	end = clock();
+
+	seconds = (double)(end - begin) / CLOCKS_PER_SEC;
+	printf("ticks %u\nseconds %.3f\nticks/s %.0f\n", n, seconds, seconds > 0 ? n / seconds : 0.0);
+	printf("games %u wins %u losses %u\n", games, wins, losses);
+	printLatency(&latency);
+	deleteList(&sim.enemyList);
+	free(replayData);
+	return 0;
+}
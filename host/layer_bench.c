@@ -0,0 +1,282 @@
+/**
+  ******************************************************************************
+  * @file    layer_bench.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only check and pixel-write benchmark for the background and sprite layers in Render.c.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/layer_bench.c Render.c Fonts.c math_functions.c tables.c particles.c starfield.c trig.c prng.c -lm -o layer_bench
+	*Stands in for the platform's frame buffers and background layer, as circle_bench.c does. Draws the same moving
+	*scene, like a frame of the game, first on a single layer, clearing and redrawing everything each frame, then
+	*layered, with the static parts drawn once on the background and only the tiles drawn on cleared. Checks that every
+	*layered frame, composited as the panel would show it, matches the single layer frame, so nothing moving leaves a
+	*ghost, and that the layers stay inside their buffers. Then reports the pixels written and the time taken each frame
+	*both ways, and the cost of compositing in software. Exits non-zero if a check fails.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Portrait, as Render.c draws */
+#define GLCD_LANDSCAPE 0
+#include "GLCD_Config.h"
+#include "platform.h"
+#include "Render.h"
+#include "particles.h"
+#include "starfield.h"
+
+#define BENCH_FRAMES 60
+#define BENCH_RUNS 5
+/* Milliseconds per rendered frame, as in Mainloop.c */
+#define FRAME_MS 33
+#define SCREEN_PIXELS (GLCD_WIDTH * GLCD_HEIGHT)
+/* Guard words either side of each buffer, to catch writes off the screen */
+#define GUARD 4096
+#define GUARD_VALUE 0xA5A5
+#define KEY GLCD_COLOR_BLACK
+/* Moving things stay above this game y, off the static turret base, so their edges blend over black both ways */
+#define MOVING_FLOOR 80
+
+static uint16_t memory[3][GUARD + SCREEN_PIXELS + GUARD];
+static uint16_t composited[SCREEN_PIXELS];
+static uint16_t* expected; /** Each single layer frame, BENCH_FRAMES of them */
+static particlePool pool;
+static starfield field;
+static int failures;
+
+void platformDisplayInit(void){
+	uint32_t i, j;
+	for(i = 0; i < 3; i++){
+		for(j = 0; j < sizeof(memory[0]) / sizeof(memory[0][0]); j++){
+			memory[i][j] = GUARD_VALUE;
+		}
+	}
+}
+
+uint16_t* platformFrameBuffer(uint32_t index){
+	return &memory[index ? 1 : 0][GUARD];
+}
+
+void platformPresent(uint32_t index){
+	(void)index;
+}
+
+static uint16_t* background(void){
+	return &memory[2][GUARD];
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int guardsIntact(void){
+	uint32_t b, i;
+	for(b = 0; b < 3; b++){
+		for(i = 0; i < GUARD; i++){
+			if((memory[b][i] != GUARD_VALUE) || (memory[b][GUARD + SCREEN_PIXELS + i] != GUARD_VALUE)){
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+/**
+	* @brief Draws the parts that don't move: a circle at the bottom, like the turret base. Returns the pixels it covers.
+*/
+static uint32_t drawStatic(void){
+	uint32_t i, covered = 0;
+	setForegroundColor(GLCD_COLOR_BLUE);
+	drawFilledCircleAA(TO_SUBPIXEL(136), 0, TO_SUBPIXEL(40));
+	for(i = 0; i < SCREEN_PIXELS; i++){
+		covered += platformFrameBuffer(1)[i] != 0;
+	}
+	return covered;
+}
+
+/**
+	* @brief Plots the stars, after the static parts, as the layered frame has them over the background.
+*/
+static void plotStars(void){
+	uint32_t x, i;
+	uint16_t* frame = platformFrameBuffer(backBufferIndex());
+	for(x = 0; x < STAR_COLUMNS; x++){
+		for(i = field.columnStarts[x]; i < field.columnStarts[x + 1]; i++){
+			frame[((GLCD_WIDTH - 1 - x) * GLCD_HEIGHT) + (GLCD_HEIGHT - 1) - (((field.y[i] >> 16) * GLCD_HEIGHT) >> 16)] = field.color[i];
+		}
+	}
+}
+
+/**
+	* @brief Draws frame's moving things: bullets and their trails, meteors, an explosion and sparks, and text.
+*/
+static void drawMoving(uint32_t frame){
+	static int16_t xs[8][4], ys[8][4];
+	polygon meteors[8];
+	uint32_t i, x, y;
+	char text[16];
+
+	for(i = 0; i < 5; i++){
+		x = 20 + ((frame * (3 + i) + i * 50) % 232);
+		y = MOVING_FLOOR + 30 + ((frame * (5 + 2 * i) + i * 70) % 340);
+		setForegroundColor(GLCD_COLOR_NAVY);
+		drawThickLine(x, MOVING_FLOOR + 10, x, y, 3);
+		setForegroundColor(GLCD_COLOR_CYAN);
+		drawFilledCircleAA(TO_SUBPIXEL(x) + (frame & 15), TO_SUBPIXEL(y), TO_SUBPIXEL(10));
+	}
+	for(i = 0; i < 8; i++){
+		x = TO_SUBPIXEL(30 + i * 30);
+		y = TO_SUBPIXEL(460 - ((frame * 4 + i * 40) % 340)) + (i * 5);
+		xs[i][0] = (int16_t)(x - TO_SUBPIXEL(9));
+		ys[i][0] = (int16_t)(y - TO_SUBPIXEL(4));
+		xs[i][1] = (int16_t)(x + TO_SUBPIXEL(2));
+		ys[i][1] = (int16_t)(y - TO_SUBPIXEL(10));
+		xs[i][2] = (int16_t)(x + TO_SUBPIXEL(10));
+		ys[i][2] = (int16_t)(y + TO_SUBPIXEL(3));
+		xs[i][3] = (int16_t)(x - TO_SUBPIXEL(1));
+		ys[i][3] = (int16_t)(y + TO_SUBPIXEL(11));
+		meteors[i].x = xs[i];
+		meteors[i].y = ys[i];
+		meteors[i].count = 4;
+		meteors[i].fill = GLCD_COLOR_MAROON;
+		meteors[i].outline = GLCD_COLOR_RED;
+		meteors[i].outlined = 1;
+	}
+	fillPolygons(meteors, 8);
+	if((frame % 30) < 12){
+		setForegroundColor(((frame / 2) & 1) ? GLCD_COLOR_DARK_GREEN : GLCD_COLOR_CYAN);
+		drawFilledCircleAA(TO_SUBPIXEL(150), TO_SUBPIXEL(300), TO_SUBPIXEL(60));
+	}
+	drawSplats(pool.x, pool.y, pool.color, pool.alpha, pool.count, 2);
+	setForegroundColor(GLCD_COLOR_WHITE);
+	sprintf(text, "%u", (unsigned)frame);
+	GLCD_DrawString(0, 456, text);
+}
+
+/**
+	* @brief Moves the stars and sparks on a frame, bursting sparks well above the turret base now and then.
+*/
+static void step(uint32_t frame){
+	if((frame % 30) == 0){
+		emitBurst(&pool, 150, 300, 600, 60, 800, GLCD_COLOR_WHITE, 0);
+	}
+	updateParticles(&pool, FRAME_MS);
+	updateStars(&field, FRAME_MS);
+}
+
+/**
+	* @brief Pixels of the background showing through key coloured sprite pixels in the composited frame, 
+	* or 0 if any of them doesn't.
+*/
+static uint32_t showingThrough(const uint16_t* sprites){
+	uint32_t i, showing = 0;
+	for(i = 0; i < SCREEN_PIXELS; i++){
+		if((sprites[i] == KEY) && (background()[i] != KEY)){
+			if(composited[i] != background()[i]){
+				return 0;
+			}
+			showing++;
+		}
+	}
+	return showing;
+}
+
+static void restart(void){
+	initParticles(&pool, 11);
+	initStars(&field, STAR_CAPACITY, 5);
+}
+
+int main(void){
+	uint32_t frame, run, i, staticPixels, cleared = 0, stars = 0, mismatched = 0, shows = 1;
+	double begin, single = 1e9, layered = 1e9, composite = 1e9, seconds, fullWrites, layeredWrites;
+
+	expected = (uint16_t*)malloc(sizeof(uint16_t) * SCREEN_PIXELS * BENCH_FRAMES);
+	GLCD_Initialize_Doublebuffer();
+	setBackgroundColor(GLCD_COLOR_BLACK);
+
+	/* One layer: clear, then draw everything, every frame */
+	clearScreen();
+	staticPixels = drawStatic();
+	for(run = 0; run < BENCH_RUNS; run++){
+		restart();
+		begin = nowSeconds();
+		for(frame = 0; frame < BENCH_FRAMES; frame++){
+			step(frame);
+			clearScreen();
+			drawStatic();
+			plotStars();
+			drawMoving(frame);
+			if(run == 0){
+				memcpy(&expected[frame * SCREEN_PIXELS], platformFrameBuffer(backBufferIndex()), sizeof(composited));
+			}
+			switchBuffer();
+		}
+		seconds = (nowSeconds() - begin) / BENCH_FRAMES;
+		single = (seconds < single) ? seconds : single;
+	}
+
+	/* Layered: the static parts once, then only what moves */
+	GLCD_InitializeLayers(background(), KEY);
+	drawToBackground();
+	clearScreen();
+	drawStatic();
+	drawToSprites();
+	for(run = 0; run < BENCH_RUNS; run++){
+		restart();
+		invalidateSprites();
+		begin = nowSeconds();
+		for(frame = 0; frame < BENCH_FRAMES; frame++){
+			step(frame);
+			i = clearSprites();
+			drawStars(field.columnStarts, field.y, field.color, field.drawn[backBufferIndex()]);
+			drawMoving(frame);
+			if(run == 0){
+				//The first two frames clear each buffer whole
+				cleared += (frame >= 2) ? i : 0;
+				stars += (frame >= 2) ? 2 * field.count : 0;
+				compositeLayers(composited, platformFrameBuffer(backBufferIndex()), background(), KEY);
+				mismatched += memcmp(composited, &expected[frame * SCREEN_PIXELS], sizeof(composited)) != 0;
+				//The turret base is only on the background, so shows through all but where stars pass over it
+				shows = shows && (showingThrough(platformFrameBuffer(backBufferIndex())) > staticPixels / 2);
+			}
+			switchBuffer();
+		}
+		seconds = (nowSeconds() - begin) / BENCH_FRAMES;
+		layered = (seconds < layered) ? seconds : layered;
+	}
+	printf("%u of %u layered frames differ from the single layer\n", (unsigned)mismatched, BENCH_FRAMES);
+	check(mismatched == 0, "every layered frame composites to the single layer frame, with no ghosts");
+	check(shows, "the background shows through the key colour");
+	check(guardsIntact(), "both layers stay inside their buffers");
+
+	/* Compositing, as the host platform does it in place of the LTDC */
+	for(run = 0; run < BENCH_RUNS; run++){
+		begin = nowSeconds();
+		for(frame = 0; frame < BENCH_FRAMES; frame++){
+			compositeLayers(composited, platformFrameBuffer(frame & 1), background(), KEY);
+		}
+		seconds = (nowSeconds() - begin) / BENCH_FRAMES;
+		composite = (seconds < composite) ? seconds : composite;
+	}
+
+	/* Pixels written apart from the moving things, which are drawn the same both ways */
+	fullWrites = SCREEN_PIXELS + staticPixels + field.count;
+	layeredWrites = (cleared + stars) / (double)(BENCH_FRAMES - 2);
+	printf("pixel writes a frame, besides moving things: single layer %.0f (clear %u, static %u, stars %u), layered %.0f (%.0f%%)\n",
+		fullWrites, (unsigned)SCREEN_PIXELS, (unsigned)staticPixels, (unsigned)field.count, layeredWrites, layeredWrites * 100 / fullWrites);
+	printf("frame: single layer %7.1f us, layered %7.1f us, %.2fx; software composite %7.1f us\n", single * 1e6, layered * 1e6,
+		layered / single, composite * 1e6);
+	check(layeredWrites * 2 < fullWrites, "layers at least halve the pixels written each frame");
+
+	free(expected);
+	return failures ? 1 : 0;
+}
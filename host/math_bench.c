@@ -0,0 +1,143 @@
+/**
+  ******************************************************************************
+  * @file    math_bench.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only accuracy and speed benchmark for the square root kernels in math_functions.c.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/math_bench.c math_functions.c -lm -o math_bench
+	*Sweeps each kernel over its input range against a double precision reference, and times it against
+	*the implementation it replaces. Host timings only rank the kernels roughly; the board's FPU is single
+	*precision only, so the double square root that the old normalize used runs in software there.
+	*Exits non-zero if intSqrt() or intSqrtBatch() is not exact, or normalizeToCircle() is wrong on an axis.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "math_functions.h"
+
+#define BENCH_COUNT 4096
+#define BENCH_ROUNDS 4000
+#define CIRCLE_RANGE (480 * 480)
+
+static int failures;
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+	* @brief Reference truncated square root.
+*/
+static uint32_t referenceSqrt(uint32_t x){
+	uint32_t r = (uint32_t)sqrt((double)x);
+	while((uint64_t)r * r > x){r--;}
+	while((uint64_t)(r + 1) * (r + 1) <= x){r++;}
+	return r;
+}
+
+/**
+	* @brief normalizeToCircle() as it was, with a double square root and two divisions.
+*/
+static void oldNormalizeToCircle(float x, float y, float radius, float out[2]){
+	float root = sqrt(x*x + y*y);
+	out[0] = (x/root)*radius;
+	out[1] = (y/root)*radius;
+}
+
+int main(void){
+	static uint32_t values[BENCH_COUNT], roots[BENCH_COUNT];
+	static float xs[BENCH_COUNT], ys[BENCH_COUNT];
+	uint32_t i, r, ref, exactErrors = 0, fastWorst = 0, fastWorstAt = 0, fastWrong = 0, n = 0;
+	uint32_t circleWrong = 0, circleWorst = 0, batchErrors = 0;
+	uint64_t x;
+	double begin, seconds;
+	float out[2];
+	volatile uint32_t sink = 0;
+	volatile float fsink = 0;
+
+	/* isqrt: every input below 2^24, then a stride across the rest, plus every perfect square and its neighbours */
+	for(x = 0; x <= 0xFFFFFFFFULL; x += (x < (1UL << 24)) ? 1 : 4099){
+		ref = referenceSqrt((uint32_t)x);
+		if(intSqrt((uint32_t)x) != ref){exactErrors++;}
+		r = fastIntSqrt((uint32_t)x);
+		r = (r > ref) ? r - ref : ref - r;
+		if(r != 0){fastWrong++;}
+		/* Render.c only takes roots of squared radii up to the screen height */
+		if((x < CIRCLE_RANGE) && (r != 0)){circleWrong++;}
+		if((x < CIRCLE_RANGE) && (r > circleWorst)){circleWorst = r;}
+		if(r > fastWorst){fastWorst = r; fastWorstAt = (uint32_t)x;}
+		n++;
+	}
+	for(x = 1; x < 65536; x++){
+		if(intSqrt((uint32_t)(x * x)) != x){exactErrors++;}
+		if(intSqrt((uint32_t)(x * x - 1)) != x - 1){exactErrors++;}
+	}
+	if(intSqrt(0xFFFFFFFF) != 65535){exactErrors++;}
+	printf("fastIntSqrt: wrong for %u of %u inputs, worst off by %u at %u\n", fastWrong, n, fastWorst, fastWorstAt);
+	printf("fastIntSqrt: wrong for %u of %u circle inputs, worst off by %u\n", circleWrong, CIRCLE_RANGE, circleWorst);
+	check(exactErrors == 0, "intSqrt is exact over the sweep and at every perfect square");
+	for(i = 0; i < BENCH_COUNT; i++){
+		values[i] = i * 1048573UL;
+	}
+	intSqrtBatch(values, roots, BENCH_COUNT);
+	for(i = 0; i < BENCH_COUNT; i++){
+		if(roots[i] != referenceSqrt(values[i])){batchErrors++;}
+	}
+	check(batchErrors == 0, "intSqrtBatch is exact across the range");
+
+	normalizeToCircle(-5, 0, 10, out);
+	check((out[0] == -10) && (out[1] == 0), "normalizeToCircle on the x axis writes both outputs");
+	normalizeToCircle(0, 3, 10, out);
+	check((out[0] == 0) && (out[1] == 10), "normalizeToCircle on the y axis writes both outputs");
+
+	/* Timing, over the circle radii Render.c takes roots for */
+	for(i = 0; i < BENCH_COUNT; i++){
+		values[i] = (i * 2654435761UL) % (300 * 300);
+		xs[i] = (float)((int32_t)(i % 273) - 136);
+		ys[i] = 300.0f + (float)(i % 17);
+	}
+	begin = nowSeconds();
+	for(r = 0; r < BENCH_ROUNDS; r++){
+		for(i = 0; i < BENCH_COUNT; i++){sink += fastIntSqrt(values[i] + r);}
+	}
+	seconds = nowSeconds() - begin;
+	printf("fastIntSqrt:   %6.2f ns/call\n", seconds * 1e9 / ((double)BENCH_ROUNDS * BENCH_COUNT));
+	begin = nowSeconds();
+	for(r = 0; r < BENCH_ROUNDS; r++){
+		for(i = 0; i < BENCH_COUNT; i++){sink += intSqrt(values[i] + r);}
+	}
+	seconds = nowSeconds() - begin;
+	printf("intSqrt:       %6.2f ns/call\n", seconds * 1e9 / ((double)BENCH_ROUNDS * BENCH_COUNT));
+	begin = nowSeconds();
+	for(r = 0; r < BENCH_ROUNDS; r++){
+		values[r % BENCH_COUNT] += r;
+		intSqrtBatch(values, roots, BENCH_COUNT);
+		sink += roots[r % BENCH_COUNT];
+	}
+	seconds = nowSeconds() - begin;
+	printf("intSqrtBatch:  %6.2f ns/value\n", seconds * 1e9 / ((double)BENCH_ROUNDS * BENCH_COUNT));
+
+	begin = nowSeconds();
+	for(r = 0; r < BENCH_ROUNDS; r++){
+		for(i = 0; i < BENCH_COUNT; i++){oldNormalizeToCircle(xs[i] + r, ys[i], 100, out); fsink += out[0];}
+	}
+	seconds = nowSeconds() - begin;
+	printf("old normalize: %6.2f ns/call\n", seconds * 1e9 / ((double)BENCH_ROUNDS * BENCH_COUNT));
+	begin = nowSeconds();
+	for(r = 0; r < BENCH_ROUNDS; r++){
+		for(i = 0; i < BENCH_COUNT; i++){normalizeToCircle(xs[i] + r, ys[i], 100, out); fsink += out[0];}
+	}
+	seconds = nowSeconds() - begin;
+	printf("normalize:     %6.2f ns/call\n", seconds * 1e9 / ((double)BENCH_ROUNDS * BENCH_COUNT));
+
+	return failures ? 1 : 0;
+}
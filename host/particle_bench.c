@@ -0,0 +1,181 @@
+/**
+  ******************************************************************************
+  * @file    particle_bench.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only check and speed benchmark for the particle pool in particles.c and drawSplats() in Render.c.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/particle_bench.c particles.c Render.c Fonts.c math_functions.c trig.c tables.c prng.c -lm -o particle_bench
+	*Stands in for the platform's frame buffers, as circle_bench.c does. Checks that bursts fill the pool up to its
+	*capacity and count what doesn't fit, that particles fade out and are removed on time, and that splats off the
+	*screen stay inside the frame buffer. Then times a frame's update and draw with the pool full, as points and
+	*as quads, and reports the occupancy. Exits non-zero if a check fails.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* Portrait, as Render.c draws */
+#define GLCD_LANDSCAPE 0
+#include "GLCD_Config.h"
+#include "platform.h"
+#include "Render.h"
+#include "particles.h"
+
+#define BENCH_FRAMES 200
+#define BENCH_RUNS 5
+/* Milliseconds per rendered frame, as in Mainloop.c */
+#define FRAME_MS 33
+/* Guard words either side of the frame buffers, to catch writes off the screen */
+#define GUARD 4096
+#define GUARD_VALUE 0xA5A5
+
+static uint16_t memory[2][GUARD + (GLCD_WIDTH * GLCD_HEIGHT) + GUARD];
+static particlePool pool;
+static int failures;
+
+void platformDisplayInit(void){
+	uint32_t i, j;
+	for(i = 0; i < 2; i++){
+		for(j = 0; j < sizeof(memory[0]) / sizeof(memory[0][0]); j++){
+			memory[i][j] = GUARD_VALUE;
+		}
+	}
+}
+
+uint16_t* platformFrameBuffer(uint32_t index){
+	return &memory[index ? 1 : 0][GUARD];
+}
+
+void platformPresent(uint32_t index){
+	(void)index;
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void clearDrawn(void){
+	memset(&memory[1][GUARD], 0, GLCD_WIDTH * GLCD_HEIGHT * sizeof(uint16_t));
+}
+
+static int guardsIntact(void){
+	uint32_t i;
+	for(i = 0; i < GUARD; i++){
+		if((memory[1][i] != GUARD_VALUE) || (memory[1][GUARD + (GLCD_WIDTH * GLCD_HEIGHT) + i] != GUARD_VALUE)){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static uint32_t litPixels(void){
+	uint32_t i, n = 0;
+	for(i = 0; i < GLCD_WIDTH * GLCD_HEIGHT; i++){
+		n += memory[1][GUARD + i] != 0;
+	}
+	return n;
+}
+
+/**
+	* @brief Fill the pool with bursts across the screen, lasting far longer than a run.
+*/
+static void fillPool(void){
+	uint32_t i;
+	initParticles(&pool, 12345);
+	for(i = 0; pool.count < PARTICLE_CAPACITY; i++){
+		emitBurst(&pool, (float)(20 + (i * 53) % 232), (float)(40 + (i * 97) % 400), 256, 60, 60000,
+			(i & 1) ? GLCD_COLOR_CYAN : GLCD_COLOR_RED, (uint8_t)(i & 1));
+	}
+}
+
+/**
+	* @brief Best time over BENCH_RUNS of BENCH_FRAMES frames, each an update and a draw of the full pool.
+*/
+static double timeFrames(uint32_t size){
+	uint32_t run, frame;
+	double begin, seconds, best = 1e9;
+	for(run = 0; run < BENCH_RUNS; run++){
+		fillPool();
+		begin = nowSeconds();
+		for(frame = 0; frame < BENCH_FRAMES; frame++){
+			updateParticles(&pool, FRAME_MS);
+			drawSplats(pool.x, pool.y, pool.color, pool.alpha, pool.count, size);
+		}
+		seconds = (nowSeconds() - begin) / BENCH_FRAMES;
+		best = (seconds < best) ? seconds : best;
+	}
+	return best;
+}
+
+int main(void){
+	uint32_t i, ok, count;
+	double seconds;
+
+	GLCD_Initialize_Doublebuffer();
+
+	/* Capacity */
+	initParticles(&pool, 1);
+	for(i = 0; i < 5; i++){
+		emitBurst(&pool, 136, 240, 1000, 100, 500, GLCD_COLOR_WHITE, 0);
+	}
+	check((pool.count == PARTICLE_CAPACITY) && (pool.peak == PARTICLE_CAPACITY) && (pool.dropped == 5000 - PARTICLE_CAPACITY),
+		"bursts fill the pool to capacity and count the rest as dropped");
+	check(particleOccupancy(&pool) == 100, "a full pool reports 100% occupancy");
+
+	/* Lifetime: a quarter is randomly taken off, so all gone by the lifetime and most still there at half */
+	initParticles(&pool, 2);
+	emitBurst(&pool, 136, 240, 1000, 100, 500, GLCD_COLOR_WHITE, 0);
+	for(i = 0; i < 8; i++){
+		updateParticles(&pool, 30);
+	}
+	count = pool.count;
+	for(i = 0; i < 10; i++){
+		updateParticles(&pool, 30);
+	}
+	check((count > 900) && (pool.count == 0), "particles last up to their lifetime, then are removed");
+	ok = 1;
+	for(i = 0; i < pool.count; i++){
+		ok = ok && (pool.alpha[i] != 0);
+	}
+	check(ok && (pool.peak == 1000), "only live particles are kept, and the peak is remembered");
+
+	/* Splats land where they are and stay on screen */
+	initParticles(&pool, 3);
+	emitBurst(&pool, 100.5f, 200.5f, 1, 0, 1000, GLCD_COLOR_WHITE, 0);
+	clearDrawn();
+	drawSplats(pool.x, pool.y, pool.color, pool.alpha, pool.count, 1);
+	check(litPixels() == 1, "a point lights one pixel");
+	clearDrawn();
+	drawSplats(pool.x, pool.y, pool.color, pool.alpha, pool.count, 2);
+	check(litPixels() == 4, "a quad lights four");
+	initParticles(&pool, 4);
+	for(i = 0; i < 64; i++){
+		emitBurst(&pool, (float)((int32_t)(i % 8) * 50 - 60), (float)((int32_t)(i / 8) * 80 - 60), 64, 2000, 1000, GLCD_COLOR_WHITE, 0);
+	}
+	for(i = 0; i < 4; i++){
+		updateParticles(&pool, 40);
+		drawSplats(pool.x, pool.y, pool.color, pool.alpha, pool.count, 1);
+		drawSplats(pool.x, pool.y, pool.color, pool.alpha, pool.count, 3);
+	}
+	check(guardsIntact(), "splats off the edges stay inside the frame buffer");
+
+	/* Timing with the pool full */
+	seconds = timeFrames(1);
+	printf("%u particles as points: %7.1f us a frame, %.1f%% of the 33 ms frame\n", (unsigned)PARTICLE_CAPACITY, seconds * 1e6, seconds * 100000.0 / FRAME_MS);
+	seconds = timeFrames(2);
+	printf("%u particles as quads:  %7.1f us a frame, %.1f%% of the 33 ms frame\n", (unsigned)PARTICLE_CAPACITY, seconds * 1e6, seconds * 100000.0 / FRAME_MS);
+	printf("occupancy %u%%, %u live, %u peak, %u dropped\n", (unsigned)particleOccupancy(&pool), (unsigned)pool.count,
+		(unsigned)pool.peak, (unsigned)pool.dropped);
+	check(pool.count == PARTICLE_CAPACITY, "a full pool of long-lived particles stays full");
+
+	return failures ? 1 : 0;
+}
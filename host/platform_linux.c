@@ -0,0 +1,491 @@
+/**
+  ******************************************************************************
+  * @file    platform_linux.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only implementation of platform.h, so the whole game runs on Linux against simulated hardware.
+	*Build from the repository root with:
+	*  gcc -O2 -I. Mainloop.c poll.c Render.c Fonts.c game.c list.c math_functions.c trig.c tables.c replay.c simulation.c eventqueue.c
+	*    debounce.c latency.c encoder.c sevenseg.c prng.c particles.c starfield.c capture.c host/platform_linux.c -lm -o asteroids
+	*Time is virtual. It only moves on when the main loop goes idle, one millisecond at a time, so a run is
+	*deterministic and as fast as the host can draw. Pin edges and timers call the game's handlers from there,
+	*in place of the interrupts. The pins are wired as on the board: touch sensor A8, button I11, encoder I2/A15
+	*(or the hardware counter when ENCODER_HARDWARE is set).
+	*Environment:
+	*  ASTEROID_SECONDS  virtual seconds to run for, default 60. Prints a report and exits at the end.
+	*  ASTEROID_INPUT    input script; lines of "ms name value", name one of touch, button, screen or turn.
+	*                    turn moves the encoder value quadrature counts, one per millisecond. Lines starting # are skipped.
+	*                    Without a script a built-in player sweeps the aim, touches the screen and fires on a rhythm.
+	*  ASTEROID_SNAPSHOT write the last presented frame to this file as a PPM at the end.
+	*  ASTEROID_REPLAY   recording for platformLoadRecording(), for builds with -DREPLAY_MODE=2.
+	*  ASTEROID_CAPTURE  file for the frame capture, for builds with -DCAPTURE_MODE=1 or 2; the ring is written out
+	*                    at the end, as the debugger would dump it, or a stream as it goes. See capture_decode.c.
+	*  ASTEROID_THREADS  threads to draw each frame with, in bands, for builds with -pthread -DRENDER_THREADS=n; 
+	*                    see setRenderThreads(). At most one per core. Frames are the same as without.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "GLCD_Config.h"
+#include "platform.h"
+#include "Render.h"
+
+#define DEFAULT_SECONDS 60
+/* Frame capture ring, as on the board */
+#define CAPTURE_BUFFER_SIZE (4 * 1024 * 1024)
+#define MAX_SCRIPT_LINES 65536
+
+/**
+	*@brief Simulated GPIO port
+*/
+typedef struct{
+	volatile uint32_t bsrr; /** Bit set/reset register; applied to output after every handler returns */
+	uint16_t input; /** Levels driven onto input pins */
+	uint16_t output; /** Levels of output pins */
+	uint16_t outputs; /** Mask of pins configured as outputs */
+	uint16_t interrupts; /** Mask of pins configured to interrupt */
+}simPort;
+
+/**
+	*@brief Simulated periodic timer
+*/
+typedef struct{
+	void (*handler)(void); /** Called every period */
+	uint32_t period; /** Microseconds between calls */
+	uint32_t next; /** Time of the next call */
+}simTimer;
+
+/**
+	*@brief Scripted input change
+*/
+typedef struct{
+	uint32_t time; /** Millisecond to apply it at */
+	char name[8]; /** touch, button, screen or turn */
+	int32_t value; /** Level, or quadrature counts for turn */
+}scriptLine;
+
+enum inputName{
+	inputTouch, inputButton, inputScreen, inputTurn, inputUnknown
+};
+
+static const pin touchPin = {portA, PIN_MASK(8)};
+static const pin buttonPin = {portI, PIN_MASK(11)};
+static pin encoderClk = {portI, PIN_MASK(2)};
+static pin encoderDt = {portA, PIN_MASK(15)};
+
+static simPort ports[PLATFORM_PORTS];
+static simTimer timers[PLATFORM_TIMERS];
+static void (*pinHandler)(uint16_t pinMask);
+
+static uint32_t micros; /** Virtual microsecond clock */
+static uint32_t endTime; /** Virtual millisecond to stop at */
+static double realStart; /** Host clock at platformInit() */
+
+static pixel frameBuffers[2][GLCD_SIZE_X * GLCD_SIZE_Y];
+static pixel background[GLCD_SIZE_X * GLCD_SIZE_Y]; /** Static layer, under the frame buffers once layered */
+static pixel panel[GLCD_SIZE_X * GLCD_SIZE_Y]; /** What the panel shows: the layers composited as the LTDC would */
+static uint8_t layered; /** Set by platformEnableLayers() */
+static uint16_t layerKey; /** Frame buffer colour that shows the background */
+static uint32_t shown; /** Frame buffer being shown */
+static uint32_t frames; /** Frames presented */
+static uint8_t captureBuffer[CAPTURE_BUFFER_SIZE];
+static uint8_t captureUsed; /** Set once platformCaptureBuffer() has handed the ring out */
+static FILE* captureFile; /** ASTEROID_CAPTURE, once a stream has been saved to it */
+
+static uint8_t touchscreen; /** Touchscreen pressed */
+static uint8_t encoderCounterRunning; /** Set once platformStartEncoderCounter() is called */
+static uint16_t encoderCounter; /** Hardware encoder counter */
+static uint8_t quadrature = 2; /** Encoder position in the 11, 01, 00, 10 quadrature cycle; the pins start low */
+static int32_t pendingTurn; /** Quadrature counts still to be made */
+
+static scriptLine* script;
+static uint32_t scriptLength, scriptPos;
+
+static double realSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+	* @brief Apply whatever the handlers wrote to the set/reset registers.
+*/
+static void applySetReset(void){
+	int i;
+	for(i = 0; i < PLATFORM_PORTS; i++){
+		ports[i].output = (uint16_t)((ports[i].output | (ports[i].bsrr & 0xFFFF)) & ~(ports[i].bsrr >> 16));
+		ports[i].bsrr = 0;
+	}
+}
+
+/**
+	* @brief Drive an input pin, calling the pin handler if it changed and interrupts.
+*/
+static void driveInput(pin p, uint8_t level){
+	simPort* port = &ports[p.port];
+	uint16_t previous = port->input;
+	port->input = level ? (port->input | p.pin) : (port->input & ~p.pin);
+	if((port->input != previous) && (port->interrupts & p.pin) && pinHandler){
+		pinHandler(p.pin);
+		applySetReset();
+	}
+}
+
+/**
+	* @brief Move the encoder one quadrature count, on the pins or the hardware counter.
+	* Clockwise goes 11, 01, 00, 10, as readEncoder() decodes it.
+*/
+static void turnEncoder(int32_t direction){
+	static const uint8_t cycle[4] = {3, 1, 0, 2};
+	quadrature = (uint8_t)((quadrature + direction) & 3);
+	if(encoderCounterRunning){
+		encoderCounter = (uint16_t)(encoderCounter + direction);
+		return;
+	}
+	//Only one channel changes per count, so only one edge is raised
+	driveInput(encoderClk, (cycle[quadrature] >> 1) & 1);
+	driveInput(encoderDt, cycle[quadrature] & 1);
+}
+
+static enum inputName parseName(const char* name){
+	if(strcmp(name, "touch") == 0){return inputTouch;}
+	if(strcmp(name, "button") == 0){return inputButton;}
+	if(strcmp(name, "screen") == 0){return inputScreen;}
+	if(strcmp(name, "turn") == 0){return inputTurn;}
+	return inputUnknown;
+}
+
+/**
+	* @brief Load the ASTEROID_INPUT script, if there is one.
+*/
+static void loadScript(void){
+	const char* path = getenv("ASTEROID_INPUT");
+	char line[128];
+	FILE* f;
+	scriptLine entry;
+	if(path == NULL){return;}
+	if((f = fopen(path, "r")) == NULL){
+		fprintf(stderr, "platform: cannot open input script %s\n", path);
+		exit(1);
+	}
+	script = (scriptLine*)malloc(sizeof(scriptLine) * MAX_SCRIPT_LINES);
+	while(fgets(line, sizeof(line), f) && (scriptLength < MAX_SCRIPT_LINES)){
+		if((line[0] == '#') || (sscanf(line, "%u %7s %d", &entry.time, entry.name, &entry.value) != 3)){continue;}
+		if(parseName(entry.name) == inputUnknown){
+			fprintf(stderr, "platform: unknown input %s\n", entry.name);
+			continue;
+		}
+		script[scriptLength++] = entry;
+	}
+	fclose(f);
+}
+
+static void applyInput(enum inputName name, int32_t value){
+	switch(name){
+		case inputTouch:
+			driveInput(touchPin, value != 0);
+			break;
+		case inputButton:
+			driveInput(buttonPin, value != 0);
+			break;
+		case inputScreen:
+			touchscreen = value != 0;
+			break;
+		case inputTurn:
+			pendingTurn += value;
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+	* @brief Built-in player for millisecond ms. Touches the screen every 4 s to start a game,
+	* sweeps the aim back and forth, and holds the touch sensor for 0.6 s out of every 1.5 s, with a little bounce.
+*/
+static void scriptedPlayer(uint32_t ms){
+	uint32_t phase = ms % 1500;
+	applyInput(inputScreen, (ms % 4000) < 100);
+	if((ms % 2000) == 0){
+		applyInput(inputTurn, ((ms / 2000) & 1) ? -40 : 40);
+	}
+	if((phase == 0) || (phase == 2)){applyInput(inputTouch, 1);}
+	if(phase == 1){applyInput(inputTouch, 0);}
+	if(phase == 600){applyInput(inputTouch, 0);}
+}
+
+/**
+	* @brief Write what the panel shows to path as a binary PPM, in the panel's own orientation.
+*/
+static void writeSnapshot(const char* path){
+	FILE* f = fopen(path, "wb");
+	uint32_t i;
+	pixel c;
+	uint8_t rgb[3];
+	if(f == NULL){
+		fprintf(stderr, "platform: cannot write snapshot %s\n", path);
+		return;
+	}
+	fprintf(f, "P6\n%d %d\n255\n", GLCD_SIZE_X, GLCD_SIZE_Y);
+	for(i = 0; i < GLCD_SIZE_X * GLCD_SIZE_Y; i++){
+		c = layered ? panel[i] : frameBuffers[shown][i];
+		#if(PIXEL_FORMAT == PIXEL_ARGB8888)
+		rgb[0] = (uint8_t)(c >> 16);
+		rgb[1] = (uint8_t)(c >> 8);
+		rgb[2] = (uint8_t)c;
+		#else
+		rgb[0] = (uint8_t)(((c >> 11) & 0x1F) * 255 / 31);
+		rgb[1] = (uint8_t)(((c >> 5) & 0x3F) * 255 / 63);
+		rgb[2] = (uint8_t)((c & 0x1F) * 255 / 31);
+		#endif
+		fwrite(rgb, 1, 3, f);
+	}
+	fclose(f);
+}
+
+/**
+	* @brief Write the whole capture buffer to ASTEROID_CAPTURE, as the debugger would dump it from the board.
+*/
+static void writeCapture(void){
+	const char* path = getenv("ASTEROID_CAPTURE");
+	FILE* f;
+	if(path == NULL){return;}
+	if((f = fopen(path, "wb")) == NULL){
+		fprintf(stderr, "platform: cannot write capture %s\n", path);
+		return;
+	}
+	fwrite(captureBuffer, 1, sizeof(captureBuffer), f);
+	fclose(f);
+}
+
+/**
+	* @brief Report the run and exit.
+*/
+static void finish(void){
+	double real = realSeconds() - realStart;
+	double virtualSeconds = micros / 1e6;
+	const char* snapshot = getenv("ASTEROID_SNAPSHOT");
+	printf("frames: %u in %.1f s virtual, %.3f s real (%.0fx real time, %.0f FPS)\n", (unsigned)frames,
+		virtualSeconds, real, real > 0 ? virtualSeconds / real : 0.0, real > 0 ? frames / real : 0.0);
+	//In order, a b c d e f g as wired in poll.c
+	printf("7-segment: %d%d%d%d%d%d%d\n",
+		(ports[portH].output >> 6) & 1, ports[portI].output & 1, (ports[portG].output >> 7) & 1,
+		(ports[portB].output >> 4) & 1, (ports[portG].output >> 6) & 1,
+		encoderCounterRunning ? (ports[portI].output >> 3) & 1 : (ports[portC].output >> 6) & 1,
+		encoderCounterRunning ? (ports[portI].output >> 1) & 1 : (ports[portC].output >> 7) & 1);
+	if(snapshot){
+		writeSnapshot(snapshot);
+	}
+	if(captureFile != NULL){
+		fclose(captureFile);
+	}
+	else if(captureUsed){
+		writeCapture();
+	}
+	exit(0);
+}
+
+void platformInit(void){
+	const char* seconds = getenv("ASTEROID_SECONDS");
+	#if(RENDER_THREADS != 0)
+	const char* threads = getenv("ASTEROID_THREADS");
+	uint32_t count, cores;
+	#endif
+	endTime = (seconds ? (uint32_t)atoi(seconds) : DEFAULT_SECONDS) * 1000;
+	loadScript();
+	#if(RENDER_THREADS != 0)
+	if(threads){
+		//More threads than cores only take turns, paying for the recording with nothing drawn alongside
+		count = (uint32_t)atoi(threads);
+		cores = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+		setRenderThreads((count > cores) ? cores : count);
+	}
+	#endif
+	realStart = realSeconds();
+}
+
+/**
+	* @brief Advance virtual time by a millisecond. Applies the input due, then runs the timers due, in time order.
+*/
+void platformIdle(void){
+	uint32_t ms, next = 0;
+	int i, due;
+	micros += 1000;
+	ms = micros / 1000;
+
+	while((scriptPos < scriptLength) && (script[scriptPos].time <= ms)){
+		applyInput(parseName(script[scriptPos].name), script[scriptPos].value);
+		scriptPos++;
+	}
+	if(script == NULL){
+		scriptedPlayer(ms);
+	}
+	if(pendingTurn != 0){
+		turnEncoder((pendingTurn > 0) ? 1 : -1);
+		pendingTurn += (pendingTurn > 0) ? -1 : 1;
+	}
+
+	do{
+		due = -1;
+		for(i = 0; i < PLATFORM_TIMERS; i++){
+			if(timers[i].handler && ((int32_t)(micros - timers[i].next) >= 0) &&
+				((due < 0) || ((int32_t)(timers[i].next - next) < 0))){
+				due = i;
+				next = timers[i].next;
+			}
+		}
+		if(due >= 0){
+			timers[due].next += timers[due].period;
+			timers[due].handler();
+			applySetReset();
+		}
+	}while(due >= 0);
+
+	if(ms >= endTime){
+		finish();
+	}
+}
+
+uint32_t platformTick(void){
+	return micros / 1000;
+}
+
+uint32_t platformMicros(void){
+	return micros;
+}
+
+void platformDelay(uint32_t milliseconds){
+	uint32_t end = platformTick() + milliseconds;
+	while((int32_t)(platformTick() - end) < 0){
+		platformIdle();
+	}
+}
+
+/**
+	* @brief Configure a pin. Pull-ups drive the input high until the script says otherwise.
+*/
+void platformConfigurePin(pin p, enum pinMode mode){
+	simPort* port = &ports[p.port];
+	port->outputs = (mode == pinOutput) ? (port->outputs | p.pin) : (port->outputs & ~p.pin);
+	port->interrupts = ((mode == pinInterrupt) || (mode == pinInterruptPullUp)) ? (port->interrupts | p.pin) : (port->interrupts & ~p.pin);
+	if(mode == pinInterruptPullUp){
+		port->input |= p.pin;
+	}
+}
+
+uint8_t platformReadPin(pin p){
+	const simPort* port = &ports[p.port];
+	return (((port->outputs & p.pin) ? port->output : port->input) & p.pin) ? 1 : 0;
+}
+
+void platformWritePin(pin p, uint8_t level){
+	ports[p.port].output = level ? (ports[p.port].output | p.pin) : (ports[p.port].output & ~p.pin);
+}
+
+volatile uint32_t* platformPortSetReset(uint8_t port){
+	return &ports[port].bsrr;
+}
+
+void platformSetPinHandler(void (*handler)(uint16_t pinMask)){
+	pinHandler = handler;
+}
+
+void platformStartTimer(enum platformTimer timer, uint32_t rate, void (*handler)(void)){
+	timers[timer].handler = handler;
+	timers[timer].period = 1000000 / rate;
+	timers[timer].next = micros + timers[timer].period;
+}
+
+/**
+	* @brief Route the encoder to the counter instead of the pins.
+*/
+void platformStartEncoderCounter(pin clk, pin dt){
+	encoderClk = clk;
+	encoderDt = dt;
+	encoderCounterRunning = 1;
+	encoderCounter = 0;
+}
+
+uint16_t platformReadEncoderCounter(void){
+	return encoderCounter;
+}
+
+void platformTouchInit(void){
+}
+
+uint8_t platformTouchscreenPressed(void){
+	return touchscreen;
+}
+
+void platformDisplayInit(void){
+	memset(frameBuffers, 0, sizeof(frameBuffers));
+	memset(background, 0, sizeof(background));
+	layered = 0;
+	shown = 0;
+}
+
+pixel* platformFrameBuffer(uint32_t index){
+	return frameBuffers[index ? 1 : 0];
+}
+
+/**
+	* @brief Show frame buffer index. There is no panel to wait for; the frame just counts.
+	* With layers, it is composited over the background here, where the LTDC would as it scans out.
+*/
+void platformPresent(uint32_t index){
+	shown = index ? 1 : 0;
+	frames++;
+	if(layered){
+		compositeLayers(panel, frameBuffers[shown], background, layerKey);
+	}
+}
+
+pixel* platformBackgroundBuffer(void){
+	return background;
+}
+
+/**
+	* @brief Show the frame buffers over the background from the next present, with keyColor see-through.
+*/
+void platformEnableLayers(uint16_t keyColor){
+	layerKey = keyColor;
+	layered = 1;
+}
+
+/**
+	* @brief Fill buffer from the ASTEROID_REPLAY file. Returns the bytes read, 0 if there is none.
+*/
+/**
+	* @brief Frame capture ring, written to ASTEROID_CAPTURE at the end unless a stream was saved there instead.
+*/
+uint8_t* platformCaptureBuffer(uint32_t* size){
+	captureUsed = 1;
+	*size = sizeof(captureBuffer);
+	return captureBuffer;
+}
+
+/**
+	* @brief Append data to the ASTEROID_CAPTURE file, opening it the first time.
+*/
+void platformSaveCapture(const uint8_t* data, uint32_t length){
+	const char* path = getenv("ASTEROID_CAPTURE");
+	if((captureFile == NULL) && ((path == NULL) || ((captureFile = fopen(path, "wb")) == NULL))){
+		return;
+	}
+	fwrite(data, 1, length, captureFile);
+}
+
+uint32_t platformLoadRecording(uint8_t* buffer, uint32_t size){
+	const char* path = getenv("ASTEROID_REPLAY");
+	FILE* f;
+	uint32_t length;
+	if((path == NULL) || ((f = fopen(path, "rb")) == NULL)){
+		return 0;
+	}
+	length = (uint32_t)fread(buffer, 1, size, f);
+	fclose(f);
+	return length;
+}
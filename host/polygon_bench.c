@@ -0,0 +1,248 @@
+/**
+  ******************************************************************************
+  * @file    polygon_bench.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only accuracy and speed benchmark for fillPolygons() in Render.c.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/polygon_bench.c Render.c Fonts.c math_functions.c tables.c -lm -o polygon_bench
+	*Stands in for the platform's frame buffers, as host/circle_bench.c does. Checks pixel-exact areas of
+	*squares, that polygons sharing an edge neither overlap nor leave a gap, concave fills, drawing order,
+	*big batches and batches of hundreds of empty polygons, and clipping, then times asteroid-sized polygons,
+	*batched and one a call, against the anti-aliased circles they replace, as polygons per 30 FPS frame.
+	*Exits non-zero if a check fails.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+/* Portrait, as Render.c draws */
+#define GLCD_LANDSCAPE 0
+#include "GLCD_Config.h"
+#include "platform.h"
+#include "Render.h"
+
+#define PI 3.14159265358979323846
+#define ASTEROIDS 4096
+#define ASTEROID_VERTICES 9
+/* Empty polygons ahead of one that draws, more than fit the polygon bits of an edge key */
+#define EMPTY_POLYGONS 300
+#define BENCH_RUNS 5
+#define GUARD 4096
+#define GUARD_VALUE 0xA5A5
+#define FRAME_SECONDS (1.0 / 30)
+
+static uint16_t memory[2][GUARD + (GLCD_WIDTH * GLCD_HEIGHT) + GUARD];
+static int failures;
+
+void platformDisplayInit(void){
+	uint32_t i, j;
+	for(i = 0; i < 2; i++){
+		for(j = 0; j < sizeof(memory[0]) / sizeof(memory[0][0]); j++){
+			memory[i][j] = GUARD_VALUE;
+		}
+	}
+}
+
+uint16_t* platformFrameBuffer(uint32_t index){
+	return &memory[index ? 1 : 0][GUARD];
+}
+
+void platformPresent(uint32_t index){
+	(void)index;
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void clearDrawn(void){
+	memset(&memory[1][GUARD], 0, GLCD_WIDTH * GLCD_HEIGHT * sizeof(uint16_t));
+}
+
+/**
+	* @brief Pixels of the drawn buffer that are exactly color.
+*/
+static uint32_t countColor(uint16_t color){
+	uint32_t i, n = 0;
+	for(i = 0; i < GLCD_WIDTH * GLCD_HEIGHT; i++){
+		n += (memory[1][GUARD + i] == color);
+	}
+	return n;
+}
+
+/**
+	* @brief The drawn buffer pixel at game position (x, y).
+*/
+static uint16_t pixelAt(int32_t x, int32_t y){
+	return memory[1][GUARD + ((GLCD_WIDTH - 1 - x) * GLCD_HEIGHT) + (GLCD_HEIGHT - 1 - y)];
+}
+
+static int guardsIntact(void){
+	uint32_t i;
+	for(i = 0; i < GUARD; i++){
+		if((memory[1][i] != GUARD_VALUE) || (memory[1][GUARD + (GLCD_WIDTH * GLCD_HEIGHT) + i] != GUARD_VALUE)){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+	* @brief Fill in a polygon from whole-pixel vertices, scaled to subpixels into x and y.
+*/
+static polygon makePolygon(const int32_t* points, uint16_t count, int16_t* x, int16_t* y, uint16_t fill){
+	polygon p;
+	uint16_t i;
+	for(i = 0; i < count; i++){
+		x[i] = (int16_t)TO_SUBPIXEL(points[2 * i]);
+		y[i] = (int16_t)TO_SUBPIXEL(points[(2 * i) + 1]);
+	}
+	p.x = x;
+	p.y = y;
+	p.count = count;
+	p.fill = fill;
+	p.outline = GLCD_COLOR_WHITE;
+	p.outlined = 0;
+	return p;
+}
+
+int main(void){
+	static const int32_t square[] = {100, 200, 140, 200, 140, 240, 100, 240};
+	static const int32_t neighbour[] = {140, 200, 180, 230, 140, 240};
+	/* A U, open towards +y, 60 wide and 60 tall with a 20 by 40 notch */
+	static const int32_t cup[] = {100, 200, 160, 200, 160, 260, 140, 260, 140, 220, 120, 220, 120, 260, 100, 260};
+	static int16_t xs[ASTEROIDS][ASTEROID_VERTICES], ys[ASTEROIDS][ASTEROID_VERTICES];
+	static polygon asteroids[ASTEROIDS];
+	static polygon empties[EMPTY_POLYGONS + 1];
+	static uint16_t batched[GLCD_WIDTH * GLCD_HEIGHT];
+	int16_t ax[8], ay[8], bx[8], by[8];
+	polygon pair[2];
+	uint32_t i, j, n, run;
+	double angle, radius, begin, seconds, fillTime = 1e9, singleTime = 1e9, outlineTime = 1e9, circleTime = 1e9;
+
+	GLCD_Initialize_Doublebuffer();
+
+	/* Pixel-exact fills */
+	clearDrawn();
+	pair[0] = makePolygon(square, 4, ax, ay, GLCD_COLOR_RED);
+	fillPolygons(pair, 1);
+	check((countColor(GLCD_COLOR_RED) == 40 * 40) && (pixelAt(100, 200) == GLCD_COLOR_RED) && (pixelAt(139, 239) == GLCD_COLOR_RED) && 
+		(pixelAt(140, 220) == 0) && (pixelAt(120, 240) == 0), "a 40 pixel square fills exactly 1600 pixels");
+
+	clearDrawn();
+	pair[1] = makePolygon(neighbour, 3, bx, by, GLCD_COLOR_RED);
+	fillPolygons(pair, 2);
+	n = countColor(GLCD_COLOR_RED);
+	clearDrawn();
+	fillPolygons(&pair[1], 1);
+	check(n == 1600 + countColor(GLCD_COLOR_RED), "polygons sharing an edge neither overlap nor leave a gap");
+
+	clearDrawn();
+	pair[0] = makePolygon(cup, 8, ax, ay, GLCD_COLOR_GREEN);
+	fillPolygons(pair, 1);
+	check((countColor(GLCD_COLOR_GREEN) == (60 * 60) - (20 * 40)) && (pixelAt(130, 240) == 0) && (pixelAt(110, 240) == GLCD_COLOR_GREEN), 
+		"a concave polygon leaves its notch empty");
+
+	clearDrawn();
+	pair[0] = makePolygon(square, 4, ax, ay, GLCD_COLOR_RED);
+	pair[1] = makePolygon(neighbour, 3, bx, by, GLCD_COLOR_BLUE);
+	for(i = 0; i < 3; i++){by[i] = (int16_t)(by[i] - TO_SUBPIXEL(10));}
+	bx[0] = (int16_t)TO_SUBPIXEL(120);
+	fillPolygons(pair, 2);
+	check((pixelAt(130, 205) == GLCD_COLOR_BLUE) && (pixelAt(110, 235) == GLCD_COLOR_RED), "later polygons in a batch draw over earlier ones");
+
+	/* More polygons than a pass can tell apart, most with nothing to draw */
+	clearDrawn();
+	for(i = 0; i < EMPTY_POLYGONS; i++){
+		empties[i] = makePolygon(square, 0, ax, ay, GLCD_COLOR_BLUE);
+	}
+	empties[EMPTY_POLYGONS] = makePolygon(square, 4, bx, by, GLCD_COLOR_RED);
+	fillPolygons(empties, EMPTY_POLYGONS + 1);
+	check((countColor(GLCD_COLOR_RED) == 40 * 40) && (countColor(GLCD_COLOR_BLUE) == 0), 
+		"a polygon after hundreds of empty ones in a batch keeps its own fill");
+
+	/* Asteroid-sized polygons, jagged, at sub-pixel positions all over the screen and past its edges */
+	n = 12345;
+	for(i = 0; i < ASTEROIDS; i++){
+		n = n * 1103515245 + 12345;
+		for(j = 0; j < ASTEROID_VERTICES; j++){
+			n = n * 1103515245 + 12345;
+			angle = (j + ((n >> 16) % 100) / 200.0) * 2 * PI / ASTEROID_VERTICES;
+			radius = TO_SUBPIXEL(7 + (int32_t)((n >> 8) % 6));
+			xs[i][j] = (int16_t)(radius * cos(angle));
+			ys[i][j] = (int16_t)(radius * sin(angle));
+		}
+		n = n * 1103515245 + 12345;
+		radius = (n >> 8) % ((GLCD_WIDTH + 40) << CIRCLE_SUBPIXEL_BITS);
+		angle = (n * 1103515245 + 12345) >> 8;
+		for(j = 0; j < ASTEROID_VERTICES; j++){
+			xs[i][j] = (int16_t)(xs[i][j] + (int32_t)radius - TO_SUBPIXEL(20));
+			ys[i][j] = (int16_t)(ys[i][j] + ((uint32_t)angle % ((GLCD_HEIGHT + 40) << CIRCLE_SUBPIXEL_BITS)) - TO_SUBPIXEL(20));
+		}
+		asteroids[i].x = xs[i];
+		asteroids[i].y = ys[i];
+		asteroids[i].count = ASTEROID_VERTICES;
+		asteroids[i].fill = (uint16_t)(i * 2654435761u >> 16);
+		asteroids[i].outline = GLCD_COLOR_WHITE;
+		asteroids[i].outlined = 0;
+	}
+	clearDrawn();
+	fillPolygons(asteroids, ASTEROIDS);
+	memcpy(batched, &memory[1][GUARD], sizeof(batched));
+	clearDrawn();
+	for(i = 0; i < ASTEROIDS; i++){
+		fillPolygons(&asteroids[i], 1);
+	}
+	check(memcmp(batched, &memory[1][GUARD], sizeof(batched)) == 0, "a batch bigger than the edge table draws as one polygon at a time does");
+	for(i = 0; i < ASTEROIDS; i++){
+		asteroids[i].outlined = 1;
+	}
+	fillPolygons(asteroids, ASTEROIDS);
+	check(guardsIntact(), "filled and outlined polygons past the edges stay inside the frame buffer");
+
+	/* Timing */
+	for(run = 0; run < BENCH_RUNS; run++){
+		for(i = 0; i < ASTEROIDS; i++){
+			asteroids[i].outlined = 0;
+		}
+		begin = nowSeconds();
+		fillPolygons(asteroids, ASTEROIDS);
+		seconds = nowSeconds() - begin;
+		fillTime = (seconds < fillTime) ? seconds : fillTime;
+		begin = nowSeconds();
+		for(i = 0; i < ASTEROIDS; i++){
+			fillPolygons(&asteroids[i], 1);
+		}
+		seconds = nowSeconds() - begin;
+		singleTime = (seconds < singleTime) ? seconds : singleTime;
+		for(i = 0; i < ASTEROIDS; i++){
+			asteroids[i].outlined = 1;
+		}
+		begin = nowSeconds();
+		fillPolygons(asteroids, ASTEROIDS);
+		seconds = nowSeconds() - begin;
+		outlineTime = (seconds < outlineTime) ? seconds : outlineTime;
+		begin = nowSeconds();
+		for(i = 0; i < ASTEROIDS; i++){
+			drawFilledCircleAA(xs[i][0] - TO_SUBPIXEL(10), ys[i][0], TO_SUBPIXEL(10));
+		}
+		seconds = nowSeconds() - begin;
+		circleTime = (seconds < circleTime) ? seconds : circleTime;
+	}
+	printf("filled:           %6.2f us/polygon, %8.0f per 30 FPS frame\n", fillTime * 1e6 / ASTEROIDS, FRAME_SECONDS * ASTEROIDS / fillTime);
+	printf("filled, one a call:%5.2f us/polygon, %8.0f per 30 FPS frame\n", singleTime * 1e6 / ASTEROIDS, FRAME_SECONDS * ASTEROIDS / singleTime);
+	printf("filled, outlined: %6.2f us/polygon, %8.0f per 30 FPS frame\n", outlineTime * 1e6 / ASTEROIDS, FRAME_SECONDS * ASTEROIDS / outlineTime);
+	printf("circle, radius 10:%6.2f us/circle,  %8.0f per 30 FPS frame\n", circleTime * 1e6 / ASTEROIDS, FRAME_SECONDS * ASTEROIDS / circleTime);
+
+	return failures ? 1 : 0;
+}
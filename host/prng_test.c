@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * @file    prng_test.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only test for prng.c.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/prng_test.c prng.c -o prng_test
+	*Checks prngFill() and prngFillRange() give the same numbers as repeated prngNext() and prngRange() calls
+	*from the same seed, and leave the generator in the same place, over several seeds, streams, lengths and
+	*bounds, including bounds where prngRange() has to redraw. Also checks prngRange() stays below its bound,
+	*and that streams of one seed differ. Exits non-zero if any check fails.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include "prng.h"
+
+#define TEST_COUNT 4096
+#define TEST_SEEDS 8
+
+static int failures;
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+int main(void){
+	/* 0 and 1 give only 0; the large bounds leave a big biased sliver, so many draws are redrawn */
+	static const uint32_t bounds[] = {0, 1, 2, 3, 7, 100, 272, 65537, 0x80000001u, 0xFFFFFFFFu};
+	static const uint32_t lengths[] = {0, 1, 5, 64, TEST_COUNT};
+	static uint32_t batch[TEST_COUNT];
+	prngState a, b;
+	uint32_t seed, l, k, i, n, same = 1, sameRange = 1, inRange = 1, streamsDiffer = 1, matches;
+
+	for(seed = 0; seed < TEST_SEEDS; seed++){
+		for(l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++){
+			n = lengths[l];
+			/* prngFill() against prngNext() */
+			prngSeed(&a, seed * 2654435761u, seed);
+			prngSeed(&b, seed * 2654435761u, seed);
+			prngFill(&a, batch, n);
+			for(i = 0; i < n; i++){
+				same = same && (batch[i] == prngNext(&b));
+			}
+			same = same && (prngNext(&a) == prngNext(&b));
+			/* prngFillRange() against prngRange(), at every bound */
+			for(k = 0; k < sizeof(bounds) / sizeof(bounds[0]); k++){
+				prngSeed(&a, seed, seed + 100);
+				prngSeed(&b, seed, seed + 100);
+				prngFillRange(&a, batch, n, bounds[k]);
+				for(i = 0; i < n; i++){
+					sameRange = sameRange && (batch[i] == prngRange(&b, bounds[k]));
+					inRange = inRange && ((bounds[k] == 0) ? (batch[i] == 0) : (batch[i] < bounds[k]));
+				}
+				sameRange = sameRange && (prngNext(&a) == prngNext(&b));
+			}
+		}
+		/* Two streams of one seed should share next to nothing */
+		prngSeed(&a, seed, 0);
+		prngSeed(&b, seed, 1);
+		matches = 0;
+		for(i = 0; i < TEST_COUNT; i++){
+			matches += (prngNext(&a) == prngNext(&b)) ? 1 : 0;
+		}
+		streamsDiffer = streamsDiffer && (matches == 0);
+	}
+	check(same, "prngFill() matches repeated prngNext() and leaves the generator where they do");
+	check(sameRange, "prngFillRange() matches repeated prngRange() at every bound and leaves the generator where they do");
+	check(inRange, "every number from prngRange() is below its bound, and 0 for a bound of 0");
+	check(streamsDiffer, "two streams of the same seed give different sequences");
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+/**
+  ******************************************************************************
+  * @file    queue_stress.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only stress test for eventqueue.c; one producer thread hammers the queue while the main thread drains it.
+	*Build from the repository root with:
+	*  gcc -O2 -pthread -I. host/queue_stress.c eventqueue.c -o queue_stress
+	*Usage: queue_stress [events]
+	*The producer retries when the queue is full, backing off so single-core hosts still make progress, and stamps every event
+	*with a sequence number. The consumer checks that every number arrives exactly once and in order.
+	*Exits non-zero on any lost, repeated or reordered event.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "eventqueue.h"
+
+#define DEFAULT_EVENTS 10000000u
+#define DRAIN_BATCH 16
+
+static eventQueue queue;
+static uint32_t total;
+static uint32_t fullRetries;
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+	* @brief Spin briefly, then sleep, so the other side gets to run even on a single-core host. 
+*/
+static void backOff(uint32_t attempts){
+	struct timespec pause = {0, 1000};
+	if((attempts & 255) == 0){nanosleep(&pause, NULL);}
+}
+
+/**
+	* @brief Producer thread. The type and value are derived from the sequence number so they can be checked too.
+*/
+static void* producer(void* arg){
+	uint32_t i;
+	(void)arg;
+	for(i = 0; i < total; i++){
+		while(pushEvent(&queue, i, (uint8_t)(i % 3), (int8_t)((i & 1) ? 1 : -1)) != 0){
+			fullRetries++;
+			backOff(fullRetries);
+		}
+	}
+	return NULL;
+}
+
+int main(int argc, char** argv){
+	pthread_t thread;
+	inputEvent batch[DRAIN_BATCH];
+	uint32_t expected = 0, count, i, errors = 0, drains = 0, emptyPolls = 0;
+	double begin, seconds;
+
+	total = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_EVENTS;
+	initEventQueue(&queue);
+
+	begin = nowSeconds();
+	pthread_create(&thread, NULL, producer, NULL);
+	/* Alternate single pops and batch drains, as the game uses both */
+	while(expected < total){
+		if(drains & 1){
+			count = (popEvent(&queue, &batch[0]) == 0) ? 1 : 0;
+		}
+		else{
+			count = drainEvents(&queue, batch, DRAIN_BATCH);
+		}
+		drains++;
+		if(count == 0){backOff(++emptyPolls);}
+		for(i = 0; i < count; i++){
+			if((batch[i].timestamp != expected) || (batch[i].type != expected % 3) ||
+				(batch[i].value != ((expected & 1) ? 1 : -1))){
+				if(errors < 10){
+					fprintf(stderr, "expected event %u, got %u\n", expected, batch[i].timestamp);
+				}
+				errors++;
+				expected = batch[i].timestamp;
+			}
+			expected++;
+		}
+	}
+	pthread_join(thread, NULL);
+	seconds = nowSeconds() - begin;
+
+	printf("events %u\nseconds %.3f\nevents/s %.0f\n", total, seconds, total / seconds);
+	printf("producer full retries %u (queue counted %u refused pushes), errors %u\n", fullRetries, queue.dropped, errors);
+	if(popEvent(&queue, &batch[0]) == 0){
+		printf("queue not empty at end\n");
+		errors++;
+	}
+	return (errors == 0) ? 0 : 1;
+}
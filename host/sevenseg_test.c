@@ -0,0 +1,212 @@
+/**
+  ******************************************************************************
+  * @file    sevenseg_test.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only test for sevenseg.c, against mock GPIO registers and a mock refresh timer.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/sevenseg_test.c tables.c -o sevenseg_test
+	*sevenseg.c is included directly, with SEVEN_SEGMENT_WRITE pointed at the mock.
+	*Checks every digit lights the same segments as the original per-pin table, on the board's pin mapping, 
+	*and counts register writes over a game's worth of 120 Hz updates against the old seven writes per tick.
+	*Then multiplexes four digits from a timer model with late interrupts, checking each digit is refreshed 
+	*often enough not to flicker, gets its share of on time, and never shows another digit's segments.
+	*Exits non-zero if any check fails.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+	*@brief Mock GPIO bank. BSRR writes are applied to ODR, as the hardware does, and counted.
+*/
+typedef struct{
+	volatile uint32_t BSRR; /** Written by the driver */
+	uint32_t ODR; /** Output level of each pin */
+	uint32_t writes; /** BSRR writes to this bank */
+}mockBank;
+
+static void mockWrite(volatile uint32_t* reg, uint32_t value);
+#define SEVEN_SEGMENT_WRITE(reg, value) mockWrite((reg), (value))
+#include "sevenseg.c"
+
+/* Mock time, in microseconds */
+#define TEST_DIGITS 4
+#define REFRESH_PERIOD_US (1000000 / (SEVEN_SEGMENT_REFRESH_RATE * TEST_DIGITS))
+/* Longest a digit may go unlit; below this the multiplexing is not visible */
+#define MAX_DARK_US (1000000 / 60)
+
+/* Banks H, I, G, B, C, as on the board, then a bank for the digit selects */
+static mockBank banks[6];
+static uint32_t totalWrites;
+static int failures;
+/* Segment pins of the board, a b c d e f g = H6, I0, G7, B4, G6, C6, C7 */
+static mockBank* const segmentBank[7] = {&banks[0], &banks[1], &banks[2], &banks[3], &banks[2], &banks[4], &banks[4]};
+static const uint16_t segmentPin[7] = {1 << 6, 1 << 0, 1 << 7, 1 << 4, 1 << 6, 1 << 6, 1 << 7};
+//The original lookup table from poll.c, 1 for GPIO_PIN_SET, in segment order a to g
+static const int states[10][7] = 
+{{1,1,1,1,1,1,0},{0,1,1,0,0,0,0},{1,1,0,1,1,0,1},{1,1,1,1,0,0,1},{0,1,1,0,0,1,1},
+{1,0,1,1,0,1,1},{1,0,1,1,1,1,1},{1,1,1,0,0,0,0},{1,1,1,1,1,1,1},{1,1,1,0,0,1,1}};
+
+/* Multiplex timing checks, updated on every write */
+static uint32_t now;
+static uint32_t ghosting;
+static uint32_t lastLit[TEST_DIGITS], litSince[TEST_DIGITS], litTotal[TEST_DIGITS], darkest[TEST_DIGITS];
+
+/**
+	* @brief Digit currently selected on the mock, or -1 if none. Selects are active low on pins 0-3 of the last bank.
+*/
+static int32_t selectedDigit(void){
+	int32_t digit, selected = -1;
+	for(digit = 0; digit < TEST_DIGITS; digit++){
+		if(!(banks[5].ODR & (1 << digit))){
+			selected = (selected == -1) ? digit : -2;
+		}
+	}
+	return selected;
+}
+
+static void mockWrite(volatile uint32_t* reg, uint32_t value){
+	mockBank* bank = (mockBank*)((char*)reg - offsetof(mockBank, BSRR));
+	int32_t before = selectedDigit(), after;
+	*reg = value;
+	//Reset is applied first, then set, so set wins if both bits are written
+	bank->ODR &= ~(value >> 16);
+	bank->ODR |= value & 0xFFFF;
+	bank->writes++;
+	totalWrites++;
+	//Segments changing under a lit digit, or two digits lit at once, would show as ghosting
+	if(((bank != &banks[5]) && (before >= 0)) || (selectedDigit() == -2)){ghosting++;}
+	after = selectedDigit();
+	if(before != after){
+		if(before >= 0){litTotal[before] += now - litSince[before]; lastLit[before] = now;}
+		if(after >= 0){
+			if(now - lastLit[after] > darkest[after]){darkest[after] = now - lastLit[after];}
+			litSince[after] = now;
+		}
+	}
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+/**
+	* @brief Pattern on the mock segment pins, as a digit, or -1 if it matches none.
+*/
+static int32_t segmentsShowing(void){
+	int32_t digit, segment, match;
+	for(digit = 0; digit < 10; digit++){
+		match = 1;
+		for(segment = 0; segment < 7; segment++){
+			match &= (((segmentBank[segment]->ODR & segmentPin[segment]) != 0) == states[digit][segment]);
+		}
+		if(match){return digit;}
+	}
+	return -1;
+}
+
+int main(void){
+	volatile uint32_t* bsrr[7];
+	sevenSegmentStruct display;
+	uint32_t i, digit, tick, game, ok, quiet, maxPerChange = 0, before, oldWrites = 0, lateCount = 0;
+	int32_t enemies, shown[TEST_DIGITS];
+
+	for(i = 0; i < 7; i++){
+		bsrr[i] = &segmentBank[i]->BSRR;
+	}
+
+	/* The board: one digit, always selected */
+	initSevenSegment(&display, bsrr, segmentPin);
+	sevenSegmentAddDigit(&display, NULL, 0, 1);
+	check(display.banks == 5, "segments grouped into 5 banks");
+
+	//Every digit, from every other digit, must light exactly the original segments
+	ok = 1;
+	quiet = 1;
+	for(i = 0; i < 10; i++){
+		for(digit = 0; digit < 10; digit++){
+			sevenSegmentDisplayNumber(&display, (int32_t)i);
+			sevenSegmentRefresh(&display);
+			before = totalWrites;
+			sevenSegmentDisplayNumber(&display, (int32_t)digit);
+			quiet &= (totalWrites == before);
+			sevenSegmentRefresh(&display);
+			if((i != digit) && (totalWrites - before > maxPerChange)){maxPerChange = totalWrites - before;}
+			ok &= (segmentsShowing() == (int32_t)digit);
+		}
+	}
+	check(ok, "all digit transitions match the original table");
+	check(quiet, "writing a number does not touch the pins");
+	check(maxPerChange <= 5, "at most one write per bank per change");
+	sevenSegmentBlank(&display);
+	sevenSegmentRefresh(&display);
+	check(!banks[0].ODR && !banks[1].ODR && !banks[2].ODR && !banks[3].ODR && !banks[4].ODR, "blank clears every segment");
+	sevenSegmentDisplayNumber(&display, 12);
+	sevenSegmentRefresh(&display);
+	check(segmentsShowing() == 9, "numbers too wide for the display saturate");
+
+	//Ten games of nine meteors, one every 10 s at 120 Hz, written every tick as updateOutputs() does
+	totalWrites = 0;
+	tick = 0;
+	for(game = 0; game < 10; game++){
+		for(enemies = 9; enemies >= 0; enemies--){
+			for(i = 0; i < 10 * 120; i++, tick++){
+				sevenSegmentDisplayNumber(&display, enemies);
+				oldWrites += 7;
+				//The refresh timer runs at SEVEN_SEGMENT_REFRESH_RATE, here in step with the simulation
+				if((tick * SEVEN_SEGMENT_REFRESH_RATE) / 120 != ((tick + 1) * SEVEN_SEGMENT_REFRESH_RATE) / 120){
+					sevenSegmentRefresh(&display);
+				}
+			}
+		}
+		sevenSegmentBlank(&display);
+		oldWrites += 7;
+	}
+	printf("%u ticks: %u register writes, was %u (%.0fx fewer)\n", tick, totalWrites, oldWrites, 
+		(double)oldWrites / totalWrites);
+	check(totalWrites <= 10 * 11 * 5, "only changes are written");
+
+	/* Four multiplexed digits with active low selects, refreshed for ten seconds */
+	banks[5].ODR = 0;
+	initSevenSegment(&display, bsrr, segmentPin);
+	for(digit = 0; digit < TEST_DIGITS; digit++){
+		sevenSegmentAddDigit(&display, &banks[5].BSRR, (uint16_t)(1 << digit), 0);
+	}
+	check(selectedDigit() == -1, "digits start deselected");
+	sevenSegmentDisplayNumber(&display, 1234);
+	totalWrites = 0;
+	ghosting = 0;
+	for(digit = 0; digit < TEST_DIGITS; digit++){
+		lastLit[digit] = 0; litTotal[digit] = 0; darkest[digit] = 0; shown[digit] = -1;
+	}
+	for(i = 1; i <= 10000000 / REFRESH_PERIOD_US; i++){
+		now = i * REFRESH_PERIOD_US;
+		//Every 7th interrupt is held off for half a period, as if behind a higher priority one
+		if(i % 7 == 0){
+			now += REFRESH_PERIOD_US / 2;
+			lateCount++;
+		}
+		sevenSegmentRefresh(&display);
+		shown[display.current] = segmentsShowing();
+	}
+	check((shown[0] == 1) && (shown[1] == 2) && (shown[2] == 3) && (shown[3] == 4), "1234 is shown across four digits");
+	check(ghosting == 0, "segments only change with every digit deselected");
+	ok = 1;
+	for(digit = 0; digit < TEST_DIGITS; digit++){
+		printf("digit %u: lit %.1f%%, longest dark %u us\n", digit, litTotal[digit] / 100000.0, darkest[digit]);
+		ok &= (darkest[digit] <= MAX_DARK_US);
+		ok &= (litTotal[digit] > 10000000 / TEST_DIGITS * 9 / 10);
+	}
+	check(ok, "every digit refreshed above 60 Hz with an even share of on time");
+	printf("%u refreshes, %u late, %.1f writes per refresh\n", 10000000 / REFRESH_PERIOD_US, lateCount, 
+		(double)totalWrites / (10000000 / REFRESH_PERIOD_US));
+
+	sevenSegmentDisplayNumber(&display, 7);
+	check((display.buffer[0] == SEVEN_SEGMENT_BLANK) && (display.buffer[2] == SEVEN_SEGMENT_BLANK) && 
+		(display.buffer[3] == 7), "leading zeroes are blanked");
+
+	return failures ? 1 : 0;
+}
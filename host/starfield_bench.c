@@ -0,0 +1,211 @@
+/**
+  ******************************************************************************
+  * @file    starfield_bench.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only check and frame-time benchmark for the starfield in starfield.c and clearScreenStars() in Render.c.
+	*Build from the repository root with:
+	*  gcc -O2 -DSTAR_CAPACITY=16384 -I. host/starfield_bench.c starfield.c Render.c Fonts.c math_functions.c tables.c prng.c -lm -o starfield_bench
+	*Stands in for the platform's frame buffers, as circle_bench.c does. Checks that the stars are sorted into their
+	*columns, scroll down at their layer's speed and wrap round, and that clearScreenStars() draws the same frame as
+	*clearScreen() followed by plotting each star. Then times a frame's update and clear at increasing star counts,
+	*against clearScreen() alone and the clear and plot done separately. Every pass is timed in the same runs, taking
+	*the best of each, and the cost per star is against clearScreenStars() with no stars, so it is the stars' own cost
+	*on the same code path. Last checks the game's STAR_COUNT stars keep the update and clear within STAR_BUDGET of
+	*clearScreen(), on the median of paired runs, as one run's timing swings by more than that. Exits non-zero if a
+	*check fails.
+	*The host clears from cache, one store per pixel, so each star's two stores (its update and its dot) are about
+	*1.5% of the clear per 1000 stars here; into the board's SDRAM the clear is far dearer and the stars cheaper beside it.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Portrait, as Render.c draws */
+#define GLCD_LANDSCAPE 0
+#include "GLCD_Config.h"
+#include "platform.h"
+#include "Render.h"
+#include "starfield.h"
+
+#define BENCH_FRAMES 200
+#define BENCH_RUNS 5
+/* Milliseconds per rendered frame, as in Mainloop.c */
+#define FRAME_MS 33
+/* Paired clear and combined runs for the budget check, and frames in each */
+#define BUDGET_RUNS 41
+#define BUDGET_FRAMES 50
+/* Most the game's stars may add to the clear, the spread of the median between runs of the same code */
+#define STAR_BUDGET 1.03
+
+static uint16_t memory[2][GLCD_WIDTH * GLCD_HEIGHT];
+static uint16_t expected[GLCD_WIDTH * GLCD_HEIGHT];
+static starfield field;
+static starfield empty; /** No stars, for the cost of clearScreenStars() itself */
+static int failures;
+
+void platformDisplayInit(void){
+}
+
+uint16_t* platformFrameBuffer(uint32_t index){
+	return memory[index ? 1 : 0];
+}
+
+void platformPresent(uint32_t index){
+	(void)index;
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compareDoubles(const void* a, const void* b){
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+/**
+	* @brief Frame buffer index of star i in column x, worked out from scratch.
+*/
+static uint32_t starDot(uint32_t x, uint32_t i){
+	uint32_t gameY = ((field.y[i] >> 16) * GLCD_HEIGHT) >> 16;
+	return ((GLCD_WIDTH - 1 - x) * GLCD_HEIGHT) + (GLCD_HEIGHT - 1 - gameY);
+}
+
+/**
+	* @brief Plot every star onto buf, one at a time, as a separate pass after a clear would.
+*/
+static void plotStars(uint16_t* buf){
+	uint32_t x, i;
+	for(x = 0; x < STAR_COLUMNS; x++){
+		for(i = field.columnStarts[x]; i < field.columnStarts[x + 1]; i++){
+			buf[starDot(x, i)] = field.color[i];
+		}
+	}
+}
+
+int main(void){
+	static const uint32_t counts[] = {0, 512, 1024, 2048, 4096, 8192, 16384};
+	static uint32_t before[STAR_CAPACITY];
+	static double ratios[BUDGET_RUNS];
+	uint32_t i, c, run, frame, ok, moved;
+	double begin, seconds, clear, bare, separate, combined;
+
+	GLCD_Initialize_Doublebuffer();
+	setBackgroundColor(GLCD_COLOR_BLACK);
+
+	/* Layout */
+	initStars(&field, 3000, 7);
+	ok = (field.columnStarts[0] == 0) && (field.columnStarts[STAR_COLUMNS] == 3000) && (field.count == 3000);
+	for(i = 0; i < STAR_COLUMNS; i++){
+		ok = ok && (field.columnStarts[i] <= field.columnStarts[i + 1]);
+	}
+	check(ok, "stars are sorted into columns that cover the field");
+	initStars(&field, STAR_CAPACITY + 10, 7);
+	check(field.count == STAR_CAPACITY, "a field is cut to STAR_CAPACITY");
+
+	/* Scrolling */
+	initStars(&field, 3000, 7);
+	memcpy(before, field.y, sizeof(before));
+	updateStars(&field, 1000);
+	ok = 1;
+	moved = 0;
+	for(i = 0; i < field.count; i++){
+		/* Pixels fallen in a second, from the fraction of the height */
+		c = (uint32_t)(((uint64_t)(uint32_t)(before[i] - field.y[i]) * GLCD_HEIGHT + 0x80000000u) >> 32);
+		ok = ok && ((c == 6) || (c == 16) || (c == 40));
+		moved += c;
+	}
+	check(ok, "each star falls at its layer's speed");
+	printf("average star speed %.1f pixels per second\n", moved / (double)field.count);
+	for(i = 0; i < 12; i++){
+		updateStars(&field, 1000);
+	}
+	ok = 0;
+	for(i = 0; i < field.count; i++){
+		ok += field.y[i] > before[i];
+	}
+	check(ok > 0, "stars wrap round from the bottom to the top");
+
+	/* One pass draws what clearing and plotting separately would */
+	clearScreenStars(field.columnStarts, field.y, field.color);
+	memset(expected, 0, sizeof(expected));
+	plotStars(expected);
+	check(memcmp(expected, memory[1], sizeof(expected)) == 0, "clearScreenStars() matches clearScreen() then plotting each star");
+
+	/* Timing, best of several runs as the host is shared; each run times every pass, so they share its conditions */
+	initStars(&empty, 0, 7);
+	printf("%6s %10s %10s %12s %12s %10s %12s\n", "stars", "clear us", "bare us", "separate us", "combined us", "vs clear", "ns per star");
+	for(c = 0; c < sizeof(counts) / sizeof(counts[0]); c++){
+		if(counts[c] > STAR_CAPACITY){
+			break;
+		}
+		initStars(&field, counts[c], 7);
+		clear = 1e9;
+		bare = 1e9;
+		separate = 1e9;
+		combined = 1e9;
+		for(run = 0; run < BENCH_RUNS; run++){
+			begin = nowSeconds();
+			for(frame = 0; frame < BENCH_FRAMES; frame++){
+				clearScreen();
+			}
+			seconds = (nowSeconds() - begin) / BENCH_FRAMES;
+			clear = (seconds < clear) ? seconds : clear;
+			begin = nowSeconds();
+			for(frame = 0; frame < BENCH_FRAMES; frame++){
+				updateStars(&empty, FRAME_MS);
+				clearScreenStars(empty.columnStarts, empty.y, empty.color);
+			}
+			seconds = (nowSeconds() - begin) / BENCH_FRAMES;
+			bare = (seconds < bare) ? seconds : bare;
+			begin = nowSeconds();
+			for(frame = 0; frame < BENCH_FRAMES; frame++){
+				updateStars(&field, FRAME_MS);
+				clearScreen();
+				plotStars(memory[1]);
+			}
+			seconds = (nowSeconds() - begin) / BENCH_FRAMES;
+			separate = (seconds < separate) ? seconds : separate;
+			begin = nowSeconds();
+			for(frame = 0; frame < BENCH_FRAMES; frame++){
+				updateStars(&field, FRAME_MS);
+				clearScreenStars(field.columnStarts, field.y, field.color);
+			}
+			seconds = (nowSeconds() - begin) / BENCH_FRAMES;
+			combined = (seconds < combined) ? seconds : combined;
+		}
+		printf("%6u %10.1f %10.1f %12.1f %12.1f %9.2fx %12.2f\n", (unsigned)counts[c], clear * 1e6, bare * 1e6, separate * 1e6, 
+			combined * 1e6, combined / clear, counts[c] ? (combined - bare) * 1e9 / counts[c] : 0.0);
+	}
+
+	/* Budget: each run times the clear and the game's stars back to back, and the median of their ratios is checked */
+	initStars(&field, STAR_COUNT, 7);
+	for(run = 0; run < BUDGET_RUNS; run++){
+		begin = nowSeconds();
+		for(frame = 0; frame < BUDGET_FRAMES; frame++){
+			clearScreen();
+		}
+		clear = nowSeconds() - begin;
+		begin = nowSeconds();
+		for(frame = 0; frame < BUDGET_FRAMES; frame++){
+			updateStars(&field, FRAME_MS);
+			clearScreenStars(field.columnStarts, field.y, field.color);
+		}
+		ratios[run] = (nowSeconds() - begin) / clear;
+	}
+	qsort(ratios, BUDGET_RUNS, sizeof(ratios[0]), compareDoubles);
+	printf("%u stars, median %.3fx the clear\n", (unsigned)STAR_COUNT, ratios[BUDGET_RUNS / 2]);
+	check(ratios[BUDGET_RUNS / 2] <= STAR_BUDGET, "the game's stars keep the update and clear within STAR_BUDGET of clearScreen()");
+
+	return failures ? 1 : 0;
+}
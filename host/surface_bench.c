@@ -0,0 +1,393 @@
+/**
+  ******************************************************************************
+  * @file    surface_bench.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only check and per-pass benchmark for drawing surfaces of other sizes and formats in Render.c.
+	*Build from the repository root with:
+	*  gcc -O2 -DRENDER_MAX_WIDTH=2160 -DRENDER_MAX_HEIGHT=3840 -I. host/surface_bench.c Render.c Fonts.c math_functions.c tables.c -lm -o surface_bench
+	*and again with -DPIXEL_FORMAT=PIXEL_ARGB8888 for 32-bit pixels. Without the RENDER_MAX sizes only the panel's
+	*size is run. Stands in for the platform's frame buffers, as circle_bench.c does, with padding after each row and
+	*guard words either side. Checks that GLCD_InitializeSurface() turns away surfaces it can't draw, then draws a frame
+	*like the game's, scaled to each surface, from the panel's 272x480 up to 2160x3840: a starfield cleared in, lines,
+	*circles, polygons, sparks and text, then the glow and a software composite over a background. Checks that nothing
+	*is written outside the surface or into the row padding, that solid fills are the colour asked for in the build's
+	*format, and that a padded 272x480 surface draws the same frame as GLCD_Initialize_Doublebuffer(). Reports each
+	*pass a frame, and per pixel, which is the figure that should stay flat as the surface grows. Exits non-zero if a
+	*check fails. Polygons stay below 2047 pixels, as far as their 16-bit vertices reach.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Portrait, as Render.c draws */
+#define GLCD_LANDSCAPE 0
+#include "GLCD_Config.h"
+#include "platform.h"
+#include "Render.h"
+
+#define BENCH_RUNS 3
+/* Pixels of padding after each frame buffer row, so a row's stride isn't its length */
+#define ROW_PAD 8
+/* Guard pixels either side of each buffer, to catch writes off the surface */
+#define GUARD 4096
+#define GUARD_VALUE ((pixel)0xA5A5A5A5u)
+#define BUFFER_PIXELS (GUARD + (RENDER_MAX_WIDTH * (RENDER_MAX_HEIGHT + ROW_PAD)) + GUARD)
+#define KEY GLCD_COLOR_BLACK
+/* Stars a pixel, as a shift, so the game's density carries over; columnStarts is 16-bit, which caps them */
+#define STAR_DENSITY_SHIFT 7
+#define MAX_STARS 65535
+#define SPARKS 4096
+#define METEORS 8
+#define PASSES 5
+
+static pixel* memory[3]; /** Both frame buffers then the background, each with guards */
+static pixel* composited;
+static pixel* expected;
+static uint16_t columnStarts[RENDER_MAX_WIDTH + 1];
+static uint32_t starY[MAX_STARS];
+static uint16_t starColor[MAX_STARS];
+static int32_t sparkX[SPARKS], sparkY[SPARKS];
+static uint16_t sparkColor[SPARKS], sparkAlpha[SPARKS];
+static uint32_t width, height, pitch; /** The surface being drawn */
+static int failures;
+
+static const char* const names[PASSES] = {"clear+stars", "primitives", "glow", "composite", "total"};
+
+void platformDisplayInit(void){
+}
+
+pixel* platformFrameBuffer(uint32_t index){
+	return &memory[index ? 1 : 0][GUARD];
+}
+
+void platformPresent(uint32_t index){
+	(void)index;
+}
+
+static pixel* background(void){
+	return &memory[2][GUARD];
+}
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+	* @brief Sets up a surface of w by h pixels, with padded rows. Returns GLCD_InitializeSurface()'s result.
+*/
+static int32_t useSurface(uint32_t w, uint32_t h, uint32_t pad){
+	renderSurface surface;
+	surface.width = w;
+	surface.height = h;
+	surface.stride = h + pad;
+	surface.format = PIXEL_FORMAT;
+	width = w;
+	height = h;
+	pitch = h + pad;
+	return GLCD_InitializeSurface(&surface);
+}
+
+/**
+	* @brief Nonzero if no buffer has been written outside the surface: the guards and every row's padding are untouched.
+*/
+static int outsideIntact(void){
+	uint32_t b, i, r;
+	for(b = 0; b < 3; b++){
+		for(i = 0; i < GUARD; i++){
+			if((memory[b][i] != GUARD_VALUE) || (memory[b][GUARD + (width * pitch) + i] != GUARD_VALUE)){
+				return 0;
+			}
+		}
+		for(r = 0; r < width; r++){
+			for(i = height; i < pitch; i++){
+				if(memory[b][GUARD + (r * pitch) + i] != GUARD_VALUE){
+					return 0;
+				}
+			}
+		}
+	}
+	return 1;
+}
+
+/**
+	* @brief Game x or y scaled from the panel's to the surface's.
+*/
+static uint32_t sx(uint32_t x){
+	return x * width / GLCD_WIDTH;
+}
+
+static uint32_t sy(uint32_t y){
+	return y * height / GLCD_HEIGHT;
+}
+
+/**
+	* @brief Makes a starfield for the surface, sorted into its columns, and a burst of sparks over it.
+*/
+static void makeField(void){
+	uint32_t i, x, count = (width * height) >> STAR_DENSITY_SHIFT, n = 77;
+	static const uint16_t shades[3] = {0x4208, 0x8410, 0xDEFB};
+	count = (count > MAX_STARS) ? MAX_STARS : count;
+	for(x = 0; x <= width; x++){
+		columnStarts[x] = (uint16_t)(((uint64_t)count * x) / width);
+	}
+	for(i = 0; i < count; i++){
+		n = n * 1103515245 + 12345;
+		starY[i] = n;
+		starColor[i] = shades[i % 3];
+	}
+	for(i = 0; i < SPARKS; i++){
+		n = n * 1103515245 + 12345;
+		sparkX[i] = (int32_t)((sx(150) << 16) + (int32_t)((n >> 8) % (sx(120) << 16)) - (int32_t)(sx(60) << 16));
+		n = n * 1103515245 + 12345;
+		sparkY[i] = (int32_t)((sy(300) << 16) + (int32_t)((n >> 8) % (sy(120) << 16)) - (int32_t)(sy(60) << 16));
+		sparkColor[i] = (i & 1) ? GLCD_COLOR_WHITE : GLCD_COLOR_YELLOW;
+		sparkAlpha[i] = (uint16_t)(0x100 + ((n >> 4) & 0xFEFF));
+	}
+}
+
+/**
+	* @brief Draws frame's moving things, scaled to the surface: trails and bullets, an explosion, meteors below
+	* 2047 pixels, sparks, a panel and text.
+*/
+static void drawPrimitives(uint32_t frame){
+	static int16_t xs[METEORS][4], ys[METEORS][4];
+	polygon meteors[METEORS];
+	uint32_t i, x, y, r;
+	char text[16];
+
+	for(i = 0; i < 5; i++){
+		x = sx(20 + ((frame * (3 + i) + i * 50) % 232));
+		y = sy(110 + ((frame * (5 + 2 * i) + i * 70) % 340));
+		setForegroundColor(GLCD_COLOR_NAVY);
+		drawThickLine(x, sy(90), x, y, sx(3));
+		setForegroundColor(GLCD_COLOR_CYAN);
+		drawFilledCircleAA(TO_SUBPIXEL(x) + (int32_t)(frame & 15), TO_SUBPIXEL(y), TO_SUBPIXEL(sx(10)));
+	}
+	setForegroundColor(GLCD_COLOR_DARK_GREEN);
+	drawFilledCircle((int32_t)sx(220), (int32_t)sy(420), (int32_t)sx(20));
+	setForegroundColor(GLCD_COLOR_WHITE);
+	drawLine(sx(10), sy(470), sx(260), sy(200));
+	//Meteors are scaled at most 4 times, from the bottom left, so their vertices stay below 2047 pixels and fit in 16 bits
+	r = (width < 4 * GLCD_WIDTH) ? sx(1 << CIRCLE_SUBPIXEL_BITS) : 4 << CIRCLE_SUBPIXEL_BITS;
+	for(i = 0; i < METEORS; i++){
+		x = r * (30 + i * 30);
+		y = r * (460 - ((frame * 4 + i * 40) % 340)) + (i * 5);
+		xs[i][0] = (int16_t)(x - (r * 9));
+		ys[i][0] = (int16_t)(y - (r * 4));
+		xs[i][1] = (int16_t)(x + (r * 2));
+		ys[i][1] = (int16_t)(y - (r * 10));
+		xs[i][2] = (int16_t)(x + (r * 10));
+		ys[i][2] = (int16_t)(y + (r * 3));
+		xs[i][3] = (int16_t)(x - r);
+		ys[i][3] = (int16_t)(y + (r * 11));
+		meteors[i].x = xs[i];
+		meteors[i].y = ys[i];
+		meteors[i].count = 4;
+		meteors[i].fill = GLCD_COLOR_MAROON;
+		meteors[i].outline = GLCD_COLOR_RED;
+		meteors[i].outlined = 1;
+	}
+	fillPolygons(meteors, METEORS);
+	if((frame % 30) < 12){
+		setForegroundColor(((frame / 2) & 1) ? GLCD_COLOR_DARK_GREEN : GLCD_COLOR_CYAN);
+		drawFilledCircleAA(TO_SUBPIXEL(sx(150)), TO_SUBPIXEL(sy(300)), TO_SUBPIXEL(sx(60)));
+	}
+	drawSplats(sparkX, sparkY, sparkColor, sparkAlpha, SPARKS, (sx(2) > 0) ? sx(2) : 1);
+	setForegroundColor(GLCD_COLOR_BLUE);
+	fillRectangle(0, 0, sx(272), sy(24));
+	setForegroundColor(GLCD_COLOR_WHITE);
+	sprintf(text, "%u", (unsigned)frame);
+	GLCD_DrawString(0, height - 24, text);
+}
+
+static void glow(void){
+	bloomExtract();
+	bloomBlurRows();
+	bloomBlurColumns();
+	bloomComposite();
+}
+
+static void drawFrame(uint32_t frame){
+	setBackgroundColor(GLCD_COLOR_BLACK);
+	clearScreenStars(columnStarts, starY, starColor);
+	drawPrimitives(frame);
+	glow();
+}
+
+/**
+	* @brief Best time of each pass over BENCH_RUNS of frames frames on the current surface, into seconds[PASSES].
+*/
+static void timePasses(uint32_t frames, double* seconds){
+	uint32_t run, frame, p;
+	double begin, total[PASSES];
+	for(p = 0; p < PASSES; p++){
+		seconds[p] = 1e9;
+	}
+	for(run = 0; run < BENCH_RUNS; run++){
+		memset(total, 0, sizeof(total));
+		for(frame = 0; frame < frames; frame++){
+			begin = nowSeconds();
+			setBackgroundColor(GLCD_COLOR_BLACK);
+			clearScreenStars(columnStarts, starY, starColor);
+			total[0] += nowSeconds() - begin;
+			begin = nowSeconds();
+			drawPrimitives(frame);
+			total[1] += nowSeconds() - begin;
+			begin = nowSeconds();
+			glow();
+			total[2] += nowSeconds() - begin;
+			begin = nowSeconds();
+			compositeLayers(composited, platformFrameBuffer(backBufferIndex()), background(), KEY);
+			total[3] += nowSeconds() - begin;
+			switchBuffer();
+		}
+		total[4] = total[0] + total[1] + total[2] + total[3];
+		for(p = 0; p < PASSES; p++){
+			seconds[p] = (total[p] / frames < seconds[p]) ? total[p] / frames : seconds[p];
+		}
+	}
+}
+
+/**
+	* @brief Fills every buffer, guards and padding included, with GUARD_VALUE.
+*/
+static void fillGuards(void){
+	uint32_t b, i;
+	for(b = 0; b < 3; b++){
+		for(i = 0; i < BUFFER_PIXELS; i++){
+			memory[b][i] = GUARD_VALUE;
+		}
+	}
+}
+
+/**
+	* @brief Nonzero if every pixel of the back buffer on the surface is color.
+*/
+static int solid(pixel color){
+	uint32_t r, i;
+	const pixel* frame = platformFrameBuffer(backBufferIndex());
+	for(r = 0; r < width; r++){
+		for(i = 0; i < height; i++){
+			if(frame[(r * pitch) + i] != color){
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+int main(void){
+	static const uint32_t sizes[][2] = {{272, 480}, {540, 960}, {1080, 1920}, {2160, 3840}};
+	static const uint16_t tests[] = {GLCD_COLOR_WHITE, GLCD_COLOR_CYAN, GLCD_COLOR_MAROON, 0x8410, 0x0841};
+	uint32_t s, i, r, p, frames, ok, run = 0;
+	double seconds[PASSES], base[PASSES];
+	renderSurface bad;
+
+	for(i = 0; i < 3; i++){
+		memory[i] = (pixel*)malloc(sizeof(pixel) * BUFFER_PIXELS);
+	}
+	composited = (pixel*)malloc(sizeof(pixel) * RENDER_MAX_WIDTH * (RENDER_MAX_HEIGHT + ROW_PAD));
+	expected = (pixel*)malloc(sizeof(pixel) * GLCD_WIDTH * GLCD_HEIGHT);
+	printf("%u-bit pixels, surfaces up to %ux%u\n", (unsigned)(sizeof(pixel) * 8), (unsigned)RENDER_MAX_WIDTH, (unsigned)RENDER_MAX_HEIGHT);
+
+	/* Surfaces that can't be drawn are turned away */
+	GLCD_Initialize_Doublebuffer();
+	bad.width = GLCD_WIDTH; bad.height = GLCD_HEIGHT; bad.stride = GLCD_HEIGHT; bad.format = PIXEL_FORMAT;
+	ok = GLCD_InitializeSurface(&bad) == 0;
+	bad.format = (PIXEL_FORMAT == PIXEL_RGB565) ? PIXEL_ARGB8888 : PIXEL_RGB565;
+	ok = ok && (GLCD_InitializeSurface(&bad) == -1);
+	bad.format = PIXEL_FORMAT; bad.stride = GLCD_HEIGHT - 1;
+	ok = ok && (GLCD_InitializeSurface(&bad) == -1);
+	bad.stride = RENDER_MAX_HEIGHT + 1; bad.height = RENDER_MAX_HEIGHT + 1;
+	ok = ok && (GLCD_InitializeSurface(&bad) == -1);
+	bad.height = GLCD_HEIGHT; bad.width = RENDER_MAX_WIDTH + 1;
+	ok = ok && (GLCD_InitializeSurface(&bad) == -1);
+	bad.width = 0;
+	ok = ok && (GLCD_InitializeSurface(&bad) == -1);
+	check(ok, "GLCD_InitializeSurface() takes the panel and turns away other formats, overlapping rows and oversized surfaces");
+
+	/* The panel, as the game draws it, to compare the padded surface with */
+	fillGuards();
+	GLCD_Initialize_Doublebuffer();
+	width = GLCD_WIDTH; height = GLCD_HEIGHT; pitch = GLCD_HEIGHT;
+	makeField();
+	drawFrame(7);
+	memcpy(expected, platformFrameBuffer(backBufferIndex()), sizeof(pixel) * GLCD_WIDTH * GLCD_HEIGHT);
+
+	printf("%-10s %-12s %12s %12s\n", "surface", "pass", "ms a frame", "ns a pixel");
+	for(s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+		if((sizes[s][0] > RENDER_MAX_WIDTH) || (sizes[s][1] > RENDER_MAX_HEIGHT)){
+			printf("%ux%u is over RENDER_MAX_WIDTH by RENDER_MAX_HEIGHT, skipped\n", (unsigned)sizes[s][0], (unsigned)sizes[s][1]);
+			continue;
+		}
+		fillGuards();
+		if(useSurface(sizes[s][0], sizes[s][1], ROW_PAD) != 0){
+			check(0, "GLCD_InitializeSurface() takes a surface within RENDER_MAX_WIDTH by RENDER_MAX_HEIGHT");
+			continue;
+		}
+		makeField();
+		GLCD_InitializeLayers(background(), KEY);
+		drawToBackground();
+		setBackgroundColor(GLCD_COLOR_BLACK);
+		clearScreen();
+		setForegroundColor(GLCD_COLOR_BLUE);
+		drawFilledCircleAA(TO_SUBPIXEL(sx(136)), 0, TO_SUBPIXEL(sx(40)));
+		drawToSprites();
+		//Back to a single layer, so the frames are drawn whole, as in the game without layers
+		GLCD_InitializeLayers(NULL, KEY);
+
+		if(s == 0){
+			drawFrame(7);
+			ok = 1;
+			for(r = 0; r < width; r++){
+				ok = ok && (memcmp(&platformFrameBuffer(backBufferIndex())[r * pitch], &expected[r * GLCD_HEIGHT], sizeof(pixel) * height) == 0);
+			}
+			check(ok, "a 272x480 surface with padded rows draws the same frame as the panel");
+		}
+		ok = 1;
+		for(i = 0; i < sizeof(tests) / sizeof(tests[0]); i++){
+			setBackgroundColor(tests[i]);
+			clearScreen();
+			ok = ok && solid(PIXEL_FROM_565(tests[i]));
+			setBackgroundColor(GLCD_COLOR_BLACK);
+			clearScreen();
+			setForegroundColor(tests[i]);
+			drawFilledCircle((int32_t)(width >> 1), (int32_t)(height >> 1), 8);
+			ok = ok && (platformFrameBuffer(backBufferIndex())[((width >> 1) * pitch) + (height >> 1)] == PIXEL_FROM_565(tests[i]));
+		}
+		check(ok, "solid fills are the colour asked for, in the build's pixel format");
+
+		frames = (width * height > 1000000) ? 4 : 20;
+		timePasses(frames, seconds);
+		check(outsideIntact(), "nothing is written outside the surface or into the row padding");
+		for(p = 0; p < PASSES; p++){
+			printf("%4ux%-5u %-12s %12.3f %12.2f", (unsigned)width, (unsigned)height, names[p], seconds[p] * 1e3,
+				seconds[p] * 1e9 / (width * height));
+			if(run == 0){
+				base[p] = seconds[p];
+				printf("\n");
+			}else{
+				printf("   %.1fx the panel's time for %.1fx the pixels\n", seconds[p] / base[p],
+					(width * height) / (double)(GLCD_WIDTH * GLCD_HEIGHT));
+			}
+		}
+		run++;
+	}
+
+	for(i = 0; i < 3; i++){
+		free(memory[i]);
+	}
+	free(composited);
+	free(expected);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,108 @@
+/**
+  ******************************************************************************
+  * @file    tables_test.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only check that the generated flash tables match the code that computes them at runtime.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/tables_test.c tables.c trig.c math_functions.c -lm -o tables_test
+	*Fails if tables.c is stale: regenerate it with host/gentables.c.
+	*The encoder and seven-segment tables are also checked against the hand-written versions they replaced,
+	*and the circle edge coverage and gamma tables for their shape.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "tables.h"
+#include "trig.h"
+#include "math_functions.h"
+
+static int failures;
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+int main(void){
+	static const int8_t oldMotionTable[16] = {0,-1,1,0,1,0,0,-1,-1,0,0,1,0,1,-1,0};
+	static const uint8_t oldPatterns[11] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x67, 0x00};
+	/* Clockwise quadrature from 11, as in poll.c */
+	static const uint8_t clockwise[5] = {3, 1, 0, 2, 3};
+	int32_t r, y, i, ok, s, c, fs, fc, e, worst = 0;
+
+	ok = 1;
+	for(r = 0; r <= CIRCLE_TABLE_RADIUS; r++){
+		for(y = 0; y <= r; y++){
+			ok = ok && (circleSpans[CIRCLE_SPAN_OFFSET(r) + y] == intSqrt((uint32_t)(r * r - y * y)));
+		}
+	}
+	check(ok, "circleSpans matches intSqrt() for every row of every radius");
+	check(sizeof(circleSpans) == CIRCLE_SPAN_OFFSET(CIRCLE_TABLE_RADIUS + 1), "circleSpans ends after the largest radius");
+
+	ok = 1;
+	for(i = 0; i < 256; i++){
+		ok = ok && (blendRamp[i] == ((i + 4) >> 3));
+	}
+	check(ok && (blendRamp[0] == 0) && (blendRamp[255] == 32), "blendRamp matches blendPixelFast()'s rounding, 0 to 32");
+
+	ok = 1;
+	for(i = 0; i <= SINE_TABLE_SIZE; i++){
+		ok = ok && (sineTable[i] == trigSin(i * (ANGLE_QUARTER / SINE_TABLE_SIZE)));
+	}
+	check(ok, "sineTable matches trigSin() at every step");
+
+	ok = 1;
+	for(i = -ANGLE_FULL; i < 2 * ANGLE_FULL; i++){
+		trigSinCos(i, &s, &c);
+		trigSinCosFast(i, &fs, &fc);
+		if(((i % (ANGLE_QUARTER / SINE_TABLE_SIZE)) == 0) && ((i & (ANGLE_FULL - 1)) <= ANGLE_QUARTER)){
+			ok = ok && (s == fs);
+		}
+		e = (s > fs) ? s - fs : fs - s;
+		if(e > worst){worst = e;}
+		e = (c > fc) ? c - fc : fc - c;
+		if(e > worst){worst = e;}
+	}
+	printf("trigSinCosFast: worst difference from trigSinCos %d\n", worst);
+	check(ok, "trigSinCosFast sine identical to trigSinCos at the table steps of the first quadrant");
+	check(worst <= 1, "trigSinCosFast within 1 of trigSinCos at every angle");
+
+	check(memcmp(encoderMotionTable, oldMotionTable, sizeof(oldMotionTable)) == 0, "encoderMotionTable matches the hand-written table");
+	ok = 1;
+	for(i = 0; i < 4; i++){
+		ok = ok && (encoderMotionTable[(clockwise[i] << 2) | clockwise[i + 1]] == 1);
+		ok = ok && (encoderMotionTable[(clockwise[i + 1] << 2) | clockwise[i]] == -1);
+	}
+	check(ok, "encoderMotionTable decodes a full cycle each way");
+
+	check(memcmp(segmentPatterns, oldPatterns, sizeof(oldPatterns)) == 0, "segmentPatterns matches the hand-written patterns");
+
+	ok = 1;
+	for(i = 1; i <= 2 * CIRCLE_EDGE_WIDTH; i++){
+		ok = ok && (circleEdgeCoverage[i] <= circleEdgeCoverage[i - 1]);
+		ok = ok && (circleEdgeCoverage[i] + circleEdgeCoverage[2 * CIRCLE_EDGE_WIDTH - i] >= 254) && (circleEdgeCoverage[i] + circleEdgeCoverage[2 * CIRCLE_EDGE_WIDTH - i] <= 256);
+	}
+	check(ok && (circleEdgeCoverage[CIRCLE_EDGE_WIDTH] == 128), "circleEdgeCoverage falls steadily and is half covered, symmetrically, at the edge");
+	check((blendRamp[circleEdgeCoverage[0]] == 32) && (blendRamp[circleEdgeCoverage[2 * CIRCLE_EDGE_WIDTH]] == 0), 
+		"circleEdgeCoverage blends as opaque and clear beyond its ends");
+
+	ok = (gammaDecode5[0] == 0) && (gammaDecode6[0] == 0) && (gammaDecode8[0] == 0);
+	ok = ok && (gammaDecode5[31] == (1 << GAMMA_LINEAR_BITS) - 1) && (gammaDecode6[63] == (1 << GAMMA_LINEAR_BITS) - 1);
+	ok = ok && (gammaDecode8[255] == (1 << GAMMA_LINEAR_BITS) - 1);
+	for(i = 1; i < 256; i++){
+		ok = ok && (gammaDecode8[i] > gammaDecode8[i - 1]) && (gammaEncode8[gammaDecode8[i]] == i);
+	}
+	for(i = 1; i < 64; i++){
+		ok = ok && (gammaDecode6[i] > gammaDecode6[i - 1]) && (gammaEncode6[gammaDecode6[i]] == i);
+		if(i < 32){
+			ok = ok && (gammaDecode5[i] > gammaDecode5[i - 1]) && (gammaEncode5[gammaDecode5[i]] == i);
+		}
+	}
+	for(i = 1; i < (1 << GAMMA_LINEAR_BITS); i++){
+		ok = ok && (gammaEncode5[i] >= gammaEncode5[i - 1]) && (gammaEncode6[i] >= gammaEncode6[i - 1]) && (gammaEncode8[i] >= gammaEncode8[i - 1]);
+	}
+	check(ok, "the gamma tables rise steadily, span the range and encode each decoded level back to itself");
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+/**
+  ******************************************************************************
+  * @file    trig_bench.c
+  * @author  David Webster - 100293854
+  * @brief   Host-only accuracy and speed benchmark for trig.c.
+	*Build from the repository root with:
+	*  gcc -O2 -I. host/trig_bench.c trig.c tables.c -lm -o trig_bench
+	*and, to check for undefined behaviour on every angle and length, with the sanitizer stopping at the first:
+	*  gcc -O2 -I. -fsanitize=undefined -fno-sanitize-recover host/trig_bench.c trig.c tables.c -lm -o trig_bench
+	*Checks every one of the 65536 angles against double precision, sweeps trigAtan2() round the circle
+	*at several lengths, and times each call against the float library. On the board the float library has
+	*no hardware sin, cos or atan to fall back on, so the CORDIC calls compare far better there than here.
+	*Exits non-zero if any result is outside its bound.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "trig.h"
+
+#define PI 3.14159265358979323846
+#define BENCH_POINTS 4096
+#define BENCH_ROUNDS 2000
+/* Largest error allowed, in Q15 units for sin/cos and binary angle units for atan2 */
+#define SINCOS_BOUND 1
+#define ATAN_BOUND 2
+
+static int failures;
+
+static void check(int condition, const char* name){
+	printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+	if(!condition){failures++;}
+}
+
+static double nowSeconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+	* @brief Print time per call, and in host cycles if the clock rate is known from /proc/cpuinfo.
+*/
+static void report(const char* name, double seconds, double calls){
+	static double mhz = -1;
+	double ns = seconds * 1e9 / calls;
+	FILE* f;
+	char line[256];
+	if(mhz < 0){
+		mhz = 0;
+		if((f = fopen("/proc/cpuinfo", "r")) != NULL){
+			while(fgets(line, sizeof(line), f) && (sscanf(line, "cpu MHz : %lf", &mhz) != 1));
+			fclose(f);
+		}
+	}
+	if(mhz > 0){
+		printf("%-16s %7.2f ns/call, %5.0f cycles\n", name, ns, ns * mhz / 1000.0);
+	}
+	else{
+		printf("%-16s %7.2f ns/call\n", name, ns);
+	}
+}
+
+int main(void){
+	static int16_t xs[BENCH_POINTS], ys[BENCH_POINTS], outX[BENCH_POINTS], outY[BENCH_POINTS];
+	int32_t a, s, c, worstSin = 0, worstCos = 0, worstAtan = 0, worstRotate = 0, e, length, r;
+	uint32_t i;
+	double rad, begin, seconds, ex, ey;
+	volatile uint32_t sink = 0;
+	volatile float fsink = 0;
+
+	/* Every angle */
+	for(a = 0; a < ANGLE_FULL; a++){
+		trigSinCos(a, &s, &c);
+		rad = a * 2 * PI / ANGLE_FULL;
+		e = (int32_t)(fabs(s - sin(rad) * TRIG_ONE) + 0.5);
+		if(e > worstSin){worstSin = e;}
+		e = (int32_t)(fabs(c - cos(rad) * TRIG_ONE) + 0.5);
+		if(e > worstCos){worstCos = e;}
+	}
+	printf("sin/cos: worst error %d/%d Q15 units\n", worstSin, worstCos);
+	check((worstSin <= SINCOS_BOUND) && (worstCos <= SINCOS_BOUND), "sin and cos within bound at every angle");
+	check((trigSin(0) == 0) && (trigCos(0) == TRIG_ONE) && (trigSin(ANGLE_QUARTER) == TRIG_ONE) &&
+		(trigCos(ANGLE_HALF) == -TRIG_ONE) && (trigSin(ANGLE_FULL + ANGLE_QUARTER) == TRIG_ONE), "exact at the axes, and wraps");
+
+	/* atan2 round the circle, short vectors to long */
+	for(length = 3; length < 100000000; length *= 7){
+		for(a = 0; a < ANGLE_FULL; a += 7){
+			rad = a * 2 * PI / ANGLE_FULL;
+			ex = cos(rad) * length;
+			ey = sin(rad) * length;
+			r = trigAtan2((int32_t)floor(ey + 0.5), (int32_t)floor(ex + 0.5));
+			/* Compare against the angle of the rounded vector, wrapped to the nearest turn */
+			e = r - (int32_t)floor(atan2(floor(ey + 0.5), floor(ex + 0.5)) * ANGLE_FULL / (2 * PI) + 0.5);
+			e = (int16_t)e;
+			e = (e < 0) ? -e : e;
+			if(e > worstAtan){worstAtan = e;}
+		}
+	}
+	printf("atan2: worst error %d binary angle units\n", worstAtan);
+	check(worstAtan <= ATAN_BOUND, "atan2 within bound round the circle at every length");
+	check((trigAtan2(0, 0) == 0) && (trigAtan2(0, 5) == 0) && (trigAtan2(5, 0) == ANGLE_QUARTER) &&
+		(trigAtan2(0, -5) == ANGLE_HALF) && (trigAtan2(-5, 0) == -ANGLE_QUARTER), "atan2 exact on the axes");
+
+	/* Rotation against doubles */
+	for(i = 0; i < BENCH_POINTS; i++){
+		xs[i] = (int16_t)((int32_t)(i * 37 % 601) - 300);
+		ys[i] = (int16_t)((int32_t)(i * 91 % 601) - 300);
+	}
+	for(a = 0; a < ANGLE_FULL; a += 997){
+		rotatePoints(xs, ys, outX, outY, BENCH_POINTS, a);
+		rad = a * 2 * PI / ANGLE_FULL;
+		for(i = 0; i < BENCH_POINTS; i++){
+			ex = xs[i] * cos(rad) - ys[i] * sin(rad);
+			ey = xs[i] * sin(rad) + ys[i] * cos(rad);
+			e = (int32_t)(fabs(outX[i] - ex) + fabs(outY[i] - ey) + 0.5);
+			if(e > worstRotate){worstRotate = e;}
+		}
+	}
+	printf("rotatePoints: worst error %d pixels, over points up to 300 from the origin\n", worstRotate);
+	check(worstRotate <= 1, "rotatePoints within a pixel");
+
+	/* Timing */
+	begin = nowSeconds();
+	for(a = 0; a < ANGLE_FULL * 16; a++){
+		trigSinCos(a * 13, &s, &c);
+		sink += s + c;
+	}
+	seconds = nowSeconds() - begin;
+	report("trigSinCos", seconds, ANGLE_FULL * 16.0);
+	begin = nowSeconds();
+	for(a = 0; a < ANGLE_FULL * 16; a++){
+		rad = (float)(a * 13) * (float)(2 * PI / ANGLE_FULL);
+		fsink += sinf((float)rad) + cosf((float)rad);
+	}
+	seconds = nowSeconds() - begin;
+	report("sinf + cosf", seconds, ANGLE_FULL * 16.0);
+	begin = nowSeconds();
+	for(a = 0; a < ANGLE_FULL * 16; a++){
+		sink += trigAtan2(a - 500000, 300 + (a & 0xFFF));
+	}
+	seconds = nowSeconds() - begin;
+	report("trigAtan2", seconds, ANGLE_FULL * 16.0);
+	begin = nowSeconds();
+	for(a = 0; a < ANGLE_FULL * 16; a++){
+		fsink += atan2f((float)(a - 500000), (float)(300 + (a & 0xFFF)));
+	}
+	seconds = nowSeconds() - begin;
+	report("atan2f", seconds, ANGLE_FULL * 16.0);
+	begin = nowSeconds();
+	for(r = 0; r < BENCH_ROUNDS; r++){
+		rotatePoints(xs, ys, outX, outY, BENCH_POINTS, r * 31);
+		sink += outX[r % BENCH_POINTS];
+	}
+	seconds = nowSeconds() - begin;
+	report("rotatePoints", seconds, (double)BENCH_ROUNDS * BENCH_POINTS);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+/**
+  ******************************************************************************
+  * @file    latency.c 
+  * @author  David Webster - 100293854
+  * @brief   This file contains functions for measuring input-to-photon latency.
+	*Has no hardware dependencies; the caller supplies the times, so a host build can measure replayed input. 
+  ******************************************************************************
+  */
+
+#include "latency.h"
+
+/**
+	* @brief Clear all measurements.
+*/
+void initLatency(latencyTracker* tracker){
+	uint32_t i;
+	for(i = 0; i < LATENCY_BUCKETS; i++){
+		tracker->histogram[i] = 0;
+	}
+	tracker->pending = 0;
+	tracker->count = 0;
+	tracker->dropped = 0;
+	tracker->min = 0xFFFFFFFF;
+	tracker->max = 0;
+	tracker->totalEdgeToStep = 0;
+	tracker->totalStepToPresent = 0;
+}
+
+/**
+	* @brief Mark an input that happened at edgeTime as acted on by the simulation step at stepTime. 
+	* Call only for inputs that change what is drawn, so the next frame presented is the first to show it. 
+*/
+void latencyInput(latencyTracker* tracker, uint32_t edgeTime, uint32_t stepTime){
+	if(tracker->pending == LATENCY_MAX_PENDING){
+		tracker->dropped++;
+		return;
+	}
+	tracker->edgeTime[tracker->pending] = edgeTime;
+	tracker->stepTime[tracker->pending] = stepTime;
+	tracker->pending++;
+}
+
+/**
+	* @brief A frame was presented at presentTime. Measures every pending input against it. 
+*/
+void latencyPresent(latencyTracker* tracker, uint32_t presentTime){
+	uint32_t i, latency, bucket;
+	for(i = 0; i < tracker->pending; i++){
+		latency = presentTime - tracker->edgeTime[i];
+		bucket = latency / LATENCY_BUCKET_MS;
+		bucket = (bucket >= LATENCY_BUCKETS) ? (LATENCY_BUCKETS - 1) : bucket;
+		tracker->histogram[bucket]++;
+		tracker->min = (latency < tracker->min) ? latency : tracker->min;
+		tracker->max = (latency > tracker->max) ? latency : tracker->max;
+		tracker->totalEdgeToStep += tracker->stepTime[i] - tracker->edgeTime[i];
+		tracker->totalStepToPresent += presentTime - tracker->stepTime[i];
+		tracker->count++;
+	}
+	tracker->pending = 0;
+}
+
+/**
+	* @brief Latency that percent of the measurements are at or below, rounded up to a bucket boundary. 
+	* Returns 0 if nothing has been measured.
+*/
+uint32_t latencyPercentile(const latencyTracker* tracker, uint32_t percent){
+	uint32_t i, seen = 0, target;
+	if(tracker->count == 0){return 0;}
+	/* Rank of the measurement wanted, at least the first */
+	target = (tracker->count * percent + 99) / 100;
+	target = (target == 0) ? 1 : target;
+	for(i = 0; i < LATENCY_BUCKETS; i++){
+		seen += tracker->histogram[i];
+		if(seen >= target){break;}
+	}
+	if(i >= LATENCY_BUCKETS - 1){return tracker->max;}
+	/* Upper edge of the bucket, but never beyond the longest actually seen */
+	return ((i + 1) * LATENCY_BUCKET_MS > tracker->max) ? tracker->max : (i + 1) * LATENCY_BUCKET_MS;
+}
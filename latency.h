@@ -0,0 +1,41 @@
+/**
+  ******************************************************************************
+  * @file    latency.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains a tracker for input-to-photon latency, from an input edge to the frame that shows it.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#ifndef latencyHeader
+#define latencyHeader
+
+/* Histogram resolution; latencies from LATENCY_BUCKET_MS*(LATENCY_BUCKETS-1) up all land in the last bucket */
+#define LATENCY_BUCKET_MS 2
+#define LATENCY_BUCKETS 64
+/* Inputs that can be waiting for a frame at once. Two covers a shot and explosion between renders. */
+#define LATENCY_MAX_PENDING 4
+
+/**
+	*@brief Latency tracker struct
+	*All times are system ticks in milliseconds. An input is marked when the simulation step first acts on it, 
+	*and measured when the next frame is presented.
+*/
+typedef struct{
+	uint32_t edgeTime[LATENCY_MAX_PENDING]; /** When each input not yet on screen happened */
+	uint32_t stepTime[LATENCY_MAX_PENDING]; /** When the simulation acted on it */
+	uint32_t pending; /** Inputs waiting for a frame */
+	uint32_t histogram[LATENCY_BUCKETS]; /** Edge to present latencies, LATENCY_BUCKET_MS per bucket */
+	uint32_t count; /** Latencies measured */
+	uint32_t dropped; /** Inputs not measured because too many were pending */
+	uint32_t min; /** Shortest edge to present latency */
+	uint32_t max; /** Longest edge to present latency */
+	uint32_t totalEdgeToStep; /** Sum of edge to step times; waiting for the queue to be read */
+	uint32_t totalStepToPresent; /** Sum of step to present times; waiting for, drawing and presenting the frame */
+}latencyTracker;
+
+void initLatency(latencyTracker* tracker);
+void latencyInput(latencyTracker* tracker, uint32_t edgeTime, uint32_t stepTime);
+void latencyPresent(latencyTracker* tracker, uint32_t presentTime);
+uint32_t latencyPercentile(const latencyTracker* tracker, uint32_t percent);
+#endif
@@ -54,10 +54,13 @@ void removeItem(iterator *iter, list* list){
 	* @brief Remove all items from list and free their allocated memory. 
 */
 void deleteList(list* list){
-	iterator iter = getIterator(list);
-	free(iter.cur);
-	while(getNext(&iter)){
-		free(iter.cur);
+	node *cur, *next;
+	cur = list->head;
+	//Read the next pointer before freeing, rather than stepping an iterator through freed nodes
+	while(cur != NULL){
+		next = cur->next;
+		free(cur);
+		cur = next;
 	}
 	list->head = NULL;
 }
@@ -7,6 +7,8 @@
   */
 
 #include "game.h"
+#ifndef listHeader
+#define listHeader
 
 /**
 	*@brief linked list node
@@ -40,5 +42,4 @@ void pushItem(list* list, Projectile data);
 iterator getIterator(list* list);
 void deleteList(list* list);
 void removeItem(iterator *iter, list* list);
-
-
+#endif
@@ -15,10 +15,11 @@
 	* @brief Approximate truncated integer square root. 
 	* Runs some newton-raphson iterations. 
 	* Good enough precision for when I only need an integer (such as in a circle), and much faster. 
+	* Superseded by intSqrt(), which is exact and quicker; kept as the reference for host/math_bench.c. 
 */
 uint32_t fastIntSqrt(uint32_t x){
 	uint32_t a, b, i;
-	if(x < 2) {return x;} //Avoid division by 0
+	if(x < 4) {return (x != 0);} //Avoid division by 0; x>>2 is 0 for 2 and 3 too
 	a = x>>2;
 	for(i = 0; i < 6; i++){
 		b = x/a;
@@ -27,12 +28,39 @@ uint32_t fastIntSqrt(uint32_t x){
 	return a;
 }
 
+/**
+	* @brief Exact truncated integer square root. 
+	* The FPU's single precision square root of x is within one of it, as x rounds to a float and the root rounds back; 
+	* a compare each way then makes it exact, without a branch or a division. 
+*/
+uint32_t intSqrt(uint32_t x){
+	uint32_t root = (uint32_t)sqrtf((float)x);
+	//x near 2^32 rounds to it, whose root of 65536 is one too big for root * root below
+	root -= root >> 16;
+	root -= (root * root) > x;
+	//(root + 1)^2 <= x, without overflowing at a root of 65535
+	root += (x - (root * root)) > (2 * root);
+	return root;
+}
+
+/**
+	* @brief intSqrt() of count values. out may be in. 
+*/
+void intSqrtBatch(const uint32_t* in, uint32_t* out, uint32_t count){
+	uint32_t i;
+	for(i = 0; i < count; i++){
+		out[i] = intSqrt(in[i]);
+	}
+}
+
 /**
 	* @brief Normalizes input vector to a circle
 	* Output is written to out[2]. 
+	* Single precision throughout; the FPU has a single precision square root, but double would be done in software. 
+	* A vector on an axis comes out exactly on the axis. 
 */
 void normalizeToCircle(float x, float y, float radius, float out[2]){
-	float root;
+	float scale;
 	
 	if(x == 0){
 		out[0] = 0; 
@@ -40,13 +68,13 @@ void normalizeToCircle(float x, float y, float radius, float out[2]){
 		return;
 	}
 	if(y == 0){
+		out[0] = (x<0) ? -radius : radius;
 		out[1] = 0;
-		out[1] = (x<0) ? -radius : radius;
 		return;
 	}
-	root = sqrt(x*x + y*y);
-	out[0] = (x/root)*radius;
-	out[1] = (y/root)*radius;
+	scale = radius / sqrtf(x*x + y*y);
+	out[0] = x*scale;
+	out[1] = y*scale;
 }
 
 /**
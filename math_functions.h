@@ -8,8 +8,13 @@
 
 
 #include <stdint.h>
+#ifndef mathFunctionsHeader
+#define mathFunctionsHeader
 
 uint32_t fastIntSqrt(uint32_t x);
+uint32_t intSqrt(uint32_t x);
+void intSqrtBatch(const uint32_t* in, uint32_t* out, uint32_t count);
 int32_t scaleTriangle(int32_t x, int32_t y, int32_t length);
 void normalizeToCircle(float x, float y, float radius, float out[2]);
 int isInRadius(float x0, float y0, float x1, float y1, float distance);
+#endif
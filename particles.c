@@ -0,0 +1,103 @@
+/**
+  ******************************************************************************
+  * @file    particles.c
+  * @author  David Webster - 100293854
+  * @brief   This file contains a fixed-size particle pool for explosion and debris effects.
+	*Particles are emitted in bursts, moved and faded together each frame, and drawn by drawParticles() in Render.c.
+  ******************************************************************************
+  */
+
+#include "particles.h"
+#include "trig.h"
+
+/**
+	* @brief Empty the pool and seed its random number generator.
+*/
+void initParticles(particlePool* pool, uint32_t seed){
+	pool->count = 0;
+	pool->peak = 0;
+	pool->dropped = 0;
+	prngSeed(&pool->rng, seed, 1);
+}
+
+/**
+	* @brief Emit count particles from game position (x, y), in random directions at up to speed pixels per second. 
+	* Each fades out over lifetime milliseconds. Particles that don't fit in the pool are counted in dropped. 
+*/
+void emitBurst(particlePool* pool, float x, float y, uint32_t count, int32_t speed, uint32_t lifetime, uint16_t color, uint8_t falls){
+	uint32_t i, n, r;
+	int32_t sine, cosine, v, top = (speed * (1 << PARTICLE_VELOCITY_SHIFT)) / 1000;
+	uint16_t fade = (uint16_t)((255u << 8) / ((lifetime > 0) ? lifetime : 1));
+	int32_t px = (int32_t)(x * (1 << PARTICLE_POSITION_SHIFT)), py = (int32_t)(y * (1 << PARTICLE_POSITION_SHIFT));
+
+	if(fade == 0){
+		fade = 1;
+	}
+	if(pool->count + count > PARTICLE_CAPACITY){
+		pool->dropped += pool->count + count - PARTICLE_CAPACITY;
+		count = PARTICLE_CAPACITY - pool->count;
+	}
+	for(i = 0, n = pool->count; i < count; i++, n++){
+		r = prngNext(&pool->rng);
+		//Low 16 bits pick the direction, the high bits two fractions of the top speed; their product crowds particles towards the centre
+		trigSinCosFast((int32_t)(r & 0xFFFF), &sine, &cosine);
+		v = (top * (int32_t)((r >> 16) & 0xFF) * (int32_t)((r >> 24) + 1)) >> 16;
+		pool->x[n] = px;
+		pool->y[n] = py;
+		pool->xvel[n] = (int16_t)((v * cosine) >> TRIG_SHIFT);
+		pool->yvel[n] = (int16_t)((v * sine) >> TRIG_SHIFT);
+		//Stagger lifetimes by up to a quarter, so a burst thins out rather than vanishing at once
+		pool->alpha[n] = (uint16_t)((255u << 8) - (prngNext(&pool->rng) & 0x3FFF));
+		pool->fade[n] = fade;
+		pool->color[n] = color;
+		pool->falls[n] = falls;
+	}
+	pool->count = n;
+	if(n > pool->peak){
+		pool->peak = n;
+	}
+}
+
+/**
+	* @brief Move and fade every live particle by milliseconds, then remove the ones that faded out. 
+	* The first loop has no branches, so the compiler can unroll or vectorise it. 
+*/
+void updateParticles(particlePool* pool, uint32_t milliseconds){
+	uint32_t i, n = pool->count;
+	int32_t dt = (milliseconds > PARTICLE_MAX_STEP) ? PARTICLE_MAX_STEP : (int32_t)milliseconds;
+	int32_t alpha;
+
+	for(i = 0; i < n; i++){
+		pool->yvel[i] = (int16_t)(pool->yvel[i] - (pool->falls[i] * PARTICLE_GRAVITY * dt));
+		pool->x[i] += pool->xvel[i] * dt * (1 << (PARTICLE_POSITION_SHIFT - PARTICLE_VELOCITY_SHIFT));
+		pool->y[i] += pool->yvel[i] * dt * (1 << (PARTICLE_POSITION_SHIFT - PARTICLE_VELOCITY_SHIFT));
+		alpha = (int32_t)pool->alpha[i] - (pool->fade[i] * dt);
+		pool->alpha[i] = (uint16_t)((alpha > 0) ? alpha : 0);
+	}
+
+	//Replace each dead particle with the last live one
+	i = 0;
+	while(i < n){
+		if(pool->alpha[i] != 0){
+			i++;
+			continue;
+		}
+		n--;
+		pool->x[i] = pool->x[n];
+		pool->y[i] = pool->y[n];
+		pool->xvel[i] = pool->xvel[n];
+		pool->yvel[i] = pool->yvel[n];
+		pool->alpha[i] = pool->alpha[n];
+		pool->fade[i] = pool->fade[n];
+		pool->color[i] = pool->color[n];
+		pool->falls[i] = pool->falls[n];
+	}
+	pool->count = n;
+}
+
+/**
+	* @brief Percentage of the pool in use.
+*/
+uint32_t particleOccupancy(const particlePool* pool){
+	return (pool->count * 100) / PARTICLE_CAPACITY;
+}
@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * @file    particles.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains a fixed-size particle pool for explosion and debris effects.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#include "prng.h"
+#ifndef particlesHeader
+#define particlesHeader
+
+/* Most particles alive at once; bursts beyond this are cut short */
+#define PARTICLE_CAPACITY 4096
+/* Fractional bits of particle positions, in pixels */
+#define PARTICLE_POSITION_SHIFT 16
+/* Fractional bits of particle velocities, in pixels per millisecond */
+#define PARTICLE_VELOCITY_SHIFT 12
+/* Downward acceleration of debris, in velocity units per millisecond; about 240 pixels per second per second */
+#define PARTICLE_GRAVITY 1
+/* Longest update step, in milliseconds; a stall ages the particles by no more than this */
+#define PARTICLE_MAX_STEP 100
+
+/**
+	*@brief Particle pool, struct-of-arrays.
+	*The live particles are always the first count of each array, so the update and draw loops run straight 
+	*down contiguous memory. Dead particles are replaced by the last live one. Nothing is allocated after start-up.
+*/
+typedef struct{
+	int32_t x[PARTICLE_CAPACITY]; /** Game x position, 16.16 pixels */
+	int32_t y[PARTICLE_CAPACITY]; /** Game y position, 16.16 pixels */
+	int16_t xvel[PARTICLE_CAPACITY]; /** x velocity, 4.12 pixels per millisecond */
+	int16_t yvel[PARTICLE_CAPACITY]; /** y velocity, 4.12 pixels per millisecond */
+	uint16_t alpha[PARTICLE_CAPACITY]; /** Opacity, 8.8; the particle dies when it reaches 0 */
+	uint16_t fade[PARTICLE_CAPACITY]; /** Opacity lost per millisecond, 8.8 */
+	uint16_t color[PARTICLE_CAPACITY]; /** RGB565 colour */
+	uint8_t falls[PARTICLE_CAPACITY]; /** Nonzero if gravity pulls it */
+	uint32_t count; /** Live particles */
+	uint32_t peak; /** Most live particles at once */
+	uint32_t dropped; /** Particles not emitted because the pool was full */
+	prngState rng; /** Burst directions and speeds; separate from the game's, so effects never change a replay */
+}particlePool;
+
+void initParticles(particlePool* pool, uint32_t seed);
+void emitBurst(particlePool* pool, float x, float y, uint32_t count, int32_t speed, uint32_t lifetime, uint16_t color, uint8_t falls);
+void updateParticles(particlePool* pool, uint32_t milliseconds);
+uint32_t particleOccupancy(const particlePool* pool);
+#endif
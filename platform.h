@@ -0,0 +1,94 @@
+/**
+  ******************************************************************************
+  * @file    platform.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains the interface between the game and the hardware it runs on.
+	*platform_stm32.c implements it with the STM32 HAL for the board. host/platform_linux.c implements it
+	*with simulated pins, time and display, so the whole game can run on Linux.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#ifndef platformHeader
+#define platformHeader
+
+/* Frame buffer pixel formats */
+#define PIXEL_RGB565 0
+#define PIXEL_ARGB8888 1
+/* Format of the frame buffers, fixed at build time so the drawing is compiled for it. The board's LTDC 
+ layers are RGB565; ARGB8888 is for host builds */
+#ifndef PIXEL_FORMAT
+#define PIXEL_FORMAT PIXEL_RGB565
+#endif
+
+#if(PIXEL_FORMAT == PIXEL_ARGB8888)
+typedef uint32_t pixel;
+/* An RGB565 colour as an opaque pixel, each channel's top bits repeated below it so full scale stays full */
+#define PIXEL_FROM_565(c) ((pixel)(0xFF000000u | (((c) & 0xF800u) << 8) | (((c) & 0xE000u) << 3) | (((c) & 0x07E0u) << 5) | (((c) & 0x0600u) >> 1) | (((c) & 0x001Fu) << 3) | (((c) & 0x001Cu) >> 2)))
+#else
+typedef uint16_t pixel;
+#define PIXEL_FROM_565(c) ((pixel)(c))
+#endif
+
+/* Pin mask for pin n of a port */
+#define PIN_MASK(n) ((uint16_t)(1 << (n)))
+
+/**
+	*@brief GPIO port enumerator
+*/
+enum platformPort{
+	portA, portB, portC, portD, portE, portF, portG, portH, portI, portJ, portK, PLATFORM_PORTS
+};
+
+/**
+	*@brief GPIO pin struct
+*/
+typedef struct{
+	uint8_t port; /** A platformPort */
+	uint16_t pin; /** Pin mask, from PIN_MASK() */
+}pin;
+
+/**
+	*@brief Pin mode enumerator. The interrupt modes call the pin handler on both edges.
+*/
+enum pinMode{
+	pinOutput, pinInput, pinInterrupt, pinInterruptPullUp
+};
+
+/**
+	*@brief Periodic timer enumerator
+*/
+enum platformTimer{
+	timerDebounce, /** Button debounce; shares the pin interrupts' priority, so neither preempts the other */
+	timerDisplay, /** 7-segment refresh; lower priority than the inputs */
+	PLATFORM_TIMERS
+};
+
+void platformInit(void);
+void platformIdle(void);
+uint32_t platformTick(void);
+uint32_t platformMicros(void);
+void platformDelay(uint32_t milliseconds);
+
+void platformConfigurePin(pin p, enum pinMode mode);
+uint8_t platformReadPin(pin p);
+void platformWritePin(pin p, uint8_t level);
+volatile uint32_t* platformPortSetReset(uint8_t port);
+void platformSetPinHandler(void (*handler)(uint16_t pinMask));
+void platformStartTimer(enum platformTimer timer, uint32_t rate, void (*handler)(void));
+void platformStartEncoderCounter(pin clk, pin dt);
+uint16_t platformReadEncoderCounter(void);
+
+void platformTouchInit(void);
+uint8_t platformTouchscreenPressed(void);
+
+void platformDisplayInit(void);
+pixel* platformFrameBuffer(uint32_t index);
+void platformPresent(uint32_t index);
+pixel* platformBackgroundBuffer(void);
+void platformEnableLayers(uint16_t keyColor);
+
+uint32_t platformLoadRecording(uint8_t* buffer, uint32_t size);
+uint8_t* platformCaptureBuffer(uint32_t* size);
+void platformSaveCapture(const uint8_t* data, uint32_t length);
+#endif
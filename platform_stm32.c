@@ -0,0 +1,553 @@
+/**
+  ******************************************************************************
+  * @file    platform_stm32.c 
+  * @author  David Webster - 100293854
+  * @brief   This file contains the STM32F746G Discovery implementation of platform.h, on the STM32 HAL.
+	*Owns every interrupt handler; the game registers callbacks for pin edges and timers instead. 
+	*Ignore the include chain errors the includes throw if you open the source code in uvision; it compiles fine. 
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "stm32f7xx_hal.h"
+#include "stm32746g_discovery_sdram.h"
+#include "Board_Touch.h"
+#include "GLCD_Config.h"
+#include "platform.h"
+
+#if(PIXEL_FORMAT != PIXEL_RGB565)
+#error "The LTDC layers are set up for RGB565 frame buffers"
+#endif
+
+#ifdef __RTX
+extern uint32_t os_time;
+uint32_t HAL_GetTick(void) {
+	return os_time;
+}
+#endif 
+
+#ifndef SDRAM_BASE_ADDR
+#define SDRAM_BASE_ADDR       0xC0000000
+#endif
+
+#define Buffer1_address SDRAM_BASE_ADDR
+#define Buffer2_address SDRAM_BASE_ADDR + GLCD_SIZE_X * GLCD_SIZE_Y * 2
+#define Background_address SDRAM_BASE_ADDR + GLCD_SIZE_X * GLCD_SIZE_Y * 4
+#define Capture_address SDRAM_BASE_ADDR + GLCD_SIZE_X * GLCD_SIZE_Y * 6
+//Frame capture ring, in the SDRAM past the layers
+#define CAPTURE_BUFFER_SIZE (4 * 1024 * 1024)
+
+//Priority of the input interrupts; all share it, so none can preempt another and together they act as a single event queue producer
+#define INPUT_PRIORITY 3
+//Priority of the display refresh, below the inputs
+#define DISPLAY_PRIORITY 4
+
+static GPIO_TypeDef* const ports[PLATFORM_PORTS] = {GPIOA, GPIOB, GPIOC, GPIOD, GPIOE, GPIOF, GPIOG, GPIOH, GPIOI, GPIOJ, GPIOK};
+static TIM_TypeDef* const timers[PLATFORM_TIMERS] = {TIM6, TIM7};
+static const IRQn_Type timerIRQs[PLATFORM_TIMERS] = {TIM6_DAC_IRQn, TIM7_IRQn};
+static const uint32_t timerPriorities[PLATFORM_TIMERS] = {INPUT_PRIORITY, DISPLAY_PRIORITY};
+
+static void (*pinHandler)(uint16_t pinMask); /** Called on every edge of an interrupt pin */
+static void (*timerHandlers[PLATFORM_TIMERS])(void); /** Called on every period of each timer */
+
+static pixel frame_buf_1[GLCD_WIDTH*GLCD_HEIGHT] __attribute__((at(Buffer1_address)));
+static pixel frame_buf_2[GLCD_WIDTH*GLCD_HEIGHT] __attribute__((at(Buffer2_address)));
+static pixel background_buf[GLCD_WIDTH*GLCD_HEIGHT] __attribute__((at(Background_address)));
+static uint8_t capture_buf[CAPTURE_BUFFER_SIZE] __attribute__((at(Capture_address)));
+static uint32_t frameLayer; /** LTDC layer showing the frame buffers; 1 once the background is under them */
+static uint32_t shownAddress; /** Address of the frame buffer being shown */
+static LTDC_HandleTypeDef LTDC_Handle;
+static TOUCH_STATE tsc_state; /** Touchscreen state struct */
+
+static void configureLayer(uint32_t layer, uint32_t address);
+
+/**
+* @brief System Clock Configuration, as given in the GLCD labsheet
+*/
+static void SystemClock_Config(void) {
+	RCC_OscInitTypeDef RCC_OscInitStruct;
+	RCC_ClkInitTypeDef RCC_ClkInitStruct;
+	/* Enable Power Control clock */
+	__HAL_RCC_PWR_CLK_ENABLE();
+	/* The voltage scaling allows optimizing the power
+	consumption when the device is clocked below the
+	maximum system frequency. */
+	__HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE1);
+	/* Enable HSE Oscillator and activate PLL
+	with HSE as source */
+	RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSE;
+	RCC_OscInitStruct.HSEState = RCC_HSE_ON;
+	RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
+	RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSE;
+	RCC_OscInitStruct.PLL.PLLM = 25;
+	RCC_OscInitStruct.PLL.PLLN = 336;
+	RCC_OscInitStruct.PLL.PLLP = RCC_PLLP_DIV2;
+	RCC_OscInitStruct.PLL.PLLQ = 7;
+	HAL_RCC_OscConfig(&RCC_OscInitStruct);
+	/* Select PLL as system clock source and configure
+	the HCLK, PCLK1 and PCLK2 clocks dividers */
+	RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_SYSCLK | 
+	RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+	RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+	RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
+	RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV4;
+	RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV2;
+	HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_5);
+}
+
+/**
+	* @brief Initialise the HAL and system clock, then start TIM5 free running at 1 MHz as the microsecond clock. 
+	* TIM5 is 32 bits and clocked from APB1's timer clock; with APB1 at HCLK/4 that is HCLK/2. It wraps every 71 minutes. 
+*/
+void platformInit(void){
+	HAL_Init();
+	SystemClock_Config();
+	__HAL_RCC_TIM5_CLK_ENABLE();
+	TIM5->PSC = (SystemCoreClock / 2 / 1000000) - 1;
+	TIM5->ARR = 0xFFFFFFFF;
+	TIM5->EGR = TIM_EGR_UG;
+	TIM5->CR1 = TIM_CR1_CEN;
+}
+
+/**
+	* @brief Called by the main loop when it has nothing to do. The board just spins. 
+*/
+void platformIdle(void){
+}
+
+/**
+	* @brief Milliseconds since start up. 
+*/
+uint32_t platformTick(void){
+	return HAL_GetTick();
+}
+
+/**
+	* @brief Microsecond clock. Only differences between readings are meaningful. 
+*/
+uint32_t platformMicros(void){
+	return TIM5->CNT;
+}
+
+void platformDelay(uint32_t milliseconds){
+	HAL_Delay(milliseconds);
+}
+
+/**
+	* @brief Interrupt line of a pin mask. 
+*/
+static IRQn_Type pinIRQ(uint16_t pinMask){
+	if(pinMask & 0xFC00){return EXTI15_10_IRQn;}
+	if(pinMask & 0x03E0){return EXTI9_5_IRQn;}
+	if(pinMask == GPIO_PIN_4){return EXTI4_IRQn;}
+	if(pinMask == GPIO_PIN_3){return EXTI3_IRQn;}
+	if(pinMask == GPIO_PIN_2){return EXTI2_IRQn;}
+	if(pinMask == GPIO_PIN_1){return EXTI1_IRQn;}
+	return EXTI0_IRQn;
+}
+
+/**
+	* @brief Configure a pin, enabling its port's clock. Interrupt pins trigger on both edges. 
+*/
+void platformConfigurePin(pin p, enum pinMode mode){
+	GPIO_InitTypeDef gpio;
+	//GPIOA to GPIOK enable bits are in order
+	RCC->AHB1ENR |= (RCC_AHB1ENR_GPIOAEN << p.port);
+	gpio.Pin = p.pin;
+	gpio.Speed = GPIO_SPEED_LOW;
+	gpio.Pull = (mode == pinInterruptPullUp) ? GPIO_PULLUP : GPIO_NOPULL;
+	gpio.Alternate = 0;
+	switch(mode){
+		case pinOutput:
+			gpio.Mode = GPIO_MODE_OUTPUT_PP;
+			break;
+		case pinInput:
+			gpio.Mode = GPIO_MODE_INPUT;
+			break;
+		default:
+			gpio.Mode = GPIO_MODE_IT_RISING_FALLING;
+			break;
+	}
+	HAL_GPIO_Init(ports[p.port], &gpio);
+	if((mode == pinInterrupt) || (mode == pinInterruptPullUp)){
+		HAL_NVIC_SetPriority(pinIRQ(p.pin), INPUT_PRIORITY, 0);
+		HAL_NVIC_EnableIRQ(pinIRQ(p.pin));
+	}
+}
+
+/**
+	* @brief Reads a pin straight from its input register. 
+*/
+uint8_t platformReadPin(pin p){
+	return (ports[p.port]->IDR & p.pin) ? 1 : 0;
+}
+
+void platformWritePin(pin p, uint8_t level){
+	ports[p.port]->BSRR = level ? p.pin : ((uint32_t)p.pin << 16);
+}
+
+/**
+	* @brief A port's bit set/reset register, for writing several of its pins at once. 
+*/
+volatile uint32_t* platformPortSetReset(uint8_t port){
+	return &ports[port]->BSRR;
+}
+
+/**
+	* @brief Set the function called with the pin mask on every edge of an interrupt pin. 
+*/
+void platformSetPinHandler(void (*handler)(uint16_t pinMask)){
+	pinHandler = handler;
+}
+
+/**
+	* @brief Start a timer calling handler rate times a second. 
+	* TIM6 and TIM7 are clocked the same as TIM5, and count at 1 MHz. 
+*/
+void platformStartTimer(enum platformTimer timer, uint32_t rate, void (*handler)(void)){
+	TIM_TypeDef* tim = timers[timer];
+	timerHandlers[timer] = handler;
+	if(timer == timerDebounce){__HAL_RCC_TIM6_CLK_ENABLE();}
+	else{__HAL_RCC_TIM7_CLK_ENABLE();}
+	tim->PSC = (SystemCoreClock / 2 / 1000000) - 1; //1 MHz count
+	tim->ARR = (1000000 / rate) - 1;
+	tim->EGR = TIM_EGR_UG; //load the prescaler now
+	tim->SR = 0;
+	tim->DIER = TIM_DIER_UIE;
+	tim->CR1 = TIM_CR1_CEN;
+	HAL_NVIC_SetPriority(timerIRQs[timer], timerPriorities[timer], 0);
+	HAL_NVIC_EnableIRQ(timerIRQs[timer]);
+}
+
+/**
+	* @brief Count a quadrature encoder in TIM3's encoder mode, with no interrupts. 
+	* TIM3 channels 1 and 2 are only on PC6 and PC7 (Arduino D1/D0) on the board, so clk and dt must be those. 
+*/
+void platformStartEncoderCounter(pin clk, pin dt){
+	GPIO_InitTypeDef gpio;
+	__HAL_RCC_TIM3_CLK_ENABLE();
+	RCC->AHB1ENR |= (RCC_AHB1ENR_GPIOAEN << clk.port);
+	gpio.Mode = GPIO_MODE_AF_PP;
+	gpio.Pull = GPIO_NOPULL;
+	gpio.Speed = GPIO_SPEED_LOW;
+	gpio.Alternate = GPIO_AF2_TIM3;
+	gpio.Pin = clk.pin | dt.pin;
+	HAL_GPIO_Init(ports[clk.port], &gpio);
+	TIM3->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_CC2S_0 | (0xF << 4) | (0xF << 12); //TI1 and TI2 inputs, longest input filter
+	TIM3->CCER = 0;
+	TIM3->SMCR = TIM_SMCR_SMS_0 | TIM_SMCR_SMS_1; //encoder mode 3, counting on both channels
+	TIM3->ARR = 0xFFFF;
+	TIM3->CNT = 0;
+	TIM3->CR1 = TIM_CR1_CEN;
+}
+
+/**
+	* @brief The encoder counter; wraps at 16 bits. 
+*/
+uint16_t platformReadEncoderCounter(void){
+	return (uint16_t)TIM3->CNT;
+}
+
+void platformTouchInit(void){
+	Touch_Initialize();
+}
+
+uint8_t platformTouchscreenPressed(void){
+	Touch_GetState(&tsc_state);
+	return tsc_state.pressed;
+}
+
+/**
+	*@brief Initialize the SDRAM and LCD-TFT Display Controller, showing buffer 0. 
+	*Almost identical to the version in the GLCD API; it simply initializes both buffers as well. 
+*/
+void platformDisplayInit(void){
+  GPIO_InitTypeDef         GPIO_InitStructure;
+  RCC_PeriphCLKInitTypeDef RCC_PeriphClkInitStructure;
+
+#if !defined(DATA_IN_ExtSDRAM)
+  /* Initialize the SDRAM */
+  BSP_SDRAM_Init();
+#endif
+
+	//initialise areas of SDRAM to 0
+	memset((uint16_t*)Buffer1_address, 0, GLCD_SIZE_X * GLCD_SIZE_Y * 2);
+	memset((uint16_t*)Buffer2_address, 0, GLCD_SIZE_X * GLCD_SIZE_Y * 2);
+	memset((uint16_t*)Background_address, 0, GLCD_SIZE_X * GLCD_SIZE_Y * 2);
+	
+  /* Enable GPIOs clock */
+  __HAL_RCC_GPIOE_CLK_ENABLE();
+  __HAL_RCC_GPIOG_CLK_ENABLE();
+  __HAL_RCC_GPIOI_CLK_ENABLE();
+  __HAL_RCC_GPIOJ_CLK_ENABLE();
+  __HAL_RCC_GPIOK_CLK_ENABLE();
+
+  /* GPIOs configuration */
+  /*
+   +------------------+-------------------+-------------------+
+   +                   LCD pins assignment                    +
+   +------------------+-------------------+-------------------+
+   |  LCD_R0 <-> PI15 |  LCD_G0 <-> PJ7   |  LCD_B0 <-> PE4   |
+   |  LCD_R1 <-> PJ0  |  LCD_G1 <-> PJ8   |  LCD_B1 <-> PJ13  |
+   |  LCD_R2 <-> PJ1  |  LCD_G2 <-> PJ9   |  LCD_B2 <-> PJ14  |
+   |  LCD_R3 <-> PJ2  |  LCD_G3 <-> PJ10  |  LCD_B3 <-> PJ15  |
+   |  LCD_R4 <-> PJ3  |  LCD_G4 <-> PJ11  |  LCD_B4 <-> PG12  |
+   |  LCD_R5 <-> PJ4  |  LCD_G5 <-> PK0   |  LCD_B5 <-> PK4   |
+   |  LCD_R6 <-> PJ5  |  LCD_G6 <-> PK1   |  LCD_B6 <-> PK5   |
+   |  LCD_R7 <-> PJ6  |  LCD_G7 <-> PK2   |  LCD_B7 <-> PK6   |
+   ------------------------------------------------------------
+   |  LCD_HSYNC <-> PI10         |  LCD_VSYNC <-> PI9         |
+   |  LCD_CLK   <-> PI14         |  LCD_DE    <-> PK7         |
+   |  LCD_DISP  <-> PI12 (GPIO)  |  LCD_INT   <-> PI13        |
+   ------------------------------------------------------------
+   |  LCD_SCL <-> PH7 (I2C3 SCL) | LCD_SDA <-> PH8 (I2C3 SDA) |
+   ------------------------------------------------------------
+   |  LCD_BL_CTRL <-> PK3 (GPIO) |
+   -------------------------------
+  */
+  GPIO_InitStructure.Mode = GPIO_MODE_AF_PP;
+  GPIO_InitStructure.Pull = GPIO_NOPULL;
+  GPIO_InitStructure.Speed = GPIO_SPEED_FAST;
+
+  GPIO_InitStructure.Alternate = GPIO_AF9_LTDC;
+
+  /* GPIOG configuration */
+  GPIO_InitStructure.Pin = GPIO_PIN_12;
+  HAL_GPIO_Init(GPIOG, &GPIO_InitStructure);
+
+  GPIO_InitStructure.Alternate = GPIO_AF14_LTDC;
+
+  /* GPIOE configuration */
+  GPIO_InitStructure.Pin = GPIO_PIN_4;
+  HAL_GPIO_Init(GPIOE, &GPIO_InitStructure);
+
+  /* GPIOI configuration */
+  GPIO_InitStructure.Pin = GPIO_PIN_9  | GPIO_PIN_10 | GPIO_PIN_14 | GPIO_PIN_15;
+  HAL_GPIO_Init(GPIOI, &GPIO_InitStructure);
+
+  /* GPIOJ configuration */
+  GPIO_InitStructure.Pin = GPIO_PIN_0  | GPIO_PIN_1  | GPIO_PIN_2  | GPIO_PIN_3  |
+                           GPIO_PIN_4  | GPIO_PIN_5  | GPIO_PIN_6  | GPIO_PIN_7  |
+                           GPIO_PIN_8  | GPIO_PIN_9  | GPIO_PIN_10 | GPIO_PIN_11 |
+                                         GPIO_PIN_13 | GPIO_PIN_14 | GPIO_PIN_15;
+  HAL_GPIO_Init(GPIOJ, &GPIO_InitStructure);
+
+  /* GPIOK configuration */
+  GPIO_InitStructure.Pin = GPIO_PIN_0  | GPIO_PIN_1  | GPIO_PIN_2  |
+                           GPIO_PIN_4  | GPIO_PIN_5  | GPIO_PIN_6  | GPIO_PIN_7;
+  HAL_GPIO_Init(GPIOK, &GPIO_InitStructure);
+
+  GPIO_InitStructure.Mode = GPIO_MODE_OUTPUT_PP;
+
+  /* GPIOI PI12 configuration */
+  GPIO_InitStructure.Pin = GPIO_PIN_12;
+  HAL_GPIO_Init(GPIOI, &GPIO_InitStructure);
+
+  /* GPIOK PK3 configuration */
+  GPIO_InitStructure.Pin = GPIO_PIN_3;
+  HAL_GPIO_Init(GPIOK, &GPIO_InitStructure);
+
+  /* LCD clock configuration 
+       PLLSAI_VCO Input = HSE_VALUE / PLL_M = 1MHz
+       PLLSAI_VCO Output = PLLSAI_VCO Input * PLLSAIN = 192MHz
+       PLLLCDCLK = PLLSAI_VCO Output / PLLSAIR = 192/5 = 38.4MHz
+       LTDC clock frequency = PLLLCDCLK / LTDC_PLLSAI_DIVR_4 = 38.4/4 = 9.6MHz
+  */
+  RCC_PeriphClkInitStructure.PeriphClockSelection = RCC_PERIPHCLK_LTDC;
+  RCC_PeriphClkInitStructure.PLLSAI.PLLSAIN = 192;
+  RCC_PeriphClkInitStructure.PLLSAI.PLLSAIR = 5;
+  RCC_PeriphClkInitStructure.PLLSAIDivR = RCC_PLLSAIDIVR_4;
+  HAL_RCCEx_PeriphCLKConfig(&RCC_PeriphClkInitStructure); 
+
+  // Enable the LTDC Clock
+  __HAL_RCC_LTDC_CLK_ENABLE();
+
+  // LTDC configuration
+  LTDC_Handle.Instance = LTDC;
+
+  // Configure horizontal synchronization width
+  LTDC_Handle.Init.HorizontalSync = 40;
+  // Configure vertical synchronization height
+  LTDC_Handle.Init.VerticalSync = 9;
+  // Configure accumulated horizontal back porch
+  LTDC_Handle.Init.AccumulatedHBP = 53;
+  // Configure accumulated vertical back porch
+  LTDC_Handle.Init.AccumulatedVBP = 11;
+  // Configure accumulated active width
+  LTDC_Handle.Init.AccumulatedActiveW = 533;
+  // Configure accumulated active height
+  LTDC_Handle.Init.AccumulatedActiveH = 283;
+  // Configure total width
+  LTDC_Handle.Init.TotalWidth = 565;
+  // Configure total height
+  LTDC_Handle.Init.TotalHeigh = 285;
+
+  // Configure R,G,B component values for LCD background color
+  LTDC_Handle.Init.Backcolor.Red   = 0;
+  LTDC_Handle.Init.Backcolor.Blue  = 0;
+  LTDC_Handle.Init.Backcolor.Green = 0;
+
+  // Polarity
+  LTDC_Handle.Init.HSPolarity = LTDC_HSPOLARITY_AL;
+  LTDC_Handle.Init.VSPolarity = LTDC_VSPOLARITY_AL;
+  LTDC_Handle.Init.DEPolarity = LTDC_DEPOLARITY_AL;
+  LTDC_Handle.Init.PCPolarity = LTDC_PCPOLARITY_IPC;
+    
+  HAL_LTDC_Init(&LTDC_Handle); 
+
+  configureLayer(0, Buffer1_address);
+	frameLayer = 0;
+	shownAddress = Buffer1_address;
+	
+  /* Turn display and backlight on */
+  HAL_GPIO_WritePin(GPIOI, GPIO_PIN_12, GPIO_PIN_SET);
+  HAL_GPIO_WritePin(GPIOK, GPIO_PIN_3,  GPIO_PIN_SET);
+}
+
+/**
+	*@brief Set up LTDC layer layer full screen, RGB565, showing the buffer at address. 
+	*Layer 1 is blended by pixel alpha as well as constant alpha, so colour keyed pixels are see-through. 
+*/
+static void configureLayer(uint32_t layer, uint32_t address){
+  LTDC_LayerCfgTypeDef     LTDC_LayerCfg;
+
+  LTDC_LayerCfg.WindowX0 = 0;
+  LTDC_LayerCfg.WindowX1 = GLCD_SIZE_X - 1;
+  LTDC_LayerCfg.WindowY0 = 0;
+  LTDC_LayerCfg.WindowY1 = GLCD_SIZE_Y - 1;
+  LTDC_LayerCfg.PixelFormat = LTDC_PIXEL_FORMAT_RGB565;
+  LTDC_LayerCfg.Alpha  = 255;
+  LTDC_LayerCfg.Alpha0 = 0;
+  LTDC_LayerCfg.BlendingFactor1 = layer ? LTDC_BLENDING_FACTOR1_PAxCA : LTDC_BLENDING_FACTOR1_CA;
+  LTDC_LayerCfg.BlendingFactor2 = layer ? LTDC_BLENDING_FACTOR2_PAxCA : LTDC_BLENDING_FACTOR2_CA;
+  LTDC_LayerCfg.ImageWidth  = GLCD_SIZE_X;
+  LTDC_LayerCfg.ImageHeight = GLCD_SIZE_Y;
+  LTDC_LayerCfg.Backcolor.Red   = 0;
+  LTDC_LayerCfg.Backcolor.Green = 0;
+  LTDC_LayerCfg.Backcolor.Blue  = 0;
+	LTDC_LayerCfg.FBStartAdress = address;
+  HAL_LTDC_ConfigLayer(&LTDC_Handle, &LTDC_LayerCfg, layer);
+}
+
+/**
+	* @brief The two frame buffers, in SDRAM. 
+*/
+pixel* platformFrameBuffer(uint32_t index){
+	return index ? frame_buf_2 : frame_buf_1;
+}
+
+/**
+	*@brief Show frame buffer index. 
+	*Points the LTDC's front buffer start address at it, then waits for the LCD panel's vertical synchronisation signal. 
+	*This is necessary because the LCD only switches frame buffers once it's finished drawing the current frame. 
+	*Otherwise, switching buffer then immediately writing to the buffer would change the front buffer. 
+*/
+void platformPresent(uint32_t index){
+	shownAddress = index ? Buffer2_address : Buffer1_address;
+	HAL_LTDC_SetAddress(&LTDC_Handle, shownAddress, frameLayer);
+	while(!(LTDC_Handle.Instance->CDSR & LTDC_CDSR_VSYNCS));
+}
+
+/**
+	* @brief The static background layer, in SDRAM after the frame buffers. 
+*/
+pixel* platformBackgroundBuffer(void){
+	return background_buf;
+}
+
+/**
+	*@brief Show the background buffer on LTDC layer 0 and the frame buffers over it on layer 1, 
+	*with frame buffer pixels of keyColor see-through. The LTDC blends the two as it scans out. 
+*/
+void platformEnableLayers(uint16_t keyColor){
+	//The key is compared after RGB565 is widened to RGB888, which shifts each channel up
+	uint32_t key = ((uint32_t)(keyColor >> 11) << 19) | ((uint32_t)((keyColor >> 5) & 0x3F) << 10) | ((uint32_t)(keyColor & 0x1F) << 3);
+	configureLayer(1, shownAddress);
+	HAL_LTDC_ConfigColorKeying(&LTDC_Handle, key, 1);
+	HAL_LTDC_EnableColorKeying(&LTDC_Handle, 1);
+	HAL_LTDC_SetAddress(&LTDC_Handle, Background_address, 0);
+	frameLayer = 1;
+}
+
+/**
+	* @brief Fill buffer with a recording to play back. On the board it is loaded with the debugger, so this returns size. 
+*/
+uint32_t platformLoadRecording(uint8_t* buffer, uint32_t size){
+	return size;
+}
+
+/**
+	* @brief Frame capture ring, in SDRAM after the background. Dump it with the debugger to decode it. 
+*/
+uint8_t* platformCaptureBuffer(uint32_t* size){
+	*size = CAPTURE_BUFFER_SIZE;
+	return capture_buf;
+}
+
+/**
+	* @brief There is nowhere on the board to stream a capture to, so it is dropped; capture to the ring instead. 
+*/
+void platformSaveCapture(const uint8_t* data, uint32_t length){
+}
+
+/**
+* @brief External interrupt callback; passes the pin on to the handler. 
+*/
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin){
+	if(pinHandler){
+		pinHandler(GPIO_Pin);
+	}
+}
+
+/**
+* @brief Boilerplate external interrupt request handlers, for pins 0 to 4. 
+*/
+void EXTI0_IRQHandler(void){
+	HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_0);
+}
+void EXTI1_IRQHandler(void){
+	HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_1);
+}
+void EXTI2_IRQHandler(void){
+	HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_2);
+}
+void EXTI3_IRQHandler(void){
+	HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_3);
+}
+void EXTI4_IRQHandler(void){
+	HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_4);
+}
+/**
+* @brief Boilerplate external interrupt request handler, for pins 5 to 9. Only pins with a pending interrupt call back. 
+*/
+void EXTI9_5_IRQHandler(void){
+	uint16_t i;
+	for(i = 5; i <= 9; i++){
+		HAL_GPIO_EXTI_IRQHandler(PIN_MASK(i));
+	}
+}
+/**
+* @brief Boilerplate external interrupt request handler, for pins 10 to 15. 
+*/
+void EXTI15_10_IRQHandler(void){
+	uint16_t i;
+	for(i = 10; i <= 15; i++){
+		HAL_GPIO_EXTI_IRQHandler(PIN_MASK(i));
+	}
+}
+
+/**
+* @brief Timer interrupts; pass each period on to the timer's handler. 
+*/
+void TIM6_DAC_IRQHandler(void){
+	if(TIM6->SR & TIM_SR_UIF){
+		TIM6->SR = ~TIM_SR_UIF;
+		if(timerHandlers[timerDebounce]){timerHandlers[timerDebounce]();}
+	}
+}
+void TIM7_IRQHandler(void){
+	if(TIM7->SR & TIM_SR_UIF){
+		TIM7->SR = ~TIM_SR_UIF;
+		if(timerHandlers[timerDisplay]){timerHandlers[timerDisplay]();}
+	}
+}
@@ -3,30 +3,33 @@
   * @file    poll.c 
   * @author  David Webster - 100293854
   * @brief   This file contains functions for polling the peripherals used for inputs. 
-	* Ignore the include chain errors the includes throw if you open the source code in uvision; it compiles fine. 
   ******************************************************************************
   */
 
-#include "stm32f7xx_hal.h"
-#include "stm32f7xx_hal_gpio.h"
+#include "platform.h"
+#include "debounce.h"
+#include "sevenseg.h"
 
-/**
-*@brief GPIO pin struct
-*/
-typedef struct{
-	GPIO_TypeDef *bank; /** GPIO bank */
-	uint16_t pin; /** GPIO pin */
-}pin;
+/* Rotary encoder decoding. 0 decodes both quadrature channels in the pin interrupts, 1 counts them in the platform's 
+ hardware encoder counter with no interrupts at all. On the board that is TIM3, which can only take the encoder on 
+ Arduino D1/D0 (PC6/PC7), so 1 also moves 7-segment f and g to D7/D13 (PI3/PI1). */
+#ifndef ENCODER_HARDWARE
+#define ENCODER_HARDWARE 0
+#endif
+
+//Rate the debounce timer checks for settled buttons at, in Hz
+#define DEBOUNCE_TIMER_RATE 1000
 
 /**
 *@brief Rotary encoder struct
 */
 typedef struct{
-	int32_t counter; /** Current position of the encoder */
+	int32_t counter; /** Current position of the encoder. Owned by the main loop; readEncoder() does not write it */
 	int clkPreviousState; /**Previous state of clk */
 	int dtPreviousState; /**Previous state of data */
 	pin clk; /** clk pin */
 	pin dt; /** data pin */
+	uint16_t timerCount; /** Hardware encoder count at the last read, when ENCODER_HARDWARE is set */
 }rotaryEncoderStruct;
 
 /**
@@ -35,12 +38,13 @@ typedef struct{
 typedef struct{
 	int state; /** Last read state of the button */
 	pin signal; /** Signal pin of the button */
-	int changed; /** Flag for if the last read changed state */
+	int changed; /** Set when the button changed state this tick; owned by the main loop */
+	debouncer debounce; /** Edge debouncer, driven from the pin's interrupt and the debounce timer */
 }buttonStruct;
 
 
-void initializePins(pin *sevenSegmentDisplay, buttonStruct *touchSensor, buttonStruct *button, rotaryEncoderStruct *rotaryEncoder);
+void initializePins(sevenSegmentStruct *sevenSegmentDisplay, buttonStruct *touchSensor, buttonStruct *button, rotaryEncoderStruct *rotaryEncoder);
 int32_t readEncoder(rotaryEncoderStruct* rotaryEncoder);
-int32_t readButton(buttonStruct* button);
-void sevenSegmentDisplayNumber(int number, pin* segments);
-void resetPins(int size, pin* pins);
+int32_t readEncoderTimer(rotaryEncoderStruct* rotaryEncoder);
+int32_t buttonEdge(buttonStruct* button, uint32_t now);
+int32_t buttonSettle(buttonStruct* button, uint32_t now);
@@ -0,0 +1,86 @@
+/**
+  ******************************************************************************
+  * @file    prng.c 
+  * @author  David Webster - 100293854
+  * @brief   This file contains a small seedable pseudo-random number generator with independent streams.
+	*PCG32 (XSH-RR); 64-bit state, 32-bit output. The only heavy operation is one 64-bit multiply per number. 
+  ******************************************************************************
+  */
+
+#include "prng.h"
+
+#define PCG_MULTIPLIER 6364136223846793005ULL
+
+/**
+	* @brief Seed a generator. 
+	* Generators with the same seed but different streams produce unrelated sequences. 
+*/
+void prngSeed(prngState* rng, uint32_t seed, uint32_t stream){
+	rng->state = 0;
+	rng->inc = ((uint64_t)stream << 1) | 1u;
+	prngNext(rng);
+	rng->state += seed;
+	prngNext(rng);
+}
+
+/**
+	* @brief Get the next 32-bit number in the sequence. 
+*/
+uint32_t prngNext(prngState* rng){
+	uint64_t old = rng->state;
+	uint32_t xorshifted, rot;
+	rng->state = old * PCG_MULTIPLIER + rng->inc;
+	//xorshift the high bits down, then rotate by the top 5 bits
+	xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+	rot = (uint32_t)(old >> 59);
+	return (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31));
+}
+
+/**
+	* @brief Get a number from 0 to bound-1 without modulo bias. 
+	* Scales with a 32x32->64 multiply rather than dividing. Only numbers landing in the biased 
+	* sliver below (2^32 mod bound) are redrawn, and only then is the one modulo computed. 
+	* Returns 0 if bound is 0. 
+*/
+uint32_t prngRange(prngState* rng, uint32_t bound){
+	uint64_t m;
+	uint32_t low, threshold;
+	
+	m = (uint64_t)prngNext(rng) * bound;
+	low = (uint32_t)m;
+	if(low < bound){
+		threshold = (0u - bound) % bound;
+		while(low < threshold){
+			m = (uint64_t)prngNext(rng) * bound;
+			low = (uint32_t)m;
+		}
+	}
+	return (uint32_t)(m >> 32);
+}
+
+/**
+	* @brief Fill out[count] with 32-bit numbers. 
+*/
+void prngFill(prngState* rng, uint32_t* out, uint32_t count){
+	uint64_t state = rng->state;
+	uint64_t inc = rng->inc;
+	uint32_t xorshifted, rot, i;
+	//Same as prngNext(), with the state kept in registers for the whole batch
+	for(i = 0; i < count; i++){
+		xorshifted = (uint32_t)(((state >> 18) ^ state) >> 27);
+		rot = (uint32_t)(state >> 59);
+		out[i] = (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31));
+		state = state * PCG_MULTIPLIER + inc;
+	}
+	rng->state = state;
+}
+
+/**
+	* @brief Fill out[count] with numbers from 0 to bound-1, without modulo bias. 
+*/
+void prngFillRange(prngState* rng, uint32_t* out, uint32_t count, uint32_t bound){
+	uint32_t i;
+	for(i = 0; i < count; i++){
+		out[i] = prngRange(rng, bound);
+	}
+}
@@ -0,0 +1,27 @@
+/**
+  ******************************************************************************
+  * @file    prng.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains a small seedable pseudo-random number generator with independent streams.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#ifndef prngHeader
+#define prngHeader
+
+/**
+	*@brief PCG32 generator state.
+	*Each distinct stream gives an independent sequence for the same seed, so parallel games never share numbers.
+*/
+typedef struct{
+	uint64_t state; /** Current position in the sequence */
+	uint64_t inc; /** Stream selector; always odd */
+}prngState;
+
+void prngSeed(prngState* rng, uint32_t seed, uint32_t stream);
+uint32_t prngNext(prngState* rng);
+uint32_t prngRange(prngState* rng, uint32_t bound);
+void prngFill(prngState* rng, uint32_t* out, uint32_t count);
+void prngFillRange(prngState* rng, uint32_t* out, uint32_t count, uint32_t bound);
+#endif
@@ -0,0 +1,177 @@
+/**
+  ******************************************************************************
+  * @file    replay.c
+  * @author  David Webster - 100293854
+  * @brief   This file contains functions for recording and replaying per-frame input.
+	*Has no hardware dependencies, so a stream recorded on the board can be replayed by a host build.
+  ******************************************************************************
+  */
+
+#include "replay.h"
+
+#define REPLAY_VERSION 4
+#define REPLAY_HEADER_SIZE 16
+
+//bit positions of the input flags byte
+#define FLAG_TOUCH_STATE 0x01
+#define FLAG_TOUCH_CHANGED 0x02
+#define FLAG_BUTTON_STATE 0x04
+#define FLAG_BUTTON_CHANGED 0x08
+#define FLAG_TOUCHSCREEN 0x10
+
+/**
+	* @brief Write a 32-bit value into buf, little-endian.
+*/
+static void writeWord(uint8_t* buf, uint32_t value){
+	buf[0] = (uint8_t)value;
+	buf[1] = (uint8_t)(value >> 8);
+	buf[2] = (uint8_t)(value >> 16);
+	buf[3] = (uint8_t)(value >> 24);
+}
+
+/**
+	* @brief Read a little-endian 32-bit value from buf.
+*/
+static uint32_t readWord(const uint8_t* buf){
+	return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/**
+	* @brief Begin recording into buffer. Writes the stream header.
+	* Returns 0 on success, or -1 if the buffer is too small to hold the header.
+*/
+int32_t startRecording(replayStream* stream, uint8_t* buffer, uint32_t size, int32_t seed, uint32_t tick){
+	stream->mode = replayOff;
+	if(size < REPLAY_HEADER_SIZE){return -1;}
+	stream->buffer = buffer;
+	stream->size = size;
+	stream->seed = seed;
+	stream->lastTick = tick;
+	buffer[0] = 'A';
+	buffer[1] = 'R';
+	buffer[2] = REPLAY_VERSION;
+	buffer[3] = 0;
+	writeWord(&buffer[4], (uint32_t)seed);
+	writeWord(&buffer[8], tick);
+	writeWord(&buffer[12], REPLAY_HEADER_SIZE);
+	stream->pos = REPLAY_HEADER_SIZE;
+	stream->mode = replayRecord;
+	return 0;
+}
+
+/**
+	* @brief Append one frame of input to a recording stream.
+	* Returns 0 on success, or -1 if the stream is not recording or is full. A full stream stops recording.
+*/
+int32_t recordFrame(replayStream* stream, const inputFrame* input){
+	uint8_t frame[9];
+	uint32_t delta, len, i;
+	int32_t counter;
+
+	if(stream->mode != replayRecord){return -1;}
+
+	//Encoder counter is clamped to +-COUNTERMAX by the game, so it always fits a signed 16-bit value
+	counter = input->encoderCounter;
+	counter = (counter > 32767) ? 32767 : counter;
+	counter = (counter < -32768) ? -32768 : counter;
+	frame[0] = (uint8_t)counter;
+	frame[1] = (uint8_t)((uint32_t)counter >> 8);
+	frame[2] = (input->touchSensorState ? FLAG_TOUCH_STATE : 0) |
+		(input->touchSensorChanged ? FLAG_TOUCH_CHANGED : 0) |
+		(input->buttonState ? FLAG_BUTTON_STATE : 0) |
+		(input->buttonChanged ? FLAG_BUTTON_CHANGED : 0) |
+		(input->touchscreenPressed ? FLAG_TOUCHSCREEN : 0);
+
+	len = 3;
+	if(input->touchSensorChanged){
+		frame[len++] = input->touchSensorEdgeAge;
+	}
+
+	//Tick delta as a varint; 7 bits per byte, top bit set if another byte follows
+	delta = input->tick - stream->lastTick;
+	do{
+		frame[len] = (uint8_t)(delta & 0x7F);
+		delta >>= 7;
+		if(delta){frame[len] |= 0x80;}
+		len++;
+	}while(delta);
+
+	if(stream->pos + len > stream->size){
+		stream->mode = replayOff;
+		return -1;
+	}
+	for(i = 0; i < len; i++){
+		stream->buffer[stream->pos++] = frame[i];
+	}
+	writeWord(&stream->buffer[12], stream->pos);
+	stream->lastTick = input->tick;
+	return 0;
+}
+
+/**
+	* @brief Begin playing back a recorded stream held in a buffer of length bytes.
+	* Plays back up to the length stored in the header, or the end of the buffer if that is shorter.
+	* Returns 0 on success, or -1 if the header is missing or from a different version.
+	* The recorded seed is left in stream->seed, to be restored by the caller.
+*/
+int32_t startPlayback(replayStream* stream, uint8_t* buffer, uint32_t length){
+	stream->mode = replayOff;
+	if(length < REPLAY_HEADER_SIZE){return -1;}
+	if((buffer[0] != 'A') || (buffer[1] != 'R') || (buffer[2] != REPLAY_VERSION)){return -1;}
+	stream->buffer = buffer;
+	stream->size = readWord(&buffer[12]);
+	stream->size = (stream->size > length) ? length : stream->size;
+	stream->seed = (int32_t)readWord(&buffer[4]);
+	stream->lastTick = readWord(&buffer[8]);
+	stream->pos = REPLAY_HEADER_SIZE;
+	stream->mode = replayPlayback;
+	return 0;
+}
+
+/**
+	* @brief Read the next frame of input from a playback stream.
+	* Returns 0 on success, or -1 at the end of the stream or on a truncated frame. Playback stops when this fails.
+*/
+int32_t readFrame(replayStream* stream, inputFrame* input){
+	uint32_t delta, shift;
+	uint8_t flags, byte;
+
+	if(stream->mode != replayPlayback){return -1;}
+	if(stream->pos + 4 > stream->size){
+		stream->mode = replayOff;
+		return -1;
+	}
+
+	input->encoderCounter = (int16_t)(stream->buffer[stream->pos] | (stream->buffer[stream->pos + 1] << 8));
+	stream->pos += 2;
+	flags = stream->buffer[stream->pos++];
+	input->touchSensorState = (flags & FLAG_TOUCH_STATE) ? 1 : 0;
+	input->touchSensorChanged = (flags & FLAG_TOUCH_CHANGED) ? 1 : 0;
+	input->buttonState = (flags & FLAG_BUTTON_STATE) ? 1 : 0;
+	input->buttonChanged = (flags & FLAG_BUTTON_CHANGED) ? 1 : 0;
+	input->touchscreenPressed = (flags & FLAG_TOUCHSCREEN) ? 1 : 0;
+	input->touchSensorEdgeAge = 0;
+	if(input->touchSensorChanged){
+		if(stream->pos >= stream->size){
+			stream->mode = replayOff;
+			return -1;
+		}
+		input->touchSensorEdgeAge = stream->buffer[stream->pos++];
+	}
+
+	delta = 0;
+	shift = 0;
+	do{
+		if((stream->pos >= stream->size) || (shift > 28)){
+			stream->mode = replayOff;
+			return -1;
+		}
+		byte = stream->buffer[stream->pos++];
+		delta |= (uint32_t)(byte & 0x7F) << shift;
+		shift += 7;
+	}while(byte & 0x80);
+
+	stream->lastTick += delta;
+	input->tick = stream->lastTick;
+	return 0;
+}
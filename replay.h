@@ -0,0 +1,56 @@
+/**
+  ******************************************************************************
+  * @file    replay.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains structs and functions for recording and replaying per-frame input.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#ifndef replayHeader
+#define replayHeader
+
+/**
+	*@brief Snapshot of every input the game reads in one simulation tick.
+	*Everything that makes two runs differ goes through here, so a recorded stream of these reproduces a session exactly.
+*/
+typedef struct{
+	int32_t encoderCounter; /** Rotary encoder counter in aim units, after clamping */
+	uint8_t touchSensorState; /** Last read state of the touch sensor */
+	uint8_t touchSensorChanged; /** Flag for if the touch sensor changed state this frame */
+	uint8_t touchSensorEdgeAge; /** Milliseconds between the touch sensor edge and tick, up to 255 */
+	uint8_t buttonState; /** Last read state of the user button */
+	uint8_t buttonChanged; /** Flag for if the user button changed state this frame */
+	uint8_t touchscreenPressed; /** Touchscreen pressed flag */
+	uint32_t tick; /** System tick when the inputs were read */
+}inputFrame;
+
+/**
+	*@brief Replay stream mode enumerator
+*/
+enum replayMode{
+	replayOff, replayRecord, replayPlayback
+};
+
+/**
+	*@brief Replay stream struct
+	*Reads or writes a compact binary stream of inputFrames in a caller-owned buffer.
+	*The stream starts with a 16 byte header: "AR", a version byte, a reserved byte, then the little-endian seed, initial tick and stream length.
+	*The length is rewritten after every frame, so a recording cut short by a reset or a debugger halt can still be played back.
+	*Each frame is then the little-endian 16-bit encoder counter, an input flags byte, the touch sensor edge age byte 
+	*if it changed, and the tick delta as a 7-bit varint; 4 bytes for most frames at rates above 8 Hz.
+*/
+typedef struct{
+	uint8_t *buffer; /** Stream data */
+	uint32_t size; /** Capacity of buffer, in bytes */
+	uint32_t pos; /** Current read/write position */
+	uint32_t lastTick; /** Tick of the previous frame, for delta encoding */
+	int32_t seed; /** Random seed recorded at the start of the stream */
+	enum replayMode mode; /** What the stream is currently doing */
+}replayStream;
+
+int32_t startRecording(replayStream* stream, uint8_t* buffer, uint32_t size, int32_t seed, uint32_t tick);
+int32_t recordFrame(replayStream* stream, const inputFrame* input);
+int32_t startPlayback(replayStream* stream, uint8_t* buffer, uint32_t length);
+int32_t readFrame(replayStream* stream, inputFrame* input);
+#endif
@@ -0,0 +1,133 @@
+/**
+  ******************************************************************************
+  * @file    sevenseg.c 
+  * @author  David Webster - 100293854
+  * @brief   This file contains a multiplexed seven-segment display driver that writes whole GPIO banks at once.
+	*Has no HAL dependency; it is given each segment's BSRR register and pin mask, so the writes can be 
+	*checked against mock registers on a host. 
+  ******************************************************************************
+  */
+
+#include <stddef.h>
+#include "sevenseg.h"
+//segmentPatterns, the lit segments of each pattern, are generated into flash from glyph descriptions
+#include "tables.h"
+
+/**
+	* @brief Write pattern to the display, unless it is already showing. 
+*/
+static void showPattern(sevenSegmentStruct* display, int32_t pattern){
+	uint32_t i;
+	if(pattern == display->shown){return;}
+	for(i = 0; i < display->banks; i++){
+		SEVEN_SEGMENT_WRITE(display->bsrr[i], display->masks[pattern][i]);
+	}
+	display->shown = pattern;
+}
+
+/**
+	* @brief Build the per-bank BSRR words for every pattern. 
+	*@param bsrr BSRR register of the bank each segment is on, from a to g. 
+	*@param pins Pin mask of each segment, from a to g. 
+	* Segments sharing a register are grouped, so each bank is written once per change. Pins must already be outputs. 
+	* Starts with no digits; add them with sevenSegmentAddDigit(). 
+*/
+void initSevenSegment(sevenSegmentStruct* display, volatile uint32_t* const* bsrr, const uint16_t* pins){
+	uint32_t segment, bank, pattern;
+	display->banks = 0;
+	for(bank = 0; bank < SEVEN_SEGMENT_MAX_BANKS; bank++){
+		for(pattern = 0; pattern < SEVEN_SEGMENT_PATTERNS; pattern++){
+			display->masks[pattern][bank] = 0;
+		}
+	}
+	for(segment = 0; segment < 7; segment++){
+		//Find this segment's bank, or add it
+		for(bank = 0; (bank < display->banks) && (display->bsrr[bank] != bsrr[segment]); bank++);
+		if(bank == display->banks){
+			display->bsrr[display->banks++] = bsrr[segment];
+		}
+		//Low half of BSRR sets a pin, high half resets it
+		for(pattern = 0; pattern < SEVEN_SEGMENT_PATTERNS; pattern++){
+			if(segmentPatterns[pattern] & (1 << segment)){
+				display->masks[pattern][bank] |= pins[segment];
+			}
+			else{
+				display->masks[pattern][bank] |= (uint32_t)pins[segment] << 16;
+			}
+		}
+	}
+	display->digits = 0;
+	display->current = 0;
+	display->shown = -1;
+}
+
+/**
+	* @brief Add a digit, to the right of any already added. 
+	*@param bsrr BSRR register of the digit's select pin, or NULL for a single digit that is always selected. 
+	*@param pin Pin mask of the select pin. 
+	*@param activeHigh 1 if the digit is lit with its select pin high, 0 if low. 
+	* The select pin must already be an output. Does nothing if SEVEN_SEGMENT_MAX_DIGITS are already added. 
+*/
+void sevenSegmentAddDigit(sevenSegmentStruct* display, volatile uint32_t* bsrr, uint16_t pin, uint8_t activeHigh){
+	uint32_t digit = display->digits;
+	if(digit == SEVEN_SEGMENT_MAX_DIGITS){return;}
+	display->digitBsrr[digit] = bsrr;
+	display->digitOn[digit] = activeHigh ? pin : ((uint32_t)pin << 16);
+	display->digitOff[digit] = activeHigh ? ((uint32_t)pin << 16) : pin;
+	display->buffer[digit] = SEVEN_SEGMENT_BLANK;
+	if(bsrr != NULL){
+		SEVEN_SEGMENT_WRITE(bsrr, display->digitOff[digit]);
+	}
+	display->digits++;
+}
+
+/**
+	* @brief Displays number on the 7-segment display, right-aligned without leading zeroes. 
+	* Negative numbers show 0, and numbers too wide for the display show all nines. 
+	* Only writes the digit buffer; the refresh interrupt puts it on the pins. The digits are written one at a time, 
+	* so a refresh in between may light one digit of the old number, for one refresh period. 
+*/
+void sevenSegmentDisplayNumber(sevenSegmentStruct* display, int32_t number){
+	uint32_t value = (number < 0) ? 0 : (uint32_t)number;
+	uint32_t digit = display->digits;
+	uint32_t max = 1;
+	for(; digit > 0; digit--){
+		max *= 10;
+	}
+	value = (value >= max) ? (max - 1) : value;
+	for(digit = display->digits; digit > 0; digit--){
+		//Always show the units, even for 0
+		display->buffer[digit - 1] = ((value != 0) || (digit == display->digits)) ? (uint8_t)(value % 10) : SEVEN_SEGMENT_BLANK;
+		value /= 10;
+	}
+}
+
+/**
+	* @brief Turns every segment off, from the next refresh. 
+*/
+void sevenSegmentBlank(sevenSegmentStruct* display){
+	uint32_t digit;
+	for(digit = 0; digit < display->digits; digit++){
+		display->buffer[digit] = SEVEN_SEGMENT_BLANK;
+	}
+}
+
+/**
+	* @brief Light the next digit. Call from a timer interrupt at SEVEN_SEGMENT_REFRESH_RATE times the number of digits. 
+	* The lit digit is deselected before the segments change, so no digit shows another's pattern. 
+	* With one always-selected digit, the pins are only written when the buffer changes. 
+*/
+void sevenSegmentRefresh(sevenSegmentStruct* display){
+	uint32_t next;
+	if(display->digits == 0){return;}
+	next = display->current + 1;
+	next = (next == display->digits) ? 0 : next;
+	if(display->digitBsrr[display->current] != NULL){
+		SEVEN_SEGMENT_WRITE(display->digitBsrr[display->current], display->digitOff[display->current]);
+	}
+	showPattern(display, display->buffer[next]);
+	if(display->digitBsrr[next] != NULL){
+		SEVEN_SEGMENT_WRITE(display->digitBsrr[next], display->digitOn[next]);
+	}
+	display->current = next;
+}
@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    sevenseg.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains a multiplexed seven-segment display driver that writes whole GPIO banks at once.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#ifndef sevenSegmentHeader
+#define sevenSegmentHeader
+
+/* Most GPIO banks the seven segments can be spread over */
+#define SEVEN_SEGMENT_MAX_BANKS 7
+/* Patterns held per bank; the digits 0-9, then blank */
+#define SEVEN_SEGMENT_PATTERNS 11
+#define SEVEN_SEGMENT_BLANK 10
+/* Most digits that can be multiplexed */
+#define SEVEN_SEGMENT_MAX_DIGITS 8
+/* Times a second each digit is lit. The refresh interrupt runs at this times the number of digits. */
+#define SEVEN_SEGMENT_REFRESH_RATE 200
+
+/* Register write used for every BSRR access. A host build can define this first to watch the writes. */
+#ifndef SEVEN_SEGMENT_WRITE
+#define SEVEN_SEGMENT_WRITE(reg, value) (*(reg) = (value))
+#endif
+
+/**
+	*@brief Seven-segment display struct
+	*Digits share the segment pins and each has a select pin; a timer interrupt lights them one at a time from buffer. 
+	*The main loop only writes buffer, so it never waits on GPIO. 
+	*Holds each bank's BSRR word for every pattern, so showing a digit is one write per bank, setting the lit 
+	*segments and resetting the rest together. Segment pins are not written if the pattern is already showing. 
+*/
+typedef struct{
+	volatile uint32_t* bsrr[SEVEN_SEGMENT_MAX_BANKS]; /** BSRR register of each segment bank used */
+	uint32_t masks[SEVEN_SEGMENT_PATTERNS][SEVEN_SEGMENT_MAX_BANKS]; /** BSRR word per pattern, per bank */
+	uint32_t banks; /** Number of segment banks used */
+	volatile uint32_t* digitBsrr[SEVEN_SEGMENT_MAX_DIGITS]; /** BSRR register of each digit's select pin, or NULL if always selected */
+	uint32_t digitOn[SEVEN_SEGMENT_MAX_DIGITS]; /** BSRR word selecting each digit */
+	uint32_t digitOff[SEVEN_SEGMENT_MAX_DIGITS]; /** BSRR word deselecting each digit */
+	uint32_t digits; /** Number of digits */
+	volatile uint8_t buffer[SEVEN_SEGMENT_MAX_DIGITS]; /** Pattern for each digit, most significant first. Written by the main loop. */
+	uint32_t current; /** Digit lit now. Only used by the refresh interrupt. */
+	int32_t shown; /** Pattern on the segment pins, or -1 if unknown. Only used by the refresh interrupt. */
+}sevenSegmentStruct;
+
+void initSevenSegment(sevenSegmentStruct* display, volatile uint32_t* const* bsrr, const uint16_t* pins);
+void sevenSegmentAddDigit(sevenSegmentStruct* display, volatile uint32_t* bsrr, uint16_t pin, uint8_t activeHigh);
+void sevenSegmentDisplayNumber(sevenSegmentStruct* display, int32_t number);
+void sevenSegmentBlank(sevenSegmentStruct* display);
+void sevenSegmentRefresh(sevenSegmentStruct* display);
+#endif
@@ -0,0 +1,203 @@
+/**
+  ******************************************************************************
+  * @file    simulation.c
+  * @author  David Webster - 100293854
+  * @brief   This file contains the game logic, separated from input polling and rendering.
+	*step() makes no Render.c or HAL calls, so it can be run headless at far above the frame rate.
+  ******************************************************************************
+  */
+
+#include <stddef.h>
+#include "simulation.h"
+#include "math_functions.h"
+#include "trig.h"
+
+/**
+	* @brief Reset sim to the start screen, with the default difficulty.
+	* The difficulty fields may be changed afterwards; they are read whenever a game starts or a meteor spawns.
+	* Seeds stream 0 of the generator; reseed sim->rng with prngSeed() to run games side by side on independent streams.
+	* sim->enemyList must be empty or already valid; any meteors left in it are freed.
+*/
+void initGame(gameState* sim, uint32_t seed){
+	deleteList(&sim->enemyList);
+	sim->state = start;
+	sim->bullet = shoot(10, 10, 131, 0, 0);
+	sim->enemiesRemaining = 0;
+	sim->explosionTimer = 0;
+	sim->enemyTimer = 0;
+	prngSeed(&sim->rng, seed, 0);
+	sim->wasTouched = 0;
+	sim->aimAngle = 0;
+	sim->aimPos = 136;
+	sim->events = 0;
+	sim->destroyedCount = 0;
+	sim->meteorCount = DEFAULT_METEOR_COUNT;
+	sim->spawnInterval = DEFAULT_SPAWN_INTERVAL;
+	sim->meteorSpeedMin = DEFAULT_METEOR_SPEED_MIN;
+	sim->meteorSpeedRange = DEFAULT_METEOR_SPEED_RANGE;
+}
+
+/**
+	* @brief Start screen logic. Starts the game on a new touch.
+*/
+static void stepStart(gameState* sim, const inputFrame* input){
+	/* Stir the generator every tick spent waiting, so how long the player takes to touch picks the game */
+	prngNext(&sim->rng);
+	/* Wait for touch to be released */
+	if(sim->wasTouched && !input->touchscreenPressed){
+		sim->wasTouched = 0;
+	}
+	if(input->touchscreenPressed && !sim->wasTouched){
+		/* Initialise game variables, set state to game */
+		sim->state = game;
+		sim->bullet = shoot(10, 10, 131, 0, 0);
+		deleteList(&sim->enemyList);
+		sim->enemiesRemaining = sim->meteorCount;
+		sim->explosionTimer = 0;
+		sim->enemyTimer = FIRST_SPAWN_DELAY;
+		sim->events |= EVENT_GAME_STARTED;
+	}
+}
+
+/**
+	* @brief Win and lose screen logic. Returns to the start screen on touch.
+*/
+static void stepEnd(gameState* sim, const inputFrame* input){
+	if(input->touchscreenPressed){
+		sim->state = start;
+		sim->wasTouched = 1;
+	}
+}
+
+/**
+	* @brief Game logic; moves projectiles, spawns meteors, handles shooting and exploding, and checks win/lose conditions.
+*/
+static void stepPlaying(gameState* sim, const inputFrame* input){
+	int32_t spawnX, targetX, speed, sine, cosine;
+	iterator enemyIter;
+	Projectile *curEnemy;
+
+	/* Get aim angle. Every encoder step turns the gun by the same angle, wherever it points. 
+	 The reticule goes where the gun's line crosses AIM_HEIGHT. */
+	sim->aimAngle = input->encoderCounter * AIM_ANGLE_UNIT;
+	trigSinCos(sim->aimAngle, &sine, &cosine);
+	sim->aimPos = 136 + (AIM_HEIGHT * sine) / cosine;
+
+	/* Move projectiles */
+
+	/* Bounce player bullet; not fully implemented, as the trail will follow it, but better than segfaulting. */
+	if(sim->bullet.xpos<5 || sim->bullet.xpos > 267){
+		sim->bullet.xvel = -sim->bullet.xvel;
+	}
+	/* Move player bullet one tick */
+	move(&sim->bullet, SIM_RATE);
+
+	/* Move enemy bullets */
+	enemyIter = getIterator(&sim->enemyList);
+	while((curEnemy = getNext(&enemyIter)) != NULL){
+		move(curEnemy, SIM_RATE);
+	}
+
+	/* Meteor shooting */
+
+	/* Shoot a meteor if there are enemies remaining, and either the button is pressed or the timer has elapsed*/
+	if((sim->enemiesRemaining!=0) && ((input->buttonChanged && input->buttonState) ||
+		(sim->enemyTimer < 0))){
+		/** Pick where the meteor starts, where along the bottom it heads for, and its speed */
+		spawnX = (int32_t)prngRange(&sim->rng, 260);
+		targetX = (int32_t)prngRange(&sim->rng, 272);
+		speed = sim->meteorSpeedMin + (int32_t)prngRange(&sim->rng, sim->meteorSpeedRange);
+		/** Create the new meteor, add it to the list*/
+		pushItem(&sim->enemyList, shoot(spawnX-targetX, 480, spawnX+6, 478, -speed));
+		sim->enemiesRemaining--; /**Decrement remaining enemies */
+		sim->enemyTimer = sim->spawnInterval; /** Start timer to spawn next meteor */
+		sim->events |= EVENT_METEOR_SPAWNED;
+	}
+	sim->enemyTimer--; /**Decrement timer to spawn next meteor */
+
+	/* Player gun */
+	if(sim->explosionTimer != 0){
+		/* Move the player bullet under the turret when the explosion ends */
+		if(!(--sim->explosionTimer)){
+			sim->bullet.xpos = 136; sim->bullet.ypos = 0;
+			/* Teleport, rather than sliding there when interpolated */
+			sim->bullet.xpos_prev = 136; sim->bullet.ypos_prev = 0;
+		}
+	}
+	else if(input->touchSensorChanged != 0){ /* If not already exploding */
+		if(input->touchSensorState != 0){ /* Shoot on a rising edge */
+			sim->bullet = shootAngle(sim->aimAngle, 136, 7, 150);
+			/* Catch up to where it would be had it been fired at the edge, not at this tick */
+			advance(&sim->bullet, input->touchSensorEdgeAge);
+			sim->events |= EVENT_SHOT;
+		}
+		else{ /* Explode on a falling edge */
+			/* Explode where the bullet was at the edge, then stop its movement */
+			advance(&sim->bullet, -(int32_t)input->touchSensorEdgeAge);
+			sim->bullet.xpos_prev = sim->bullet.xpos; sim->bullet.ypos_prev = sim->bullet.ypos;
+			sim->bullet.xvel = 0; sim->bullet.yvel = 0;
+
+			/* Check for and remove destroyed meteors */
+			enemyIter = getIterator(&sim->enemyList);
+			while((curEnemy = getNext(&enemyIter)) != NULL){
+				/* If a meteor is in the explosion radius, remove it */
+				if(isInRadius(curEnemy->xpos, curEnemy->ypos, sim->bullet.xpos, sim->bullet.ypos, BULLET_EXPLOSION_RADIUS)){
+					if(sim->destroyedCount < MAX_REPORTED_DESTROYED){
+						sim->destroyedX[sim->destroyedCount] = curEnemy->xpos;
+						sim->destroyedY[sim->destroyedCount] = curEnemy->ypos;
+						sim->destroyedCount++;
+					}
+					sim->events |= EVENT_METEOR_DESTROYED;
+					removeItem(&enemyIter, &sim->enemyList);
+				}
+			}
+
+			/* Set one second timer of explosion effect */
+			sim->explosionTimer = EXPLOSION_TICKS;
+			sim->events |= EVENT_EXPLODED;
+		}
+	}
+
+	/* Check victory and defeat conditions */
+
+	enemyIter = getIterator(&sim->enemyList);
+	/* Check if enemy list is empty */
+	curEnemy = getNext(&enemyIter);
+	if(curEnemy == NULL){
+		if(sim->enemiesRemaining == 0){ /** If so and none are remaining, the player has won */
+			sim->state = win;
+			sim->events |= EVENT_GAME_OVER;
+		}
+	}
+	else{
+		/* Otherwise, check none are less than 20 pixels off the bottom of the screen.
+		If one is, the player loses. */
+		do{
+			if(curEnemy->ypos <= 20){
+				sim->state = lose;
+				sim->events |= EVENT_GAME_OVER;
+			}
+		}while((curEnemy = getNext(&enemyIter)) != NULL);
+	}
+}
+
+/**
+	* @brief Advance the game by one tick, 1/SIM_RATE seconds, using input.
+	* Clears sim->events, then raises EVENT_ flags for anything the caller needs to act on.
+*/
+void step(gameState* sim, const inputFrame* input){
+	sim->events = 0;
+	sim->destroyedCount = 0;
+	switch(sim->state){
+		case start:
+			stepStart(sim, input);
+			break;
+		case game:
+			stepPlaying(sim, input);
+			break;
+		case lose:
+		case win:
+			stepEnd(sim, input);
+			break;
+	}
+}
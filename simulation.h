@@ -0,0 +1,82 @@
+/**
+  ******************************************************************************
+  * @file    simulation.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains the game state struct and the functions that advance it.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#ifndef simulationHeader
+#define simulationHeader
+
+#include "game.h"
+#include "list.h"
+#include "replay.h"
+#include "prng.h"
+
+/* Aim units per encoder step at rest, before sub-step counting and acceleration. The encoder counter is in aim units. */
+#define AIM_STEP 15
+#define COUNTERMAX (10*AIM_STEP)
+/* Turret angle per aim unit, as a binary angle; COUNTERMAX aims about 43 degrees either side of straight up */
+#define AIM_ANGLE_UNIT 52
+/* Height the reticule is drawn at */
+#define AIM_HEIGHT 160
+#define BULLET_EXPLOSION_RADIUS 60
+#define BULLET_RADIUS 10
+
+/* Simulation ticks per second. Independent of the render rate; all timers below count ticks. */
+#define SIM_RATE 120
+
+/* Default difficulty, as tuned on the board */
+#define DEFAULT_METEOR_COUNT 9
+#define DEFAULT_SPAWN_INTERVAL (10*SIM_RATE)
+#define FIRST_SPAWN_DELAY (2*SIM_RATE)
+#define EXPLOSION_TICKS (SIM_RATE)
+#define DEFAULT_METEOR_SPEED_MIN 20
+#define DEFAULT_METEOR_SPEED_RANGE 60
+
+/* Flags set in gameState.events by step(), for side effects outside the simulation */
+#define EVENT_GAME_STARTED 0x01 /** The start screen was left; the encoder should be re-centred */
+#define EVENT_SHOT 0x02 /** The player bullet was fired */
+#define EVENT_EXPLODED 0x04 /** The player bullet exploded */
+#define EVENT_METEOR_SPAWNED 0x08 /** A meteor was shot */
+#define EVENT_GAME_OVER 0x10 /** The game was won or lost; the 7-segment display should be cleared */
+#define EVENT_METEOR_DESTROYED 0x20 /** Meteors were caught in the explosion; where is in destroyedX and destroyedY */
+
+/* Most destroyed meteors whose positions one step reports; any more still count, but aren't placed */
+#define MAX_REPORTED_DESTROYED 16
+
+/** Enumerator representing the different screens */
+enum stateEnum{
+	start, game, lose, win
+};
+
+/**
+	*@brief Everything the game needs to advance by one tick.
+	*Contains no hardware or rendering state, so any number of these can be stepped independently.
+*/
+typedef struct{
+	enum stateEnum state; /** Current screen */
+	Projectile bullet; /** Player bullet */
+	list enemyList; /** Live meteors */
+	int enemiesRemaining; /** Meteors left to spawn */
+	int explosionTimer; /** Ticks of explosion effect left */
+	int enemyTimer; /** Ticks until the next meteor spawns */
+	prngState rng; /** Meteor spawn random number generator */
+	int wasTouched; /** Set until the touchscreen is released after leaving the win/lose screen */
+	int32_t aimAngle; /** Turret angle from straight up, positive to the right, as a binary angle */
+	int32_t aimPos; /** X position the turret is aiming at, at AIM_HEIGHT */
+	uint32_t events; /** EVENT_ flags raised by the last step */
+	int destroyedCount; /** Meteors destroyed by the last step with their positions reported */
+	float destroyedX[MAX_REPORTED_DESTROYED]; /** Where each was destroyed */
+	float destroyedY[MAX_REPORTED_DESTROYED];
+	int meteorCount; /** Meteors per game */
+	int spawnInterval; /** Ticks between timed meteor spawns */
+	int meteorSpeedMin; /** Slowest meteor speed, in pixels per second */
+	int meteorSpeedRange; /** Meteor speeds are meteorSpeedMin up to meteorSpeedMin + meteorSpeedRange - 1 */
+}gameState;
+
+void initGame(gameState* sim, uint32_t seed);
+void step(gameState* sim, const inputFrame* input);
+#endif
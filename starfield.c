@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file    starfield.c
+  * @author  David Webster - 100293854
+  * @brief   This file contains a scrolling, layered starfield for the game's background.
+	*Stars are placed once, spread evenly over the columns at random heights, then all scroll down together each frame 
+	*at their layer's speed. 
+	*They are drawn by clearScreenStars() in Render.c in place of clearScreen().
+  ******************************************************************************
+  */
+
+#include "starfield.h"
+#include "prng.h"
+
+/* Screen height in pixels, GLCD_HEIGHT in portrait; speeds are fractions of it */
+#define STAR_SCREEN_HEIGHT 480
+
+/* Each layer's speed in pixels per second, colour, and share of the stars out of 6. Most stars are far away. */
+static const uint32_t layerSpeed[STAR_LAYERS] = {6, 16, 40};
+static const uint16_t layerColor[STAR_LAYERS] = {0x31A6, 0x7BEF, 0xDEFB};
+static const uint8_t layerShare[STAR_LAYERS] = {3, 2, 1};
+
+/**
+	* @brief Fill field with count stars, sorted by column. count is cut to STAR_CAPACITY. 
+	* Star i goes in column i % STAR_COLUMNS, so every column holds the same number give or take one: clearScreenStars() 
+	* then does the same work on every row, and its loop over a row's stars is not mispredicted as random counts made it. 
+	* Heights and layers come from the seed's stream. 
+*/
+void initStars(starfield* field, uint32_t count, uint32_t seed){
+	prngState stars;
+	uint32_t i, x, n, layer, pick, shares = 0;
+
+	if(count > STAR_CAPACITY){
+		count = STAR_CAPACITY;
+	}
+	for(layer = 0; layer < STAR_LAYERS; layer++){
+		shares += layerShare[layer];
+	}
+	field->count = count;
+	for(x = 0; x <= STAR_COLUMNS; x++){
+		field->columnStarts[x] = 0;
+	}
+	for(i = 0; i < count; i++){
+		field->columnStarts[i % STAR_COLUMNS]++;
+	}
+	//Turn the counts into the end of each column, then fill each column from its end back to its start
+	for(x = 1; x < STAR_COLUMNS; x++){
+		field->columnStarts[x] += field->columnStarts[x - 1];
+	}
+	field->columnStarts[STAR_COLUMNS] = (uint16_t)count;
+	prngSeed(&stars, seed, 3);
+	for(i = 0; i < count; i++){
+		n = --field->columnStarts[i % STAR_COLUMNS];
+		pick = prngRange(&stars, shares);
+		for(layer = 0; pick >= layerShare[layer]; layer++){
+			pick -= layerShare[layer];
+		}
+		field->y[n] = prngNext(&stars);
+		field->speed[n] = (uint32_t)(((uint64_t)layerSpeed[layer] << 32) / (1000u * STAR_SCREEN_HEIGHT));
+		field->color[n] = layerColor[layer];
+		field->drawn[0][n] = 0;
+		field->drawn[1][n] = 0;
+	}
+}
+
+/**
+	* @brief Scroll every star down by milliseconds at its speed. 
+	* Positions wrap by unsigned overflow, so the loop has no branches and the compiler can vectorise it. 
+*/
+void updateStars(starfield* field, uint32_t milliseconds){
+	uint32_t i, n = field->count;
+	for(i = 0; i < n; i++){
+		field->y[i] -= field->speed[i] * milliseconds;
+	}
+}
@@ -0,0 +1,46 @@
+/**
+  ******************************************************************************
+  * @file    starfield.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains a scrolling, layered starfield for the game's background.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#ifndef starfieldHeader
+#define starfieldHeader
+
+/* Most stars a field holds. Override to benchmark bigger fields. */
+#ifndef STAR_CAPACITY
+#define STAR_CAPACITY 2048
+#endif
+/* Stars in the game's field: the most for which updateStars() and clearScreenStars() together still cost about 
+ what clearScreen() alone does, as host/starfield_bench.c checks */
+#ifndef STAR_COUNT
+#define STAR_COUNT 512
+#endif
+/* Game x pixels across the screen, GLCD_WIDTH in portrait; stars are sorted into these columns. 
+ Override to match the drawing surface's width when it isn't the panel's */
+#ifndef STAR_COLUMNS
+#define STAR_COLUMNS 272
+#endif
+/* Depth layers; the nearer, the faster and brighter */
+#define STAR_LAYERS 3
+
+/**
+	*@brief Starfield, struct-of-arrays.
+	*Stars only scroll down the screen, so each keeps its x column for good. They are sorted by column once when 
+	*the field is made, and clearScreenStars() draws each column's stars as it clears the frame buffer row it lies on. 
+*/
+typedef struct{
+	uint32_t y[STAR_CAPACITY]; /** Height up the screen as a fraction of it, 0.32 fixed point, so it wraps round by itself */
+	uint32_t speed[STAR_CAPACITY]; /** Fraction of the screen's height fallen per millisecond, 0.32 */
+	uint16_t color[STAR_CAPACITY]; /** RGB565 colour, by layer */
+	uint16_t columnStarts[STAR_COLUMNS + 1]; /** First star in each x column; the last entry is count */
+	uint32_t drawn[2][STAR_CAPACITY]; /** Frame buffer index of each star when last drawn in each buffer, for drawStars() to erase */
+	uint32_t count; /** Stars in the field */
+}starfield;
+
+void initStars(starfield* field, uint32_t count, uint32_t seed);
+void updateStars(starfield* field, uint32_t milliseconds);
+#endif
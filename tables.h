@@ -0,0 +1,38 @@
+/**
+  ******************************************************************************
+  * @file    tables.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains the lookup tables kept in flash.
+	*Generated by host/gentables.c from the runtime code; do not edit. Checked by host/tables_test.c.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#ifndef tablesHeader
+#define tablesHeader
+
+/* Largest radius in circleSpans; bigger circles fall back to intSqrt() */
+#define CIRCLE_TABLE_RADIUS 64
+/* Index of the span at row 0 of a circle of radius r; rows 0 to r follow it */
+#define CIRCLE_SPAN_OFFSET(r) (((r) * ((r) + 1)) / 2)
+/* sineTable holds a quarter wave in 2^SINE_TABLE_BITS steps, plus the end point */
+#define SINE_TABLE_BITS 8
+#define SINE_TABLE_SIZE (1 << SINE_TABLE_BITS)
+/* circleEdgeCoverage spans this many subpixels either side of an edge */
+#define CIRCLE_EDGE_WIDTH 9
+/* The gammaDecode tables give linear light to this many bits; the gammaEncode tables take it back */
+#define GAMMA_LINEAR_BITS 12
+
+extern const uint8_t circleSpans[CIRCLE_SPAN_OFFSET(CIRCLE_TABLE_RADIUS + 1)]; /** Half width of each row of each circle, from intSqrt() */
+extern const uint8_t blendRamp[256]; /** 8-bit alpha to blendPixelFast()'s 0 to 32 weight */
+extern const uint16_t sineTable[SINE_TABLE_SIZE + 1]; /** Q15 sine over a quarter turn, from trigSin() */
+extern const int8_t encoderMotionTable[16]; /** Encoder step from previous clk, dt and current clk, dt */
+extern const uint8_t circleEdgeCoverage[2 * CIRCLE_EDGE_WIDTH + 1]; /** Alpha of a pixel whose centre is index - CIRCLE_EDGE_WIDTH subpixels outside an edge */
+extern const uint8_t segmentPatterns[11]; /** Lit segments of 0-9 and blank, bit 0 is a through bit 6 is g */
+extern const uint16_t gammaDecode5[32]; /** Linear light of each 5-bit sRGB level */
+extern const uint16_t gammaDecode6[64]; /** Linear light of each 6-bit sRGB level */
+extern const uint8_t gammaEncode5[1 << GAMMA_LINEAR_BITS]; /** Nearest 5-bit sRGB level to each linear light value */
+extern const uint8_t gammaEncode6[1 << GAMMA_LINEAR_BITS]; /** Nearest 6-bit sRGB level to each linear light value */
+extern const uint16_t gammaDecode8[256]; /** Linear light of each 8-bit sRGB level, for ARGB8888 frame buffers */
+extern const uint8_t gammaEncode8[1 << GAMMA_LINEAR_BITS]; /** Nearest 8-bit sRGB level to each linear light value */
+#endif
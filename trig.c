@@ -0,0 +1,150 @@
+/**
+  ******************************************************************************
+  * @file    trig.c
+  * @author  David Webster - 100293854
+  * @brief   This file contains fixed-point sine, cosine, arctangent and point rotation, by CORDIC.
+	*CORDIC turns a vector by a fixed sequence of angles atan(2^-i), one way or the other, using only shifts and adds. 
+	*Internally angles have 14 more bits than the binary angles outside, and vectors are Q29. 
+  ******************************************************************************
+  */
+
+#include "trig.h"
+#ifndef TABLE_GENERATOR
+#include "tables.h"
+#endif
+
+/* Extra fractional bits of the angle accumulator */
+#define ANGLE_EXTRA 14
+/* CORDIC gain correction, 1/1.6468, in Q29; the vector starts this long so it comes out at unit length */
+#define CORDIC_K 326016437
+/* Vectors are scaled to below this before vectoring, so the gain can't overflow them */
+#define VECTOR_LIMIT (1L << 28)
+/* v, negated if mask is all ones; leaves it alone if mask is 0. Keeps the iterations free of branches. */
+#define NEGATE_IF(v, mask) (((v) ^ (mask)) - (mask))
+
+/* atan(2^-i) as a fraction of a full turn, times 2^30 */
+static const int32_t atanTable[TRIG_ITERATIONS] = {
+	134217728, 79233351, 41864727, 21251189, 10666833, 5338616, 2669960, 1335061, 667541, 
+	333772, 166886, 83443, 41722, 20861, 10430, 5215, 2608, 1304
+};
+
+/**
+	* @brief Sine and cosine of angle, both Q15. 
+	* Angles past a quarter turn either way are turned round by a half turn first, as CORDIC only converges within about 99 degrees. 
+*/
+void trigSinCos(int32_t angle, int32_t* sine, int32_t* cosine){
+	int32_t x = CORDIC_K, y = 0, z, dx, d, i, negate = 0;
+	angle = (int16_t)angle;
+	if(angle > ANGLE_QUARTER){
+		angle -= ANGLE_HALF;
+		negate = 1;
+	}
+	else if(angle < -ANGLE_QUARTER){
+		angle += ANGLE_HALF;
+		negate = 1;
+	}
+	z = angle * (1 << ANGLE_EXTRA);
+	//Turn towards z each iteration: anticlockwise while it is positive, clockwise while negative
+	for(i = 0; i < TRIG_ITERATIONS; i++){
+		dx = x;
+		d = z >> 31;
+		x -= NEGATE_IF(y >> i, d);
+		y += NEGATE_IF(dx >> i, d);
+		z -= NEGATE_IF(atanTable[i], d);
+	}
+	//Q29 to Q15, rounded
+	x = (x + (1 << 13)) >> 14;
+	y = (y + (1 << 13)) >> 14;
+	*cosine = negate ? -x : x;
+	*sine = negate ? -y : y;
+}
+
+int32_t trigSin(int32_t angle){
+	int32_t s, c;
+	trigSinCos(angle, &s, &c);
+	return s;
+}
+
+int32_t trigCos(int32_t angle){
+	int32_t s, c;
+	trigSinCos(angle, &s, &c);
+	return c;
+}
+
+/**
+	* @brief Angle of the vector (x, y) from the x axis towards the y axis, as a binary angle from -ANGLE_HALF to ANGLE_HALF. 
+	* Returns 0 for a zero vector. 
+*/
+int32_t trigAtan2(int32_t y, int32_t x){
+	int32_t z = 0, dx, d, i;
+	if((x == 0) && (y == 0)){return 0;}
+	//Scale into range: big enough to keep the precision, small enough that the gain can't overflow
+	while((x >= VECTOR_LIMIT) || (x <= -VECTOR_LIMIT) || (y >= VECTOR_LIMIT) || (y <= -VECTOR_LIMIT)){
+		x >>= 1;
+		y >>= 1;
+	}
+	while((x < VECTOR_LIMIT / 2) && (x > -VECTOR_LIMIT / 2) && (y < VECTOR_LIMIT / 2) && (y > -VECTOR_LIMIT / 2)){
+		x *= 2;
+		y *= 2;
+	}
+	//Vectoring only converges on the right half plane; turn the left half round by a half turn
+	if(x < 0){
+		x = -x;
+		y = -y;
+		z = (y > 0) ? -(ANGLE_HALF << ANGLE_EXTRA) : (ANGLE_HALF << ANGLE_EXTRA);
+	}
+	//Turn the vector onto the x axis, adding up how far it turned
+	for(i = 0; i < TRIG_ITERATIONS; i++){
+		dx = x;
+		d = ~((-y) >> 31); //0 while y is above the axis, all ones on or below it
+		x += NEGATE_IF(y >> i, d);
+		y -= NEGATE_IF(dx >> i, d);
+		z += NEGATE_IF(atanTable[i], d);
+	}
+	return (z + (1 << (ANGLE_EXTRA - 1))) >> ANGLE_EXTRA;
+}
+
+/**
+	* @brief Rotate count points about the origin by angle; anticlockwise for positive angles with y up. 
+	* The sine and cosine are taken once, so each point is just four multiplies. outX and outY may be x and y. 
+*/
+void rotatePoints(const int16_t* x, const int16_t* y, int16_t* outX, int16_t* outY, uint32_t count, int32_t angle){
+	int32_t s, c, px, py;
+	uint32_t i;
+	trigSinCos(angle, &s, &c);
+	for(i = 0; i < count; i++){
+		px = x[i];
+		py = y[i];
+		outX[i] = (int16_t)((px * c - py * s + (1 << (TRIG_SHIFT - 1))) >> TRIG_SHIFT);
+		outY[i] = (int16_t)((px * s + py * c + (1 << (TRIG_SHIFT - 1))) >> TRIG_SHIFT);
+	}
+}
+
+#ifndef TABLE_GENERATOR
+/**
+	* @brief Q15 sine of a position along the quarter wave, from 0 to ANGLE_QUARTER, interpolated from sineTable. 
+*/
+static int32_t quarterSine(int32_t position){
+	int32_t i = position >> (14 - SINE_TABLE_BITS), fraction = position & ((1 << (14 - SINE_TABLE_BITS)) - 1);
+	int32_t a = sineTable[i];
+	if(fraction == 0){return a;}
+	return a + (((sineTable[i + 1] - a) * fraction + (1 << (13 - SINE_TABLE_BITS))) >> (14 - SINE_TABLE_BITS));
+}
+
+/**
+	* @brief trigSinCos() from the flash sine table, for drawing. 
+	* Every quadrant is read from the first quadrant's sine, so it is within 1 of trigSinCos(), which 
+	* is not quite symmetric itself, and within 2 of exact. 
+*/
+void trigSinCosFast(int32_t angle, int32_t* sine, int32_t* cosine){
+	int32_t position = angle & (ANGLE_QUARTER - 1), quadrant = (angle >> 14) & 3;
+	int32_t rising = quarterSine(position), falling = quarterSine(ANGLE_QUARTER - position);
+	//Each quadrant is the quarter wave run forwards or backwards, and maybe negated
+	switch(quadrant){
+		case 0: *sine = rising; *cosine = falling; break;
+		case 1: *sine = falling; *cosine = -rising; break;
+		case 2: *sine = -rising; *cosine = -falling; break;
+		default: *sine = -falling; *cosine = rising; break;
+	}
+}
+#endif
@@ -0,0 +1,32 @@
+/**
+  ******************************************************************************
+  * @file    trig.h
+  * @author  David Webster - 100293854
+  * @brief   This file contains fixed-point sine, cosine, arctangent and point rotation, by CORDIC.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#ifndef trigHeader
+#define trigHeader
+
+/* Angles are binary: a full turn is ANGLE_FULL, and they wrap at 16 bits, so any int32_t is a valid angle */
+#define ANGLE_FULL 65536
+#define ANGLE_HALF 32768
+#define ANGLE_QUARTER 16384
+/* Sine and cosine are Q15; TRIG_ONE is 1.0 */
+#define TRIG_SHIFT 15
+#define TRIG_ONE (1 << TRIG_SHIFT)
+/* CORDIC iterations; each adds about a bit of precision, and 18 leaves the Q15 results within 1 of exact */
+#define TRIG_ITERATIONS 18
+
+/* Convert degrees to a binary angle, for constants */
+#define DEGREES_TO_ANGLE(d) ((int32_t)((d) * ANGLE_FULL / 360))
+
+void trigSinCos(int32_t angle, int32_t* sine, int32_t* cosine);
+void trigSinCosFast(int32_t angle, int32_t* sine, int32_t* cosine);
+int32_t trigSin(int32_t angle);
+int32_t trigCos(int32_t angle);
+int32_t trigAtan2(int32_t y, int32_t x);
+void rotatePoints(const int16_t* x, const int16_t* y, int16_t* outX, int16_t* outY, uint32_t count, int32_t angle);
+#endif